@@ -0,0 +1,58 @@
+#pragma once
+#include "Core.hpp"
+#include <ez/BitFlags.hpp>
+
+namespace rt {
+	/*
+	Memory barrier bits, for making writes from shaders (image stores, shader storage buffers, atomic counters)
+	visible to the commands that come after the barrier. Each bit names the way the data will be read afterwards,
+	not the way it was written.
+	*/
+	enum class Barrier {
+		// Vertex data sourced from buffers written by shaders.
+		VertexAttribArray = 0,
+		// Index data sourced from buffers written by shaders.
+		ElementArray = 1,
+		// Uniform blocks sourced from buffers written by shaders.
+		Uniform = 2,
+		// Texture fetches from textures written by shaders.
+		TextureFetch = 3,
+		// Image load, store and atomic operations.
+		ShaderImageAccess = 5,
+		// Indirect draw and dispatch commands sourced from buffers written by shaders.
+		Command = 6,
+		// Pixel pack and unpack operations on buffers written by shaders.
+		PixelBuffer = 7,
+		// Texture uploads, downloads and copies on textures written by shaders.
+		TextureUpdate = 8,
+		// Buffer copies, sub data and mapping of buffers written by shaders.
+		BufferUpdate = 9,
+		// Framebuffer reads and writes of attachments written by shaders.
+		Framebuffer = 10,
+		TransformFeedback = 11,
+		AtomicCounter = 12,
+		// Shader storage buffer reads and writes.
+		ShaderStorage = 13,
+		// Access through persistent client mappings of buffers written by shaders.
+		ClientMappedBuffer = 14,
+		QueryBuffer = 15,
+
+		_Count,
+		_EnableOperators
+	};
+	using Barriers = ez::BitFlags<Barrier>;
+
+	static void memoryBarrier(Barriers barriers) {
+		glMemoryBarrier(static_cast<GLbitfield>(barriers.rawValue()));
+		checkError();
+	}
+	// Only orders the accesses of fragment shaders within the same framebuffer region, which can be much cheaper.
+	static void memoryBarrierByRegion(Barriers barriers) {
+		glMemoryBarrierByRegion(static_cast<GLbitfield>(barriers.rawValue()));
+		checkError();
+	}
+	static void memoryBarrierAll() {
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		checkError();
+	}
+}
@@ -2,4 +2,9 @@
 
 #include "buffer/BufferBase.hpp"
 #include "buffer/ImmutableBuffer.hpp"
-#include "buffer/MutableBuffer.hpp"
\ No newline at end of file
+#include "buffer/MutableBuffer.hpp"
+#include "buffer/BufferSlice.hpp"
+#include "buffer/BufferHeap.hpp"
+#include "buffer/StreamRingBuffer.hpp"
+#include "buffer/DirtyRanges.hpp"
+#include "buffer/MappedRange.hpp"
\ No newline at end of file
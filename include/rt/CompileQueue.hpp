@@ -0,0 +1,153 @@
+#pragma once
+#include "Core.hpp"
+#include "Shader.hpp"
+#include "Program.hpp"
+#include <deque>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+
+namespace rt {
+	/*
+	Queue of shader compiles and program links that run in the background.
+	Everything is submitted to the driver up front, then poll is called every so often, for example between asset loads,
+	to pick up the results that are ready without stalling.
+	With GL_KHR_parallel_shader_compile the queue asks the driver whether each job is done.
+	Without it, the status of a job can only be read by waiting for it, so poll resolves a limited number of the oldest jobs per call.
+	The shaders and programs must outlive their jobs.
+	*/
+	class CompileQueue {
+	public:
+		// Called with the result of a job once it is done.
+		using Callback = std::function<void(bool)>;
+
+		// threads is a hint for the number of compiler threads the driver should use, 0 lets the driver decide.
+		CompileQueue(uint32_t threads = 0)
+			: jobs()
+			, parallel(parallelShaderCompileSupported())
+			, succeeded(0)
+			, failed(0)
+		{
+			if (parallel) {
+#if defined(GL_KHR_parallel_shader_compile)
+				glMaxShaderCompilerThreadsKHR(threads == 0 ? 0xFFFFFFFF : threads);
+				checkError();
+#elif defined(GL_ARB_parallel_shader_compile)
+				glMaxShaderCompilerThreadsARB(threads == 0 ? 0xFFFFFFFF : threads);
+				checkError();
+#endif
+			}
+		}
+		~CompileQueue() {
+			wait();
+		}
+
+		CompileQueue(CompileQueue&&) noexcept = default;
+		CompileQueue& operator=(CompileQueue&&) noexcept = default;
+
+		CompileQueue(const CompileQueue&) = delete;
+		CompileQueue& operator=(const CompileQueue&) = delete;
+
+		// Start compiling the shader. The shader must already have its source.
+		void submit(Shader& shader, Callback callback = {}) {
+			assert(shader.isValid());
+			shader.submit();
+			jobs.push_back(Job{ &shader, nullptr, std::move(callback) });
+		}
+
+		// Start linking the program. The attached shaders can still be in the queue, the driver takes care of the ordering.
+		void submit(Program& program, Callback callback = {}) {
+			assert(program.isValid());
+			program.submitLink();
+			jobs.push_back(Job{ nullptr, &program, std::move(callback) });
+		}
+
+		/*
+		Finish every job that is done, and call its callback. Never blocks when parallel compile is supported.
+		Otherwise up to maxBlocking of the oldest jobs are finished, each of which may block until the driver is done with it.
+		Callbacks may submit more jobs, those are picked up by the next poll. Returns the number of jobs finished.
+		*/
+		size_t poll(size_t maxBlocking = 1) {
+			// The jobs are taken out of the queue before any callback runs, so submitting from one can not invalidate the iteration.
+			std::vector<Job> done;
+			if (!parallel) {
+				size_t count = std::min(maxBlocking, jobs.size());
+				done.insert(done.end(), std::make_move_iterator(jobs.begin()), std::make_move_iterator(jobs.begin() + count));
+				jobs.erase(jobs.begin(), jobs.begin() + count);
+			}
+			else {
+				for (auto it = jobs.begin(); it != jobs.end();) {
+					if (isComplete(*it)) {
+						done.push_back(std::move(*it));
+						it = jobs.erase(it);
+					}
+					else {
+						++it;
+					}
+				}
+			}
+
+			for (Job& job : done) {
+				finish(job);
+			}
+			return done.size();
+		}
+
+		// Block until every job is finished, including the ones callbacks submit along the way.
+		void wait() {
+			while (!jobs.empty()) {
+				Job job = std::move(jobs.front());
+				jobs.pop_front();
+				finish(job);
+			}
+		}
+
+		size_t numPending() const noexcept {
+			return jobs.size();
+		}
+		bool empty() const noexcept {
+			return jobs.empty();
+		}
+
+		// True if the driver can report completion without blocking.
+		bool isParallel() const noexcept {
+			return parallel;
+		}
+
+		uint64_t numSucceeded() const noexcept {
+			return succeeded;
+		}
+		uint64_t numFailed() const noexcept {
+			return failed;
+		}
+	private:
+		struct Job {
+			Shader* shader;
+			Program* program;
+			Callback callback;
+		};
+
+		static bool isComplete(const Job& job) {
+			return job.shader != nullptr ? job.shader->isCompileComplete() : job.program->isLinkComplete();
+		}
+
+		void finish(Job& job) {
+			bool result = job.shader != nullptr ? job.shader->finishCompile() : job.program->finishLink();
+			if (result) {
+				++succeeded;
+			}
+			else {
+				++failed;
+			}
+			if (job.callback) {
+				job.callback(result);
+			}
+		}
+
+		std::deque<Job> jobs;
+		bool parallel;
+
+		uint64_t succeeded, failed;
+	};
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include "Core.hpp"
+#include "Program.hpp"
+#include "Shader.hpp"
+#include "Buffer.hpp"
+#include "Barrier.hpp"
+
+namespace rt {
+	// Matches the layout opengl expects for glDispatchComputeIndirect.
+	struct DispatchIndirectCommand {
+		GLuint numGroupsX;
+		GLuint numGroupsY;
+		GLuint numGroupsZ;
+	};
+
+	/*
+	A program made of a single compute shader.
+	The work group size declared in the shader is read back after linking, so dispatchFor can work out
+	how many groups are needed to cover a problem of a given size.
+	*/
+	class ComputeProgram : public Program {
+	public:
+		static glm::ivec3 getMaxWorkGroupCount() {
+			glm::ivec3 result{ 0 };
+			for (GLuint i = 0; i < 3; ++i) {
+				glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, i, &result[i]);
+			}
+			checkError();
+			return result;
+		}
+		static glm::ivec3 getMaxWorkGroupSize() {
+			glm::ivec3 result{ 0 };
+			for (GLuint i = 0; i < 3; ++i) {
+				glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, i, &result[i]);
+			}
+			checkError();
+			return result;
+		}
+		static GLint getMaxWorkGroupInvocations() {
+			GLint value = 0;
+			glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &value);
+			checkError();
+			return value;
+		}
+
+		// The number of groups of groupSize needed to cover count items.
+		static constexpr GLuint groupCount(GLuint count, GLuint groupSize) noexcept {
+			return (count + groupSize - 1) / groupSize;
+		}
+
+		ComputeProgram()
+			: Program()
+			, groupSize(0)
+		{}
+		ComputeProgram(Shader& computeShader)
+			: Program()
+			, groupSize(0)
+		{
+			compile(computeShader);
+		}
+
+		ComputeProgram(ComputeProgram&&) noexcept = default;
+		ComputeProgram& operator=(ComputeProgram&&) noexcept = default;
+
+		ComputeProgram(const ComputeProgram&) = delete;
+		ComputeProgram& operator=(const ComputeProgram&) = delete;
+
+		bool compile(Shader& computeShader) {
+			if (!computeShader.isValid()) {
+				return false;
+			}
+			assert(computeShader.getType() == ShaderStage::Compute);
+			assert(isValid());
+
+			attachShader(computeShader);
+			return compile();
+		}
+
+		bool compile(std::string_view source) {
+			Shader shader(ShaderStage::Compute, source);
+			shader.compile();
+
+			return compile(shader);
+		}
+
+		bool compile() {
+			groupSize = glm::uvec3{ 0 };
+			return Program::compile();
+		}
+
+		// The local size declared in the shader. Only valid once the program is linked.
+		glm::uvec3 getWorkGroupSize() const {
+			if (groupSize.x == 0) {
+				GLint values[3] = { 0, 0, 0 };
+				glGetProgramiv(id, GL_COMPUTE_WORK_GROUP_SIZE, values);
+				checkError();
+				groupSize = glm::uvec3(values[0], values[1], values[2]);
+			}
+			return groupSize;
+		}
+
+		// Dispatch ---
+		// These bind the program first, which also flushes any deferred uniforms.
+		void dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) {
+			assert(isLinked() && "Cannot dispatch a compute program that is not linked!");
+			bind();
+			glDispatchCompute(groupsX, groupsY, groupsZ);
+			checkError();
+		}
+
+		// Dispatch enough groups to cover a problem of the given size, the shader has to skip the invocations past the end.
+		void dispatchFor(GLuint width, GLuint height = 1, GLuint depth = 1) {
+			glm::uvec3 size = getWorkGroupSize();
+			assert(size.x > 0 && size.y > 0 && size.z > 0);
+			dispatch(groupCount(width, size.x), groupCount(height, size.y), groupCount(depth, size.z));
+		}
+
+		// Dispatch with the group counts read from a DispatchIndirectCommand in a buffer on the GPU.
+		void dispatchIndirect(const Buffer& commands, intptr_t offset = 0) {
+			assert(isLinked() && "Cannot dispatch a compute program that is not linked!");
+			assert(commands.boundsCheckBytes(offset, sizeof(DispatchIndirectCommand)));
+			assert(offset % 4 == 0 && "Indirect dispatch offsets must be a multiple of 4!");
+			bind();
+			glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, commands.getId());
+			glDispatchComputeIndirect(offset);
+			checkError();
+		}
+
+		void dispatchIndirect(const BufferSlice& commands, intptr_t offset = 0) {
+			assert(commands.isValid());
+			dispatchIndirect(commands.getBuffer(), commands.getOffset() + offset);
+		}
+	private:
+		mutable glm::uvec3 groupSize;
+	};
+}
@@ -13,6 +13,11 @@
 
 #include <rt/GLError.hpp>
 
+// Same value for the KHR and ARB versions of parallel shader compile, older headers may have neither.
+#if !defined(GL_COMPLETION_STATUS_KHR)
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace rt {
 	enum class Type {
 		Half = GL_HALF_FLOAT,
@@ -48,4 +53,27 @@ namespace rt {
 
 		return macro_exists;
 	}
+
+	// Returns true if the current context exposes the named extension, for example "GL_ARB_indirect_parameters".
+	// This walks the whole extension list, so cache the result if it's needed often.
+	static bool hasExtension(std::string_view name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		checkError();
+
+		for (GLint i = 0; i < count; ++i) {
+			const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+			if (ext != nullptr && name == ext) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Returns true if compiles and links can be polled with GL_COMPLETION_STATUS_KHR, without blocking.
+	// The answer is looked up once, the first time this is called with a current context.
+	static bool parallelShaderCompileSupported() {
+		static const bool supported = hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile");
+		return supported;
+	}
 }
\ No newline at end of file
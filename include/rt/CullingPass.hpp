@@ -0,0 +1,295 @@
+#pragma once
+#include "Core.hpp"
+#include "Buffer.hpp"
+#include "VertexArray.hpp"
+#include "IndirectDrawList.hpp"
+#include "ComputeProgram.hpp"
+#include "Barrier.hpp"
+#include "DepthPyramid.hpp"
+#include "texture/Texture2d.hpp"
+#include <vector>
+#include <array>
+
+namespace rt {
+	// Matches the std430 layout of the instance bounds read by CullingPass, a world space bounding sphere and the draw it belongs to.
+	struct CullBounds {
+		glm::vec3 center;
+		float radius;
+		GLuint draw;
+		GLuint padding[3];
+	};
+	static_assert(sizeof(CullBounds) == 32, "rt::CullBounds must match the std430 layout of the culling shader!");
+
+	namespace intern {
+		static constexpr std::string_view cullSource =
+			"#version 450\n"
+			"layout(local_size_x = 64) in;\n"
+			"struct Bounds { vec4 sphere; uint draw; };\n"
+			"struct Command { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };\n"
+			"layout(std430, binding = 0) readonly buffer BoundsBuffer { Bounds bounds[]; };\n"
+			"layout(std430, binding = 1) buffer Commands { Command commands[]; };\n"
+			"layout(std430, binding = 2) writeonly buffer Visible { uint visible[]; };\n"
+			"uniform uint numInstances;\n"
+			"uniform vec4 planes[6];\n"
+			"uniform mat4 viewProj;\n"
+			"uniform bool useHiZ;\n"
+			"uniform sampler2D hiZ;\n"
+			"bool occluded(vec3 center, float radius) {\n"
+			"	vec3 lo = center - radius;\n"
+			"	vec3 hi = center + radius;\n"
+			"	vec2 ndcMin = vec2(1.0);\n"
+			"	vec2 ndcMax = vec2(-1.0);\n"
+			"	float nearest = 1.0;\n"
+			"	for (int i = 0; i < 8; ++i) {\n"
+			"		vec3 corner = mix(lo, hi, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));\n"
+			"		vec4 clip = viewProj * vec4(corner, 1.0);\n"
+			"		if (clip.w <= 0.0) { return false; }\n"
+			"		vec3 ndc = clip.xyz / clip.w;\n"
+			"		ndcMin = min(ndcMin, ndc.xy);\n"
+			"		ndcMax = max(ndcMax, ndc.xy);\n"
+			"		nearest = min(nearest, ndc.z);\n"
+			"	}\n"
+			"	vec2 uvMin = clamp(ndcMin * 0.5 + 0.5, 0.0, 1.0);\n"
+			"	vec2 uvMax = clamp(ndcMax * 0.5 + 0.5, 0.0, 1.0);\n"
+			"	ivec2 baseSize = textureSize(hiZ, 0);\n"
+			"	vec2 extent = (uvMax - uvMin) * vec2(baseSize);\n"
+			"	int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, textureQueryLevels(hiZ) - 1);\n"
+			"	ivec2 size = max(baseSize >> level, ivec2(1));\n"
+			"	ivec2 a = clamp(ivec2(uvMin * vec2(size)), ivec2(0), size - 1);\n"
+			"	ivec2 b = clamp(ivec2(uvMax * vec2(size)), ivec2(0), size - 1);\n"
+			"	float farthest = max(\n"
+			"		max(texelFetch(hiZ, a, level).r, texelFetch(hiZ, ivec2(b.x, a.y), level).r),\n"
+			"		max(texelFetch(hiZ, ivec2(a.x, b.y), level).r, texelFetch(hiZ, b, level).r));\n"
+			"	return nearest * 0.5 + 0.5 > farthest;\n"
+			"}\n"
+			"void main() {\n"
+			"	uint i = gl_GlobalInvocationID.x;\n"
+			"	if (i >= numInstances) { return; }\n"
+			"	vec4 sphere = bounds[i].sphere;\n"
+			"	for (int p = 0; p < 6; ++p) {\n"
+			"		if (dot(planes[p].xyz, sphere.xyz) + planes[p].w < -sphere.w) { return; }\n"
+			"	}\n"
+			"	if (useHiZ && occluded(sphere.xyz, sphere.w)) { return; }\n"
+			"	uint draw = bounds[i].draw;\n"
+			"	uint slot = atomicAdd(commands[draw].instanceCount, 1u);\n"
+			"	visible[commands[draw].baseInstance + slot] = i;\n"
+			"}\n";
+
+		static constexpr std::string_view compactSource =
+			"#version 450\n"
+			"layout(local_size_x = 64) in;\n"
+			"struct Command { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };\n"
+			"layout(std430, binding = 1) readonly buffer Commands { Command commands[]; };\n"
+			"layout(std430, binding = 3) writeonly buffer Compacted { Command compacted[]; };\n"
+			"layout(std430, binding = 4) buffer Parameters { uint drawCount; };\n"
+			"uniform uint numDraws;\n"
+			"void main() {\n"
+			"	uint i = gl_GlobalInvocationID.x;\n"
+			"	if (i >= numDraws || commands[i].instanceCount == 0u) { return; }\n"
+			"	compacted[atomicAdd(drawCount, 1u)] = commands[i];\n"
+			"}\n";
+	}
+
+	/*
+	Culls instances on the GPU, and turns the survivors into indirect draw commands.
+	Each draw is a mesh with a range of the index buffer, and a number of instance slots. An instance names the draw it belongs to in its CullBounds.
+	A compute pass tests the bounds of every instance against the view frustum, and optionally a hierarchical depth buffer.
+	Surviving instances are counted with atomics into their draw's command, and their indices are written to the visible buffer,
+	starting at the command's baseInstance. A second pass compacts the draws that have any visible instances,
+	and counts them for glMultiDrawElementsIndirectCount, so the CPU never touches the instances.
+
+	The vertex shader finds the instance through the visible buffer, bound as an instanced vertex attribute (divisor 1),
+	which opengl offsets by the baseInstance of each command.
+
+	cull binds shader storage buffers 0 through 4 and the hiZ texture unit, any previous bindings there are replaced.
+	*/
+	class CullingPass {
+	public:
+		static constexpr GLuint BoundsBinding = 0;
+		static constexpr GLuint CommandsBinding = 1;
+		static constexpr GLuint VisibleBinding = 2;
+		static constexpr GLuint CompactedBinding = 3;
+		static constexpr GLuint ParametersBinding = 4;
+
+		// Extract the normalized frustum planes of a view projection matrix, as (normal, distance) with the normals pointing inside.
+		static std::array<glm::vec4, 6> extractPlanes(const glm::mat4& viewProj) {
+			glm::mat4 m = glm::transpose(viewProj);
+			std::array<glm::vec4, 6> planes = {
+				m[3] + m[0],
+				m[3] - m[0],
+				m[3] + m[1],
+				m[3] - m[1],
+				m[3] + m[2],
+				m[3] - m[2]
+			};
+			for (glm::vec4& plane : planes) {
+				plane /= glm::length(glm::vec3(plane));
+			}
+			return planes;
+		}
+
+		CullingPass()
+			: cullProgram()
+			, compactProgram()
+			, templates()
+			, commands()
+			, compacted()
+			, visible()
+			, parameters()
+			, numDraws(0)
+			, numSlots(0)
+			, hiZUnit(0)
+		{
+			bool linked = cullProgram.compile(intern::cullSource);
+			linked = compactProgram.compile(intern::compactSource) && linked;
+			assert(linked && "Failed to link the culling programs!");
+
+			parameters.initValue(GLuint(0), BufferInits::None);
+		}
+
+		CullingPass(CullingPass&&) noexcept = default;
+		CullingPass& operator=(CullingPass&&) noexcept = default;
+
+		CullingPass(const CullingPass&) = delete;
+		CullingPass& operator=(const CullingPass&) = delete;
+
+		/*
+		Set the draws instances can belong to. The instanceCount of each command is the number of instances that belong to the draw,
+		which reserves that many slots in the visible buffer. baseInstance is overwritten with the start of the draw's slots.
+		Instances must not name more draws than this, or put more instances in a draw than it has slots.
+		*/
+		void setDraws(const DrawElementsIndirectCommand* draws, uint32_t count) {
+			assert(count > 0);
+			std::vector<DrawElementsIndirectCommand> initial(draws, draws + count);
+
+			GLuint slots = 0;
+			for (DrawElementsIndirectCommand& cmd : initial) {
+				cmd.baseInstance = slots;
+				slots += cmd.instanceCount;
+				cmd.instanceCount = 0;
+			}
+
+			templates.reset();
+			commands.reset();
+			compacted.reset();
+			visible.reset();
+			templates.initArray(initial.data(), initial.size(), BufferInits::None);
+			commands.initArray(initial.size() * sizeof(DrawElementsIndirectCommand), BufferInits::None);
+			compacted.initArray(initial.size() * sizeof(DrawElementsIndirectCommand), BufferInits::None);
+			visible.initArray(std::max<GLuint>(slots, 1) * sizeof(GLuint), BufferInits::None);
+
+			numDraws = count;
+			numSlots = slots;
+		}
+		void setDraws(const std::vector<DrawElementsIndirectCommand>& draws) {
+			setDraws(draws.data(), static_cast<uint32_t>(draws.size()));
+		}
+
+		// The texture unit the hierarchical depth buffer is bound to while culling.
+		void setHiZUnit(GLuint unit) {
+			hiZUnit = unit;
+		}
+
+		// Cull against the view frustum only.
+		void cull(Buffer& bounds, uint32_t numInstances, const glm::mat4& viewProj) {
+			run(bounds, numInstances, viewProj, nullptr);
+		}
+
+		/*
+		Cull against the view frustum, then against a hierarchical depth buffer of the previous frame.
+		Every mip of hiZ must hold the farthest depth of the texels it covers, in the red channel, in the [0, 1] range of the default depth range.
+		Its mip chain has to go down to a single texel for large objects to be tested.
+		*/
+		void cull(Buffer& bounds, uint32_t numInstances, const glm::mat4& viewProj, Texture2dBase& hiZ) {
+			run(bounds, numInstances, viewProj, &hiZ);
+		}
+		void cull(Buffer& bounds, uint32_t numInstances, const glm::mat4& viewProj, DepthPyramid& pyramid) {
+			assert(pyramid.getReduction() == DepthReduction::Max && "Occlusion culling needs the farthest depth, use DepthReduction::Max!");
+			run(bounds, numInstances, viewProj, &pyramid.getTexture());
+		}
+
+		/*
+		Draw every visible instance, the vertex array must be bound.
+		Without GL_ARB_indirect_parameters every draw is submitted, the empty ones just draw nothing.
+		*/
+		void draw(VertexArray& vao, Primitive prim, Index index) {
+			assert(numDraws > 0 && "Call rt::CullingPass::setDraws before drawing!");
+			if (VertexArray::indirectCountSupported()) {
+				vao.multiDrawElementsIndirectCount(prim, index, compacted, parameters, 0, static_cast<GLsizei>(numDraws));
+			}
+			else {
+				vao.multiDrawElementsIndirect(prim, index, commands, static_cast<GLsizei>(numDraws));
+			}
+		}
+
+		// Getters ---
+		// The indices of the visible instances, grouped by draw.
+		Buffer& getVisible() noexcept {
+			return visible;
+		}
+		// The commands of every draw, in the order they were set, with the visible instance counts.
+		Buffer& getCommands() noexcept {
+			return commands;
+		}
+		// The commands of the draws with any visible instances, in no particular order.
+		Buffer& getCompacted() noexcept {
+			return compacted;
+		}
+		// Holds the number of compacted commands, as a single GLuint.
+		Buffer& getParameters() noexcept {
+			return parameters;
+		}
+
+		uint32_t numDrawCommands() const noexcept {
+			return numDraws;
+		}
+		uint32_t numInstanceSlots() const noexcept {
+			return numSlots;
+		}
+	private:
+		void run(Buffer& bounds, uint32_t numInstances, const glm::mat4& viewProj, Texture2dBase* hiZ) {
+			assert(numDraws > 0 && "Call rt::CullingPass::setDraws before culling!");
+			assert(numInstances <= numSlots && "More instances than draw slots!");
+			assert(bounds.boundsCheckBytes(0, numInstances * sizeof(CullBounds)));
+
+			// Start from zero instances and zero draws.
+			templates.copyTo(commands);
+			parameters.clearTo(GLuint(0));
+
+			bounds.bindSSBO(BoundsBinding);
+			commands.bindSSBO(CommandsBinding);
+			visible.bindSSBO(VisibleBinding);
+			compacted.bindSSBO(CompactedBinding);
+			parameters.bindSSBO(ParametersBinding);
+
+			std::array<glm::vec4, 6> planes = extractPlanes(viewProj);
+			cullProgram.uniform(cullProgram.getUniformLocation("numInstances"), GLuint(numInstances));
+			cullProgram.uniform(cullProgram.getUniformLocation("planes"), planes.data(), 6);
+			cullProgram.uniform(cullProgram.getUniformLocation("viewProj"), viewProj);
+			cullProgram.uniform(cullProgram.getUniformLocation("useHiZ"), hiZ != nullptr);
+			if (hiZ != nullptr) {
+				hiZ->bindUnit(hiZUnit);
+				cullProgram.uniform(cullProgram.getUniformLocation("hiZ"), GLint(hiZUnit));
+			}
+
+			if (numInstances > 0) {
+				cullProgram.dispatchFor(numInstances);
+				memoryBarrier(Barrier::ShaderStorage);
+			}
+
+			compactProgram.uniform(compactProgram.getUniformLocation("numDraws"), GLuint(numDraws));
+			compactProgram.dispatchFor(numDraws);
+
+			// The results are read as draw commands, draw counts and instanced vertex attributes, or by shaders.
+			memoryBarrier(Barrier::Command | Barrier::VertexAttribArray | Barrier::ShaderStorage);
+		}
+
+		ComputeProgram cullProgram, compactProgram;
+
+		ImmutableBuffer templates, commands, compacted, visible;
+		ImmutableBuffer parameters;
+
+		uint32_t numDraws, numSlots;
+		GLuint hiZUnit;
+	};
+}
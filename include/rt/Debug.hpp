@@ -0,0 +1,507 @@
+#pragma once
+#include "Core.hpp"
+#include "Buffer.hpp"
+#include "Texture.hpp"
+#include "RenderBuffer.hpp"
+#include "FrameBuffer.hpp"
+#include "VertexArray.hpp"
+#include "Program.hpp"
+#include "Shader.hpp"
+#include "Sampler.hpp"
+#include <fmt/core.h>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+namespace rt {
+	enum class DebugSource {
+		Api,
+		WindowSystem,
+		ShaderCompiler,
+		ThirdParty,
+		Application,
+		Other,
+		_Count,
+	};
+
+	enum class DebugType {
+		Error,
+		Deprecated,
+		UndefinedBehavior,
+		Portability,
+		Performance,
+		Marker,
+		PushGroup,
+		PopGroup,
+		Other,
+		_Count,
+	};
+
+	enum class DebugSeverity {
+		High,
+		Medium,
+		Low,
+		Notification,
+		_Count,
+	};
+
+	// Best effort classification of driver performance warnings, based on the message text.
+	enum class PerformanceKind {
+		BufferMigration,
+		ShaderRecompile,
+		Stall,
+		Other,
+	};
+
+	static DebugSource convertDebugSource(GLenum source) noexcept {
+		switch (source) {
+		case GL_DEBUG_SOURCE_API:
+			return DebugSource::Api;
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+			return DebugSource::WindowSystem;
+		case GL_DEBUG_SOURCE_SHADER_COMPILER:
+			return DebugSource::ShaderCompiler;
+		case GL_DEBUG_SOURCE_THIRD_PARTY:
+			return DebugSource::ThirdParty;
+		case GL_DEBUG_SOURCE_APPLICATION:
+			return DebugSource::Application;
+		default:
+			return DebugSource::Other;
+		}
+	}
+	static DebugType convertDebugType(GLenum type) noexcept {
+		switch (type) {
+		case GL_DEBUG_TYPE_ERROR:
+			return DebugType::Error;
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+			return DebugType::Deprecated;
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+			return DebugType::UndefinedBehavior;
+		case GL_DEBUG_TYPE_PORTABILITY:
+			return DebugType::Portability;
+		case GL_DEBUG_TYPE_PERFORMANCE:
+			return DebugType::Performance;
+		case GL_DEBUG_TYPE_MARKER:
+			return DebugType::Marker;
+		case GL_DEBUG_TYPE_PUSH_GROUP:
+			return DebugType::PushGroup;
+		case GL_DEBUG_TYPE_POP_GROUP:
+			return DebugType::PopGroup;
+		default:
+			return DebugType::Other;
+		}
+	}
+	static DebugSeverity convertDebugSeverity(GLenum severity) noexcept {
+		switch (severity) {
+		case GL_DEBUG_SEVERITY_HIGH:
+			return DebugSeverity::High;
+		case GL_DEBUG_SEVERITY_MEDIUM:
+			return DebugSeverity::Medium;
+		case GL_DEBUG_SEVERITY_LOW:
+			return DebugSeverity::Low;
+		default:
+			return DebugSeverity::Notification;
+		}
+	}
+	static GLenum convertGL(DebugSeverity severity) noexcept {
+		switch (severity) {
+		case DebugSeverity::High:
+			return GL_DEBUG_SEVERITY_HIGH;
+		case DebugSeverity::Medium:
+			return GL_DEBUG_SEVERITY_MEDIUM;
+		case DebugSeverity::Low:
+			return GL_DEBUG_SEVERITY_LOW;
+		default:
+			return GL_DEBUG_SEVERITY_NOTIFICATION;
+		}
+	}
+
+	static std::string_view getDebugTypeString(DebugType type) {
+		switch (type) {
+		case DebugType::Error:
+			return intern::makeView("Error");
+		case DebugType::Deprecated:
+			return intern::makeView("Deprecated");
+		case DebugType::UndefinedBehavior:
+			return intern::makeView("Undefined behavior");
+		case DebugType::Portability:
+			return intern::makeView("Portability");
+		case DebugType::Performance:
+			return intern::makeView("Performance");
+		case DebugType::Marker:
+			return intern::makeView("Marker");
+		case DebugType::PushGroup:
+			return intern::makeView("Push group");
+		case DebugType::PopGroup:
+			return intern::makeView("Pop group");
+		default:
+			return intern::makeView("Other");
+		}
+	}
+
+	// A single message from the driver. The text is truncated to fit, so that the callback never allocates.
+	struct DebugMessage {
+		static constexpr size_t MaxLength = 512;
+
+		DebugSource source;
+		DebugType type;
+		DebugSeverity severity;
+		GLuint id;
+		uint32_t length;
+		char text[MaxLength];
+
+		std::string_view getText() const noexcept {
+			return std::string_view{ text, length };
+		}
+	};
+
+	struct PerformanceEvent {
+		PerformanceKind kind;
+		DebugSource source;
+		DebugSeverity severity;
+		GLuint id;
+		std::string_view text;
+	};
+
+	/*
+	Bounded lock-free queue with many producers and a single consumer.
+	Each cell carries a sequence number, which tells producers and the consumer whose turn it is to use it.
+	Pushing into a full queue fails instead of waiting.
+	*/
+	template<typename T>
+	class MPSCQueue {
+	public:
+		// The capacity is rounded up to a power of two.
+		MPSCQueue(size_t capacity)
+			: cells()
+			, mask(0)
+			, head(0)
+			, tail(0)
+		{
+			size_t size = 2;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			cells = std::make_unique<Cell[]>(size);
+			mask = size - 1;
+			for (size_t i = 0; i < size; ++i) {
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		// Safe to call from any thread. Returns false if the queue is full.
+		template<typename F>
+		bool push(F&& write) {
+			size_t pos = tail.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell& cell = cells[pos & mask];
+				size_t seq = cell.sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0) {
+					if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						write(cell.value);
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0) {
+					return false;
+				}
+				else {
+					pos = tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// Only safe to call from a single thread at a time. Returns false if the queue is empty.
+		template<typename F>
+		bool pop(F&& read) {
+			Cell& cell = cells[head & mask];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(head + 1) < 0) {
+				return false;
+			}
+			read(cell.value);
+			cell.sequence.store(head + mask + 1, std::memory_order_release);
+			++head;
+			return true;
+		}
+
+		size_t capacity() const noexcept {
+			return mask + 1;
+		}
+	private:
+		struct Cell {
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> cells;
+		size_t mask;
+		size_t head;
+		std::atomic<size_t> tail;
+	};
+
+	/*
+	Receives messages from the driver through glDebugMessageCallback, which needs a debug context or GL_KHR_debug.
+	The callback only copies the message into a lock-free queue and bumps the counters, so it's cheap enough to leave on in production,
+	and output is left asynchronous, so the driver never has to synchronize to report something.
+	Messages are handed to the handlers by drain, either called once per frame or from a consumer thread.
+	Only one DebugOutput should exist per context, since it replaces the callback.
+	*/
+	class DebugOutput {
+	public:
+		using Handler = std::function<void(const DebugMessage&)>;
+		using PerformanceHandler = std::function<void(const PerformanceEvent&)>;
+
+		DebugOutput(size_t queueSize = 1024)
+			: queue(queueSize)
+			, handler()
+			, performanceHandler()
+			, sources()
+			, types()
+			, severities()
+			, dropped(0)
+			, consumer()
+			, running(false)
+		{
+			glEnable(GL_DEBUG_OUTPUT);
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+			glDebugMessageCallback(&DebugOutput::callback, this);
+			checkError();
+		}
+		~DebugOutput() {
+			stopThread();
+			glDebugMessageCallback(nullptr, nullptr);
+			checkError();
+		}
+
+		// The callback refers back to the object, so it cannot be moved.
+		DebugOutput(DebugOutput&&) = delete;
+		DebugOutput& operator=(DebugOutput&&) = delete;
+
+		DebugOutput(const DebugOutput&) = delete;
+		DebugOutput& operator=(const DebugOutput&) = delete;
+
+		// Called from drain for every message. Without a handler, high and medium severity messages are printed to stderr.
+		void setHandler(Handler nhandler) {
+			handler = std::move(nhandler);
+		}
+		// Called from drain for every performance message, after the regular handler.
+		void setPerformanceHandler(PerformanceHandler nhandler) {
+			performanceHandler = std::move(nhandler);
+		}
+
+		// Ask the driver not to generate messages below the given severity. Messages that are never generated cost nothing.
+		void setMinimumSeverity(DebugSeverity minimum) {
+			for (int i = 0; i < static_cast<int>(DebugSeverity::_Count); ++i) {
+				DebugSeverity severity = static_cast<DebugSeverity>(i);
+				glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, convertGL(severity), 0, nullptr, severity <= minimum ? GL_TRUE : GL_FALSE);
+			}
+			checkError();
+		}
+
+		// Deliver every queued message to the handlers. Returns the number of messages delivered.
+		// Must not be called while the consumer thread is running.
+		size_t drain() {
+			size_t count = 0;
+			while (queue.pop([this](const DebugMessage& msg) { deliver(msg); })) {
+				++count;
+			}
+			return count;
+		}
+
+		// Drain on a background thread, polling the queue every interval.
+		void startThread(std::chrono::milliseconds interval = std::chrono::milliseconds(1)) {
+			if (running.exchange(true)) {
+				return;
+			}
+			consumer = std::thread([this, interval]() {
+				while (running.load(std::memory_order_acquire)) {
+					if (drain() == 0) {
+						std::this_thread::sleep_for(interval);
+					}
+				}
+				drain();
+			});
+		}
+		void stopThread() {
+			if (running.exchange(false) && consumer.joinable()) {
+				consumer.join();
+			}
+		}
+
+		// Counters ---
+		// These count messages as they arrive, whether or not they have been drained.
+		uint64_t count(DebugSource source) const noexcept {
+			return sources[static_cast<size_t>(source)].load(std::memory_order_relaxed);
+		}
+		uint64_t count(DebugType type) const noexcept {
+			return types[static_cast<size_t>(type)].load(std::memory_order_relaxed);
+		}
+		uint64_t count(DebugSeverity severity) const noexcept {
+			return severities[static_cast<size_t>(severity)].load(std::memory_order_relaxed);
+		}
+		uint64_t errorCount() const noexcept {
+			return count(DebugType::Error);
+		}
+		// Messages lost because the queue was full.
+		uint64_t droppedCount() const noexcept {
+			return dropped.load(std::memory_order_relaxed);
+		}
+		void resetStats() noexcept {
+			for (auto& counter : sources) {
+				counter.store(0, std::memory_order_relaxed);
+			}
+			for (auto& counter : types) {
+				counter.store(0, std::memory_order_relaxed);
+			}
+			for (auto& counter : severities) {
+				counter.store(0, std::memory_order_relaxed);
+			}
+			dropped.store(0, std::memory_order_relaxed);
+		}
+
+		// Guess what a performance message is about from its text. Driver wording varies, so unknown messages are Other.
+		static PerformanceKind classify(std::string_view text) noexcept {
+			if (contains(text, "recompil")) {
+				return PerformanceKind::ShaderRecompile;
+			}
+			if (contains(text, "migrat") || contains(text, "memory") || contains(text, "moved")) {
+				return PerformanceKind::BufferMigration;
+			}
+			if (contains(text, "stall") || contains(text, "sync") || contains(text, "wait")) {
+				return PerformanceKind::Stall;
+			}
+			return PerformanceKind::Other;
+		}
+	private:
+		static void GLAPIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user) {
+			DebugOutput* self = const_cast<DebugOutput*>(static_cast<const DebugOutput*>(user));
+
+			DebugSource src = convertDebugSource(source);
+			DebugType kind = convertDebugType(type);
+			DebugSeverity sev = convertDebugSeverity(severity);
+
+			self->sources[static_cast<size_t>(src)].fetch_add(1, std::memory_order_relaxed);
+			self->types[static_cast<size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+			self->severities[static_cast<size_t>(sev)].fetch_add(1, std::memory_order_relaxed);
+
+			size_t textLength = length >= 0 ? static_cast<size_t>(length) : std::strlen(message);
+			textLength = std::min(textLength, DebugMessage::MaxLength);
+
+			bool pushed = self->queue.push([&](DebugMessage& msg) {
+				msg.source = src;
+				msg.type = kind;
+				msg.severity = sev;
+				msg.id = id;
+				msg.length = static_cast<uint32_t>(textLength);
+				std::memcpy(msg.text, message, textLength);
+			});
+			if (!pushed) {
+				self->dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		static bool contains(std::string_view text, std::string_view word) noexcept {
+			if (word.size() > text.size()) {
+				return false;
+			}
+			for (size_t i = 0; i + word.size() <= text.size(); ++i) {
+				size_t j = 0;
+				while (j < word.size() && std::tolower(static_cast<unsigned char>(text[i + j])) == word[j]) {
+					++j;
+				}
+				if (j == word.size()) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void deliver(const DebugMessage& msg) {
+			if (handler) {
+				handler(msg);
+			}
+			else if (msg.severity == DebugSeverity::High || msg.severity == DebugSeverity::Medium) {
+				fmt::print(stderr, "OpenGL {} ({}): {}\n", getDebugTypeString(msg.type), msg.id, msg.getText());
+			}
+
+			if (msg.type == DebugType::Performance && performanceHandler) {
+				performanceHandler(PerformanceEvent{ classify(msg.getText()), msg.source, msg.severity, msg.id, msg.getText() });
+			}
+		}
+
+		MPSCQueue<DebugMessage> queue;
+		Handler handler;
+		PerformanceHandler performanceHandler;
+
+		std::array<std::atomic<uint64_t>, static_cast<size_t>(DebugSource::_Count)> sources;
+		std::array<std::atomic<uint64_t>, static_cast<size_t>(DebugType::_Count)> types;
+		std::array<std::atomic<uint64_t>, static_cast<size_t>(DebugSeverity::_Count)> severities;
+		std::atomic<uint64_t> dropped;
+
+		std::thread consumer;
+		std::atomic<bool> running;
+	};
+
+	// Groups the calls made during its lifetime under a name, in debug output and in tools like RenderDoc.
+	class DebugGroup {
+	public:
+		DebugGroup(std::string_view name, GLuint id = 0) {
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, id, static_cast<GLsizei>(name.size()), name.data());
+			checkError();
+		}
+		~DebugGroup() {
+			glPopDebugGroup();
+			checkError();
+		}
+
+		DebugGroup(const DebugGroup&) = delete;
+		DebugGroup& operator=(const DebugGroup&) = delete;
+	};
+
+	// Labels ---
+	// Names show up in debug messages, and in tools like RenderDoc.
+	// Nothing is labelled on creation, the wrappers have no names to give, so label the objects worth telling apart.
+	namespace intern {
+		static void objectLabel(GLenum identifier, GLuint id, std::string_view name) {
+			glObjectLabel(identifier, id, static_cast<GLsizei>(name.size()), name.data());
+			checkError();
+		}
+	}
+
+	static void label(const Buffer& obj, std::string_view name) {
+		intern::objectLabel(GL_BUFFER, obj.getId(), name);
+	}
+	static void label(const TextureBase& obj, std::string_view name) {
+		intern::objectLabel(GL_TEXTURE, obj.getId(), name);
+	}
+	static void label(const RenderBuffer& obj, std::string_view name) {
+		intern::objectLabel(GL_RENDERBUFFER, obj.getId(), name);
+	}
+	static void label(const FrameBuffer& obj, std::string_view name) {
+		intern::objectLabel(GL_FRAMEBUFFER, obj.getId(), name);
+	}
+	static void label(const VertexArray& obj, std::string_view name) {
+		intern::objectLabel(GL_VERTEX_ARRAY, obj.getId(), name);
+	}
+	static void label(const Program& obj, std::string_view name) {
+		intern::objectLabel(GL_PROGRAM, obj.getId(), name);
+	}
+	static void label(const Shader& obj, std::string_view name) {
+		intern::objectLabel(GL_SHADER, obj.getId(), name);
+	}
+	static void label(const Sampler& obj, std::string_view name) {
+		intern::objectLabel(GL_SAMPLER, obj.getId(), name);
+	}
+}
@@ -0,0 +1,320 @@
+#pragma once
+#include "Core.hpp"
+#include "ComputeProgram.hpp"
+#include "Program.hpp"
+#include "FrameBuffer.hpp"
+#include "VertexArray.hpp"
+#include "Barrier.hpp"
+#include "texture/Texture2d.hpp"
+#include <string>
+
+namespace rt {
+	/*
+	How the texels of a depth pyramid combine.
+	Max keeps the farthest depth with the default depth conventions, which is what occlusion culling wants.
+	Min keeps the farthest depth with reversed depth, or the nearest with the default conventions.
+	*/
+	enum class DepthReduction {
+		Min,
+		Max,
+	};
+
+	namespace intern {
+		// Shared by both paths. Texel p of pyramid level 0 covers every depth texel it overlaps, so no depth is ever skipped.
+		static constexpr std::string_view depthPyramidCommon =
+			"uniform sampler2D source;\n"
+			"uniform ivec2 depthSize;\n"
+			"uniform ivec2 pyramidSize;\n"
+			"ivec2 levelSize(int level) { return max(pyramidSize >> level, ivec2(1)); }\n"
+			"float reduce4(float a, float b, float c, float d) { return REDUCE(REDUCE(a, b), REDUCE(c, d)); }\n"
+			"float fetchDepth(ivec2 p) {\n"
+			"	ivec2 lo = p * depthSize / pyramidSize;\n"
+			"	ivec2 hi = min((((p + 1) * depthSize) + pyramidSize - 1) / pyramidSize, depthSize) - 1;\n"
+			"	float v = texelFetch(source, lo, 0).r;\n"
+			"	for (int y = lo.y; y <= hi.y; ++y) {\n"
+			"		for (int x = lo.x; x <= hi.x; ++x) {\n"
+			"			v = REDUCE(v, texelFetch(source, ivec2(x, y), 0).r);\n"
+			"		}\n"
+			"	}\n"
+			"	return v;\n"
+			"}\n"
+			"float fetchLevel(ivec2 p, int level, int lod) {\n"
+			"	ivec2 last = levelSize(level) - 1;\n"
+			"	return reduce4(\n"
+			"		texelFetch(source, min(p, last), lod).r,\n"
+			"		texelFetch(source, min(p + ivec2(1, 0), last), lod).r,\n"
+			"		texelFetch(source, min(p + ivec2(0, 1), last), lod).r,\n"
+			"		texelFetch(source, min(p + ivec2(1, 1), last), lod).r);\n"
+			"}\n";
+
+		/*
+		Each group of 16x16 threads writes a 32x32 tile of baseLevel, then reduces it down to a single texel of baseLevel + 5.
+		The first two levels stay in registers, the rest go through shared memory.
+		*/
+		static constexpr std::string_view depthPyramidCompute =
+			"layout(local_size_x = 16, local_size_y = 16) in;\n"
+			"uniform int baseLevel;\n"
+			"uniform int numLevels;\n"
+			"layout(binding = 0, r32f) uniform writeonly image2D level0;\n"
+			"layout(binding = 1, r32f) uniform writeonly image2D level1;\n"
+			"layout(binding = 2, r32f) uniform writeonly image2D level2;\n"
+			"layout(binding = 3, r32f) uniform writeonly image2D level3;\n"
+			"layout(binding = 4, r32f) uniform writeonly image2D level4;\n"
+			"layout(binding = 5, r32f) uniform writeonly image2D level5;\n"
+			"shared float tile[16][16];\n"
+			"void store(int i, ivec2 p, float v) {\n"
+			"	if (i >= numLevels || any(greaterThanEqual(p, levelSize(baseLevel + i)))) { return; }\n"
+			"	switch (i) {\n"
+			"	case 0: imageStore(level0, p, vec4(v)); break;\n"
+			"	case 1: imageStore(level1, p, vec4(v)); break;\n"
+			"	case 2: imageStore(level2, p, vec4(v)); break;\n"
+			"	case 3: imageStore(level3, p, vec4(v)); break;\n"
+			"	case 4: imageStore(level4, p, vec4(v)); break;\n"
+			"	case 5: imageStore(level5, p, vec4(v)); break;\n"
+			"	}\n"
+			"}\n"
+			"float fetchBase(ivec2 p) {\n"
+			"	p = min(p, levelSize(baseLevel) - 1);\n"
+			"	if (baseLevel == 0) { return fetchDepth(p); }\n"
+			"	return fetchLevel(2 * p, baseLevel - 1, baseLevel - 1);\n"
+			"}\n"
+			"void main() {\n"
+			"	ivec2 t = ivec2(gl_LocalInvocationID.xy);\n"
+			"	ivec2 g = ivec2(gl_WorkGroupID.xy);\n"
+			"	ivec2 p = g * 32 + t * 2;\n"
+			"	float a = fetchBase(p);\n"
+			"	float b = fetchBase(p + ivec2(1, 0));\n"
+			"	float c = fetchBase(p + ivec2(0, 1));\n"
+			"	float d = fetchBase(p + ivec2(1, 1));\n"
+			"	store(0, p, a);\n"
+			"	store(0, p + ivec2(1, 0), b);\n"
+			"	store(0, p + ivec2(0, 1), c);\n"
+			"	store(0, p + ivec2(1, 1), d);\n"
+			"	float v = reduce4(a, b, c, d);\n"
+			"	store(1, g * 16 + t, v);\n"
+			"	for (int i = 2; i < 6; ++i) {\n"
+			"		tile[t.y][t.x] = v;\n"
+			"		barrier();\n"
+			"		int n = 32 >> i;\n"
+			"		if (t.x < n && t.y < n) {\n"
+			"			ivec2 s = t * 2;\n"
+			"			v = reduce4(tile[s.y][s.x], tile[s.y][s.x + 1], tile[s.y + 1][s.x], tile[s.y + 1][s.x + 1]);\n"
+			"			store(i, g * n + t, v);\n"
+			"		}\n"
+			"		barrier();\n"
+			"	}\n"
+			"}\n";
+
+		static constexpr std::string_view depthPyramidVertex =
+			"#version 450\n"
+			"void main() {\n"
+			"	vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+			"	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);\n"
+			"}\n";
+
+		// The source levels are limited to the one being read, so lod 0 is always the previous level.
+		static constexpr std::string_view depthPyramidFragment =
+			"uniform int level;\n"
+			"out float result;\n"
+			"void main() {\n"
+			"	ivec2 p = ivec2(gl_FragCoord.xy);\n"
+			"	result = level == 0 ? fetchDepth(p) : fetchLevel(2 * p, level - 1, 0);\n"
+			"}\n";
+	}
+
+	/*
+	A hierarchical depth buffer, where each texel of a level holds the min or max of the four texels below it.
+	Level 0 is the largest power of two that fits in the depth buffer, and every texel of it covers all of the depth texels it overlaps,
+	so the reduction stays conservative for any size of depth buffer. The pyramid is mapped to the depth buffer by uv.
+
+	The compute path writes up to six levels per dispatch, so a 4k depth buffer takes two dispatches.
+	The fragment path draws one level at a time, for drivers where the compute path is slow, or when the work has to stay in order with draws.
+	*/
+	class DepthPyramid {
+	public:
+		static constexpr GLint LevelsPerPass = 6;
+
+		enum class Path {
+			Compute,
+			Fragment,
+		};
+
+		// The largest power of two that is not larger than size.
+		static GLint floorPowerOfTwo(GLint size) {
+			assert(size > 0);
+			GLint result = 1;
+			while (result * 2 <= size) {
+				result *= 2;
+			}
+			return result;
+		}
+
+		DepthPyramid(DepthReduction mode = DepthReduction::Max)
+			: texture()
+			, computeProgram()
+			, fragmentProgram()
+			, framebuffer()
+			, emptyVao()
+			, depthSize(0)
+			, levels(0)
+			, reduction(mode)
+		{
+			bool linked = computeProgram.compile(source(intern::depthPyramidCompute));
+			assert(linked && "Failed to link the depth pyramid compute program!");
+		}
+
+		DepthPyramid(const DepthPyramid&) = delete;
+		DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+		// Allocate the pyramid for a depth buffer of the given size, build does this whenever the size changes.
+		void resize(const glm::ivec2& size) {
+			assert(size.x > 0 && size.y > 0);
+			if (size == depthSize) {
+				return;
+			}
+
+			glm::ivec2 base{ floorPowerOfTwo(size.x), floorPowerOfTwo(size.y) };
+			levels = 1;
+			while ((std::max(base.x, base.y) >> levels) > 0) {
+				++levels;
+			}
+
+			texture.reset();
+			texture.init(TexFormat::R_F32, levels, base);
+			texture.filterNearest();
+			depthSize = size;
+		}
+
+		/*
+		Rebuild every level from a depth texture, which must not use depth comparison.
+		The results are visible to texture fetches and image loads once this returns.
+		*/
+		void build(Texture2dBase& depth, Path path = Path::Compute) {
+			assert(depth.isValidSize());
+			resize(depth.getSize());
+
+			if (path == Path::Compute) {
+				buildCompute(depth);
+			}
+			else {
+				buildFragment(depth);
+			}
+		}
+
+		// Getters ---
+		ImmutableTexture2d& getTexture() noexcept {
+			return texture;
+		}
+		const ImmutableTexture2d& getTexture() const noexcept {
+			return texture;
+		}
+
+		glm::ivec2 getSize() const noexcept {
+			return texture.getSize();
+		}
+		glm::ivec2 getLevelSize(GLint level) const noexcept {
+			return glm::ivec2{ std::max(texture.getWidth() >> level, 1), std::max(texture.getHeight() >> level, 1) };
+		}
+		// The size of the depth buffer the pyramid was built for.
+		glm::ivec2 getDepthSize() const noexcept {
+			return depthSize;
+		}
+		GLint numLevels() const noexcept {
+			return levels;
+		}
+
+		DepthReduction getReduction() const noexcept {
+			return reduction;
+		}
+	private:
+		std::string source(std::string_view body) const {
+			std::string result = "#version 450\n";
+			result += reduction == DepthReduction::Min ? "#define REDUCE min\n" : "#define REDUCE max\n";
+			result += intern::depthPyramidCommon;
+			result += body;
+			return result;
+		}
+
+		void setSizes(Program& program) {
+			program.uniform(program.getUniformLocation("depthSize"), depthSize);
+			program.uniform(program.getUniformLocation("pyramidSize"), texture.getSize());
+			program.uniform(program.getUniformLocation("source"), GLint(0));
+		}
+
+		void buildCompute(Texture2dBase& depth) {
+			setSizes(computeProgram);
+			GLint baseLocation = computeProgram.getUniformLocation("baseLevel");
+			GLint countLocation = computeProgram.getUniformLocation("numLevels");
+
+			for (GLint base = 0; base < levels; base += LevelsPerPass) {
+				GLint count = std::min(LevelsPerPass, levels - base);
+				for (GLint i = 0; i < count; ++i) {
+					texture.bindImage(static_cast<GLuint>(i), base + i, ImageAccess::Write);
+				}
+				if (base == 0) {
+					depth.bindUnit(0);
+				}
+				else {
+					texture.bindUnit(0);
+				}
+
+				computeProgram.uniform(baseLocation, base);
+				computeProgram.uniform(countLocation, count);
+
+				glm::ivec2 size = getLevelSize(base);
+				computeProgram.dispatch(ComputeProgram::groupCount(size.x, 32), ComputeProgram::groupCount(size.y, 32));
+				memoryBarrier(Barrier::TextureFetch | Barrier::ShaderImageAccess);
+			}
+		}
+
+		void buildFragment(Texture2dBase& depth) {
+			if (!fragmentProgram.isLinked()) {
+				bool linked = fragmentProgram.compile(intern::depthPyramidVertex, source(intern::depthPyramidFragment));
+				assert(linked && "Failed to link the depth pyramid fragment program!");
+			}
+			setSizes(fragmentProgram);
+			GLint levelLocation = fragmentProgram.getUniformLocation("level");
+
+			GLint viewport[4];
+			glGetIntegerv(GL_VIEWPORT, viewport);
+			GLuint previousFramebuffer = FrameBuffer::CurrentDrawId();
+
+			fragmentProgram.bind();
+			emptyVao.bind();
+			framebuffer.bindDraw();
+			for (GLint level = 0; level < levels; ++level) {
+				if (level == 0) {
+					depth.bindUnit(0);
+				}
+				else {
+					// Only the previous level can be sampled, so the level being drawn to is not a feedback loop.
+					texture.setLevelRange(level - 1, level - 1);
+					texture.bindUnit(0);
+				}
+				framebuffer.attachColor(texture, 0, level);
+				fragmentProgram.uniform(levelLocation, level);
+
+				glm::ivec2 size = getLevelSize(level);
+				glViewport(0, 0, size.x, size.y);
+				emptyVao.drawArrays(Primitive::Triangles, 3);
+			}
+			texture.resetLevelRange();
+
+			if (StateCache::get().bindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer)) {
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+			}
+			glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+			checkError();
+		}
+
+		ImmutableTexture2d texture;
+		ComputeProgram computeProgram;
+		Program fragmentProgram;
+		FrameBuffer framebuffer;
+		VertexArray emptyVao;
+
+		glm::ivec2 depthSize;
+		GLint levels;
+		DepthReduction reduction;
+	};
+}
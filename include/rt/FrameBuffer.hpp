@@ -2,6 +2,7 @@
 #include "Core.hpp"
 #include "Texture.hpp"
 #include "RenderBuffer.hpp"
+#include "StateCache.hpp"
 
 namespace rt {
 	enum class FrameBufferStatus {
@@ -39,11 +40,19 @@ namespace rt {
 		using Attachment = FrameBufferAttachment;
 		
 		static GLuint CurrentReadId() {
+			GLuint known = StateCache::get().currentReadFramebuffer();
+			if (known != StateCache::Unknown) {
+				return known;
+			}
 			GLint value = 0;
 			glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &value);
 			return value;
 		}
 		static GLuint CurrentDrawId() {
+			GLuint known = StateCache::get().currentDrawFramebuffer();
+			if (known != StateCache::Unknown) {
+				return known;
+			}
 			GLint value = 0;
 			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &value);
 			return value;
@@ -66,6 +75,7 @@ namespace rt {
 		}
 		~FrameBuffer() {
 			if (isValid()) {
+				StateCache::get().forgetFramebuffer(id);
 				glDeleteFramebuffers(1, &id); 
 				checkError();
 				id = 0;
@@ -142,32 +152,44 @@ namespace rt {
 
 		void bind() {
 			assert(isValid());
-			glBindFramebuffer(GL_FRAMEBUFFER, id); 
-			checkError();
+			if (StateCache::get().bindFramebuffer(GL_FRAMEBUFFER, id)) {
+				glBindFramebuffer(GL_FRAMEBUFFER, id);
+				checkError();
+			}
 		}
 		void unbind() {
-			glBindFramebuffer(GL_FRAMEBUFFER, 0); 
-			checkError();
+			if (StateCache::get().bindFramebuffer(GL_FRAMEBUFFER, 0)) {
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				checkError();
+			}
 		}
 
 		void bindRead() {
 			assert(isValid());
-			glBindFramebuffer(GL_READ_FRAMEBUFFER, id); 
-			checkError();
+			if (StateCache::get().bindFramebuffer(GL_READ_FRAMEBUFFER, id)) {
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, id);
+				checkError();
+			}
 		}
 		void unbindRead() {
-			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0); 
-			checkError();
+			if (StateCache::get().bindFramebuffer(GL_READ_FRAMEBUFFER, 0)) {
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+				checkError();
+			}
 		}
 
 		void bindDraw() {
 			assert(isValid());
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, id); 
-			checkError();
+			if (StateCache::get().bindFramebuffer(GL_DRAW_FRAMEBUFFER, id)) {
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, id);
+				checkError();
+			}
 		}
 		void unbindDraw() {
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); 
-			checkError();
+			if (StateCache::get().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0)) {
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+				checkError();
+			}
 		}
 
 		GLuint getId() const {
@@ -176,6 +198,7 @@ namespace rt {
 
 		void reset() {
 			if (isValid()) {
+				StateCache::get().forgetFramebuffer(id);
 				glDeleteFramebuffers(1, &id); checkError();
 			}
 			glCreateFramebuffers(1, &id); checkError();
@@ -1,6 +1,17 @@
 #pragma once
 #include "Core.hpp"
 #include <fmt/core.h>
+#include <stdexcept>
+#include <vector>
+
+// Call site of the caller, when used as a default argument. The same builtins are used by std::source_location.
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1926)
+#define RT_CALLER_FILE __builtin_FILE()
+#define RT_CALLER_LINE __builtin_LINE()
+#else
+#define RT_CALLER_FILE ""
+#define RT_CALLER_LINE 0
+#endif
 
 namespace rt {
 	namespace intern {
@@ -44,13 +55,150 @@ namespace rt {
 		return getErrorString(glGetError());
 	}
 
-	static void checkError() {
-#ifdef RENDER_TOOLS_ERROR_CHECKS
+#if defined(RENDER_TOOLS_DEFERRED_ERROR_CHECKS)
+	/*
+	Deferred error checking, enabled by defining RENDER_TOOLS_DEFERRED_ERROR_CHECKS. It takes precedence over RENDER_TOOLS_ERROR_CHECKS.
+	Instead of calling glGetError after every call, checkError only records where it was called from in a ring buffer.
+	glGetError is called by checkErrors, for example at the end of a frame or by an ErrorScope, or every N recorded calls if an interval is set.
+	The calls are not recorded, so an error that already happened can not be pinned to one of them. Instead, when an error shows up,
+	the calls since the last check are reported as suspects and the window for the next occurrence is halved.
+	An error that happens every frame is narrowed down to a single call within a few frames.
+	Errors are never thrown, checks print the suspects to stderr, return false and keep them for getSuspects.
+	*/
+	class DeferredErrors {
+	public:
+		static constexpr uint32_t RingSize = 256;
+
+		struct Tag {
+			const char* file;
+			uint32_t line;
+		};
+
+		// The tracker of the calling thread.
+		static DeferredErrors& get() {
+			thread_local DeferredErrors errors;
+			return errors;
+		}
+
+		void record(const char* file, uint32_t line) {
+			ring[head % RingSize] = Tag{ file, line };
+			++head;
+			++pending;
+			if (current != 0 && pending >= current) {
+				check();
+			}
+		}
+
+		// Calls glGetError once. Returns true if there was no error.
+		bool check() {
+			uint32_t code = glGetError();
+			uint64_t suspects = pending;
+			pending = 0;
+
+			if (code == GL_NO_ERROR) {
+				return true;
+			}
+			// Errors are sticky until read, drain any others so they don't get blamed on later calls.
+			while (glGetError() != GL_NO_ERROR) {}
+
+			lastError = code;
+			suspectTags.clear();
+			uint64_t shown = suspects < RingSize ? suspects : RingSize;
+			for (uint64_t i = 0; i < shown; ++i) {
+				suspectTags.push_back(ring[(head - shown + i) % RingSize]);
+			}
+
+			if (suspects == 0) {
+				fmt::print(stderr, "OpenGL error encountered!\n{} outside of any checked call\n", getErrorString(code));
+			}
+			else if (suspects == 1) {
+				fmt::print(stderr, "OpenGL error encountered!\n{} at {}:{}\n", getErrorString(code), suspectTags[0].file, suspectTags[0].line);
+				current = interval;
+			}
+			else {
+				fmt::print(stderr, "OpenGL error encountered!\n{} in one of the last {} calls:\n", getErrorString(code), suspects);
+				for (const Tag& tag : suspectTags) {
+					fmt::print(stderr, "\t{}:{}\n", tag.file, tag.line);
+				}
+				// The next occurrence is checked for in a window half the size.
+				current = static_cast<uint32_t>(suspects / 2);
+			}
+			return false;
+		}
+
+		// The calls the last error was blamed on, oldest first, at most RingSize of them. A single one once the window is narrowed down.
+		const std::vector<Tag>& getSuspects() const noexcept {
+			return suspectTags;
+		}
+		// The code of the last error, or GL_NO_ERROR if there was none yet.
+		uint32_t getLastError() const noexcept {
+			return lastError;
+		}
+
+		// Check every interval recorded calls, 0 to only check when asked to.
+		void setCheckInterval(uint32_t calls) noexcept {
+			interval = calls;
+			current = calls;
+		}
+		uint32_t getCheckInterval() const noexcept {
+			return interval;
+		}
+	private:
+		DeferredErrors()
+			: ring()
+			, head(0)
+			, pending(0)
+			, interval(0)
+			, current(0)
+			, lastError(GL_NO_ERROR)
+			, suspectTags()
+		{}
+
+		std::array<Tag, RingSize> ring;
+		uint64_t head, pending;
+		uint32_t interval, current;
+		uint32_t lastError;
+		std::vector<Tag> suspectTags;
+	};
+#endif
+
+	// The default arguments pick up the location of the caller, which deferred error checks use to report where an error happened.
+	static void checkError(const char* file = RT_CALLER_FILE, uint32_t line = RT_CALLER_LINE) {
+#if defined(RENDER_TOOLS_DEFERRED_ERROR_CHECKS)
+		DeferredErrors::get().record(file, line);
+#elif defined(RENDER_TOOLS_ERROR_CHECKS)
+		(void)file;
+		(void)line;
 		uint32_t code = glGetError();
 		if (code != GL_NO_ERROR) {
 			fmt::print(stderr, "OpenGL error encountered!\n{}\n", getErrorString(code));
-			throw std::exception(getErrorString(code).data());
+			throw std::runtime_error(getErrorString(code).data());
 		}
+#else
+		(void)file;
+		(void)line;
 #endif
 	}
+
+	// Check for any errors in the calls since the last check. Only does something with deferred error checks.
+	// Returns true if there was no error.
+	static bool checkErrors() {
+#if defined(RENDER_TOOLS_DEFERRED_ERROR_CHECKS)
+		return DeferredErrors::get().check();
+#else
+		return true;
+#endif
+	}
+
+	// Checks for deferred errors when it goes out of scope, any are reported like by checkErrors.
+	class ErrorScope {
+	public:
+		ErrorScope() = default;
+		~ErrorScope() {
+			checkErrors();
+		}
+
+		ErrorScope(const ErrorScope&) = delete;
+		ErrorScope& operator=(const ErrorScope&) = delete;
+	};
 }
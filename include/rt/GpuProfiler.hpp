@@ -0,0 +1,354 @@
+#pragma once
+#include "Core.hpp"
+#include <vector>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <fmt/core.h>
+
+namespace rt {
+	// Timing statistics of one named scope over the recorded history, in milliseconds.
+	struct GpuScopeStats {
+		double min, avg, p99;
+		size_t count;
+	};
+
+	// A single completed scope, with times in nanoseconds on the GPU clock.
+	struct GpuTraceEvent {
+		std::string name;
+		uint64_t start, duration;
+		uint64_t frame;
+		uint32_t depth;
+	};
+
+	/*
+	Measures GPU time of nested scopes with GL_TIMESTAMP queries, written at the start and end of each scope.
+	Queries are pooled per frame in a ring of frameLatency frames, and results are only read back once they are available,
+	so the profiler never waits on the GPU. A frame that is still not done when its slot comes around again is dropped.
+	Timestamps are used rather than GL_TIME_ELAPSED, since elapsed time queries cannot be nested.
+	*/
+	class GpuProfiler {
+	public:
+		GpuProfiler(uint32_t frameLatency = 4, size_t historyFrames = 240)
+			: frames(frameLatency)
+			, history()
+			, events()
+			, stack()
+			, stats()
+			, current(0)
+			, frameCount(0)
+			, historySize(historyFrames)
+			, baseTime(0)
+			, dropped(0)
+			, inFrame(false)
+		{
+			assert(frameLatency > 0);
+		}
+		~GpuProfiler() {
+			deleteQueries();
+		}
+
+		GpuProfiler(GpuProfiler&&) noexcept = default;
+		GpuProfiler& operator=(GpuProfiler&& other) noexcept {
+			if (this == &other) {
+				return *this;
+			}
+			deleteQueries();
+
+			frames = std::move(other.frames);
+			history = std::move(other.history);
+			events = std::move(other.events);
+			stack = std::move(other.stack);
+			stats = std::move(other.stats);
+			current = other.current;
+			frameCount = other.frameCount;
+			historySize = other.historySize;
+			baseTime = other.baseTime;
+			dropped = other.dropped;
+			inFrame = other.inFrame;
+
+			// The queries belong to this profiler now.
+			other.frames.clear();
+			other.inFrame = false;
+			return *this;
+		}
+
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+		// Start recording a frame. Collects the results of any earlier frames that the GPU has finished.
+		void beginFrame() {
+			assert(!inFrame && "rt::GpuProfiler::beginFrame called twice without endFrame!");
+			collect();
+
+			current = static_cast<uint32_t>(frameCount % frames.size());
+			Frame& frame = frames[current];
+			if (frame.pending) {
+				// The GPU is more than frameLatency frames behind, give up on this one instead of waiting.
+				frame.pending = false;
+				++dropped;
+			}
+			frame.scopes.clear();
+			frame.used = 0;
+			frame.index = frameCount;
+			stack.clear();
+			inFrame = true;
+		}
+
+		void endFrame() {
+			assert(inFrame && "rt::GpuProfiler::endFrame called without beginFrame!");
+			assert(stack.empty() && "Not all rt::GpuProfiler scopes were closed before the end of the frame!");
+			frames[current].pending = !frames[current].scopes.empty();
+			++frameCount;
+			inFrame = false;
+		}
+
+		// Open a scope, prefer GpuScope which closes it automatically.
+		void push(std::string_view name) {
+			assert(inFrame && "rt::GpuProfiler scopes must be inside of beginFrame and endFrame!");
+			Frame& frame = frames[current];
+
+			ScopeRecord record;
+			record.name = std::string{ name };
+			record.depth = static_cast<uint32_t>(stack.size());
+			record.begin = timestamp(frame);
+			record.end = 0;
+
+			stack.push_back(frame.scopes.size());
+			frame.scopes.push_back(std::move(record));
+		}
+
+		void pop() {
+			assert(!stack.empty() && "rt::GpuProfiler::pop called without a matching push!");
+			Frame& frame = frames[current];
+			frame.scopes[stack.back()].end = timestamp(frame);
+			stack.pop_back();
+		}
+
+		// Read back every finished frame. Called by beginFrame, only needed to get results without starting a new frame.
+		void collect() {
+			for (size_t i = 0; i < frames.size(); ++i) {
+				// Oldest first, so events stay in order.
+				Frame& frame = frames[(frameCount + i) % frames.size()];
+				if (!frame.pending) {
+					continue;
+				}
+
+				// Queries finish in order, so if the last one is available all of them are.
+				GLint available = GL_FALSE;
+				glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+				checkError();
+				if (available != GL_TRUE) {
+					continue;
+				}
+				read(frame);
+				frame.pending = false;
+			}
+		}
+
+		// Statistics ---
+		GpuScopeStats getStats(std::string_view name) const {
+			auto it = stats.find(std::string{ name });
+			if (it == stats.end() || it->second.empty()) {
+				return GpuScopeStats{ 0.0, 0.0, 0.0, 0 };
+			}
+			return summarize(it->second);
+		}
+
+		// The name of every scope seen in the recorded history.
+		std::vector<std::string> getScopeNames() const {
+			std::vector<std::string> names;
+			names.reserve(stats.size());
+			for (const auto& [name, samples] : stats) {
+				names.push_back(name);
+			}
+			std::sort(names.begin(), names.end());
+			return names;
+		}
+
+		// The completed scopes of the last historyFrames frames, oldest first.
+		const std::deque<GpuTraceEvent>& getEvents() const noexcept {
+			return events;
+		}
+
+		// Frames dropped because the GPU did not finish them in time.
+		uint64_t droppedFrames() const noexcept {
+			return dropped;
+		}
+
+		void clear() {
+			events.clear();
+			history.clear();
+			stats.clear();
+			dropped = 0;
+		}
+
+		/*
+		Write the recorded history as a Chrome trace, which can be opened in chrome://tracing or Perfetto.
+		The min, avg and p99 of every scope are written under "scopeStats". Returns false if the file could not be written.
+		*/
+		bool writeChromeTrace(const std::filesystem::path& path) const {
+			std::ofstream file(path, std::ios::trunc);
+			if (!file) {
+				return false;
+			}
+
+			file << "{\"traceEvents\":[\n";
+			bool first = true;
+			for (const GpuTraceEvent& event : events) {
+				file << (first ? "" : ",\n");
+				file << fmt::format("{{\"name\":\"{}\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"frame\":{}}}}}",
+					escape(event.name), (event.start - baseTime) / 1000.0, event.duration / 1000.0, event.frame);
+				first = false;
+			}
+			file << "\n],\n\"displayTimeUnit\":\"ms\",\n\"scopeStats\":{\n";
+
+			first = true;
+			for (const std::string& name : getScopeNames()) {
+				GpuScopeStats scope = getStats(name);
+				file << (first ? "" : ",\n");
+				file << fmt::format("\"{}\":{{\"min_ms\":{:.4f},\"avg_ms\":{:.4f},\"p99_ms\":{:.4f},\"count\":{}}}",
+					escape(name), scope.min, scope.avg, scope.p99, scope.count);
+				first = false;
+			}
+			file << "\n}}\n";
+
+			return file.good();
+		}
+	private:
+		struct ScopeRecord {
+			std::string name;
+			uint32_t depth;
+			uint32_t begin, end;
+		};
+
+		struct Frame {
+			std::vector<GLuint> queries;
+			std::vector<ScopeRecord> scopes;
+			uint64_t index = 0;
+			uint32_t used = 0;
+			bool pending = false;
+		};
+
+		uint32_t timestamp(Frame& frame) {
+			if (frame.used == frame.queries.size()) {
+				size_t grow = std::max<size_t>(frame.queries.size(), 16);
+				frame.queries.resize(frame.queries.size() + grow);
+				glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(grow), frame.queries.data() + frame.used);
+				checkError();
+			}
+			uint32_t index = frame.used++;
+			glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+			checkError();
+			return index;
+		}
+
+		void read(const Frame& frame) {
+			std::vector<GLuint64> times(frame.used);
+			for (uint32_t i = 0; i < frame.used; ++i) {
+				glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &times[i]);
+			}
+			checkError();
+
+			if (baseTime == 0 && !times.empty()) {
+				baseTime = times[0];
+			}
+
+			for (const ScopeRecord& scope : frame.scopes) {
+				uint64_t start = times[scope.begin];
+				uint64_t duration = times[scope.end] >= start ? times[scope.end] - start : 0;
+				events.push_back(GpuTraceEvent{ scope.name, start, duration, frame.index, scope.depth });
+				stats[scope.name].push_back(duration);
+			}
+			history.push_back(frame.scopes.size());
+
+			// Keep only the last historySize frames.
+			while (history.size() > historySize) {
+				for (size_t i = 0; i < history.front(); ++i) {
+					std::deque<uint64_t>& samples = stats[events.front().name];
+					samples.pop_front();
+					if (samples.empty()) {
+						stats.erase(events.front().name);
+					}
+					events.pop_front();
+				}
+				history.pop_front();
+			}
+		}
+
+		static GpuScopeStats summarize(const std::deque<uint64_t>& samples) {
+			std::vector<uint64_t> sorted(samples.begin(), samples.end());
+			std::sort(sorted.begin(), sorted.end());
+
+			double total = 0.0;
+			for (uint64_t sample : sorted) {
+				total += static_cast<double>(sample);
+			}
+			size_t p99 = std::min(sorted.size() - 1, (sorted.size() * 99) / 100);
+
+			return GpuScopeStats{
+				sorted.front() / 1e6,
+				total / static_cast<double>(sorted.size()) / 1e6,
+				sorted[p99] / 1e6,
+				sorted.size()
+			};
+		}
+
+		static std::string escape(std::string_view text) {
+			std::string result;
+			result.reserve(text.size());
+			for (char c : text) {
+				if (c == '"' || c == '\\') {
+					result.push_back('\\');
+				}
+				result.push_back(c);
+			}
+			return result;
+		}
+
+		void deleteQueries() {
+			for (Frame& frame : frames) {
+				if (!frame.queries.empty()) {
+					glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+					checkError();
+				}
+			}
+			frames.clear();
+		}
+
+		std::vector<Frame> frames;
+		// The number of events each recorded frame added, oldest first.
+		std::deque<size_t> history;
+		std::deque<GpuTraceEvent> events;
+		std::vector<size_t> stack;
+		std::unordered_map<std::string, std::deque<uint64_t>> stats;
+
+		uint32_t current;
+		uint64_t frameCount;
+		size_t historySize;
+		uint64_t baseTime;
+		uint64_t dropped;
+		bool inFrame;
+	};
+
+	// Measures the GPU time of everything issued during its lifetime.
+	class GpuScope {
+	public:
+		GpuScope(GpuProfiler& prof, std::string_view name)
+			: profiler(prof)
+		{
+			profiler.push(name);
+		}
+		~GpuScope() {
+			profiler.pop();
+		}
+
+		GpuScope(const GpuScope&) = delete;
+		GpuScope& operator=(const GpuScope&) = delete;
+	private:
+		GpuProfiler& profiler;
+	};
+}
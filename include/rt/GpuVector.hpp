@@ -0,0 +1,301 @@
+#pragma once
+#include "Core.hpp"
+#include "Buffer.hpp"
+#include "VertexArray.hpp"
+#include <vector>
+#include <initializer_list>
+#include <type_traits>
+
+namespace rt {
+	/*
+	A std::vector like container whose elements also live in a buffer.
+	Changes are made to a CPU copy and remembered as dirty ranges, sync uploads all of them at once.
+	Ranges close enough together are uploaded as one, a few ranges go through subArray, and many of them through a single
+	explicitly flushed map. The GPU storage grows like MutableBuffer, so it reallocates about as often as the CPU copy does.
+	Non const element access counts as a write, and positions are indices rather than iterators.
+	*/
+	template<typename T>
+	class GpuVector {
+	public:
+		static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::GpuVector is not trivially copyable!");
+
+		using value_type = T;
+		using const_iterator = typename std::vector<T>::const_iterator;
+
+		GpuVector(MutableType type = MutableType::DynamicDraw, float growthFactor = 2.f)
+			: elements()
+			, buffer(type, growthFactor)
+			, dirty()
+			, uploads(0)
+			, uploadedBytes(0)
+		{}
+		GpuVector(std::initializer_list<T> values, MutableType type = MutableType::DynamicDraw)
+			: GpuVector(type)
+		{
+			assign(values.begin(), values.end());
+		}
+
+		GpuVector(GpuVector&&) noexcept = default;
+		GpuVector& operator=(GpuVector&&) noexcept = default;
+
+		GpuVector(const GpuVector&) = delete;
+		GpuVector& operator=(const GpuVector&) = delete;
+
+		// Element access ---
+
+		T& operator[](size_t index) {
+			assert(index < elements.size());
+			markDirty(index, index + 1);
+			return elements[index];
+		}
+		const T& operator[](size_t index) const {
+			assert(index < elements.size());
+			return elements[index];
+		}
+
+		void set(size_t index, const T& value) {
+			assert(index < elements.size());
+			elements[index] = value;
+			markDirty(index, index + 1);
+		}
+		// Pointer for writing count elements starting at index, which are marked as written.
+		T* writable(size_t index, size_t count) {
+			assert(index + count <= elements.size());
+			markDirty(index, index + count);
+			return elements.data() + index;
+		}
+
+		const T& front() const {
+			return elements.front();
+		}
+		const T& back() const {
+			return elements.back();
+		}
+		const T* data() const noexcept {
+			return elements.data();
+		}
+		const_iterator begin() const noexcept {
+			return elements.begin();
+		}
+		const_iterator end() const noexcept {
+			return elements.end();
+		}
+
+		// Modifiers ---
+
+		void push_back(const T& value) {
+			elements.push_back(value);
+			markDirty(elements.size() - 1, elements.size());
+		}
+		template<typename... Args>
+		T& emplace_back(Args&&... args) {
+			elements.emplace_back(std::forward<Args>(args)...);
+			markDirty(elements.size() - 1, elements.size());
+			return elements.back();
+		}
+		void pop_back() {
+			assert(!elements.empty());
+			elements.pop_back();
+		}
+
+		// Inserts before index, every element from there on moves and is uploaded again.
+		void insert(size_t index, const T& value) {
+			insert(index, &value, 1);
+		}
+		void insert(size_t index, const T* values, size_t count) {
+			assert(index <= elements.size());
+			elements.insert(elements.begin() + index, values, values + count);
+			markDirty(index, elements.size());
+		}
+		void insert(size_t index, std::initializer_list<T> values) {
+			insert(index, values.begin(), values.size());
+		}
+
+		void erase(size_t index, size_t count = 1) {
+			assert(index + count <= elements.size());
+			elements.erase(elements.begin() + index, elements.begin() + index + count);
+			markDirty(index, elements.size());
+		}
+
+		void assign(const T* values, size_t count) {
+			elements.assign(values, values + count);
+			dirty.clear();
+			markDirty(0, elements.size());
+		}
+		template<typename It>
+		void assign(It first, It last) {
+			elements.assign(first, last);
+			dirty.clear();
+			markDirty(0, elements.size());
+		}
+		void assign(const std::vector<T>& values) {
+			assign(values.data(), values.size());
+		}
+		void assign(size_t count, const T& value) {
+			elements.assign(count, value);
+			dirty.clear();
+			markDirty(0, elements.size());
+		}
+
+		void resize(size_t count, const T& value = T{}) {
+			size_t old = elements.size();
+			elements.resize(count, value);
+			markDirty(old, elements.size());
+		}
+		void clear() noexcept {
+			elements.clear();
+			dirty.clear();
+		}
+
+		// Reserves room for count elements on both the CPU and the GPU.
+		void reserve(size_t count) {
+			elements.reserve(count);
+			buffer.reserve(count * sizeof(T));
+		}
+		void shrinkToFit() {
+			sync();
+			elements.shrink_to_fit();
+			buffer.shrinkToFit();
+		}
+
+		// Uploading ---
+
+		// Uploads every change since the last sync. Returns the number of separate uploads it took.
+		size_t sync() {
+			size_t bytes = elements.size() * sizeof(T);
+			size_t issued = 0;
+			if (bytes > buffer.capacityBytes()) {
+				// The storage has to be replaced anyway, so everything goes up with it.
+				buffer.resizeArray(elements.data(), elements.size());
+				issued = bytes > 0 ? 1 : 0;
+				uploadedBytes += bytes;
+			}
+			else {
+				buffer.resizeArray(bytes);
+				issued = upload();
+			}
+			dirty.clear();
+			uploads += issued;
+			return issued;
+		}
+
+		// Binding, these sync first ---
+
+		void bindSSBO(GLuint index) {
+			sync();
+			if (elements.empty()) {
+				buffer.bindSSBO(index);
+			}
+			else {
+				buffer.bindSSBO(index, 0, sizeBytes());
+			}
+		}
+		void bindUBO(GLuint index) {
+			sync();
+			if (elements.empty()) {
+				buffer.bindUBO(index);
+			}
+			else {
+				buffer.bindUBO(index, 0, sizeBytes());
+			}
+		}
+		void bindVertex(VertexArray& vao, GLuint index, GLsizei stride = sizeof(T)) {
+			sync();
+			vao.bindVertex(buffer, index, 0, stride);
+		}
+		void bindIndex(VertexArray& vao) {
+			sync();
+			vao.bindIndex(buffer);
+		}
+
+		// Getters ---
+
+		size_t size() const noexcept {
+			return elements.size();
+		}
+		size_t capacity() const noexcept {
+			return elements.capacity();
+		}
+		bool empty() const noexcept {
+			return elements.empty();
+		}
+		size_t sizeBytes() const noexcept {
+			return elements.size() * sizeof(T);
+		}
+		bool isDirty() const noexcept {
+			return !dirty.empty() || buffer.sizeBytes() != sizeBytes();
+		}
+		const DirtyRanges& getDirty() const noexcept {
+			return dirty;
+		}
+
+		// The buffer is only up to date after sync.
+		const MutableBuffer& getBuffer() const noexcept {
+			return buffer;
+		}
+		MutableBuffer& getBuffer() noexcept {
+			return buffer;
+		}
+
+		// Totals over every sync so far.
+		size_t numUploads() const noexcept {
+			return uploads;
+		}
+		size_t numUploadedBytes() const noexcept {
+			return uploadedBytes;
+		}
+	private:
+		// Clean gaps up to this size are uploaded along with the ranges around them, one larger upload is cheaper than two calls.
+		static constexpr size_t CoalesceBytes = 256;
+		// Past this many ranges, they are written through one map instead of a subArray each.
+		static constexpr size_t MapThreshold = 8;
+
+		void markDirty(size_t begin, size_t end) {
+			dirty.add(begin, end);
+		}
+
+		size_t upload() {
+			std::vector<DirtyRanges::Range> ranges;
+			size_t gap = std::max<size_t>(1, CoalesceBytes / sizeof(T));
+			dirty.forEach([&](const DirtyRanges::Range& range) {
+				size_t end = std::min(range.end, elements.size());
+				if (range.begin >= end) {
+					return;
+				}
+				if (!ranges.empty() && range.begin - ranges.back().end <= gap) {
+					ranges.back().end = end;
+				}
+				else {
+					ranges.push_back(DirtyRanges::Range{ range.begin, end });
+				}
+			});
+			if (ranges.empty()) {
+				return 0;
+			}
+
+			if (ranges.size() <= MapThreshold) {
+				for (const DirtyRanges::Range& range : ranges) {
+					buffer.subArray(elements.data() + range.begin, range.size(), intptr_t(range.begin * sizeof(T)));
+					uploadedBytes += range.size() * sizeof(T);
+				}
+				return ranges.size();
+			}
+
+			size_t first = ranges.front().begin;
+			size_t count = ranges.back().end - first;
+			// No invalidation, the clean elements between the ranges are mapped too and have to survive.
+			MappedRange<T> mapped{ buffer, intptr_t(first), count, Buffer::Flag::Write | Buffer::Flag::FlushExplicit };
+			for (const DirtyRanges::Range& range : ranges) {
+				mapped.write(range.begin - first, elements.data() + range.begin, range.size());
+				uploadedBytes += range.size() * sizeof(T);
+			}
+			mapped.unmap();
+			return 1;
+		}
+
+		std::vector<T> elements;
+		MutableBuffer buffer;
+		DirtyRanges dirty;
+		size_t uploads, uploadedBytes;
+	};
+}
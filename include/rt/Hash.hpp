@@ -0,0 +1,46 @@
+#pragma once
+#include <string_view>
+#include <cinttypes>
+
+namespace rt {
+	constexpr uint64_t FnvOffsetBasis = 14695981039346656037ull;
+
+	// 64 bit FNV-1a, usable at compile time. Pass a previous result as the seed to hash several strings as one.
+	constexpr uint64_t fnv1a(std::string_view str, uint64_t hash = FnvOffsetBasis) noexcept {
+		for (char c : str) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	/*
+	Precomputed hash of a resource name, used as the key for program reflection lookups.
+	Declare the hashes of names that are used every frame as constexpr, so no hashing happens at runtime:
+		constexpr rt::NameHash ModelName{ "model" };
+	*/
+	struct NameHash {
+		constexpr explicit NameHash(std::string_view name) noexcept
+			: value(fnv1a(name))
+		{}
+
+		constexpr bool operator==(const NameHash& other) const noexcept {
+			return value == other.value;
+		}
+		constexpr bool operator!=(const NameHash& other) const noexcept {
+			return value != other.value;
+		}
+
+		uint64_t value;
+	};
+
+	constexpr NameHash hashName(std::string_view name) noexcept {
+		return NameHash{ name };
+	}
+
+	namespace literals {
+		constexpr NameHash operator""_name(const char* str, size_t length) noexcept {
+			return NameHash{ std::string_view{ str, length } };
+		}
+	}
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "Core.hpp"
+#include "Buffer.hpp"
+#include "VertexArray.hpp"
+#include <type_traits>
+
+namespace rt {
+	// Matches the layout opengl expects for glDrawArraysIndirect and glMultiDrawArraysIndirect.
+	struct DrawArraysIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	// Matches the layout opengl expects for glDrawElementsIndirect and glMultiDrawElementsIndirect.
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	/*
+	Builds a list of indirect draw commands directly into a persistently mapped stream buffer,
+	then submits the whole list with a single multi draw call.
+	Each begin() reserves space for the maximum number of commands, so any number of lists can be built per frame,
+	as long as a region of the underlying ring can hold them.
+	*/
+	template<typename Command>
+	class IndirectCommandList {
+	public:
+		static_assert(std::is_same_v<Command, DrawArraysIndirectCommand> || std::is_same_v<Command, DrawElementsIndirectCommand>,
+			"rt::IndirectCommandList only supports DrawArraysIndirectCommand and DrawElementsIndirectCommand!");
+
+		// maxCommands is the largest number of commands a single list can hold.
+		// The ring holds listsPerRegion lists per region, across regionCount regions.
+		IndirectCommandList(uint32_t maxCommands, uint32_t regionCount = 3, uint32_t listsPerRegion = 1)
+			: ring(static_cast<size_t>(maxCommands) * sizeof(Command) * listsPerRegion, regionCount)
+			, current{ nullptr, 0, 0 }
+			, capacity(maxCommands)
+			, count(0)
+		{
+			assert(maxCommands > 0);
+			assert(listsPerRegion > 0);
+		}
+
+		IndirectCommandList(IndirectCommandList&&) noexcept = default;
+		IndirectCommandList& operator=(IndirectCommandList&&) noexcept = default;
+
+		IndirectCommandList(const IndirectCommandList&) = delete;
+		IndirectCommandList& operator=(const IndirectCommandList&) = delete;
+
+		// Start a new list, any commands added since the last begin are discarded.
+		void begin() {
+			current = ring.allocate<Command>(capacity, 16);
+			assert(current.isValid());
+			count = 0;
+		}
+
+		void add(const Command& cmd) {
+			assert(current.isValid() && "Call rt::IndirectCommandList::begin before adding commands!");
+			assert(count < capacity && "Too many commands added to the indirect draw list!");
+			current.as<Command>()[count] = cmd;
+			++count;
+		}
+
+		template<typename C = Command, typename = std::enable_if_t<std::is_same_v<C, DrawElementsIndirectCommand>>>
+		void add(GLuint elemCount, GLuint instanceCount = 1, GLuint firstIndex = 0, GLint baseVertex = 0, GLuint baseInstance = 0) {
+			add(DrawElementsIndirectCommand{ elemCount, instanceCount, firstIndex, baseVertex, baseInstance });
+		}
+
+		template<typename C = Command, typename = std::enable_if_t<std::is_same_v<C, DrawArraysIndirectCommand>>>
+		void add(GLuint elemCount, GLuint instanceCount = 1, GLuint first = 0, GLuint baseInstance = 0) {
+			add(DrawArraysIndirectCommand{ elemCount, instanceCount, first, baseInstance });
+		}
+
+		// Draw every command added since begin, using the vertex array's bindings. The vertex array must be bound.
+		template<typename C = Command, typename = std::enable_if_t<std::is_same_v<C, DrawElementsIndirectCommand>>>
+		void submit(VertexArray& vao, Primitive prim, Index index) {
+			if (count == 0) {
+				return;
+			}
+			prepare();
+			vao.multiDrawElementsIndirect(prim, index, ring.getBuffer(), static_cast<GLsizei>(count), current.offset);
+		}
+
+		template<typename C = Command, typename = std::enable_if_t<std::is_same_v<C, DrawArraysIndirectCommand>>>
+		void submit(VertexArray& vao, Primitive prim) {
+			if (count == 0) {
+				return;
+			}
+			prepare();
+			vao.multiDrawArraysIndirect(prim, ring.getBuffer(), static_cast<GLsizei>(count), current.offset);
+		}
+
+		// Draw the commands added since begin, with the actual draw count read from the parameters buffer on the GPU.
+		// The count is clamped to the number of commands in the list.
+		template<typename C = Command, typename = std::enable_if_t<std::is_same_v<C, DrawElementsIndirectCommand>>>
+		void submitCount(VertexArray& vao, Primitive prim, Index index, const Buffer& parameters, intptr_t paramOffset = 0) {
+			if (count == 0) {
+				return;
+			}
+			prepare();
+			vao.multiDrawElementsIndirectCount(prim, index, ring.getBuffer(), parameters, paramOffset, static_cast<GLsizei>(count), current.offset);
+		}
+
+		template<typename C = Command, typename = std::enable_if_t<std::is_same_v<C, DrawArraysIndirectCommand>>>
+		void submitCount(VertexArray& vao, Primitive prim, const Buffer& parameters, intptr_t paramOffset = 0) {
+			if (count == 0) {
+				return;
+			}
+			prepare();
+			vao.multiDrawArraysIndirectCount(prim, ring.getBuffer(), parameters, paramOffset, static_cast<GLsizei>(count), current.offset);
+		}
+
+		Command* data() noexcept {
+			return current.as<Command>();
+		}
+		const Command* data() const noexcept {
+			return current.as<Command>();
+		}
+
+		uint32_t size() const noexcept {
+			return count;
+		}
+		uint32_t maxSize() const noexcept {
+			return capacity;
+		}
+		bool empty() const noexcept {
+			return count == 0;
+		}
+
+		// Access to the ring, for the stall counters and for binding the commands as a shader storage buffer.
+		StreamRingBuffer& getStream() noexcept {
+			return ring;
+		}
+		const StreamRingBuffer& getStream() const noexcept {
+			return ring;
+		}
+		// The offset in bytes of the current list inside of the stream buffer.
+		intptr_t getOffset() const noexcept {
+			return current.offset;
+		}
+	private:
+		void prepare() {
+			if (!ring.coherent()) {
+				ring.flush(StreamAllocation{ current.data, current.offset, count * sizeof(Command) });
+			}
+		}
+
+		StreamRingBuffer ring;
+		StreamAllocation current;
+		uint32_t capacity, count;
+	};
+
+	using IndirectDrawList = IndirectCommandList<DrawElementsIndirectCommand>;
+	using IndirectArraysDrawList = IndirectCommandList<DrawArraysIndirectCommand>;
+}
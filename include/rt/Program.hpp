@@ -4,10 +4,14 @@
 #include <cassert>
 #include <string_view>
 #include <stdexcept>
+#include <vector>
 
 #include "Core.hpp"
+#include "StateCache.hpp"
 #include "Shader.hpp"
 #include "BindlessTexture.hpp"
+#include "UniformCache.hpp"
+#include "ProgramReflection.hpp"
 
 namespace rt {
 	enum class UniformType : GLenum {
@@ -133,6 +137,10 @@ namespace rt {
 class Program {
 public:
 	static GLuint CurrentId() {
+		GLuint known = StateCache::get().currentProgram();
+		if (known != StateCache::Unknown) {
+			return known;
+		}
 		GLint value = 0;
 		glGetIntegerv(GL_CURRENT_PROGRAM, &value);
 		checkError();
@@ -142,6 +150,9 @@ public:
 	Program(Shader & vertShader, Shader & fragShader) 
 		: id(0)
 		, bound(false)
+		, uniformCache()
+		, reflection()
+		, deferred(false)
 	{
 		id = glCreateProgram();
 		checkError();
@@ -152,12 +163,17 @@ public:
 	Program()
 		: id(0)
 		, bound(false)
+		, uniformCache()
+		, reflection()
+		, deferred(false)
 	{
 		id = glCreateProgram();
 		assert(isValid());
 	}
 	~Program() {
+		cancelDeferred();
 		if (id != 0) {
+			StateCache::get().forgetProgram(id);
 			glDeleteProgram(id);
 			checkError();
 			id = 0;
@@ -170,13 +186,21 @@ public:
 	Program(Program&& other) noexcept
 		: id(other.id)
 		, bound(other.bound)
+		, uniformCache(std::move(other.uniformCache))
+		, reflection(std::move(other.reflection))
+		, deferred(other.deferred)
 	{
+		if (deferred) {
+			StateCache::get().moveUniforms(&other, this);
+		}
 		other.id = 0;
 		other.bound = false;
+		other.deferred = false;
 	}
 
 	Program& operator=(Program&& other) noexcept {
 		if (isValid()) {
+			StateCache::get().forgetProgram(id);
 			glDeleteProgram(id);
 			checkError();
 
@@ -184,55 +208,104 @@ public:
 			checkError();
 		}
 
+		cancelDeferred();
+
 		id = other.id;
 		bound = other.bound;
+		uniformCache = std::move(other.uniformCache);
+		reflection = std::move(other.reflection);
+		deferred = other.deferred;
+		if (deferred) {
+			StateCache::get().moveUniforms(&other, this);
+		}
 
 		other.id = 0;
 		other.bound = false;
+		other.deferred = false;
 		return *this;
 	}
 
+	/*
+	Resource lookups ---
+	Once the program is linked these are answered from the reflection tables, without calling into opengl.
+	Names do not have to be null terminated. Each lookup has an overload taking a precomputed rt::NameHash,
+	which skips comparing the name and only finds names as reflected, so "arr" or "arr[0]" but not "arr[2]".
+	*/
 	GLint getInputLocation(std::string_view name) const {
-		// std::string_view and c-strings are not the same, so we have to check. This is opengl's fault. >:(
-		if (*(name.data() + name.length()) != '\0') {
-			throw std::invalid_argument("Argument 'name' for rt::Program::getSSBOIndex is not null terminated!");
+		if (!reflection.isBuilt()) {
+			return queryLocation(GL_PROGRAM_INPUT, name);
 		}
-		GLint tmp = glGetProgramResourceLocation(id, GL_PROGRAM_INPUT, name.data());
-		checkError();
-		return tmp;
+		const ProgramResource* res = reflection.findInput(name);
+		if (res == nullptr && !name.empty() && name.back() == ']') {
+			// Elements of arrays of matrices take several locations each, so leave the arithmetic to opengl.
+			return queryLocation(GL_PROGRAM_INPUT, name);
+		}
+		return res != nullptr ? res->location : -1;
 	}
+	GLint getInputLocation(NameHash name) const {
+		const ProgramResource* res = reflection.findInput(name);
+		return res != nullptr ? res->location : -1;
+	}
+
 	GLint getOutputLocation(std::string_view name) const {
-		if (*(name.data() + name.length()) != '\0') {
-			throw std::invalid_argument("Argument 'name' for rt::Program::getSSBOIndex is not null terminated!");
+		if (!reflection.isBuilt()) {
+			return queryLocation(GL_PROGRAM_OUTPUT, name);
 		}
-		GLint tmp = glGetProgramResourceLocation(id, GL_PROGRAM_OUTPUT, name.data());
-		checkError();
-		return tmp;
+		const ProgramResource* res = reflection.findOutput(name);
+		if (res == nullptr && !name.empty() && name.back() == ']') {
+			return queryLocation(GL_PROGRAM_OUTPUT, name);
+		}
+		return res != nullptr ? res->location : -1;
 	}
+	GLint getOutputLocation(NameHash name) const {
+		const ProgramResource* res = reflection.findOutput(name);
+		return res != nullptr ? res->location : -1;
+	}
+
 	GLint getUniformLocation(std::string_view name) const {
-		if (*(name.data() + name.length()) != '\0') {
-			throw std::invalid_argument("Argument 'name' for rt::Program::getSSBOIndex is not null terminated!");
+		if (!reflection.isBuilt()) {
+			return queryLocation(GL_UNIFORM, name);
 		}
-		GLint tmp = glGetProgramResourceLocation(id, GL_UNIFORM, name.data());
-		checkError();
-		return tmp;
+		const ProgramResource* res = reflection.findUniform(name);
+		return res != nullptr ? res->location : reflection.uniformElementLocation(name);
+	}
+	GLint getUniformLocation(NameHash name) const {
+		const ProgramResource* res = reflection.findUniform(name);
+		return res != nullptr ? res->location : -1;
 	}
 
 	GLint getUBOIndex(std::string_view name) const {
-		if (*(name.data() + name.length()) != '\0') {
-			throw std::invalid_argument("Argument 'name' for rt::Program::getSSBOIndex is not null terminated!");
+		if (!reflection.isBuilt()) {
+			return queryIndex(GL_UNIFORM_BLOCK, name);
 		}
-		GLint tmp = glGetProgramResourceIndex(id, GL_UNIFORM_BLOCK, name.data());
-		checkError();
-		return tmp;
+		const ProgramResource* res = reflection.findUBO(name);
+		return res != nullptr ? res->index : static_cast<GLint>(GL_INVALID_INDEX);
+	}
+	GLint getUBOIndex(NameHash name) const {
+		const ProgramResource* res = reflection.findUBO(name);
+		return res != nullptr ? res->index : static_cast<GLint>(GL_INVALID_INDEX);
 	}
+
 	GLint getSSBOIndex(std::string_view name) const {
-		if (*(name.data() + name.length()) != '\0') {
-			throw std::invalid_argument("Argument 'name' for rt::Program::getSSBOIndex is not null terminated!");
+		if (!reflection.isBuilt()) {
+			return queryIndex(GL_SHADER_STORAGE_BLOCK, name);
 		}
-		GLint tmp = glGetProgramResourceIndex(id, GL_SHADER_STORAGE_BLOCK, name.data());
-		checkError();
-		return tmp;
+		const ProgramResource* res = reflection.findSSBO(name);
+		return res != nullptr ? res->index : static_cast<GLint>(GL_INVALID_INDEX);
+	}
+	GLint getSSBOIndex(NameHash name) const {
+		const ProgramResource* res = reflection.findSSBO(name);
+		return res != nullptr ? res->index : static_cast<GLint>(GL_INVALID_INDEX);
+	}
+
+	// Full reflection data of the linked program, including types, array sizes and block offsets.
+	const ProgramReflection& getReflection() const noexcept {
+		return reflection;
+	}
+
+	// Rebuild the reflection tables, needed if the program was linked without going through compile.
+	void reflect() {
+		buildReflection();
 	}
 
 
@@ -257,28 +330,46 @@ public:
 	}
 
 	void uniform(GLint location, const GLfloat val) {
+		if (!cacheUniform(location, UniformType::Float, &val, 1)) {
+			return;
+		}
 		glProgramUniform1f(id, location, val);
 		checkError();
 	}
 	void uniform(GLint location, const GLfloat * vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::Float, vals, count)) {
+			return;
+		}
 		glProgramUniform1fv(id, location, count, vals);
 		checkError();
 	}
 
 	void uniform(GLint location, const GLuint vals) {
+		if (!cacheUniform(location, UniformType::UInt, &vals, 1)) {
+			return;
+		}
 		glProgramUniform1ui(id, location, vals);
 		checkError();
 	}
 	void uniform(GLint location, const GLuint * vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::UInt, vals, count)) {
+			return;
+		}
 		glProgramUniform1uiv(id, location, count, vals);
 		checkError();
 	}
 
 	void uniform(GLint location, const GLint vals) {
+		if (!cacheUniform(location, UniformType::Int, &vals, 1)) {
+			return;
+		}
 		glProgramUniform1i(id, location, vals);
 		checkError();
 	}
 	void uniform(GLint location, const GLint * vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::Int, vals, count)) {
+			return;
+		}
 		glProgramUniform1iv(id, location, count, vals);
 		checkError();
 	}
@@ -297,176 +388,333 @@ public:
 	}
 	
 	void uniformSampler(GLint location, const GLint vals) {
+		if (!cacheUniform(location, UniformType::Int, &vals, 1)) {
+			return;
+		}
 		glProgramUniform1i(id, location, vals);
 		checkError();
 	}
 	void uniformSampler(GLint location, const GLint * vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::Int, vals, count)) {
+			return;
+		}
 		glProgramUniform1iv(id, location, count, vals);
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::vec2& vals) {
+		if (!cacheUniform(location, UniformType::Vec2, &vals, 1)) {
+			return;
+		}
 		glProgramUniform2f(id, location, vals.x, vals.y);
 		checkError();
 	}
 	void uniform(GLint location, const glm::vec3& vals) {
+		if (!cacheUniform(location, UniformType::Vec3, &vals, 1)) {
+			return;
+		}
 		glProgramUniform3f(id, location, vals.x, vals.y, vals.z);
 		checkError();
 	}
 	void uniform(GLint location, const glm::vec4& vals) {
+		if (!cacheUniform(location, UniformType::Vec4, &vals, 1)) {
+			return;
+		}
 		glProgramUniform4f(id, location, vals.x, vals.y, vals.z, vals.w);
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::vec2* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::Vec2, vals, count)) {
+			return;
+		}
 		glProgramUniform2fv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::vec3* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::Vec3, vals, count)) {
+			return;
+		}
 		glProgramUniform3fv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::vec4* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::Vec4, vals, count)) {
+			return;
+		}
 		glProgramUniform4fv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
 
 	void uniform(GLint location, const glm::uvec2& vals) {
+		if (!cacheUniform(location, UniformType::UVec2, &vals, 1)) {
+			return;
+		}
 		glProgramUniform2ui(id, location, vals.x, vals.y);
 		checkError();
 	}
 	void uniform(GLint location, const glm::uvec3& vals) {
+		if (!cacheUniform(location, UniformType::UVec3, &vals, 1)) {
+			return;
+		}
 		glProgramUniform3ui(id, location, vals.x, vals.y, vals.z);
 		checkError();
 	}
 	void uniform(GLint location, const glm::uvec4& vals) {
+		if (!cacheUniform(location, UniformType::UVec4, &vals, 1)) {
+			return;
+		}
 		glProgramUniform4ui(id, location, vals.x, vals.y, vals.z, vals.w);
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::uvec2* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::UVec2, vals, count)) {
+			return;
+		}
 		glProgramUniform2uiv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::uvec3* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::UVec3, vals, count)) {
+			return;
+		}
 		glProgramUniform3uiv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::uvec4* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::UVec4, vals, count)) {
+			return;
+		}
 		glProgramUniform4uiv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
 
 	void uniform(GLint location, const glm::ivec2& vals) {
+		if (!cacheUniform(location, UniformType::IVec2, &vals, 1)) {
+			return;
+		}
 		glProgramUniform2i(id, location, vals.x, vals.y);
 		checkError();
 	}
 	void uniform(GLint location, const glm::ivec3& vals) {
+		if (!cacheUniform(location, UniformType::IVec3, &vals, 1)) {
+			return;
+		}
 		glProgramUniform3i(id, location, vals.x, vals.y, vals.z);
 		checkError();
 	}
 	void uniform(GLint location, const glm::ivec4& vals) {
+		if (!cacheUniform(location, UniformType::IVec4, &vals, 1)) {
+			return;
+		}
 		glProgramUniform4i(id, location, vals.x, vals.y, vals.z, vals.w);
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::ivec2* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::IVec2, vals, count)) {
+			return;
+		}
 		glProgramUniform2iv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::ivec3* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::IVec3, vals, count)) {
+			return;
+		}
 		glProgramUniform3iv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::ivec4* vals, GLsizei count) {
+		if (!cacheUniform(location, UniformType::IVec4, vals, count)) {
+			return;
+		}
 		glProgramUniform4iv(id, location, count, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::mat2x2& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat2, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix2fv(id, location, 1, transpose, glm::value_ptr(vals));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat2x3& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat2x3, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix2x3fv(id, location, 1, transpose, glm::value_ptr(vals));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat2x4& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat2x4, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix2x4fv(id, location, 1, transpose, glm::value_ptr(vals));
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::mat2x2* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat2, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix2fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat2x3* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat2x3, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix2x3fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat2x4* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat2x4, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix2x4fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
 
 	void uniform(GLint location, const glm::mat3x2& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat3x2, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix3x2fv(id, location, 1, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat3x3& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat3, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix3fv(id, location, 1, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat3x4& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat3x4, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix3x4fv(id, location, 1, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::mat3x2* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat3x2, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix3x2fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat3x3* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat3, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix3fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat3x4* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat3x4, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix3x4fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
 
 	void uniform(GLint location, const glm::mat4x2& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat4x2, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix4x2fv(id, location, 1, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat4x3& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat4x3, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix4x3fv(id, location, 1, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat4x4& vals, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat4, &vals, 1, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix4fv(id, location, 1, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
 	void uniform(GLint location, const glm::mat4x2* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat4x2, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix4x2fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat4x3* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat4x3, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix4x3fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 	void uniform(GLint location, const glm::mat4x4* vals, GLsizei count, bool transpose = false) {
+		if (!cacheUniform(location, UniformType::Mat4, vals, count, transpose)) {
+			return;
+		}
 		glProgramUniformMatrix4fv(id, location, count, transpose, glm::value_ptr(vals[0]));
 		checkError();
 	}
 
+	/*
+	Uniform caching ---
+	Cached mode skips uniform calls that would not change the value at that location.
+	Deferred mode also stages changed values, and sends them right before the next draw through rt::VertexArray,
+	or when the program is bound or flushed. Setting a value several times between draws then costs one call,
+	and elements of an array set one by one go out as a single array upload.
+	Draws made with opengl directly have to call flushUniforms first. Bindless handles are never cached.
+	*/
+	void setUniformMode(UniformMode mode) {
+		if (uniformCache.getMode() == UniformMode::Deferred && mode != UniformMode::Deferred) {
+			flushUniforms();
+		}
+		uniformCache.setMode(mode);
+	}
+	UniformMode getUniformMode() const noexcept {
+		return uniformCache.getMode();
+	}
+
+	// Send every staged uniform to opengl. Draws through rt::VertexArray do this for every program on their own.
+	void flushUniforms() {
+		cancelDeferred();
+		if (!uniformCache.hasPending()) {
+			return;
+		}
+		uniformCache.flush([this](GLint location, UniformType type, const void* data, GLsizei count, bool transpose) {
+			uploadUniform(location, type, data, count, transpose);
+		});
+	}
+
+	// Forget the cached uniform values, needed if uniforms were changed without going through this program.
+	void invalidateUniforms() {
+		cancelDeferred();
+		uniformCache.invalidate();
+	}
+
+	const UniformCache& getUniformCache() const noexcept {
+		return uniformCache;
+	}
+	UniformCache& getUniformCache() noexcept {
+		return uniformCache;
+	}
+
 	void attachShader(const Shader & shader) {
-		assert(shader.isCompiled());
+		// Shaders may still be compiling in the background, a failed compile shows up as a link failure.
+		assert(shader.isValid());
 		glAttachShader(id, shader.getId());
 		checkError();
 	}
@@ -515,13 +763,19 @@ public:
 
 	void bind() {
 		assert(isValid() && "There is no program! Compilation either failed or did not occur.");
-		glUseProgram(id);
-		checkError();
+		if (StateCache::get().useProgram(id)) {
+			glUseProgram(id);
+			checkError();
+		}
 		bound = true;
+
+		flushUniforms();
 	}
 	void unbind() {
-		glUseProgram(0);
-		checkError();
+		if (StateCache::get().useProgram(0)) {
+			glUseProgram(0);
+			checkError();
+		}
 		bound = false;
 	}
 
@@ -535,6 +789,7 @@ public:
 
 	void reset() {
 		if(isValid()) {
+			StateCache::get().forgetProgram(id);
 			glDeleteProgram(id);
 			checkError();
 			id = glCreateProgram();
@@ -545,6 +800,8 @@ public:
 			id = glCreateProgram();
 			checkError();
 		}
+		invalidateUniforms();
+		reflection.clear();
 	}
 
 	bool compile(Shader & vertShader, Shader & fragShader) {
@@ -577,10 +834,35 @@ public:
 	}
 
 	bool compile() {
+		submitLink();
+		return finishLink();
+	}
+
+	// Start linking without waiting for the result, see rt::CompileQueue.
+	// The attached shaders may still be compiling.
+	void submitLink() {
 		assert(!isLinked() && "Program was already linked!");
 
 		glLinkProgram(id);
+		checkError();
+		invalidateUniforms();
+		reflection.clear();
+	}
 
+	// Returns true once a submitted link has finished, successfully or not.
+	// Without parallel shader compile support this always returns true, and the status query will block instead.
+	bool isLinkComplete() const {
+		if (!parallelShaderCompileSupported()) {
+			return true;
+		}
+		GLint result = GL_TRUE;
+		glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &result);
+		checkError();
+		return result == GL_TRUE;
+	}
+
+	// Wait for a submitted link and report its result, printing the log on failure.
+	bool finishLink() {
 		if (!isLinked()) {
 
 			std::string log = getInfoLog();
@@ -594,10 +876,52 @@ public:
 			return false;
 		}
 		else {
+			buildReflection();
 			return true;
 		}
 	}
 
+	// Program binaries ---
+	// Must be set before linking, for drivers to keep the binary around for getBinary.
+	void setBinaryRetrievable(bool retrievable) {
+		glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, retrievable ? GL_TRUE : GL_FALSE);
+		checkError();
+	}
+
+	// Returns the driver specific binary of the linked program, and writes out its format. Empty if there is none.
+	std::vector<uint8_t> getBinary(GLenum& format) const {
+		std::vector<uint8_t> result;
+		GLint length = 0;
+		glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+		checkError();
+		if (length <= 0) {
+			return result;
+		}
+
+		result.resize(static_cast<size_t>(length));
+		GLsizei written = 0;
+		glGetProgramBinary(id, length, &written, &format, result.data());
+		checkError();
+
+		result.resize(static_cast<size_t>(written));
+		return result;
+	}
+
+	// Link the program from a binary previously returned by getBinary.
+	// Drivers are free to reject binaries, for example after an update, so the caller must be ready to compile from source.
+	bool loadBinary(GLenum format, const void* data, GLsizei length) {
+		glProgramBinary(id, format, data, length);
+		checkError();
+		invalidateUniforms();
+		reflection.clear();
+
+		if (!isLinked()) {
+			return false;
+		}
+		buildReflection();
+		return true;
+	}
+
 	GLuint getId() const {
 		return id;
 	}
@@ -608,8 +932,126 @@ public:
 		return result == GL_TRUE;
 	}
 protected:
+	// Opengl needs null terminated names, which std::string_view does not guarantee.
+	GLint queryLocation(GLenum interface, std::string_view name) const {
+		std::string terminated{ name };
+		GLint tmp = glGetProgramResourceLocation(id, interface, terminated.c_str());
+		checkError();
+		return tmp;
+	}
+	GLint queryIndex(GLenum interface, std::string_view name) const {
+		std::string terminated{ name };
+		GLint tmp = static_cast<GLint>(glGetProgramResourceIndex(id, interface, terminated.c_str()));
+		checkError();
+		return tmp;
+	}
+
+	template<typename T>
+	bool cacheUniform(GLint location, UniformType type, const T* vals, GLsizei count, bool transpose = false) {
+		bool send = uniformCache.update(location, type, vals, sizeof(T) * count, count, transpose);
+		if (!deferred && uniformCache.hasPending()) {
+			StateCache::get().deferUniforms(this, &Program::flushDeferred);
+			deferred = true;
+		}
+		return send;
+	}
+
+	void buildReflection() {
+		reflection.build(id);
+		uniformCache.clearArrays();
+		reflection.forEachUniform([this](const ProgramResource& res) {
+			uniformCache.addArray(res.location, res.arraySize);
+		});
+	}
+
+	static void flushDeferred(void* program) {
+		static_cast<Program*>(program)->flushUniforms();
+	}
+	void cancelDeferred() {
+		if (deferred) {
+			StateCache::get().cancelUniforms(this);
+			deferred = false;
+		}
+	}
+
+	void uploadUniform(GLint location, UniformType type, const void* data, GLsizei count, bool transpose) {
+		switch (type) {
+		case UniformType::Float:
+			glProgramUniform1fv(id, location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Vec2:
+			glProgramUniform2fv(id, location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Vec3:
+			glProgramUniform3fv(id, location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Vec4:
+			glProgramUniform4fv(id, location, count, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Int:
+			glProgramUniform1iv(id, location, count, static_cast<const GLint*>(data));
+			break;
+		case UniformType::IVec2:
+			glProgramUniform2iv(id, location, count, static_cast<const GLint*>(data));
+			break;
+		case UniformType::IVec3:
+			glProgramUniform3iv(id, location, count, static_cast<const GLint*>(data));
+			break;
+		case UniformType::IVec4:
+			glProgramUniform4iv(id, location, count, static_cast<const GLint*>(data));
+			break;
+		case UniformType::UInt:
+			glProgramUniform1uiv(id, location, count, static_cast<const GLuint*>(data));
+			break;
+		case UniformType::UVec2:
+			glProgramUniform2uiv(id, location, count, static_cast<const GLuint*>(data));
+			break;
+		case UniformType::UVec3:
+			glProgramUniform3uiv(id, location, count, static_cast<const GLuint*>(data));
+			break;
+		case UniformType::UVec4:
+			glProgramUniform4uiv(id, location, count, static_cast<const GLuint*>(data));
+			break;
+		case UniformType::Mat2:
+			glProgramUniformMatrix2fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat3:
+			glProgramUniformMatrix3fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat4:
+			glProgramUniformMatrix4fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat2x3:
+			glProgramUniformMatrix2x3fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat2x4:
+			glProgramUniformMatrix2x4fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat3x2:
+			glProgramUniformMatrix3x2fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat3x4:
+			glProgramUniformMatrix3x4fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat4x2:
+			glProgramUniformMatrix4x2fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		case UniformType::Mat4x3:
+			glProgramUniformMatrix4x3fv(id, location, count, transpose, static_cast<const GLfloat*>(data));
+			break;
+		default:
+			assert(false && "Uniform type cannot be staged by rt::Program!");
+			break;
+		}
+		checkError();
+	}
+
 	GLuint id;
 	bool bound;
+	UniformCache uniformCache;
+	ProgramReflection reflection;
+	// True while the program is registered with the StateCache, to have its staged uniforms flushed by the next draw.
+	bool deferred;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,277 @@
+#pragma once
+#include "Core.hpp"
+#include "Hash.hpp"
+#include "Shader.hpp"
+#include "Program.hpp"
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+namespace rt {
+	struct ShaderSource {
+		ShaderStage stage;
+		std::string_view source;
+	};
+
+	/*
+	Cache of linked program binaries, stored in a single file on disk.
+	Programs are keyed by a hash of their sources, and the whole file is tied to the vendor, renderer and version strings
+	of the driver that wrote it, so a driver update simply starts from an empty cache.
+	The file is read into memory on construction, and written back by save or when the cache is destroyed.
+	*/
+	class ProgramCache {
+	public:
+		// Returns true if the driver supports at least one program binary format.
+		static bool isSupported() {
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			checkError();
+			return formats > 0;
+		}
+
+		ProgramCache(std::filesystem::path file)
+			: entries()
+			, path(std::move(file))
+			, driver(driverHash())
+			, dirty(false)
+			, hitCount(0)
+			, missCount(0)
+			, rejectCount(0)
+		{
+			read();
+		}
+		~ProgramCache() {
+			if (dirty) {
+				save();
+			}
+		}
+
+		ProgramCache(ProgramCache&& other) noexcept
+			: entries(std::move(other.entries))
+			, path(std::move(other.path))
+			, driver(other.driver)
+			, dirty(other.dirty)
+			, hitCount(other.hitCount)
+			, missCount(other.missCount)
+			, rejectCount(other.rejectCount)
+		{
+			other.dirty = false;
+		}
+		ProgramCache& operator=(ProgramCache&& other) noexcept {
+			if (dirty) {
+				save();
+			}
+			entries = std::move(other.entries);
+			path = std::move(other.path);
+			driver = other.driver;
+			dirty = other.dirty;
+			hitCount = other.hitCount;
+			missCount = other.missCount;
+			rejectCount = other.rejectCount;
+
+			other.dirty = false;
+			return *this;
+		}
+
+		ProgramCache(const ProgramCache&) = delete;
+		ProgramCache& operator=(const ProgramCache&) = delete;
+
+		/*
+		Link the program from the cached binary for these sources, or compile it from source if there is none,
+		or if the driver rejects the binary. Newly compiled programs are added to the cache.
+		The program is reset first, so any shaders already attached to it are dropped. Returns true if the program linked.
+		*/
+		bool load(Program& program, const std::vector<ShaderSource>& sources) {
+			uint64_t key = hashSources(sources);
+
+			auto it = entries.find(key);
+			if (it != entries.end()) {
+				program.reset();
+				const Entry& entry = it->second;
+				if (program.loadBinary(entry.format, entry.data.data(), static_cast<GLsizei>(entry.data.size()))) {
+					++hitCount;
+					return true;
+				}
+				++rejectCount;
+				entries.erase(it);
+				dirty = true;
+			}
+			else {
+				++missCount;
+			}
+
+			program.reset();
+			program.setBinaryRetrievable(true);
+
+			for (const ShaderSource& src : sources) {
+				// Attached shaders are only flagged for deletion, they live on until the program is reset.
+				Shader shader(src.stage, src.source);
+				if (!shader.compile()) {
+					return false;
+				}
+				program.attachShader(shader);
+			}
+			if (!program.compile()) {
+				return false;
+			}
+
+			Entry entry;
+			entry.data = program.getBinary(entry.format);
+			if (!entry.data.empty()) {
+				entries[key] = std::move(entry);
+				dirty = true;
+			}
+			return true;
+		}
+
+		bool load(Program& program, std::string_view vertexSource, std::string_view fragmentSource) {
+			return load(program, { ShaderSource{ ShaderStage::Vertex, vertexSource }, ShaderSource{ ShaderStage::Fragment, fragmentSource } });
+		}
+
+		// Write the cache file. Returns false if the file could not be written.
+		bool save() {
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file) {
+				return false;
+			}
+
+			Header header{ Magic, Version, driver, static_cast<uint32_t>(entries.size()), 0 };
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			for (const auto& [key, entry] : entries) {
+				EntryHeader eheader{ key, entry.format, static_cast<uint32_t>(entry.data.size()) };
+				file.write(reinterpret_cast<const char*>(&eheader), sizeof(eheader));
+				file.write(reinterpret_cast<const char*>(entry.data.data()), static_cast<std::streamsize>(entry.data.size()));
+			}
+
+			dirty = !file.good();
+			return !dirty;
+		}
+
+		// Drop every cached binary. The file is only changed on the next save.
+		void clear() {
+			entries.clear();
+			dirty = true;
+		}
+
+		// The number of programs in the cache.
+		size_t size() const noexcept {
+			return entries.size();
+		}
+		const std::filesystem::path& getPath() const noexcept {
+			return path;
+		}
+
+		// Programs linked from a cached binary.
+		uint64_t hits() const noexcept {
+			return hitCount;
+		}
+		// Programs compiled because there was no cached binary.
+		uint64_t misses() const noexcept {
+			return missCount;
+		}
+		// Programs compiled because the driver refused the cached binary.
+		uint64_t rejects() const noexcept {
+			return rejectCount;
+		}
+		void resetStats() noexcept {
+			hitCount = 0;
+			missCount = 0;
+			rejectCount = 0;
+		}
+	private:
+		static constexpr uint32_t Magic = 0x43505452; // "RTPC"
+		static constexpr uint32_t Version = 1;
+
+		struct Header {
+			uint32_t magic, version;
+			uint64_t driver;
+			uint32_t count, padding;
+		};
+		struct EntryHeader {
+			uint64_t key;
+			uint32_t format, length;
+		};
+		struct Entry {
+			GLenum format;
+			std::vector<uint8_t> data;
+		};
+
+		static uint64_t driverHash() {
+			uint64_t hash = FnvOffsetBasis;
+			for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+				const char* str = reinterpret_cast<const char*>(glGetString(name));
+				checkError();
+				hash = fnv1a(str != nullptr ? std::string_view{ str } : std::string_view{}, hash);
+				hash = fnv1a("\n", hash);
+			}
+			return hash;
+		}
+
+		uint64_t hashSources(const std::vector<ShaderSource>& sources) const {
+			uint64_t hash = driver;
+			for (const ShaderSource& src : sources) {
+				GLenum stage = static_cast<GLenum>(src.stage);
+				hash = fnv1a(std::string_view{ reinterpret_cast<const char*>(&stage), sizeof(stage) }, hash);
+				hash = fnv1a(src.source, hash);
+			}
+			return hash;
+		}
+
+		void read() {
+			std::ifstream file(path, std::ios::binary);
+			if (!file) {
+				return;
+			}
+
+			Header header{};
+			file.read(reinterpret_cast<char*>(&header), sizeof(header));
+			if (!file || header.magic != Magic || header.version != Version || header.driver != driver) {
+				// Written by another driver or another version of the format, start over.
+				dirty = true;
+				return;
+			}
+
+			// Lengths come from disk, a corrupt or truncated file must not make us allocate more than it could possibly hold.
+			std::streamoff start = file.tellg();
+			file.seekg(0, std::ios::end);
+			uint64_t remaining = static_cast<uint64_t>(file.tellg() - start);
+			file.seekg(start);
+			if (!file || static_cast<uint64_t>(header.count) * sizeof(EntryHeader) > remaining) {
+				dirty = true;
+				return;
+			}
+
+			for (uint32_t i = 0; i < header.count; ++i) {
+				EntryHeader eheader{};
+				file.read(reinterpret_cast<char*>(&eheader), sizeof(eheader));
+				remaining -= sizeof(eheader);
+				if (!file || eheader.length > remaining) {
+					// Nothing read from a damaged file can be trusted, drop all of it and write the cache out again.
+					entries.clear();
+					dirty = true;
+					return;
+				}
+
+				Entry entry;
+				entry.format = eheader.format;
+				entry.data.resize(eheader.length);
+				file.read(reinterpret_cast<char*>(entry.data.data()), static_cast<std::streamsize>(eheader.length));
+				remaining -= eheader.length;
+				if (!file) {
+					entries.clear();
+					dirty = true;
+					return;
+				}
+				entries.emplace(eheader.key, std::move(entry));
+			}
+		}
+
+		std::unordered_map<uint64_t, Entry> entries;
+		std::filesystem::path path;
+		uint64_t driver;
+		bool dirty;
+
+		uint64_t hitCount, missCount, rejectCount;
+	};
+}
@@ -0,0 +1,349 @@
+#pragma once
+#include "Core.hpp"
+#include "Hash.hpp"
+#include <vector>
+#include <string>
+#include <charconv>
+
+namespace rt {
+	enum class UniformType : GLenum;
+
+	// Everything reflection knows about a single active resource of a program.
+	struct ProgramResource {
+		uint64_t hash;
+		std::string name;
+
+		// The index of the resource in its interface, as used by glGetProgramResource*.
+		GLint index;
+		// The location of uniforms, inputs and outputs. -1 for blocks, and for uniforms that live inside of a block.
+		GLint location;
+		UniformType type;
+		GLint arraySize;
+
+		// For uniforms, the index of the block they live in, or -1 for the default block.
+		GLint blockIndex;
+		// For uniforms inside of a block, the offset in bytes from the start of the block.
+		GLint offset;
+
+		// For blocks, the buffer binding index and the minimum size in bytes of the buffer bound to it.
+		GLint binding;
+		GLint dataSize;
+	};
+
+	/*
+	Open addressing hash table of resources, keyed by the FNV hash of their names.
+	The table is built once and never modified, so it is just a flat array kept at most half full.
+	Names are kept next to the hashes, lookups by name compare them so a collision can not return the wrong resource.
+	*/
+	class ResourceTable {
+	public:
+		ResourceTable()
+			: slots()
+			, count(0)
+		{}
+
+		void build(const std::vector<ProgramResource>& resources) {
+			size_t capacity = 8;
+			while (capacity < resources.size() * 2) {
+				capacity <<= 1;
+			}
+			slots.assign(capacity, ProgramResource{});
+			count = 0;
+
+			for (const ProgramResource& res : resources) {
+				uint64_t key = normalize(res.hash);
+				size_t slot = key & (capacity - 1);
+				// Different names with the same hash both get a slot, only an identical name is skipped.
+				while (slots[slot].hash != 0 && !(slots[slot].hash == key && slots[slot].name == res.name)) {
+					slot = (slot + 1) & (capacity - 1);
+				}
+				// The first resource with a given name wins, which keeps "arr[0]" ahead of its "arr" alias.
+				if (slots[slot].hash == 0) {
+					slots[slot] = res;
+					slots[slot].hash = key;
+					++count;
+				}
+			}
+		}
+
+		// Returns nullptr if there is no active resource with that name.
+		const ProgramResource* find(std::string_view name) const noexcept {
+			if (slots.empty()) {
+				return nullptr;
+			}
+			uint64_t key = normalize(fnv1a(name));
+			size_t mask = slots.size() - 1;
+			size_t slot = key & mask;
+			while (slots[slot].hash != 0) {
+				if (slots[slot].hash == key && slots[slot].name == name) {
+					return &slots[slot];
+				}
+				slot = (slot + 1) & mask;
+			}
+			return nullptr;
+		}
+		// Only compares hashes, so a name that is not in the program could still match another one with the same hash.
+		const ProgramResource* find(NameHash name) const noexcept {
+			if (slots.empty()) {
+				return nullptr;
+			}
+			uint64_t key = normalize(name.value);
+			size_t mask = slots.size() - 1;
+			size_t slot = key & mask;
+			while (slots[slot].hash != 0) {
+				if (slots[slot].hash == key) {
+					return &slots[slot];
+				}
+				slot = (slot + 1) & mask;
+			}
+			return nullptr;
+		}
+
+		// Visits every resource, arrays twice since they are also stored under their name without "[0]".
+		template<typename F>
+		void forEach(F&& fn) const {
+			for (const ProgramResource& res : slots) {
+				if (res.hash != 0) {
+					fn(res);
+				}
+			}
+		}
+
+		void clear() {
+			slots.clear();
+			count = 0;
+		}
+
+		size_t size() const noexcept {
+			return count;
+		}
+		bool empty() const noexcept {
+			return count == 0;
+		}
+	private:
+		// A hash of 0 marks an empty slot.
+		static constexpr uint64_t normalize(uint64_t hash) noexcept {
+			return hash != 0 ? hash : 1;
+		}
+
+		std::vector<ProgramResource> slots;
+		size_t count;
+	};
+
+	/*
+	Reflection of every active resource in a linked program, gathered with one pass over the program interfaces.
+	Lookups after that are a hash and a probe, with no calls into opengl.
+	Array resources can be found both as "name[0]" and "name", elements past the first through uniformElementLocation.
+	*/
+	class ProgramReflection {
+	public:
+		ProgramReflection()
+			: uniforms()
+			, uniformBlocks()
+			, storageBlocks()
+			, inputs()
+			, outputs()
+			, built(false)
+		{}
+
+		// Query all resources of the linked program. Any previous contents are replaced.
+		void build(GLuint program) {
+			clear();
+
+			uniforms.build(gather(program, GL_UNIFORM));
+			uniformBlocks.build(gather(program, GL_UNIFORM_BLOCK));
+			storageBlocks.build(gather(program, GL_SHADER_STORAGE_BLOCK));
+			inputs.build(gather(program, GL_PROGRAM_INPUT));
+			outputs.build(gather(program, GL_PROGRAM_OUTPUT));
+
+			built = true;
+		}
+
+		void clear() {
+			uniforms.clear();
+			uniformBlocks.clear();
+			storageBlocks.clear();
+			inputs.clear();
+			outputs.clear();
+			built = false;
+		}
+
+		bool isBuilt() const noexcept {
+			return built;
+		}
+
+		const ProgramResource* findUniform(std::string_view name) const noexcept {
+			return uniforms.find(name);
+		}
+		const ProgramResource* findUniform(NameHash name) const noexcept {
+			return uniforms.find(name);
+		}
+		const ProgramResource* findUBO(std::string_view name) const noexcept {
+			return uniformBlocks.find(name);
+		}
+		const ProgramResource* findUBO(NameHash name) const noexcept {
+			return uniformBlocks.find(name);
+		}
+		const ProgramResource* findSSBO(std::string_view name) const noexcept {
+			return storageBlocks.find(name);
+		}
+		const ProgramResource* findSSBO(NameHash name) const noexcept {
+			return storageBlocks.find(name);
+		}
+		const ProgramResource* findInput(std::string_view name) const noexcept {
+			return inputs.find(name);
+		}
+		const ProgramResource* findInput(NameHash name) const noexcept {
+			return inputs.find(name);
+		}
+		const ProgramResource* findOutput(std::string_view name) const noexcept {
+			return outputs.find(name);
+		}
+		const ProgramResource* findOutput(NameHash name) const noexcept {
+			return outputs.find(name);
+		}
+
+		/*
+		Location of an element of a uniform array, like "weights[2]", which is not in the table by itself.
+		The elements of a uniform array have consecutive locations, so it is the location of the first one plus the index.
+		Returns -1 if the name is not an element of an active array in the default block, or the index is out of range.
+		*/
+		GLint uniformElementLocation(std::string_view name) const noexcept {
+			size_t index = 0;
+			std::string_view base = splitElement(name, index);
+			if (base.empty()) {
+				return -1;
+			}
+			// "name[0]" of an array is in the table itself, so index 0 here means name is not an array.
+			const ProgramResource* res = uniforms.find(base);
+			if (res == nullptr || res->location < 0 || index == 0 || index >= static_cast<size_t>(res->arraySize)) {
+				return -1;
+			}
+			return res->location + static_cast<GLint>(index);
+		}
+
+		// Splits "name[index]" into name and index. Returns an empty name if it does not end in an array index.
+		static std::string_view splitElement(std::string_view name, size_t& index) noexcept {
+			if (name.size() < 4 || name.back() != ']') {
+				return {};
+			}
+			size_t open = name.rfind('[');
+			if (open == std::string_view::npos || open == 0 || open + 2 >= name.size()) {
+				return {};
+			}
+			const char* first = name.data() + open + 1;
+			const char* last = name.data() + name.size() - 1;
+			std::from_chars_result parsed = std::from_chars(first, last, index);
+			if (parsed.ec != std::errc{} || parsed.ptr != last) {
+				return {};
+			}
+			return name.substr(0, open);
+		}
+
+		template<typename F>
+		void forEachUniform(F&& fn) const {
+			uniforms.forEach(std::forward<F>(fn));
+		}
+
+		size_t numUniforms() const noexcept {
+			return uniforms.size();
+		}
+		size_t numUBOs() const noexcept {
+			return uniformBlocks.size();
+		}
+		size_t numSSBOs() const noexcept {
+			return storageBlocks.size();
+		}
+		size_t numInputs() const noexcept {
+			return inputs.size();
+		}
+		size_t numOutputs() const noexcept {
+			return outputs.size();
+		}
+	private:
+		static std::vector<ProgramResource> gather(GLuint program, GLenum interface) {
+			std::vector<ProgramResource> result;
+
+			GLint count = 0, maxLength = 0;
+			glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+			glGetProgramInterfaceiv(program, interface, GL_MAX_NAME_LENGTH, &maxLength);
+			checkError();
+
+			if (count <= 0) {
+				return result;
+			}
+			result.reserve(static_cast<size_t>(count) * 2);
+
+			bool isBlock = interface == GL_UNIFORM_BLOCK || interface == GL_SHADER_STORAGE_BLOCK;
+			std::string name(static_cast<size_t>(maxLength), '\0');
+
+			for (GLint i = 0; i < count; ++i) {
+				GLsizei length = 0;
+				glGetProgramResourceName(program, interface, static_cast<GLuint>(i), maxLength, &length, name.data());
+				checkError();
+
+				ProgramResource res{};
+				res.index = i;
+				res.location = -1;
+				res.type = UniformType{};
+				res.arraySize = 1;
+				res.blockIndex = -1;
+				res.offset = -1;
+				res.binding = -1;
+				res.dataSize = 0;
+
+				if (isBlock) {
+					const GLenum props[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+					GLint values[2] = { -1, 0 };
+					glGetProgramResourceiv(program, interface, static_cast<GLuint>(i), 2, props, 2, nullptr, values);
+					checkError();
+
+					res.binding = values[0];
+					res.dataSize = values[1];
+				}
+				else if (interface == GL_UNIFORM) {
+					const GLenum props[] = { GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX, GL_OFFSET };
+					GLint values[5] = { -1, 0, 1, -1, -1 };
+					glGetProgramResourceiv(program, interface, static_cast<GLuint>(i), 5, props, 5, nullptr, values);
+					checkError();
+
+					res.location = values[0];
+					res.type = static_cast<UniformType>(values[1]);
+					res.arraySize = values[2];
+					res.blockIndex = values[3];
+					res.offset = values[4];
+				}
+				else {
+					const GLenum props[] = { GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE };
+					GLint values[3] = { -1, 0, 1 };
+					glGetProgramResourceiv(program, interface, static_cast<GLuint>(i), 3, props, 3, nullptr, values);
+					checkError();
+
+					res.location = values[0];
+					res.type = static_cast<UniformType>(values[1]);
+					res.arraySize = values[2];
+				}
+
+				std::string_view view{ name.data(), static_cast<size_t>(length) };
+				res.hash = fnv1a(view);
+				res.name = view;
+				result.push_back(res);
+
+				// Arrays are reported as "name[0]", but are usually looked up as just "name".
+				if (view.size() > 3 && view.substr(view.size() - 3) == "[0]") {
+					res.hash = fnv1a(view.substr(0, view.size() - 3));
+					res.name = view.substr(0, view.size() - 3);
+					result.push_back(res);
+				}
+			}
+			return result;
+		}
+
+		ResourceTable uniforms;
+		ResourceTable uniformBlocks;
+		ResourceTable storageBlocks;
+		ResourceTable inputs;
+		ResourceTable outputs;
+		bool built;
+	};
+}
@@ -0,0 +1,324 @@
+#pragma once
+#include "Core.hpp"
+#include "Buffer.hpp"
+#include "Texture.hpp"
+#include "Fence.hpp"
+#include <vector>
+
+namespace rt {
+	class ReadbackQueue;
+
+	/*
+	Future-like handle for a single readback request.
+	The data can only be accessed once the request is ready, and stays valid until the handle is released.
+	*/
+	class ReadbackHandle {
+	public:
+		ReadbackHandle()
+			: queue(nullptr)
+			, slot(0)
+			, generation(0)
+		{}
+
+		// Returns true if the GPU has finished writing the data for this request. Never blocks.
+		bool isReady() const;
+
+		// Block until the request is ready, or the timeout expires. Returns true if the request is ready.
+		bool wait(uint64_t timeoutNanoseconds = GL_TIMEOUT_IGNORED) const;
+
+		// Returns a pointer to the mapped result, or nullptr if the request is not ready yet.
+		template<typename T = uint8_t>
+		const T* data() const;
+
+		// The size in bytes of the result.
+		size_t sizeBytes() const;
+
+		// Return the slot to the queue, the data pointer is no longer valid after this.
+		void release();
+
+		bool isValid() const;
+	private:
+		friend class ReadbackQueue;
+
+		ReadbackHandle(ReadbackQueue* q, uint32_t s, uint32_t g)
+			: queue(q)
+			, slot(s)
+			, generation(g)
+		{}
+
+		ReadbackQueue* queue;
+		uint32_t slot;
+		uint32_t generation;
+	};
+
+	/*
+	Asynchronous readback of textures and buffers.
+	Each request copies into one slot from a pool of persistently mapped pixel pack buffers, with a fence placed after the copy.
+	The result can be read straight out of the mapping once the fence has signaled, so the CPU never waits on the GPU
+	as long as the requests are consumed a few frames after they were issued.
+	*/
+	class ReadbackQueue {
+	public:
+		// Creates slotCount slots, each capable of holding slotSize bytes.
+		ReadbackQueue(size_t slotSize, uint32_t slotCount = 3)
+			: slots(slotCount)
+			, slotBytes(slotSize)
+		{
+			assert(slotSize > 0);
+			assert(slotCount > 0);
+
+			for (Slot& slot : slots) {
+				slot.buffer.initArray(slotBytes, Init::Read | Init::Persistent | Init::Coherent);
+				slot.mapping = slot.buffer.map<uint8_t>(Flag::Read | Flag::Persistent | Flag::Coherent);
+				assert(slot.mapping != nullptr && "Failed to persistently map a readback slot!");
+			}
+		}
+		~ReadbackQueue() {
+			for (Slot& slot : slots) {
+				if (slot.mapping != nullptr) {
+					slot.buffer.unmap();
+					slot.mapping = nullptr;
+				}
+			}
+		}
+
+		ReadbackQueue(const ReadbackQueue&) = delete;
+		ReadbackQueue& operator=(const ReadbackQueue&) = delete;
+
+		// Handles refer back to the queue, so it cannot be moved.
+		ReadbackQueue(ReadbackQueue&&) = delete;
+		ReadbackQueue& operator=(ReadbackQueue&&) = delete;
+
+		/// <summary>
+		/// Queue a read of a region of a texture. The result is tightly packed.
+		/// Returns an invalid handle if there are no free slots, or the region does not fit into a slot.
+		/// Leaves GL_PIXEL_PACK_BUFFER unbound, like rt::TextureUploader does with the unpack buffer.
+		/// </summary>
+		/// <param name="tex">The texture to read from</param>
+		/// <param name="level">The mipmap level to read from</param>
+		/// <param name="offset">The offset into the texture to read from</param>
+		/// <param name="region">The size of the region to read</param>
+		/// <param name="comp">The component layout to read the pixels as</param>
+		/// <param name="form">The format to read the pixels as</param>
+		ReadbackHandle readTexture(const TextureBase& tex, GLint level, const glm::ivec3& offset, const glm::ivec3& region, PixelComponent comp, PixelFormat form) {
+			assert(tex.isValid());
+			assert(level >= 0);
+
+			size_t length = pixelSize(comp, form) * static_cast<size_t>(region.x) * static_cast<size_t>(region.y) * static_cast<size_t>(region.z);
+			int32_t index = acquire(length);
+			if (index < 0) {
+				return ReadbackHandle{};
+			}
+			Slot& slot = slots[index];
+
+			// Rows that are a multiple of 8 bytes are tightly packed at any pack alignment, so only odd rows have to change it.
+			size_t rowBytes = pixelSize(comp, form) * static_cast<size_t>(region.x);
+			GLint alignment = 0;
+			if (rowBytes % 8 != 0) {
+				glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+				glPixelStorei(GL_PACK_ALIGNMENT, 1);
+				checkError();
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer.getId());
+			checkError();
+
+			glGetTextureSubImage(
+				tex.getId(), level,
+				offset.x, offset.y, offset.z,
+				region.x, region.y, region.z,
+				convertGL(comp), convertGL(comp, form),
+				static_cast<GLsizei>(slotBytes), (void*)0);
+			checkError();
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			if (alignment != 0) {
+				glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+			}
+			checkError();
+
+			return submit(static_cast<uint32_t>(index));
+		}
+
+		ReadbackHandle readTexture(const Texture2dBase& tex, GLint level, const glm::ivec2& offset, const glm::ivec2& region, PixelComponent comp, PixelFormat form) {
+			return readTexture(tex, level, glm::ivec3{ offset, 0 }, glm::ivec3{ region, 1 }, comp, form);
+		}
+
+		// Queue a read of a range of a buffer.
+		// Returns an invalid handle if there are no free slots, or the range does not fit into a slot.
+		ReadbackHandle readBuffer(const Buffer& src, size_t length, intptr_t readOffset = 0) {
+			assert(src.isValid());
+			assert(src.boundsCheckBytes(readOffset, length) && "Attempted to read data out of bounds!");
+
+			int32_t index = acquire(length);
+			if (index < 0) {
+				return ReadbackHandle{};
+			}
+			Slot& slot = slots[index];
+
+			glCopyNamedBufferSubData(src.getId(), slot.buffer.getId(), readOffset, 0, length);
+			checkError();
+
+			return submit(static_cast<uint32_t>(index));
+		}
+
+		// The number of slots not currently held by a handle.
+		uint32_t numFreeSlots() const noexcept {
+			uint32_t count = 0;
+			for (const Slot& slot : slots) {
+				if (!slot.busy) {
+					++count;
+				}
+			}
+			return count;
+		}
+		uint32_t numSlots() const noexcept {
+			return static_cast<uint32_t>(slots.size());
+		}
+		size_t slotSize() const noexcept {
+			return slotBytes;
+		}
+	private:
+		friend class ReadbackHandle;
+
+		using Init = BufferInit;
+		using Flag = BufferFlag;
+
+		struct Slot {
+			Slot()
+				: buffer()
+				, fence()
+				, mapping(nullptr)
+				, length(0)
+				, generation(0)
+				, busy(false)
+				, ready(false)
+			{}
+
+			ImmutableBuffer buffer;
+			Fence fence;
+			const uint8_t* mapping;
+			size_t length;
+			uint32_t generation;
+			bool busy, ready;
+		};
+
+		int32_t acquire(size_t length) {
+			if (length == 0 || length > slotBytes) {
+				return -1;
+			}
+			for (size_t i = 0; i < slots.size(); ++i) {
+				Slot& slot = slots[i];
+				if (!slot.busy) {
+					slot.busy = true;
+					slot.ready = false;
+					slot.length = length;
+					return static_cast<int32_t>(i);
+				}
+			}
+			return -1;
+		}
+
+		ReadbackHandle submit(uint32_t index) {
+			Slot& slot = slots[index];
+			slot.fence.reset();
+			slot.fence.init();
+			return ReadbackHandle{ this, index, slot.generation };
+		}
+
+		const Slot* find(uint32_t index, uint32_t generation) const noexcept {
+			if (index >= slots.size()) {
+				return nullptr;
+			}
+			const Slot& slot = slots[index];
+			if (!slot.busy || slot.generation != generation) {
+				return nullptr;
+			}
+			return &slot;
+		}
+		Slot* find(uint32_t index, uint32_t generation) noexcept {
+			return const_cast<Slot*>(static_cast<const ReadbackQueue*>(this)->find(index, generation));
+		}
+
+		bool poll(uint32_t index, uint32_t generation, uint64_t timeout) {
+			Slot* slot = find(index, generation);
+			if (slot == nullptr) {
+				return false;
+			}
+			if (slot->ready) {
+				return true;
+			}
+
+			FenceResult res = slot->fence.waitClient(0);
+			if (timeout != 0) {
+				while (res == FenceResult::Timeout) {
+					res = slot->fence.waitClient(timeout);
+					if (timeout != GL_TIMEOUT_IGNORED) {
+						break;
+					}
+				}
+			}
+
+			if (res == FenceResult::Signaled || res == FenceResult::Satisfied) {
+				slot->ready = true;
+				slot->fence.reset();
+			}
+			return slot->ready;
+		}
+
+		void release(uint32_t index, uint32_t generation) {
+			Slot* slot = find(index, generation);
+			if (slot != nullptr) {
+				slot->fence.reset();
+				slot->busy = false;
+				slot->ready = false;
+				slot->length = 0;
+				slot->generation += 1;
+			}
+		}
+
+		std::vector<Slot> slots;
+		size_t slotBytes;
+	};
+
+	inline bool ReadbackHandle::isValid() const {
+		return queue != nullptr && queue->find(slot, generation) != nullptr;
+	}
+
+	inline bool ReadbackHandle::isReady() const {
+		if (queue == nullptr) {
+			return false;
+		}
+		return queue->poll(slot, generation, 0);
+	}
+
+	inline bool ReadbackHandle::wait(uint64_t timeoutNanoseconds) const {
+		if (queue == nullptr) {
+			return false;
+		}
+		return queue->poll(slot, generation, timeoutNanoseconds);
+	}
+
+	template<typename T>
+	inline const T* ReadbackHandle::data() const {
+		static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::ReadbackHandle::data is not trivially copyable!");
+		if (!isReady()) {
+			return nullptr;
+		}
+		return reinterpret_cast<const T*>(queue->find(slot, generation)->mapping);
+	}
+
+	inline size_t ReadbackHandle::sizeBytes() const {
+		if (queue == nullptr) {
+			return 0;
+		}
+		const ReadbackQueue::Slot* found = queue->find(slot, generation);
+		return found != nullptr ? found->length : 0;
+	}
+
+	inline void ReadbackHandle::release() {
+		if (queue != nullptr) {
+			queue->release(slot, generation);
+			queue = nullptr;
+		}
+	}
+}
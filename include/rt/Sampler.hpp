@@ -1,5 +1,6 @@
 #pragma once
 #include "Core.hpp"
+#include "StateCache.hpp"
 
 namespace rt {
 	class Sampler {
@@ -14,6 +15,7 @@ namespace rt {
 		~Sampler()
 		{
 			if (isValid()) {
+				StateCache::get().forgetSampler(id);
 				glDeleteSamplers(1, &id);
 				checkError();
 				id = 0;
@@ -21,13 +23,17 @@ namespace rt {
 		}
 
 		void bindUnit(GLuint texUnit) {
-			glBindSampler(id, texUnit); 
-			checkError();
+			if (StateCache::get().bindSampler(texUnit, id)) {
+				glBindSampler(texUnit, id);
+				checkError();
+			}
 		}
 
 		void unbindUnit(GLuint texUnit) {
-			glBindSampler(0, texUnit); 
-			checkError();
+			if (StateCache::get().bindSampler(texUnit, 0)) {
+				glBindSampler(texUnit, 0);
+				checkError();
+			}
 		}
 
 		void setBorderColor(float r, float g, float b, float a) {
@@ -63,7 +63,30 @@ namespace rt {
 		}
 
 		bool compile() {
+			submit();
+			return finishCompile();
+		}
+
+		// Start compiling without waiting for the result, see rt::CompileQueue.
+		void submit() {
 			glCompileShader(id);
+			checkError();
+		}
+
+		// Returns true once a submitted compile has finished, successfully or not.
+		// Without parallel shader compile support this always returns true, and the status query will block instead.
+		bool isCompileComplete() const {
+			if (!parallelShaderCompileSupported()) {
+				return true;
+			}
+			GLint result = GL_TRUE;
+			glGetShaderiv(id, GL_COMPLETION_STATUS_KHR, &result);
+			checkError();
+			return result == GL_TRUE;
+		}
+
+		// Wait for a submitted compile and report its result, printing the log on failure.
+		bool finishCompile() {
 			bool compiled = isCompiled();
 
 			if (!compiled)
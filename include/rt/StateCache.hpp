@@ -0,0 +1,271 @@
+#pragma once
+#include "Core.hpp"
+#include <vector>
+
+namespace rt {
+	/*
+	Shadow copy of the bind state of the current opengl context.
+	The wrappers ask the cache before every bind, and skip the call if the object is already bound.
+	It is disabled by default, since it can only stay correct if every bind of the tracked state goes through rt.
+	Code that binds things through opengl directly should call invalidate afterwards.
+
+	There is one cache per thread, which matches opengl as long as each thread only ever uses a single context.
+	Call invalidate when making a different context current on a thread.
+
+	It also keeps the programs with deferred uniforms waiting to be sent, which the draw calls flush first.
+	*/
+	class StateCache {
+	public:
+		// Marks state the cache knows nothing about.
+		static constexpr GLuint Unknown = 0xFFFFFFFF;
+
+		// The cache of the calling thread.
+		static StateCache& get() {
+			thread_local StateCache cache;
+			return cache;
+		}
+
+		void enable() {
+			if (!enabled) {
+				invalidate();
+				enabled = true;
+			}
+		}
+		void disable() {
+			enabled = false;
+			invalidate();
+		}
+		bool isEnabled() const noexcept {
+			return enabled;
+		}
+
+		// Forget all of the tracked state, the next bind of everything goes to opengl.
+		void invalidate() {
+			program = Unknown;
+			vertexArray = Unknown;
+			readFramebuffer = Unknown;
+			drawFramebuffer = Unknown;
+			textures.clear();
+			samplers.clear();
+			uniformBuffers.clear();
+			storageBuffers.clear();
+		}
+
+		// Binds ---
+		// Each of these records the new binding, and returns true if the call has to be made.
+		bool useProgram(GLuint id) {
+			return update(program, id);
+		}
+		bool bindVertexArray(GLuint id) {
+			return update(vertexArray, id);
+		}
+		// Accepts GL_FRAMEBUFFER, GL_READ_FRAMEBUFFER and GL_DRAW_FRAMEBUFFER.
+		bool bindFramebuffer(GLenum target, GLuint id) {
+			switch (target) {
+			case GL_READ_FRAMEBUFFER:
+				return update(readFramebuffer, id);
+			case GL_DRAW_FRAMEBUFFER:
+				return update(drawFramebuffer, id);
+			default:
+				if (enabled && readFramebuffer == id && drawFramebuffer == id) {
+					++elided;
+					return false;
+				}
+				readFramebuffer = id;
+				drawFramebuffer = id;
+				++issued;
+				return true;
+			}
+		}
+		bool bindTextureUnit(GLuint unit, GLuint id) {
+			return update(slot(textures, unit), id);
+		}
+		bool bindSampler(GLuint unit, GLuint id) {
+			return update(slot(samplers, unit), id);
+		}
+		// A length of 0 stands for the whole buffer, as bound by glBindBufferBase.
+		// Accepts GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER.
+		bool bindBuffer(GLenum target, GLuint index, GLuint id, intptr_t offset = 0, size_t length = 0) {
+			std::vector<BufferRange>& ranges = target == GL_UNIFORM_BUFFER ? uniformBuffers : storageBuffers;
+			assert(target == GL_UNIFORM_BUFFER || target == GL_SHADER_STORAGE_BUFFER);
+
+			if (ranges.size() <= index) {
+				ranges.resize(static_cast<size_t>(index) + 1, BufferRange{ Unknown, 0, 0 });
+			}
+			BufferRange& range = ranges[index];
+			if (enabled && range.id == id && range.offset == offset && range.length == length) {
+				++elided;
+				return false;
+			}
+			range = BufferRange{ id, offset, length };
+			++issued;
+			return true;
+		}
+
+		// Deletion ---
+		// Called when an object is deleted, since opengl unbinds it and may hand the same name out again.
+		void forgetProgram(GLuint id) {
+			forget(program, id);
+		}
+		void forgetVertexArray(GLuint id) {
+			forget(vertexArray, id);
+		}
+		void forgetFramebuffer(GLuint id) {
+			forget(readFramebuffer, id);
+			forget(drawFramebuffer, id);
+		}
+		void forgetTexture(GLuint id) {
+			for (GLuint& bound : textures) {
+				forget(bound, id);
+			}
+		}
+		void forgetSampler(GLuint id) {
+			for (GLuint& bound : samplers) {
+				forget(bound, id);
+			}
+		}
+		void forgetBuffer(GLuint id) {
+			for (BufferRange& range : uniformBuffers) {
+				forget(range.id, id);
+			}
+			for (BufferRange& range : storageBuffers) {
+				forget(range.id, id);
+			}
+		}
+
+		/*
+		Deferred uniforms ---
+		Programs in deferred uniform mode register here once they have staged values, whether or not the cache is enabled.
+		The draw calls of rt::VertexArray call flushUniforms first, so the values reach opengl once per draw.
+		*/
+		using FlushFunction = void(*)(void*);
+
+		void deferUniforms(void* owner, FlushFunction flush) {
+			pendingUniforms.push_back(PendingUniforms{ owner, flush });
+		}
+		void cancelUniforms(const void* owner) {
+			for (size_t i = 0; i < pendingUniforms.size(); ++i) {
+				if (pendingUniforms[i].owner == owner) {
+					pendingUniforms[i] = pendingUniforms.back();
+					pendingUniforms.pop_back();
+					return;
+				}
+			}
+		}
+		// For owners that were moved.
+		void moveUniforms(const void* from, void* to) {
+			for (PendingUniforms& pending : pendingUniforms) {
+				if (pending.owner == from) {
+					pending.owner = to;
+					return;
+				}
+			}
+		}
+		void flushUniforms() {
+			if (pendingUniforms.empty()) {
+				return;
+			}
+			// The flush functions cancel themselves, so they run from a copy of the list.
+			flushing.swap(pendingUniforms);
+			for (const PendingUniforms& pending : flushing) {
+				pending.flush(pending.owner);
+			}
+			flushing.clear();
+		}
+
+		// Getters ---
+		// These return Unknown when the cache is disabled, or does not know the current binding yet.
+		GLuint currentProgram() const noexcept {
+			return enabled ? program : Unknown;
+		}
+		GLuint currentVertexArray() const noexcept {
+			return enabled ? vertexArray : Unknown;
+		}
+		GLuint currentReadFramebuffer() const noexcept {
+			return enabled ? readFramebuffer : Unknown;
+		}
+		GLuint currentDrawFramebuffer() const noexcept {
+			return enabled ? drawFramebuffer : Unknown;
+		}
+		GLuint currentTexture(GLuint unit) const noexcept {
+			return enabled && unit < textures.size() ? textures[unit] : Unknown;
+		}
+		GLuint currentSampler(GLuint unit) const noexcept {
+			return enabled && unit < samplers.size() ? samplers[unit] : Unknown;
+		}
+
+		// The number of binds skipped because the object was already bound.
+		uint64_t elidedCount() const noexcept {
+			return elided;
+		}
+		// The number of binds sent to opengl.
+		uint64_t issuedCount() const noexcept {
+			return issued;
+		}
+		void resetStats() noexcept {
+			elided = 0;
+			issued = 0;
+		}
+	private:
+		struct BufferRange {
+			GLuint id;
+			intptr_t offset;
+			size_t length;
+		};
+		struct PendingUniforms {
+			void* owner;
+			FlushFunction flush;
+		};
+
+		StateCache()
+			: program(Unknown)
+			, vertexArray(Unknown)
+			, readFramebuffer(Unknown)
+			, drawFramebuffer(Unknown)
+			, textures()
+			, samplers()
+			, uniformBuffers()
+			, storageBuffers()
+			, pendingUniforms()
+			, flushing()
+			, enabled(false)
+			, elided(0)
+			, issued(0)
+		{}
+
+		bool update(GLuint& bound, GLuint id) {
+			if (enabled && bound == id) {
+				++elided;
+				return false;
+			}
+			bound = id;
+			++issued;
+			return true;
+		}
+
+		static void forget(GLuint& bound, GLuint id) {
+			if (bound == id) {
+				bound = Unknown;
+			}
+		}
+
+		static GLuint& slot(std::vector<GLuint>& units, GLuint unit) {
+			if (units.size() <= unit) {
+				units.resize(static_cast<size_t>(unit) + 1, Unknown);
+			}
+			return units[unit];
+		}
+
+		GLuint program;
+		GLuint vertexArray;
+		GLuint readFramebuffer, drawFramebuffer;
+		std::vector<GLuint> textures;
+		std::vector<GLuint> samplers;
+		std::vector<BufferRange> uniformBuffers;
+		std::vector<BufferRange> storageBuffers;
+		std::vector<PendingUniforms> pendingUniforms, flushing;
+
+		bool enabled;
+		uint64_t elided, issued;
+	};
+}
@@ -1,4 +1,8 @@
 #pragma once
 #include "texture/Texture1d.hpp"
 #include "texture/Texture2d.hpp"
-#include "texture/Texture3d.hpp"
\ No newline at end of file
+#include "texture/Texture3d.hpp"
+#include "texture/SparseTexture.hpp"
+#include "texture/TextureAtlas.hpp"
+#include "texture/MipBuilder.hpp"
+#include "texture/BlockCompressor.hpp"
\ No newline at end of file
@@ -0,0 +1,486 @@
+#pragma once
+#include "Core.hpp"
+#include "Buffer.hpp"
+#include "Texture.hpp"
+#include "Fence.hpp"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
+namespace rt {
+	/*
+	Streams texture data through a persistently mapped pixel unpack buffer, so glTextureSubImage never copies from client memory.
+	Requests wait in a priority queue until there is room in the staging ring, then a worker thread writes the pixels into the ring,
+	either by copying them or by running a fill function that decodes or converts straight into the staging memory.
+	update is called once per frame on the render thread, it issues the finished uploads from the buffer, up to a byte budget,
+	and fences them so the staging space is reused only once the GPU is done reading it.
+
+	Everything but the fill functions runs on the render thread. The textures, and the data of copy requests, must outlive their uploads.
+	*/
+	class TextureUploader {
+	public:
+		// Writes exactly length bytes of tightly packed pixels to staging. Runs on a worker thread.
+		using Fill = std::function<void(uint8_t* staging, size_t length)>;
+		// Called on the render thread once the upload has been issued, anything submitted after it sees the new data.
+		using Callback = std::function<void()>;
+
+		// Creates a stagingSize byte ring, requests larger than this are rejected.
+		TextureUploader(size_t stagingSize, uint32_t workerCount = 2, size_t frameBudget = 16 * 1024 * 1024)
+			: buffer()
+			, mapping(nullptr)
+			, ringBytes(stagingSize)
+			, head(0)
+			, allocations()
+			, batches()
+			, pending()
+			, readyTickets()
+			, jobs()
+			, finished()
+			, workers()
+			, mutex()
+			, wake()
+			, done()
+			, budget(frameBudget)
+			, filling(0)
+			, nextTicket(1)
+			, serial(0)
+			, retired(0)
+			, issuedLastUpdate(0)
+			, issuedTotal(0)
+			, stopping(false)
+		{
+			assert(stagingSize > 0);
+			assert(workerCount > 0);
+
+			buffer.initArray(ringBytes, Init::Write | Init::Persistent | Init::Coherent);
+			mapping = buffer.map<uint8_t>(Flag::Write | Flag::Persistent | Flag::Coherent);
+			assert(mapping != nullptr && "Failed to persistently map the staging buffer!");
+
+			for (uint32_t i = 0; i < workerCount; ++i) {
+				workers.emplace_back([this]() { workerLoop(); });
+			}
+		}
+		~TextureUploader() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+
+			if (mapping != nullptr) {
+				buffer.unmap();
+				mapping = nullptr;
+			}
+		}
+
+		// The workers point back into the uploader, so it cannot be moved.
+		TextureUploader(TextureUploader&&) = delete;
+		TextureUploader& operator=(TextureUploader&&) = delete;
+
+		TextureUploader(const TextureUploader&) = delete;
+		TextureUploader& operator=(const TextureUploader&) = delete;
+
+		/// <summary>
+		/// Queue an upload of a region of a texture, the pixels are produced by fill on a worker thread.
+		/// Higher priorities are started first, equal priorities in the order they were submitted.
+		/// Returns a ticket for the request, or 0 if the region does not fit into the staging ring.
+		/// </summary>
+		/// <param name="tex">The texture to write to</param>
+		/// <param name="level">The mipmap level to write to</param>
+		/// <param name="offset">The offset into the texture to write to</param>
+		/// <param name="region">The size of the region to write</param>
+		/// <param name="comp">The component layout of the pixels fill writes</param>
+		/// <param name="form">The format of the pixels fill writes</param>
+		/// <param name="fill">Writes the tightly packed pixels into the staging ring</param>
+		/// <param name="priority">The priority of the request</param>
+		/// <param name="callback">Called once the upload has been issued</param>
+		uint64_t submit(Texture3dBase& tex, GLint level, const glm::ivec3& offset, const glm::ivec3& region, PixelComponent comp, PixelFormat form, Fill fill, int priority = 0, Callback callback = {}) {
+			assert(tex.boundsCheck(offset, region, level));
+			return push(tex, 3, level, offset, region, comp, form, std::move(fill), priority, std::move(callback));
+		}
+		uint64_t submit(Texture2dBase& tex, GLint level, const glm::ivec2& offset, const glm::ivec2& region, PixelComponent comp, PixelFormat form, Fill fill, int priority = 0, Callback callback = {}) {
+			assert(tex.boundsCheck(offset, region, level));
+			return push(tex, 2, level, glm::ivec3{ offset, 0 }, glm::ivec3{ region, 1 }, comp, form, std::move(fill), priority, std::move(callback));
+		}
+		uint64_t submit(Texture1dBase& tex, GLint level, GLint offset, GLint region, PixelComponent comp, PixelFormat form, Fill fill, int priority = 0, Callback callback = {}) {
+			assert(tex.boundsCheck(offset, region, level));
+			return push(tex, 1, level, glm::ivec3{ offset, 0, 0 }, glm::ivec3{ region, 1, 1 }, comp, form, std::move(fill), priority, std::move(callback));
+		}
+
+		// Queue an upload of tightly packed pixels, which a worker copies into the staging ring. The data must stay valid until the upload is issued.
+		template<typename Texture, typename Offset>
+		uint64_t submit(Texture& tex, GLint level, const Offset& offset, const Offset& region, PixelComponent comp, PixelFormat form, const void* data, int priority = 0, Callback callback = {}) {
+			assert(data != nullptr);
+			return submit(tex, level, offset, region, comp, form, [data](uint8_t* staging, size_t length) {
+				std::memcpy(staging, data, length);
+			}, priority, std::move(callback));
+		}
+
+		/*
+		Call once per frame on the render thread.
+		Issues the uploads the workers have finished, up to the frame budget, fences them,
+		then hands the highest priority requests to the workers while there is room in the staging ring.
+		The first upload of a frame is always issued, so a request larger than the budget still goes through.
+		*/
+		void update() {
+			issue(budget);
+			retire();
+			dispatch();
+		}
+
+		// Block until every queued request has been issued, ignoring the budget. Useful for loading screens.
+		void flush() {
+			while (!empty()) {
+				retire();
+				dispatch();
+				waitFinished();
+				issue(SIZE_MAX);
+				if (!pending.empty() && !allocations.empty() && allIssued()) {
+					// The ring is full of uploads the GPU has not finished reading, wait for the oldest of them.
+					waitOldestBatch();
+				}
+			}
+		}
+
+		// Settings ---
+		void setFrameBudget(size_t bytes) noexcept {
+			budget = bytes;
+		}
+		size_t getFrameBudget() const noexcept {
+			return budget;
+		}
+
+		// Statistics ---
+		// Requests that have not been handed to a worker yet.
+		size_t numPending() const noexcept {
+			return pending.size();
+		}
+		// Requests that are being written by the workers, or waiting to be issued.
+		size_t numInFlight() const noexcept {
+			size_t count = 0;
+			for (const Allocation& alloc : allocations) {
+				count += alloc.issued ? 0 : 1;
+			}
+			return count;
+		}
+		bool empty() const noexcept {
+			return pending.empty() && allIssued();
+		}
+
+		size_t bytesIssuedLastUpdate() const noexcept {
+			return issuedLastUpdate;
+		}
+		uint64_t bytesIssuedTotal() const noexcept {
+			return issuedTotal;
+		}
+		size_t stagingSize() const noexcept {
+			return ringBytes;
+		}
+		GLuint getId() const noexcept {
+			return buffer.getId();
+		}
+	private:
+		using Init = BufferInit;
+		using Flag = BufferFlag;
+
+		// Offsets into the unpack buffer must be aligned to the component size, this covers all of them.
+		static constexpr size_t StagingAlignment = 16;
+
+		struct Request {
+			GLuint texture;
+			uint32_t dimensions;
+			GLint level;
+			glm::ivec3 offset, region;
+			PixelComponent comp;
+			PixelFormat form;
+			size_t length;
+			Fill fill;
+			Callback callback;
+			int priority;
+			uint64_t ticket;
+		};
+
+		// A region of the staging ring, in the order they were allocated.
+		struct Allocation {
+			Request request;
+			size_t start;
+			uint64_t serial;
+			bool issued;
+		};
+
+		struct Job {
+			uint64_t ticket;
+			uint8_t* staging;
+			size_t length;
+			const Fill* fill;
+		};
+
+		struct Batch {
+			uint64_t serial;
+			Fence fence;
+		};
+
+		static size_t alignUp(size_t value, size_t alignment) noexcept {
+			return ((value + alignment - 1) / alignment) * alignment;
+		}
+
+		// Orders the heap so the highest priority, then the oldest ticket, is at the front.
+		static bool lowerPriority(const Request& a, const Request& b) noexcept {
+			return a.priority != b.priority ? a.priority < b.priority : a.ticket > b.ticket;
+		}
+
+		uint64_t push(const TextureBase& tex, uint32_t dimensions, GLint level, const glm::ivec3& offset, const glm::ivec3& region, PixelComponent comp, PixelFormat form, Fill fill, int priority, Callback callback) {
+			assert(tex.isValid());
+			assert(level >= 0);
+			assert(fill && "rt::TextureUploader requests need a fill function!");
+
+			size_t length = pixelSize(comp, form) * static_cast<size_t>(region.x) * static_cast<size_t>(region.y) * static_cast<size_t>(region.z);
+			if (length == 0 || length >= ringBytes) {
+				return 0;
+			}
+
+			uint64_t ticket = nextTicket++;
+			pending.push_back(Request{ tex.getId(), dimensions, level, offset, region, comp, form, length, std::move(fill), std::move(callback), priority, ticket });
+			std::push_heap(pending.begin(), pending.end(), lowerPriority);
+			return ticket;
+		}
+
+		// Carve length bytes out of the ring, returns false if there is not enough contiguous space.
+		bool allocate(size_t length, size_t& start) {
+			if (allocations.empty()) {
+				head = 0;
+				start = 0;
+				return length < ringBytes;
+			}
+
+			size_t tail = allocations.front().start;
+			size_t aligned = alignUp(head, StagingAlignment);
+			if (head >= tail) {
+				if (aligned + length <= ringBytes) {
+					start = aligned;
+					return true;
+				}
+				// Wrap around, the end of the ring is left as padding.
+				if (length < tail) {
+					start = 0;
+					return true;
+				}
+				return false;
+			}
+			if (aligned + length < tail) {
+				start = aligned;
+				return true;
+			}
+			return false;
+		}
+
+		void dispatch() {
+			bool queued = false;
+			while (!pending.empty() && filling < std::max<size_t>(budget, 1)) {
+				size_t start = 0;
+				if (!allocate(pending.front().length, start)) {
+					break;
+				}
+
+				std::pop_heap(pending.begin(), pending.end(), lowerPriority);
+				Request request = std::move(pending.back());
+				pending.pop_back();
+
+				head = start + request.length;
+				filling += request.length;
+				allocations.push_back(Allocation{ std::move(request), start, 0, false });
+
+				// Allocations is a deque, so the fill function stays put while the worker runs it.
+				const Allocation& alloc = allocations.back();
+				std::lock_guard<std::mutex> lock(mutex);
+				jobs.push_back(Job{ alloc.request.ticket, mapping + start, alloc.request.length, &alloc.request.fill });
+				queued = true;
+			}
+			if (queued) {
+				wake.notify_all();
+			}
+		}
+
+		void issue(size_t limit) {
+			std::vector<uint64_t> ready;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				ready.swap(finished);
+			}
+			readyTickets.insert(readyTickets.end(), ready.begin(), ready.end());
+
+			issuedLastUpdate = 0;
+			if (readyTickets.empty()) {
+				return;
+			}
+
+			GLint alignment = 4;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+			checkError();
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.getId());
+			checkError();
+
+			++serial;
+			std::vector<Callback> callbacks;
+			auto it = readyTickets.begin();
+			for (; it != readyTickets.end(); ++it) {
+				Allocation& alloc = findAllocation(*it);
+				if (issuedLastUpdate > 0 && issuedLastUpdate + alloc.request.length > limit) {
+					break;
+				}
+				upload(alloc);
+				alloc.issued = true;
+				alloc.serial = serial;
+				filling -= alloc.request.length;
+				issuedLastUpdate += alloc.request.length;
+				if (alloc.request.callback) {
+					callbacks.push_back(std::move(alloc.request.callback));
+				}
+			}
+			readyTickets.erase(readyTickets.begin(), it);
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+			checkError();
+
+			Batch batch{ serial, Fence{} };
+			batch.fence.init();
+			batches.push_back(std::move(batch));
+			issuedTotal += issuedLastUpdate;
+
+			for (Callback& callback : callbacks) {
+				callback();
+			}
+		}
+
+		void upload(const Allocation& alloc) {
+			const Request& req = alloc.request;
+			const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(alloc.start));
+			switch (req.dimensions) {
+			case 1:
+				glTextureSubImage1D(req.texture, req.level, req.offset.x, req.region.x, convertGL(req.comp), convertGL(req.comp, req.form), offset);
+				break;
+			case 2:
+				glTextureSubImage2D(req.texture, req.level, req.offset.x, req.offset.y, req.region.x, req.region.y, convertGL(req.comp), convertGL(req.comp, req.form), offset);
+				break;
+			default:
+				glTextureSubImage3D(req.texture, req.level, req.offset.x, req.offset.y, req.offset.z, req.region.x, req.region.y, req.region.z, convertGL(req.comp), convertGL(req.comp, req.form), offset);
+				break;
+			}
+			checkError();
+		}
+
+		// Free the staging space of every batch the GPU has finished with. Never blocks.
+		void retire() {
+			while (!batches.empty()) {
+				Batch& batch = batches.front();
+				FenceResult res = batch.fence.waitClient(0);
+				if (res != FenceResult::Signaled && res != FenceResult::Satisfied) {
+					break;
+				}
+				retired = batch.serial;
+				batches.pop_front();
+			}
+			release();
+		}
+
+		void waitOldestBatch() {
+			if (batches.empty()) {
+				return;
+			}
+			FenceResult res = batches.front().fence.waitClient(GL_TIMEOUT_IGNORED);
+			assert(res != FenceResult::Failed);
+			retired = batches.front().serial;
+			batches.pop_front();
+			release();
+		}
+
+		// The ring is freed in allocation order, so an upload still being written holds back everything after it.
+		void release() {
+			while (!allocations.empty() && allocations.front().issued && allocations.front().serial <= retired) {
+				allocations.pop_front();
+			}
+		}
+
+		Allocation& findAllocation(uint64_t ticket) {
+			auto it = std::find_if(allocations.begin(), allocations.end(), [ticket](const Allocation& alloc) {
+				return alloc.request.ticket == ticket;
+			});
+			assert(it != allocations.end());
+			return *it;
+		}
+
+		bool allIssued() const noexcept {
+			return std::all_of(allocations.begin(), allocations.end(), [](const Allocation& alloc) { return alloc.issued; });
+		}
+
+		// Block until at least one job has been written by the workers, if there are any.
+		void waitFinished() {
+			if (allIssued() || !readyTickets.empty()) {
+				return;
+			}
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this]() { return !finished.empty(); });
+		}
+
+		void workerLoop() {
+			while (true) {
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+					if (stopping) {
+						return;
+					}
+					job = jobs.front();
+					jobs.pop_front();
+				}
+
+				(*job.fill)(job.staging, job.length);
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					finished.push_back(job.ticket);
+				}
+				done.notify_all();
+			}
+		}
+
+		ImmutableBuffer buffer;
+		uint8_t* mapping;
+		size_t ringBytes;
+		size_t head;
+
+		std::deque<Allocation> allocations;
+		std::deque<Batch> batches;
+		// A heap ordered by lowerPriority.
+		std::vector<Request> pending;
+		// Tickets written by the workers, but not issued yet because of the budget.
+		std::vector<uint64_t> readyTickets;
+
+		// Shared with the workers, guarded by mutex.
+		std::deque<Job> jobs;
+		std::vector<uint64_t> finished;
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake, done;
+
+		size_t budget;
+		// Bytes handed to the workers that have not been issued yet.
+		size_t filling;
+		uint64_t nextTicket;
+		uint64_t serial, retired;
+		size_t issuedLastUpdate;
+		uint64_t issuedTotal;
+		bool stopping;
+	};
+}
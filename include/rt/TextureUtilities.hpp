@@ -2,6 +2,50 @@
 #include "Core.hpp"
 #include <cassert>
 
+// S3TC and ASTC are extensions, older headers may not have their formats.
+#if !defined(GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#if !defined(GL_COMPRESSED_SRGB_S3TC_DXT1_EXT)
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT 0x8C4E
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#if !defined(GL_COMPRESSED_RGBA_ASTC_4x4_KHR)
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#define GL_COMPRESSED_RGBA_ASTC_5x4_KHR 0x93B1
+#define GL_COMPRESSED_RGBA_ASTC_5x5_KHR 0x93B2
+#define GL_COMPRESSED_RGBA_ASTC_6x5_KHR 0x93B3
+#define GL_COMPRESSED_RGBA_ASTC_6x6_KHR 0x93B4
+#define GL_COMPRESSED_RGBA_ASTC_8x5_KHR 0x93B5
+#define GL_COMPRESSED_RGBA_ASTC_8x6_KHR 0x93B6
+#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR 0x93B7
+#define GL_COMPRESSED_RGBA_ASTC_10x5_KHR 0x93B8
+#define GL_COMPRESSED_RGBA_ASTC_10x6_KHR 0x93B9
+#define GL_COMPRESSED_RGBA_ASTC_10x8_KHR 0x93BA
+#define GL_COMPRESSED_RGBA_ASTC_10x10_KHR 0x93BB
+#define GL_COMPRESSED_RGBA_ASTC_12x10_KHR 0x93BC
+#define GL_COMPRESSED_RGBA_ASTC_12x12_KHR 0x93BD
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x4_KHR 0x93D1
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x5_KHR 0x93D2
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x5_KHR 0x93D3
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR 0x93D4
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x5_KHR 0x93D5
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x6_KHR 0x93D6
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR 0x93D7
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x5_KHR 0x93D8
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x6_KHR 0x93D9
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x8_KHR 0x93DA
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x10_KHR 0x93DB
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x10_KHR 0x93DC
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR 0x93DD
+#endif
+
 #ifdef RENDER_TOOLS_ERROR_CHECKS
 #define RT_ERROR(x) x;
 #else
@@ -61,6 +105,62 @@ namespace rt {
         // Stencil
         S8,
 
+        // Block compressed, S3TC, RGTC and BPTC
+        BC1,
+        BC1_SRGB,
+        BC2,
+        BC2_SRGB,
+        BC3,
+        BC3_SRGB,
+        BC4,
+        BC4_SN,
+        BC5,
+        BC5_SN,
+        BC6H_UF,
+        BC6H_SF,
+        BC7,
+        BC7_SRGB,
+
+        // Block compressed, ETC2 and EAC
+        ETC2,
+        ETC2_SRGB,
+        ETC2_A1,
+        ETC2_A1_SRGB,
+        ETC2_EAC,
+        ETC2_EAC_SRGB,
+        EAC,
+        EAC_SN,
+
+        // Block compressed, ASTC
+        ASTC_4x4,
+        ASTC_5x4,
+        ASTC_5x5,
+        ASTC_6x5,
+        ASTC_6x6,
+        ASTC_8x5,
+        ASTC_8x6,
+        ASTC_8x8,
+        ASTC_10x5,
+        ASTC_10x6,
+        ASTC_10x8,
+        ASTC_10x10,
+        ASTC_12x10,
+        ASTC_12x12,
+        ASTC_4x4_SRGB,
+        ASTC_5x4_SRGB,
+        ASTC_5x5_SRGB,
+        ASTC_6x5_SRGB,
+        ASTC_6x6_SRGB,
+        ASTC_8x5_SRGB,
+        ASTC_8x6_SRGB,
+        ASTC_8x8_SRGB,
+        ASTC_10x5_SRGB,
+        ASTC_10x6_SRGB,
+        ASTC_10x8_SRGB,
+        ASTC_10x10_SRGB,
+        ASTC_12x10_SRGB,
+        ASTC_12x12_SRGB,
+
         _Count
     };
 
@@ -142,7 +242,67 @@ namespace rt {
         // Stencil
         S8 = (int)TexType::S8,
 
-        _Count = 54
+        // Block compressed, S3TC, RGTC and BPTC
+        RGB_BC1 = (int)TexComponent::RGB | (int)TexType::BC1,
+        RGBA_BC1 = (int)TexComponent::RGBA | (int)TexType::BC1,
+        RGB_BC1_SRGB = (int)TexComponent::RGB | (int)TexType::BC1_SRGB,
+        RGBA_BC1_SRGB = (int)TexComponent::RGBA | (int)TexType::BC1_SRGB,
+        RGBA_BC2 = (int)TexComponent::RGBA | (int)TexType::BC2,
+        RGBA_BC2_SRGB = (int)TexComponent::RGBA | (int)TexType::BC2_SRGB,
+        RGBA_BC3 = (int)TexComponent::RGBA | (int)TexType::BC3,
+        RGBA_BC3_SRGB = (int)TexComponent::RGBA | (int)TexType::BC3_SRGB,
+        R_BC4 = (int)TexComponent::R | (int)TexType::BC4,
+        R_BC4_SN = (int)TexComponent::R | (int)TexType::BC4_SN,
+        RG_BC5 = (int)TexComponent::RG | (int)TexType::BC5,
+        RG_BC5_SN = (int)TexComponent::RG | (int)TexType::BC5_SN,
+        RGB_BC6H_UF = (int)TexComponent::RGB | (int)TexType::BC6H_UF,
+        RGB_BC6H_SF = (int)TexComponent::RGB | (int)TexType::BC6H_SF,
+        RGBA_BC7 = (int)TexComponent::RGBA | (int)TexType::BC7,
+        RGBA_BC7_SRGB = (int)TexComponent::RGBA | (int)TexType::BC7_SRGB,
+
+        // Block compressed, ETC2 and EAC
+        RGB_ETC2 = (int)TexComponent::RGB | (int)TexType::ETC2,
+        RGB_ETC2_SRGB = (int)TexComponent::RGB | (int)TexType::ETC2_SRGB,
+        RGBA_ETC2_A1 = (int)TexComponent::RGBA | (int)TexType::ETC2_A1,
+        RGBA_ETC2_A1_SRGB = (int)TexComponent::RGBA | (int)TexType::ETC2_A1_SRGB,
+        RGBA_ETC2_EAC = (int)TexComponent::RGBA | (int)TexType::ETC2_EAC,
+        RGBA_ETC2_EAC_SRGB = (int)TexComponent::RGBA | (int)TexType::ETC2_EAC_SRGB,
+        R_EAC = (int)TexComponent::R | (int)TexType::EAC,
+        R_EAC_SN = (int)TexComponent::R | (int)TexType::EAC_SN,
+        RG_EAC = (int)TexComponent::RG | (int)TexType::EAC,
+        RG_EAC_SN = (int)TexComponent::RG | (int)TexType::EAC_SN,
+
+        // Block compressed, ASTC
+        RGBA_ASTC_4x4 = (int)TexComponent::RGBA | (int)TexType::ASTC_4x4,
+        RGBA_ASTC_5x4 = (int)TexComponent::RGBA | (int)TexType::ASTC_5x4,
+        RGBA_ASTC_5x5 = (int)TexComponent::RGBA | (int)TexType::ASTC_5x5,
+        RGBA_ASTC_6x5 = (int)TexComponent::RGBA | (int)TexType::ASTC_6x5,
+        RGBA_ASTC_6x6 = (int)TexComponent::RGBA | (int)TexType::ASTC_6x6,
+        RGBA_ASTC_8x5 = (int)TexComponent::RGBA | (int)TexType::ASTC_8x5,
+        RGBA_ASTC_8x6 = (int)TexComponent::RGBA | (int)TexType::ASTC_8x6,
+        RGBA_ASTC_8x8 = (int)TexComponent::RGBA | (int)TexType::ASTC_8x8,
+        RGBA_ASTC_10x5 = (int)TexComponent::RGBA | (int)TexType::ASTC_10x5,
+        RGBA_ASTC_10x6 = (int)TexComponent::RGBA | (int)TexType::ASTC_10x6,
+        RGBA_ASTC_10x8 = (int)TexComponent::RGBA | (int)TexType::ASTC_10x8,
+        RGBA_ASTC_10x10 = (int)TexComponent::RGBA | (int)TexType::ASTC_10x10,
+        RGBA_ASTC_12x10 = (int)TexComponent::RGBA | (int)TexType::ASTC_12x10,
+        RGBA_ASTC_12x12 = (int)TexComponent::RGBA | (int)TexType::ASTC_12x12,
+        RGBA_ASTC_4x4_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_4x4_SRGB,
+        RGBA_ASTC_5x4_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_5x4_SRGB,
+        RGBA_ASTC_5x5_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_5x5_SRGB,
+        RGBA_ASTC_6x5_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_6x5_SRGB,
+        RGBA_ASTC_6x6_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_6x6_SRGB,
+        RGBA_ASTC_8x5_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_8x5_SRGB,
+        RGBA_ASTC_8x6_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_8x6_SRGB,
+        RGBA_ASTC_8x8_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_8x8_SRGB,
+        RGBA_ASTC_10x5_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_10x5_SRGB,
+        RGBA_ASTC_10x6_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_10x6_SRGB,
+        RGBA_ASTC_10x8_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_10x8_SRGB,
+        RGBA_ASTC_10x10_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_10x10_SRGB,
+        RGBA_ASTC_12x10_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_12x10_SRGB,
+        RGBA_ASTC_12x12_SRGB = (int)TexComponent::RGBA | (int)TexType::ASTC_12x12_SRGB,
+
+        _Count = 108
     };
 
     enum class PixelComponent {
@@ -238,6 +398,106 @@ namespace rt {
             return intern::makeView("D32_S8");
         case TexType::S8:
             return intern::makeView("S8");
+        case TexType::BC1:
+            return intern::makeView("BC1");
+        case TexType::BC1_SRGB:
+            return intern::makeView("BC1_SRGB");
+        case TexType::BC2:
+            return intern::makeView("BC2");
+        case TexType::BC2_SRGB:
+            return intern::makeView("BC2_SRGB");
+        case TexType::BC3:
+            return intern::makeView("BC3");
+        case TexType::BC3_SRGB:
+            return intern::makeView("BC3_SRGB");
+        case TexType::BC4:
+            return intern::makeView("BC4");
+        case TexType::BC4_SN:
+            return intern::makeView("BC4_SN");
+        case TexType::BC5:
+            return intern::makeView("BC5");
+        case TexType::BC5_SN:
+            return intern::makeView("BC5_SN");
+        case TexType::BC6H_UF:
+            return intern::makeView("BC6H_UF");
+        case TexType::BC6H_SF:
+            return intern::makeView("BC6H_SF");
+        case TexType::BC7:
+            return intern::makeView("BC7");
+        case TexType::BC7_SRGB:
+            return intern::makeView("BC7_SRGB");
+        case TexType::ETC2:
+            return intern::makeView("ETC2");
+        case TexType::ETC2_SRGB:
+            return intern::makeView("ETC2_SRGB");
+        case TexType::ETC2_A1:
+            return intern::makeView("ETC2_A1");
+        case TexType::ETC2_A1_SRGB:
+            return intern::makeView("ETC2_A1_SRGB");
+        case TexType::ETC2_EAC:
+            return intern::makeView("ETC2_EAC");
+        case TexType::ETC2_EAC_SRGB:
+            return intern::makeView("ETC2_EAC_SRGB");
+        case TexType::EAC:
+            return intern::makeView("EAC");
+        case TexType::EAC_SN:
+            return intern::makeView("EAC_SN");
+        case TexType::ASTC_4x4:
+            return intern::makeView("ASTC_4x4");
+        case TexType::ASTC_5x4:
+            return intern::makeView("ASTC_5x4");
+        case TexType::ASTC_5x5:
+            return intern::makeView("ASTC_5x5");
+        case TexType::ASTC_6x5:
+            return intern::makeView("ASTC_6x5");
+        case TexType::ASTC_6x6:
+            return intern::makeView("ASTC_6x6");
+        case TexType::ASTC_8x5:
+            return intern::makeView("ASTC_8x5");
+        case TexType::ASTC_8x6:
+            return intern::makeView("ASTC_8x6");
+        case TexType::ASTC_8x8:
+            return intern::makeView("ASTC_8x8");
+        case TexType::ASTC_10x5:
+            return intern::makeView("ASTC_10x5");
+        case TexType::ASTC_10x6:
+            return intern::makeView("ASTC_10x6");
+        case TexType::ASTC_10x8:
+            return intern::makeView("ASTC_10x8");
+        case TexType::ASTC_10x10:
+            return intern::makeView("ASTC_10x10");
+        case TexType::ASTC_12x10:
+            return intern::makeView("ASTC_12x10");
+        case TexType::ASTC_12x12:
+            return intern::makeView("ASTC_12x12");
+        case TexType::ASTC_4x4_SRGB:
+            return intern::makeView("ASTC_4x4_SRGB");
+        case TexType::ASTC_5x4_SRGB:
+            return intern::makeView("ASTC_5x4_SRGB");
+        case TexType::ASTC_5x5_SRGB:
+            return intern::makeView("ASTC_5x5_SRGB");
+        case TexType::ASTC_6x5_SRGB:
+            return intern::makeView("ASTC_6x5_SRGB");
+        case TexType::ASTC_6x6_SRGB:
+            return intern::makeView("ASTC_6x6_SRGB");
+        case TexType::ASTC_8x5_SRGB:
+            return intern::makeView("ASTC_8x5_SRGB");
+        case TexType::ASTC_8x6_SRGB:
+            return intern::makeView("ASTC_8x6_SRGB");
+        case TexType::ASTC_8x8_SRGB:
+            return intern::makeView("ASTC_8x8_SRGB");
+        case TexType::ASTC_10x5_SRGB:
+            return intern::makeView("ASTC_10x5_SRGB");
+        case TexType::ASTC_10x6_SRGB:
+            return intern::makeView("ASTC_10x6_SRGB");
+        case TexType::ASTC_10x8_SRGB:
+            return intern::makeView("ASTC_10x8_SRGB");
+        case TexType::ASTC_10x10_SRGB:
+            return intern::makeView("ASTC_10x10_SRGB");
+        case TexType::ASTC_12x10_SRGB:
+            return intern::makeView("ASTC_12x10_SRGB");
+        case TexType::ASTC_12x12_SRGB:
+            return intern::makeView("ASTC_12x12_SRGB");
         }
         RT_ERROR(fmt::print(stderr, "Unexpected value passed into rt::to_string_view! Expected a TexType enumerator."));
         assert(false);
@@ -353,6 +613,114 @@ namespace rt {
 	        return intern::makeView("D32_S8");
         case TexFormat::S8:
 	        return intern::makeView("S8");
+        case TexFormat::RGB_BC1:
+            return intern::makeView("RGB_BC1");
+        case TexFormat::RGBA_BC1:
+            return intern::makeView("RGBA_BC1");
+        case TexFormat::RGB_BC1_SRGB:
+            return intern::makeView("RGB_BC1_SRGB");
+        case TexFormat::RGBA_BC1_SRGB:
+            return intern::makeView("RGBA_BC1_SRGB");
+        case TexFormat::RGBA_BC2:
+            return intern::makeView("RGBA_BC2");
+        case TexFormat::RGBA_BC2_SRGB:
+            return intern::makeView("RGBA_BC2_SRGB");
+        case TexFormat::RGBA_BC3:
+            return intern::makeView("RGBA_BC3");
+        case TexFormat::RGBA_BC3_SRGB:
+            return intern::makeView("RGBA_BC3_SRGB");
+        case TexFormat::R_BC4:
+            return intern::makeView("R_BC4");
+        case TexFormat::R_BC4_SN:
+            return intern::makeView("R_BC4_SN");
+        case TexFormat::RG_BC5:
+            return intern::makeView("RG_BC5");
+        case TexFormat::RG_BC5_SN:
+            return intern::makeView("RG_BC5_SN");
+        case TexFormat::RGB_BC6H_UF:
+            return intern::makeView("RGB_BC6H_UF");
+        case TexFormat::RGB_BC6H_SF:
+            return intern::makeView("RGB_BC6H_SF");
+        case TexFormat::RGBA_BC7:
+            return intern::makeView("RGBA_BC7");
+        case TexFormat::RGBA_BC7_SRGB:
+            return intern::makeView("RGBA_BC7_SRGB");
+        case TexFormat::RGB_ETC2:
+            return intern::makeView("RGB_ETC2");
+        case TexFormat::RGB_ETC2_SRGB:
+            return intern::makeView("RGB_ETC2_SRGB");
+        case TexFormat::RGBA_ETC2_A1:
+            return intern::makeView("RGBA_ETC2_A1");
+        case TexFormat::RGBA_ETC2_A1_SRGB:
+            return intern::makeView("RGBA_ETC2_A1_SRGB");
+        case TexFormat::RGBA_ETC2_EAC:
+            return intern::makeView("RGBA_ETC2_EAC");
+        case TexFormat::RGBA_ETC2_EAC_SRGB:
+            return intern::makeView("RGBA_ETC2_EAC_SRGB");
+        case TexFormat::R_EAC:
+            return intern::makeView("R_EAC");
+        case TexFormat::R_EAC_SN:
+            return intern::makeView("R_EAC_SN");
+        case TexFormat::RG_EAC:
+            return intern::makeView("RG_EAC");
+        case TexFormat::RG_EAC_SN:
+            return intern::makeView("RG_EAC_SN");
+        case TexFormat::RGBA_ASTC_4x4:
+            return intern::makeView("RGBA_ASTC_4x4");
+        case TexFormat::RGBA_ASTC_5x4:
+            return intern::makeView("RGBA_ASTC_5x4");
+        case TexFormat::RGBA_ASTC_5x5:
+            return intern::makeView("RGBA_ASTC_5x5");
+        case TexFormat::RGBA_ASTC_6x5:
+            return intern::makeView("RGBA_ASTC_6x5");
+        case TexFormat::RGBA_ASTC_6x6:
+            return intern::makeView("RGBA_ASTC_6x6");
+        case TexFormat::RGBA_ASTC_8x5:
+            return intern::makeView("RGBA_ASTC_8x5");
+        case TexFormat::RGBA_ASTC_8x6:
+            return intern::makeView("RGBA_ASTC_8x6");
+        case TexFormat::RGBA_ASTC_8x8:
+            return intern::makeView("RGBA_ASTC_8x8");
+        case TexFormat::RGBA_ASTC_10x5:
+            return intern::makeView("RGBA_ASTC_10x5");
+        case TexFormat::RGBA_ASTC_10x6:
+            return intern::makeView("RGBA_ASTC_10x6");
+        case TexFormat::RGBA_ASTC_10x8:
+            return intern::makeView("RGBA_ASTC_10x8");
+        case TexFormat::RGBA_ASTC_10x10:
+            return intern::makeView("RGBA_ASTC_10x10");
+        case TexFormat::RGBA_ASTC_12x10:
+            return intern::makeView("RGBA_ASTC_12x10");
+        case TexFormat::RGBA_ASTC_12x12:
+            return intern::makeView("RGBA_ASTC_12x12");
+        case TexFormat::RGBA_ASTC_4x4_SRGB:
+            return intern::makeView("RGBA_ASTC_4x4_SRGB");
+        case TexFormat::RGBA_ASTC_5x4_SRGB:
+            return intern::makeView("RGBA_ASTC_5x4_SRGB");
+        case TexFormat::RGBA_ASTC_5x5_SRGB:
+            return intern::makeView("RGBA_ASTC_5x5_SRGB");
+        case TexFormat::RGBA_ASTC_6x5_SRGB:
+            return intern::makeView("RGBA_ASTC_6x5_SRGB");
+        case TexFormat::RGBA_ASTC_6x6_SRGB:
+            return intern::makeView("RGBA_ASTC_6x6_SRGB");
+        case TexFormat::RGBA_ASTC_8x5_SRGB:
+            return intern::makeView("RGBA_ASTC_8x5_SRGB");
+        case TexFormat::RGBA_ASTC_8x6_SRGB:
+            return intern::makeView("RGBA_ASTC_8x6_SRGB");
+        case TexFormat::RGBA_ASTC_8x8_SRGB:
+            return intern::makeView("RGBA_ASTC_8x8_SRGB");
+        case TexFormat::RGBA_ASTC_10x5_SRGB:
+            return intern::makeView("RGBA_ASTC_10x5_SRGB");
+        case TexFormat::RGBA_ASTC_10x6_SRGB:
+            return intern::makeView("RGBA_ASTC_10x6_SRGB");
+        case TexFormat::RGBA_ASTC_10x8_SRGB:
+            return intern::makeView("RGBA_ASTC_10x8_SRGB");
+        case TexFormat::RGBA_ASTC_10x10_SRGB:
+            return intern::makeView("RGBA_ASTC_10x10_SRGB");
+        case TexFormat::RGBA_ASTC_12x10_SRGB:
+            return intern::makeView("RGBA_ASTC_12x10_SRGB");
+        case TexFormat::RGBA_ASTC_12x12_SRGB:
+            return intern::makeView("RGBA_ASTC_12x12_SRGB");
         }
         RT_ERROR(fmt::print(stderr, "Unexpected value passed into rt::to_string_view! Expected a TexFormat enumerator."));
         assert(false);
@@ -425,6 +793,54 @@ namespace rt {
         return {};
     }
 
+    static constexpr int componentCount(PixelComponent comp) noexcept {
+        switch (comp) {
+        case PixelComponent::R:
+        case PixelComponent::Depth:
+        case PixelComponent::Stencil:
+            return 1;
+        case PixelComponent::RG:
+            return 2;
+        case PixelComponent::RGB:
+        case PixelComponent::BGR:
+            return 3;
+        case PixelComponent::RGBA:
+        case PixelComponent::BGRA:
+            return 4;
+        }
+        return 0;
+    }
+
+    // The size in bytes of a single tightly packed pixel, with the given component layout and format.
+    static constexpr size_t pixelSize(PixelComponent comp, PixelFormat format) noexcept {
+        switch (format) {
+        case PixelFormat::U8:
+            return 1 * componentCount(comp);
+        case PixelFormat::U16:
+        case PixelFormat::F16:
+            return 2 * componentCount(comp);
+        case PixelFormat::U24:
+        case PixelFormat::U32:
+        case PixelFormat::F32:
+            return 4 * componentCount(comp);
+        case PixelFormat::U8_3_3_2:
+        case PixelFormat::RU8_3_3_2:
+            return 1;
+        case PixelFormat::U16_5_6_5:
+        case PixelFormat::RU16_5_6_5:
+        case PixelFormat::U16_4_4_4_4:
+        case PixelFormat::RU16_4_4_4_4:
+        case PixelFormat::U16_5_5_5_1:
+        case PixelFormat::RU16_5_5_5_1:
+            return 2;
+        case PixelFormat::U32_8_8_8_8:
+        case PixelFormat::RU32_8_8_8_8:
+        case PixelFormat::U32_10_10_10_2:
+        case PixelFormat::RU32_10_10_10_2:
+            return 4;
+        }
+        return 0;
+    }
 
     static TexFormat combine(TexComponent comp, TexType size) noexcept {
         return static_cast<TexFormat>((int)comp | (int)size);
@@ -438,6 +854,97 @@ namespace rt {
         return static_cast<TexComponent>((int)format & 0xFFFF00);
     }
 
+    // True for the block compressed formats, which are written with compressedSubImage instead of subImage.
+    static constexpr bool isCompressed(TexType type) noexcept {
+        return static_cast<int>(type) >= static_cast<int>(TexType::BC1) && static_cast<int>(type) < static_cast<int>(TexType::_Count);
+    }
+    static constexpr bool isCompressed(TexFormat format) noexcept {
+        return isCompressed(static_cast<TexType>((int)format & 0xFF));
+    }
+
+    // The size of a compression block in texels, 1 by 1 for uncompressed formats.
+    static glm::ivec2 blockSize(TexFormat format) noexcept {
+        switch (static_cast<TexType>((int)format & 0xFF)) {
+        case TexType::ASTC_4x4:
+        case TexType::ASTC_4x4_SRGB:
+            return glm::ivec2{ 4, 4 };
+        case TexType::ASTC_5x4:
+        case TexType::ASTC_5x4_SRGB:
+            return glm::ivec2{ 5, 4 };
+        case TexType::ASTC_5x5:
+        case TexType::ASTC_5x5_SRGB:
+            return glm::ivec2{ 5, 5 };
+        case TexType::ASTC_6x5:
+        case TexType::ASTC_6x5_SRGB:
+            return glm::ivec2{ 6, 5 };
+        case TexType::ASTC_6x6:
+        case TexType::ASTC_6x6_SRGB:
+            return glm::ivec2{ 6, 6 };
+        case TexType::ASTC_8x5:
+        case TexType::ASTC_8x5_SRGB:
+            return glm::ivec2{ 8, 5 };
+        case TexType::ASTC_8x6:
+        case TexType::ASTC_8x6_SRGB:
+            return glm::ivec2{ 8, 6 };
+        case TexType::ASTC_8x8:
+        case TexType::ASTC_8x8_SRGB:
+            return glm::ivec2{ 8, 8 };
+        case TexType::ASTC_10x5:
+        case TexType::ASTC_10x5_SRGB:
+            return glm::ivec2{ 10, 5 };
+        case TexType::ASTC_10x6:
+        case TexType::ASTC_10x6_SRGB:
+            return glm::ivec2{ 10, 6 };
+        case TexType::ASTC_10x8:
+        case TexType::ASTC_10x8_SRGB:
+            return glm::ivec2{ 10, 8 };
+        case TexType::ASTC_10x10:
+        case TexType::ASTC_10x10_SRGB:
+            return glm::ivec2{ 10, 10 };
+        case TexType::ASTC_12x10:
+        case TexType::ASTC_12x10_SRGB:
+            return glm::ivec2{ 12, 10 };
+        case TexType::ASTC_12x12:
+        case TexType::ASTC_12x12_SRGB:
+            return glm::ivec2{ 12, 12 };
+        default:
+            return isCompressed(format) ? glm::ivec2{ 4, 4 } : glm::ivec2{ 1, 1 };
+        }
+    }
+
+    // The size of a compression block in bytes, 0 for uncompressed formats.
+    static constexpr size_t blockBytes(TexFormat format) noexcept {
+        if (!isCompressed(format)) {
+            return 0;
+        }
+        switch (format) {
+        case TexFormat::RGB_BC1:
+        case TexFormat::RGBA_BC1:
+        case TexFormat::RGB_BC1_SRGB:
+        case TexFormat::RGBA_BC1_SRGB:
+        case TexFormat::R_BC4:
+        case TexFormat::R_BC4_SN:
+        case TexFormat::RGB_ETC2:
+        case TexFormat::RGB_ETC2_SRGB:
+        case TexFormat::RGBA_ETC2_A1:
+        case TexFormat::RGBA_ETC2_A1_SRGB:
+        case TexFormat::R_EAC:
+        case TexFormat::R_EAC_SN:
+            return 8;
+        default:
+            return 16;
+        }
+    }
+
+    // The number of bytes a compressed image of the given size takes up, partial blocks at the edges count as whole ones.
+    static size_t compressedSize(TexFormat format, const glm::ivec3& size) noexcept {
+        assert(isCompressed(format));
+        glm::ivec2 block = blockSize(format);
+        size_t blocksX = static_cast<size_t>((size.x + block.x - 1) / block.x);
+        size_t blocksY = static_cast<size_t>((size.y + block.y - 1) / block.y);
+        return blocksX * blocksY * static_cast<size_t>(size.z) * blockBytes(format);
+    }
+
     static bool isCompatible(TexComponent tcomp, PixelComponent pcomp) {
         switch (tcomp) {
         case TexComponent::R:
@@ -590,6 +1097,114 @@ namespace rt {
             return GL_DEPTH32F_STENCIL8;
         case TexFormat::S8:
             return GL_STENCIL_INDEX8;
+        case TexFormat::RGB_BC1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case TexFormat::RGBA_BC1:
+            return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case TexFormat::RGB_BC1_SRGB:
+            return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+        case TexFormat::RGBA_BC1_SRGB:
+            return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+        case TexFormat::RGBA_BC2:
+            return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+        case TexFormat::RGBA_BC2_SRGB:
+            return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+        case TexFormat::RGBA_BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case TexFormat::RGBA_BC3_SRGB:
+            return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+        case TexFormat::R_BC4:
+            return GL_COMPRESSED_RED_RGTC1;
+        case TexFormat::R_BC4_SN:
+            return GL_COMPRESSED_SIGNED_RED_RGTC1;
+        case TexFormat::RG_BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        case TexFormat::RG_BC5_SN:
+            return GL_COMPRESSED_SIGNED_RG_RGTC2;
+        case TexFormat::RGB_BC6H_UF:
+            return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+        case TexFormat::RGB_BC6H_SF:
+            return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+        case TexFormat::RGBA_BC7:
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case TexFormat::RGBA_BC7_SRGB:
+            return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+        case TexFormat::RGB_ETC2:
+            return GL_COMPRESSED_RGB8_ETC2;
+        case TexFormat::RGB_ETC2_SRGB:
+            return GL_COMPRESSED_SRGB8_ETC2;
+        case TexFormat::RGBA_ETC2_A1:
+            return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+        case TexFormat::RGBA_ETC2_A1_SRGB:
+            return GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+        case TexFormat::RGBA_ETC2_EAC:
+            return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case TexFormat::RGBA_ETC2_EAC_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+        case TexFormat::R_EAC:
+            return GL_COMPRESSED_R11_EAC;
+        case TexFormat::R_EAC_SN:
+            return GL_COMPRESSED_SIGNED_R11_EAC;
+        case TexFormat::RG_EAC:
+            return GL_COMPRESSED_RG11_EAC;
+        case TexFormat::RG_EAC_SN:
+            return GL_COMPRESSED_SIGNED_RG11_EAC;
+        case TexFormat::RGBA_ASTC_4x4:
+            return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+        case TexFormat::RGBA_ASTC_5x4:
+            return GL_COMPRESSED_RGBA_ASTC_5x4_KHR;
+        case TexFormat::RGBA_ASTC_5x5:
+            return GL_COMPRESSED_RGBA_ASTC_5x5_KHR;
+        case TexFormat::RGBA_ASTC_6x5:
+            return GL_COMPRESSED_RGBA_ASTC_6x5_KHR;
+        case TexFormat::RGBA_ASTC_6x6:
+            return GL_COMPRESSED_RGBA_ASTC_6x6_KHR;
+        case TexFormat::RGBA_ASTC_8x5:
+            return GL_COMPRESSED_RGBA_ASTC_8x5_KHR;
+        case TexFormat::RGBA_ASTC_8x6:
+            return GL_COMPRESSED_RGBA_ASTC_8x6_KHR;
+        case TexFormat::RGBA_ASTC_8x8:
+            return GL_COMPRESSED_RGBA_ASTC_8x8_KHR;
+        case TexFormat::RGBA_ASTC_10x5:
+            return GL_COMPRESSED_RGBA_ASTC_10x5_KHR;
+        case TexFormat::RGBA_ASTC_10x6:
+            return GL_COMPRESSED_RGBA_ASTC_10x6_KHR;
+        case TexFormat::RGBA_ASTC_10x8:
+            return GL_COMPRESSED_RGBA_ASTC_10x8_KHR;
+        case TexFormat::RGBA_ASTC_10x10:
+            return GL_COMPRESSED_RGBA_ASTC_10x10_KHR;
+        case TexFormat::RGBA_ASTC_12x10:
+            return GL_COMPRESSED_RGBA_ASTC_12x10_KHR;
+        case TexFormat::RGBA_ASTC_12x12:
+            return GL_COMPRESSED_RGBA_ASTC_12x12_KHR;
+        case TexFormat::RGBA_ASTC_4x4_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR;
+        case TexFormat::RGBA_ASTC_5x4_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x4_KHR;
+        case TexFormat::RGBA_ASTC_5x5_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x5_KHR;
+        case TexFormat::RGBA_ASTC_6x5_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x5_KHR;
+        case TexFormat::RGBA_ASTC_6x6_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR;
+        case TexFormat::RGBA_ASTC_8x5_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x5_KHR;
+        case TexFormat::RGBA_ASTC_8x6_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x6_KHR;
+        case TexFormat::RGBA_ASTC_8x8_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR;
+        case TexFormat::RGBA_ASTC_10x5_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x5_KHR;
+        case TexFormat::RGBA_ASTC_10x6_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x6_KHR;
+        case TexFormat::RGBA_ASTC_10x8_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x8_KHR;
+        case TexFormat::RGBA_ASTC_10x10_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x10_KHR;
+        case TexFormat::RGBA_ASTC_12x10_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x10_KHR;
+        case TexFormat::RGBA_ASTC_12x12_SRGB:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR;
         default:
             RT_ERROR(fmt::print(stderr, "Unexpected value passed into rt::convertGL! Expected a TexFormat enumerator."));
             assert(false);
@@ -0,0 +1,229 @@
+#pragma once
+#include "Core.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace rt {
+	enum class UniformType : GLenum;
+
+	enum class UniformMode {
+		// Every uniform call is sent to opengl right away, this is the default.
+		Immediate,
+
+		// Values are shadowed per location, and calls that would not change the value are skipped.
+		Cached,
+
+		// Values are shadowed per location and staged. Changed values are sent to opengl once, by the next draw through
+		// rt::VertexArray, or when the program is bound or flushed. Several changes between two draws cost a single call.
+		Deferred,
+	};
+
+	/*
+	Shadow copy of the values of a program's uniforms, indexed by location.
+	Every element of an array has a location of its own and is shadowed there, so writes of overlapping arrays and
+	single elements compare against, and update, the same values that opengl holds.
+	Values are packed into a single staging block, with each value starting on a 16 byte boundary like std140.
+	Note that the cache cannot see uniform changes made without going through rt::Program.
+	*/
+	class UniformCache {
+	public:
+		UniformCache()
+			: entries()
+			, arrays()
+			, staging()
+			, dirty()
+			, scratch()
+			, mode(UniformMode::Immediate)
+			, issued(0)
+			, skipped(0)
+		{}
+
+		UniformMode getMode() const noexcept {
+			return mode;
+		}
+		// Immediate mode does not record values, so the shadow copy is dropped when switching into or out of it.
+		void setMode(UniformMode nmode) noexcept {
+			if (nmode != mode && (nmode == UniformMode::Immediate || mode == UniformMode::Immediate)) {
+				invalidate();
+			}
+			mode = nmode;
+		}
+
+		bool isEnabled() const noexcept {
+			return mode != UniformMode::Immediate;
+		}
+
+		// Which locations make up one array, so elements written one at a time can still be flushed as a single upload.
+		// Filled in from reflection once the program is linked.
+		void addArray(GLint location, GLint size) {
+			if (location < 0 || size <= 1) {
+				return;
+			}
+			size_t end = static_cast<size_t>(location) + static_cast<size_t>(size);
+			if (arrays.size() < end) {
+				arrays.resize(end, -1);
+			}
+			for (size_t i = static_cast<size_t>(location); i < end; ++i) {
+				arrays[i] = location;
+			}
+		}
+		void clearArrays() {
+			arrays.clear();
+		}
+
+		// Record new values for count elements starting at location. Returns true if the caller should send the values to opengl now.
+		bool update(GLint location, UniformType type, const void* data, size_t size, GLsizei count, bool transpose = false) {
+			if (mode == UniformMode::Immediate) {
+				++issued;
+				return true;
+			}
+			if (location < 0 || count <= 0) {
+				// Opengl silently ignores location -1, so we can too.
+				return false;
+			}
+
+			size_t elementSize = size / static_cast<size_t>(count);
+			const uint8_t* values = static_cast<const uint8_t*>(data);
+			bool changed = false;
+			for (GLsizei i = 0; i < count; ++i) {
+				Entry& entry = get(location + i);
+				const uint8_t* value = values + static_cast<size_t>(i) * elementSize;
+				if (entry.valid && entry.size == elementSize && entry.type == type && entry.transpose == transpose &&
+					std::memcmp(staging.data() + entry.offset, value, elementSize) == 0) {
+					continue;
+				}
+				changed = true;
+
+				if (!entry.valid || entry.size < elementSize) {
+					size_t offset = (staging.size() + Alignment - 1) & ~(Alignment - 1);
+					staging.resize(offset + elementSize);
+					entry.offset = static_cast<uint32_t>(offset);
+				}
+				std::memcpy(staging.data() + entry.offset, value, elementSize);
+
+				entry.size = static_cast<uint32_t>(elementSize);
+				entry.type = type;
+				entry.base = arrayOf(location + i, location);
+				entry.transpose = transpose;
+				entry.valid = true;
+
+				if (mode == UniformMode::Deferred && !entry.dirty) {
+					entry.dirty = true;
+					dirty.push_back(location + i);
+				}
+			}
+
+			if (!changed) {
+				++skipped;
+				return false;
+			}
+			if (mode == UniformMode::Deferred) {
+				return false;
+			}
+			++issued;
+			return true;
+		}
+
+		/*
+		Send every staged value to opengl, through the upload function.
+		Staged elements at consecutive locations that were written as one array go out together, as one call.
+		The upload function is called as upload(location, type, data, count, transpose).
+		*/
+		template<typename F>
+		void flush(F&& upload) {
+			std::sort(dirty.begin(), dirty.end());
+			size_t i = 0;
+			while (i < dirty.size()) {
+				GLint first = dirty[i];
+				const Entry& head = entries[first];
+				size_t run = 1;
+				while (i + run < dirty.size() && dirty[i + run] == first + static_cast<GLint>(run)) {
+					const Entry& next = entries[dirty[i + run]];
+					// Neighbouring locations can belong to different uniforms, an upload must not run past the end of an array.
+					if (next.base != head.base || next.type != head.type || next.size != head.size || next.transpose != head.transpose) {
+						break;
+					}
+					++run;
+				}
+
+				const void* data = staging.data() + head.offset;
+				if (run > 1) {
+					scratch.resize(run * head.size);
+					for (size_t j = 0; j < run; ++j) {
+						std::memcpy(scratch.data() + j * head.size, staging.data() + entries[first + static_cast<GLint>(j)].offset, head.size);
+					}
+					data = scratch.data();
+				}
+				upload(first, head.type, data, static_cast<GLsizei>(run), head.transpose);
+				++issued;
+
+				for (size_t j = 0; j < run; ++j) {
+					entries[first + static_cast<GLint>(j)].dirty = false;
+				}
+				i += run;
+			}
+			dirty.clear();
+		}
+
+		bool hasPending() const noexcept {
+			return !dirty.empty();
+		}
+
+		// Forget all of the shadowed values, for example after the program was relinked.
+		void invalidate() {
+			entries.clear();
+			staging.clear();
+			dirty.clear();
+		}
+
+		// The number of uniform updates actually sent to opengl.
+		uint64_t issuedCount() const noexcept {
+			return issued;
+		}
+		// The number of uniform updates skipped, because the value did not change.
+		uint64_t skippedCount() const noexcept {
+			return skipped;
+		}
+		void resetStats() noexcept {
+			issued = 0;
+			skipped = 0;
+		}
+	private:
+		static constexpr size_t Alignment = 16;
+
+		struct Entry {
+			uint32_t offset, size;
+			UniformType type;
+			// The first location of the array the element is part of, or the location it was written through if that is not known.
+			// Only elements with the same base can go out as one upload.
+			GLint base;
+			bool transpose, valid, dirty;
+		};
+
+		Entry& get(GLint location) {
+			if (static_cast<size_t>(location) >= entries.size()) {
+				entries.resize(static_cast<size_t>(location) + 1, Entry{ 0, 0, UniformType{}, -1, false, false, false });
+			}
+			return entries[location];
+		}
+
+		// The first location of the array each location belongs to, or -1 if it is not known to be part of one.
+		GLint arrayOf(GLint location, GLint fallback) const noexcept {
+			if (static_cast<size_t>(location) < arrays.size() && arrays[location] >= 0) {
+				return arrays[location];
+			}
+			return fallback;
+		}
+
+		std::vector<Entry> entries;
+		std::vector<GLint> arrays;
+		std::vector<uint8_t> staging;
+		std::vector<GLint> dirty;
+		// Gathers the elements of one array upload, which are not contiguous in staging.
+		std::vector<uint8_t> scratch;
+		UniformMode mode;
+
+		uint64_t issued, skipped;
+	};
+}
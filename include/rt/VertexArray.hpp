@@ -1,6 +1,7 @@
 #pragma once
 #include "Core.hpp"
 #include "Buffer.hpp"
+#include "StateCache.hpp"
 
 namespace rt {
 
@@ -17,6 +18,10 @@ namespace rt {
 	class VertexArray {
 	public:
 		static GLuint CurrentId() {
+			GLuint known = StateCache::get().currentVertexArray();
+			if (known != StateCache::Unknown) {
+				return known;
+			}
 			GLint value = 0;
 			glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
 			checkError();
@@ -34,6 +39,7 @@ namespace rt {
 		}
 		~VertexArray() {
 			if (isValid()) {
+				StateCache::get().forgetVertexArray(id);
 				glDeleteVertexArrays(1, &id);
 				checkError();
 				id = 0;
@@ -45,6 +51,7 @@ namespace rt {
 
 		VertexArray& operator=(VertexArray&& other) noexcept {
 			if (isValid()) {
+				StateCache::get().forgetVertexArray(id);
 				glDeleteVertexArrays(1, &id); 
 				checkError();
 			}
@@ -59,6 +66,12 @@ namespace rt {
 			glVertexArrayVertexBuffer(id, index, buff.getId(), offset, stride);
 			checkError();
 		}
+		// Bind a slice from a BufferHeap, the offset is relative to the start of the slice.
+		void bindVertex(const BufferSlice& slice, GLuint index, intptr_t offset, GLsizei stride) {
+			assert(slice.isValid());
+			glVertexArrayVertexBuffer(id, index, slice.getId(), slice.getOffset() + offset, stride);
+			checkError();
+		}
 		void unbindVertex(GLuint index) {
 			glVertexArrayVertexBuffer(id, index, 0, 0, 0);
 			checkError();
@@ -74,12 +87,16 @@ namespace rt {
 		}
 
 		void bind() {
-			glBindVertexArray(id); 
-			checkError();
+			if (StateCache::get().bindVertexArray(id)) {
+				glBindVertexArray(id);
+				checkError();
+			}
 		}
 		void unbind() {
-			glBindVertexArray(0); 
-			checkError();
+			if (StateCache::get().bindVertexArray(0)) {
+				glBindVertexArray(0);
+				checkError();
+			}
 		}
 
 		void attribEnable(GLuint index) {
@@ -198,16 +215,21 @@ namespace rt {
 			return static_cast<GLuint>(val);
 		}
 	
+		// Draws ---
+		// Each of these first sends the uniforms that programs in deferred mode have staged.
 		void drawArrays(Primitive prim, GLsizei count, uintptr_t offset = 0) {
+			flushUniforms();
 			glDrawArrays(convertGL(prim), static_cast<GLint>(offset), count); 
 			checkError();
 		}
 		void drawArraysInstanced(Primitive prim, GLsizei elemCount, GLsizei primCount, uintptr_t offset = 0) {
+			flushUniforms();
 			glDrawArraysInstanced(convertGL(prim), static_cast<GLint>(offset), elemCount, primCount); 
 			checkError();
 		}
 
 		void drawElements(Primitive prim, Index index, GLsizei count, uintptr_t offset = 0) {
+			flushUniforms();
 			glDrawElements(
 				convertGL(prim), 
 				count, 
@@ -216,6 +238,7 @@ namespace rt {
 			checkError();
 		}
 		void drawElementsInstanced(Primitive prim, Index index, GLsizei elemCount, GLsizei primCount, uintptr_t offset = 0) {
+			flushUniforms();
 			glDrawElementsInstanced(
 				convertGL(prim), 
 				elemCount, 
@@ -225,6 +248,86 @@ namespace rt {
 			checkError();
 		}
 
+		void drawArraysInstancedBaseInstance(Primitive prim, GLsizei elemCount, GLsizei primCount, GLuint baseInstance, uintptr_t offset = 0) {
+			flushUniforms();
+			glDrawArraysInstancedBaseInstance(convertGL(prim), static_cast<GLint>(offset), elemCount, primCount, baseInstance);
+			checkError();
+		}
+		void drawElementsBaseVertex(Primitive prim, Index index, GLsizei count, GLint baseVertex, uintptr_t offset = 0) {
+			flushUniforms();
+			glDrawElementsBaseVertex(
+				convertGL(prim),
+				count,
+				convertGL(index),
+				reinterpret_cast<const void*>(offset),
+				baseVertex);
+			checkError();
+		}
+		void drawElementsInstancedBaseVertexBaseInstance(Primitive prim, Index index, GLsizei elemCount, GLsizei primCount, GLint baseVertex, GLuint baseInstance, uintptr_t offset = 0) {
+			flushUniforms();
+			glDrawElementsInstancedBaseVertexBaseInstance(
+				convertGL(prim),
+				elemCount,
+				convertGL(index),
+				reinterpret_cast<const void*>(offset),
+				primCount,
+				baseVertex,
+				baseInstance);
+			checkError();
+		}
+
+		// Indirect drawing ---
+		// The commands buffer must contain tightly packed DrawArraysIndirectCommand or DrawElementsIndirectCommand structures,
+		// unless a stride is given. Offsets are in bytes.
+		void drawArraysIndirect(Primitive prim, const Buffer& commands, intptr_t offset = 0) {
+			flushUniforms();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getId());
+			glDrawArraysIndirect(convertGL(prim), reinterpret_cast<const void*>(offset));
+			checkError();
+		}
+		void drawElementsIndirect(Primitive prim, Index index, const Buffer& commands, intptr_t offset = 0) {
+			flushUniforms();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getId());
+			glDrawElementsIndirect(convertGL(prim), convertGL(index), reinterpret_cast<const void*>(offset));
+			checkError();
+		}
+
+		void multiDrawArraysIndirect(Primitive prim, const Buffer& commands, GLsizei drawCount, intptr_t offset = 0, GLsizei stride = 0) {
+			flushUniforms();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getId());
+			glMultiDrawArraysIndirect(convertGL(prim), reinterpret_cast<const void*>(offset), drawCount, stride);
+			checkError();
+		}
+		void multiDrawElementsIndirect(Primitive prim, Index index, const Buffer& commands, GLsizei drawCount, intptr_t offset = 0, GLsizei stride = 0) {
+			flushUniforms();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getId());
+			glMultiDrawElementsIndirect(convertGL(prim), convertGL(index), reinterpret_cast<const void*>(offset), drawCount, stride);
+			checkError();
+		}
+
+		// The draw count is read from the parameters buffer at paramOffset, as a single GLuint, and clamped to maxDrawCount.
+		// Requires GL_ARB_indirect_parameters, or opengl 4.6.
+		void multiDrawArraysIndirectCount(Primitive prim, const Buffer& commands, const Buffer& parameters, intptr_t paramOffset, GLsizei maxDrawCount, intptr_t offset = 0, GLsizei stride = 0) {
+			flushUniforms();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getId());
+			glBindBuffer(GL_PARAMETER_BUFFER_ARB, parameters.getId());
+			glMultiDrawArraysIndirectCountARB(convertGL(prim), reinterpret_cast<const void*>(offset), paramOffset, maxDrawCount, stride);
+			checkError();
+		}
+		void multiDrawElementsIndirectCount(Primitive prim, Index index, const Buffer& commands, const Buffer& parameters, intptr_t paramOffset, GLsizei maxDrawCount, intptr_t offset = 0, GLsizei stride = 0) {
+			flushUniforms();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getId());
+			glBindBuffer(GL_PARAMETER_BUFFER_ARB, parameters.getId());
+			glMultiDrawElementsIndirectCountARB(convertGL(prim), convertGL(index), reinterpret_cast<const void*>(offset), paramOffset, maxDrawCount, stride);
+			checkError();
+		}
+
+		// The answer is looked up once, the first time this is called with a current context.
+		static bool indirectCountSupported() {
+			static const bool supported = hasExtension("GL_ARB_indirect_parameters");
+			return supported;
+		}
+
 		GLuint getId() const {
 			return id;
 		}
@@ -235,6 +338,7 @@ namespace rt {
 
 		void reset() {
 			if (isValid()) {
+				StateCache::get().forgetVertexArray(id);
 				glDeleteVertexArrays(1, &id); 
 				checkError();
 				glCreateVertexArrays(1, &id); 
@@ -246,6 +350,10 @@ namespace rt {
 			}
 		}
 	protected:
+		static void flushUniforms() {
+			StateCache::get().flushUniforms();
+		}
+
 		GLuint id;
 	};
 
@@ -0,0 +1,635 @@
+#pragma once
+#include "Core.hpp"
+#include "Texture.hpp"
+#include "Program.hpp"
+#include "Buffer.hpp"
+#include "Barrier.hpp"
+#include "ReadbackQueue.hpp"
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+
+namespace rt {
+	// One page of one level of a virtual texture, in pages from the top left of the level.
+	struct VirtualPage {
+		uint32_t x, y, level;
+
+		// The layout the feedback shader writes, x | y << 12 | level << 24.
+		uint32_t pack() const noexcept {
+			return x | (y << 12) | (level << 24);
+		}
+		static VirtualPage unpack(uint32_t key) noexcept {
+			return VirtualPage{ key & 0xFFF, (key >> 12) & 0xFFF, key >> 24 };
+		}
+
+		bool operator==(const VirtualPage& other) const noexcept {
+			return x == other.x && y == other.y && level == other.level;
+		}
+	};
+
+	enum class VirtualBackend {
+		// Pages are committed in an ARB_sparse_texture texture, and sampled by the hardware.
+		Sparse,
+		// Pages live in slots of a physical cache texture, found through the indirection texture.
+		Software,
+	};
+
+	namespace intern {
+		/*
+		Declarations for shaders that sample a virtual texture, insert them after the #version line.
+		rtVtSample(uv) samples the texture and requests the page it needed, rtVtRequest(uv, level) only requests a page.
+		Both need to be in uniform control flow, since they use derivatives.
+		*/
+		static constexpr std::string_view virtualTextureSource =
+			"layout(std430, binding = 6) buffer RtVtFeedback { uint rtVtRequestCount; uint rtVtRequests[]; };\n"
+			"layout(std430, binding = 7) buffer RtVtSeen { uint rtVtSeen[]; };\n"
+			"uniform usampler2D rtVtIndirection;\n"
+			"uniform sampler2D rtVtTexture;\n"
+			"uniform ivec2 rtVtPages;\n"
+			"uniform vec2 rtVtSize;\n"
+			"uniform vec2 rtVtPageSize;\n"
+			"uniform vec2 rtVtCacheSize;\n"
+			"uniform int rtVtLevels;\n"
+			"uniform bool rtVtSparse;\n"
+			"uniform uint rtVtCapacity;\n"
+			"ivec2 rtVtLevelPages(int level) { return max(rtVtPages >> level, ivec2(1)); }\n"
+			"float rtVtLod(vec2 uv) {\n"
+			"	vec2 dx = dFdx(uv * rtVtSize);\n"
+			"	vec2 dy = dFdy(uv * rtVtSize);\n"
+			"	return clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0, float(rtVtLevels - 1));\n"
+			"}\n"
+			"void rtVtRequest(vec2 uv, int level) {\n"
+			"	ivec2 pages = rtVtLevelPages(level);\n"
+			"	ivec2 page = clamp(ivec2(uv * vec2(pages)), ivec2(0), pages - 1);\n"
+			"	uint index = 0u;\n"
+			"	for (int i = 0; i < level; ++i) {\n"
+			"		ivec2 count = rtVtLevelPages(i);\n"
+			"		index += uint(count.x * count.y);\n"
+			"	}\n"
+			"	index += uint(page.y * pages.x + page.x);\n"
+			"	uint bit = 1u << (index & 31u);\n"
+			"	if ((atomicOr(rtVtSeen[index >> 5], bit) & bit) == 0u) {\n"
+			"		uint slot = atomicAdd(rtVtRequestCount, 1u);\n"
+			"		if (slot < rtVtCapacity) {\n"
+			"			rtVtRequests[slot] = uint(page.x) | (uint(page.y) << 12) | (uint(level) << 24);\n"
+			"		}\n"
+			"	}\n"
+			"}\n"
+			"vec4 rtVtSample(vec2 uv) {\n"
+			"	float lod = rtVtLod(uv);\n"
+			"	int level = int(lod);\n"
+			"	rtVtRequest(uv, level);\n"
+			"	ivec2 pages = rtVtLevelPages(level);\n"
+			"	uvec4 entry = texelFetch(rtVtIndirection, clamp(ivec2(uv * vec2(pages)), ivec2(0), pages - 1), level);\n"
+			"	int resident = int(entry.z);\n"
+			"	if (rtVtSparse) {\n"
+			"		return textureLod(rtVtTexture, uv, max(lod, float(resident)));\n"
+			"	}\n"
+			// Keep the bilinear footprint inside of the page, the neighbouring slot holds an unrelated page.
+			"	vec2 inPage = clamp(fract(uv * vec2(rtVtLevelPages(resident))), 0.5 / rtVtPageSize, 1.0 - 0.5 / rtVtPageSize);\n"
+			"	return textureLod(rtVtTexture, (vec2(entry.xy) + inPage) * rtVtPageSize / rtVtCacheSize, 0.0);\n"
+			"}\n";
+	}
+
+	/*
+	A texture far larger than fits in memory, split into pages that are made resident as they are needed.
+	Shaders sample it through intern::virtualTextureSource, which also writes the pages it needed to a feedback buffer.
+	The feedback is read back asynchronously, and update makes the requested pages resident, coarse levels first,
+	evicting the least recently used pages once the memory budget is used up.
+
+	With ARB_sparse_texture the pages are committed in a sparse texture. Without it, for example in llvmpipe,
+	the pages are copied into slots of a physical cache texture instead, and the indirection texture maps each virtual page to its slot.
+	Either way each entry of the indirection texture holds the finest resident level covering that page,
+	every page of the coarsest level is always resident so there is something to fall back on.
+
+	The size and the page size must be powers of two. The coarsest level is the one where the smaller side is a single page.
+	*/
+	class VirtualTexture {
+	public:
+		static constexpr GLuint FeedbackBinding = 6, SeenBinding = 7;
+
+		// Called when a page is made resident, it should write the page with writePage before returning.
+		using Loader = std::function<void(VirtualTexture&, const VirtualPage&)>;
+
+		/// <summary>
+		/// Create a virtual texture, and load every page of the coarsest level.
+		/// </summary>
+		/// <param name="form">The format of the texture</param>
+		/// <param name="size">The size of the texture at level 0</param>
+		/// <param name="budgetBytes">The memory the resident pages may use</param>
+		/// <param name="pageLoader">Writes the contents of pages as they become resident</param>
+		/// <param name="softwarePageSize">The page size used without sparse textures, the sparse page size is chosen by the driver</param>
+		/// <param name="feedbackCapacity">The number of distinct page requests the feedback buffer holds per frame</param>
+		/// <param name="allowSparse">Use sparse textures if they are supported</param>
+		VirtualTexture(TexFormat form, const glm::ivec2& size, size_t budgetBytes, Loader pageLoader, const glm::ivec2& softwarePageSize = glm::ivec2{ 128 }, uint32_t feedbackCapacity = 4096, bool allowSparse = true)
+			: loader(std::move(pageLoader))
+			, format(form)
+			, virtualSize(size)
+			, pageSize(softwarePageSize)
+			, backend(VirtualBackend::Software)
+			, levels(0)
+			, capacity(0)
+			, feedbackCount(feedbackCapacity)
+			, readback(sizeof(GLuint) * (static_cast<size_t>(feedbackCapacity) + 1), 3)
+			, frame(0)
+			, commitsPerUpdate(16)
+			, commitsLastUpdate(0)
+			, evictions(0)
+		{
+			assert(isPowerOfTwo(size.x) && isPowerOfTwo(size.y) && "rt::VirtualTexture sizes must be powers of two!");
+			assert(loader && "rt::VirtualTexture needs a page loader!");
+
+			if (allowSparse && sparseTexturesSupported()) {
+				std::vector<glm::ivec3> sizes = sparsePageSizes(GL_TEXTURE_2D, format);
+				if (!sizes.empty() && isPowerOfTwo(sizes[0].x) && isPowerOfTwo(sizes[0].y) && sizes[0].x <= size.x && sizes[0].y <= size.y) {
+					pageSize = glm::ivec2{ sizes[0].x, sizes[0].y };
+					backend = VirtualBackend::Sparse;
+				}
+			}
+			assert(isPowerOfTwo(pageSize.x) && isPowerOfTwo(pageSize.y) && pageSize.x <= size.x && pageSize.y <= size.y);
+
+			pages = size / pageSize;
+			GLint smallest = std::min(pages.x, pages.y);
+			while ((smallest >> levels) > 0) {
+				++levels;
+			}
+
+			levelOffsets.resize(levels + 1, 0);
+			entries.resize(levels);
+			dirty.resize(levels);
+			for (GLint level = 0; level < levels; ++level) {
+				glm::ivec2 count = levelPages(level);
+				levelOffsets[level + 1] = levelOffsets[level] + static_cast<uint32_t>(count.x * count.y);
+				entries[level].resize(static_cast<size_t>(count.x) * count.y, Entry{ 0, 0, NoLevel, 0 });
+			}
+
+			size_t pageBytes = static_cast<size_t>(pageSize.x) * pageSize.y * texelSize(format);
+			glm::ivec2 top = levelPages(levels - 1);
+			size_t pinned = static_cast<size_t>(top.x) * top.y;
+			capacity = std::max(budgetBytes / pageBytes, pinned + 1);
+
+			if (backend == VirtualBackend::Sparse) {
+				bool sparseInit = sparse.init(format, levels, virtualSize);
+				assert(sparseInit);
+				(void)sparseInit;
+			}
+			else {
+				initCache();
+			}
+			for (uint32_t i = 0; i < capacity; ++i) {
+				freeSlots.push_back(static_cast<uint32_t>(capacity - 1 - i));
+			}
+
+			// Integer textures are only complete with nearest filtering.
+			indirection.init(TexFormat::RGBA_U16, levels, pages);
+			glTextureParameteri(indirection.getId(), GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			glTextureParameteri(indirection.getId(), GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			checkError();
+
+			feedback.initArray(sizeof(GLuint) * (static_cast<size_t>(feedbackCount) + 1), BufferInit::Dynamic);
+			seen.initArray(sizeof(GLuint) * ((levelOffsets[levels] + 31) / 32), BufferInit::Dynamic);
+			feedback.clearTo(GLuint(0));
+			seen.clearTo(GLuint(0));
+
+			// The coarsest level is always resident, everything falls back on it.
+			for (GLint y = 0; y < top.y; ++y) {
+				for (GLint x = 0; x < top.x; ++x) {
+					makeResident(VirtualPage{ static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(levels - 1) }, true);
+				}
+			}
+			uploadIndirection();
+		}
+
+		// The feedback handles point into the readback queue, so it cannot be moved.
+		VirtualTexture(VirtualTexture&&) = delete;
+		VirtualTexture& operator=(VirtualTexture&&) = delete;
+
+		VirtualTexture(const VirtualTexture&) = delete;
+		VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+		// Frame ---
+		// Clear the feedback, call before the draws that sample the texture.
+		void beginFrame() {
+			feedback.clearTo(GLuint(0));
+			seen.clearTo(GLuint(0));
+			bindFeedback();
+		}
+
+		// Queue a read of this frame's feedback, call after the draws that sample the texture.
+		void endFrame() {
+			memoryBarrier(Barrier::BufferUpdate);
+			ReadbackHandle handle = readback.readBuffer(feedback, feedback.sizeBytes());
+			if (handle.isValid()) {
+				requests.push_back(handle);
+			}
+			++frame;
+		}
+
+		/*
+		Make up to commitsPerUpdate of the requested pages resident, coarse levels first, then update the indirection texture.
+		Picks up the feedback of earlier frames that the GPU has finished, never blocks on it.
+		*/
+		void update() {
+			while (!requests.empty() && requests.front().isReady()) {
+				ReadbackHandle& handle = requests.front();
+				const GLuint* data = handle.data<GLuint>();
+				uint32_t count = std::min(data[0], feedbackCount);
+				request(data + 1, count);
+				handle.release();
+				requests.pop_front();
+			}
+
+			// Coarse pages first, they are the fallback of everything under them.
+			std::sort(wanted.begin(), wanted.end(), [](uint32_t a, uint32_t b) {
+				return (a >> 24) != (b >> 24) ? (a >> 24) > (b >> 24) : a < b;
+			});
+			wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+
+			// Mark every requested page that is already resident first, so none of them get evicted for the others.
+			size_t kept = 0;
+			for (size_t i = 0; i < wanted.size(); ++i) {
+				auto found = resident.find(wanted[i]);
+				if (found != resident.end()) {
+					touch(found->second);
+				}
+				else {
+					wanted[kept++] = wanted[i];
+				}
+			}
+			wanted.resize(kept);
+
+			commitsLastUpdate = 0;
+			kept = 0;
+			for (size_t i = 0; i < wanted.size(); ++i) {
+				uint32_t key = wanted[i];
+				if (commitsLastUpdate >= commitsPerUpdate) {
+					// Try again next update.
+					wanted[kept++] = key;
+					continue;
+				}
+				// When every page is in use this frame the request is dropped, the feedback asks again if it is still needed.
+				if (makeResident(VirtualPage::unpack(key), false)) {
+					++commitsLastUpdate;
+				}
+			}
+			wanted.resize(kept);
+
+			uploadIndirection();
+		}
+
+		// Request pages directly, in the packed layout of VirtualPage. Pages out of range are ignored.
+		void request(const uint32_t* keys, size_t count) {
+			for (size_t i = 0; i < count; ++i) {
+				VirtualPage page = VirtualPage::unpack(keys[i]);
+				if (isValidPage(page)) {
+					wanted.push_back(keys[i]);
+				}
+			}
+		}
+		void request(const VirtualPage& page) {
+			uint32_t key = page.pack();
+			request(&key, 1);
+		}
+
+		// Write the contents of a resident page, pageSize texels tightly packed.
+		void writePage(const VirtualPage& page, const void* data, PixelComponent comp, PixelFormat form) {
+			auto found = resident.find(page.pack());
+			assert(found != resident.end() && "Only resident pages can be written!");
+
+			if (backend == VirtualBackend::Sparse) {
+				glm::ivec2 offset{ static_cast<GLint>(page.x) * pageSize.x, static_cast<GLint>(page.y) * pageSize.y };
+				sparse.subImage(data, static_cast<GLint>(page.level), offset, pageSize, comp, form);
+			}
+			else {
+				cache.subImage(data, 0, slotOffset(found->second.slot) * pageSize, pageSize, comp, form);
+			}
+		}
+
+		// Bind the textures and feedback buffers, and set the uniforms of intern::virtualTextureSource.
+		void bind(Program& program, GLuint indirectionUnit, GLuint textureUnit) {
+			indirection.bindUnit(indirectionUnit);
+			if (backend == VirtualBackend::Sparse) {
+				sparse.bindUnit(textureUnit);
+			}
+			else {
+				cache.bindUnit(textureUnit);
+			}
+			bindFeedback();
+
+			program.uniformSampler(program.getUniformLocation("rtVtIndirection"), static_cast<GLint>(indirectionUnit));
+			program.uniformSampler(program.getUniformLocation("rtVtTexture"), static_cast<GLint>(textureUnit));
+			program.uniform(program.getUniformLocation("rtVtPages"), pages);
+			program.uniform(program.getUniformLocation("rtVtSize"), glm::vec2(virtualSize));
+			program.uniform(program.getUniformLocation("rtVtPageSize"), glm::vec2(pageSize));
+			program.uniform(program.getUniformLocation("rtVtCacheSize"), glm::vec2(backend == VirtualBackend::Sparse ? virtualSize : cacheSize));
+			program.uniform(program.getUniformLocation("rtVtLevels"), levels);
+			program.uniform(program.getUniformLocation("rtVtSparse"), backend == VirtualBackend::Sparse);
+			program.uniform(program.getUniformLocation("rtVtCapacity"), feedbackCount);
+		}
+
+		// Settings ---
+		void setCommitsPerUpdate(uint32_t count) noexcept {
+			commitsPerUpdate = count;
+		}
+
+		// Getters ---
+		bool isResident(const VirtualPage& page) const {
+			return resident.find(page.pack()) != resident.end();
+		}
+		// The finest resident level covering a page, what the indirection texture holds for it.
+		GLint residentLevel(const VirtualPage& page) const {
+			return entries[page.level][entryIndex(page)].level;
+		}
+		bool isValidPage(const VirtualPage& page) const noexcept {
+			if (page.level >= static_cast<uint32_t>(levels)) {
+				return false;
+			}
+			glm::ivec2 count = levelPages(static_cast<GLint>(page.level));
+			return page.x < static_cast<uint32_t>(count.x) && page.y < static_cast<uint32_t>(count.y);
+		}
+
+		VirtualBackend getBackend() const noexcept {
+			return backend;
+		}
+		glm::ivec2 getSize() const noexcept {
+			return virtualSize;
+		}
+		glm::ivec2 getPageSize() const noexcept {
+			return pageSize;
+		}
+		// The number of pages along each side of level 0.
+		glm::ivec2 getPageCount() const noexcept {
+			return pages;
+		}
+		glm::ivec2 levelPages(GLint level) const noexcept {
+			return glm::ivec2{ std::max(pages.x >> level, 1), std::max(pages.y >> level, 1) };
+		}
+		GLint numLevels() const noexcept {
+			return levels;
+		}
+		// The number of pages that fit into the memory budget.
+		size_t pageCapacity() const noexcept {
+			return capacity;
+		}
+		size_t numResident() const noexcept {
+			return resident.size();
+		}
+		size_t numWanted() const noexcept {
+			return wanted.size();
+		}
+		uint32_t numCommitsLastUpdate() const noexcept {
+			return commitsLastUpdate;
+		}
+		uint64_t numEvictions() const noexcept {
+			return evictions;
+		}
+
+		const ImmutableTexture2d& getIndirection() const noexcept {
+			return indirection;
+		}
+		// The texture that holds the pages, the sparse texture or the physical cache.
+		const Texture2dBase& getTexture() const noexcept {
+			if (backend == VirtualBackend::Sparse) {
+				return sparse;
+			}
+			return cache;
+		}
+	private:
+		// Matches the RGBA_U16 texels of the indirection texture, the slot of the page and its level.
+		struct Entry {
+			uint16_t x, y, level, padding;
+		};
+
+		static constexpr uint16_t NoLevel = 0xFFFF;
+
+		struct Resident {
+			std::list<uint32_t>::iterator lru;
+			uint32_t slot;
+			uint64_t lastUsed;
+			bool pinned;
+		};
+
+		struct DirtyRect {
+			glm::ivec2 min{ INT32_MAX };
+			glm::ivec2 max{ -1 };
+
+			void add(const glm::ivec2& lo, const glm::ivec2& hi) noexcept {
+				min = glm::ivec2{ std::min(min.x, lo.x), std::min(min.y, lo.y) };
+				max = glm::ivec2{ std::max(max.x, hi.x), std::max(max.y, hi.y) };
+			}
+			bool empty() const noexcept {
+				return max.x < min.x;
+			}
+		};
+
+		static constexpr bool isPowerOfTwo(GLint value) noexcept {
+			return value > 0 && (value & (value - 1)) == 0;
+		}
+
+		static size_t texelSize(TexFormat format) noexcept {
+			size_t components = static_cast<size_t>(extractComponent(format)) >> 8;
+			switch (extractSize(format)) {
+			case TexType::N8:
+			case TexType::SN8:
+			case TexType::I8:
+			case TexType::U8:
+				return components;
+			case TexType::N16:
+			case TexType::SN16:
+			case TexType::I16:
+			case TexType::U16:
+			case TexType::F16:
+				return components * 2;
+			default:
+				return components * 4;
+			}
+		}
+
+		void initCache() {
+			GLint maxSize = 0;
+			glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+			checkError();
+
+			glm::ivec2 maxSlots{ std::max(maxSize / pageSize.x, 1), std::max(maxSize / pageSize.y, 1) };
+			GLint side = 1;
+			while (static_cast<size_t>(side) * side < capacity) {
+				++side;
+			}
+			slotsX = std::min(side, maxSlots.x);
+			GLint slotsY = std::min(static_cast<GLint>((capacity + slotsX - 1) / slotsX), maxSlots.y);
+			capacity = std::min(capacity, static_cast<size_t>(slotsX) * slotsY);
+
+			cacheSize = glm::ivec2{ slotsX * pageSize.x, slotsY * pageSize.y };
+			cache.init(format, 1, cacheSize);
+			cache.filterLinear();
+			cache.clampEdge();
+		}
+
+		glm::ivec2 slotOffset(uint32_t slot) const noexcept {
+			return glm::ivec2{ static_cast<GLint>(slot % slotsX), static_cast<GLint>(slot / slotsX) };
+		}
+
+		size_t entryIndex(const VirtualPage& page) const noexcept {
+			return static_cast<size_t>(page.y) * levelPages(static_cast<GLint>(page.level)).x + page.x;
+		}
+
+		void touch(Resident& page) {
+			page.lastUsed = frame;
+			if (!page.pinned) {
+				lru.splice(lru.begin(), lru, page.lru);
+			}
+		}
+
+		bool makeResident(const VirtualPage& page, bool pinned) {
+			if (freeSlots.empty() && !evict()) {
+				return false;
+			}
+			uint32_t slot = freeSlots.back();
+			freeSlots.pop_back();
+
+			uint32_t key = page.pack();
+			Resident& res = resident[key];
+			res.slot = slot;
+			res.lastUsed = frame;
+			res.pinned = pinned;
+			if (!pinned) {
+				lru.push_front(key);
+				res.lru = lru.begin();
+			}
+
+			if (backend == VirtualBackend::Sparse) {
+				glm::ivec2 offset{ static_cast<GLint>(page.x) * pageSize.x, static_cast<GLint>(page.y) * pageSize.y };
+				sparse.commit(static_cast<GLint>(page.level), offset, pageSize);
+			}
+			loader(*this, page);
+
+			glm::ivec2 physical = backend == VirtualBackend::Sparse ? glm::ivec2{ 0 } : slotOffset(slot);
+			Entry entry{ static_cast<uint16_t>(physical.x), static_cast<uint16_t>(physical.y), static_cast<uint16_t>(page.level), 0 };
+			// This page is now the finest resident level under it, unless there is something finer already.
+			remap(page, entry, [&page](const Entry& current) { return current.level > page.level; });
+			return true;
+		}
+
+		// Evict the least recently used page, as long as it was not needed this frame.
+		bool evict() {
+			if (lru.empty()) {
+				return false;
+			}
+			uint32_t key = lru.back();
+			auto found = resident.find(key);
+			if (found->second.lastUsed >= frame) {
+				return false;
+			}
+
+			VirtualPage page = VirtualPage::unpack(key);
+			if (backend == VirtualBackend::Sparse) {
+				glm::ivec2 offset{ static_cast<GLint>(page.x) * pageSize.x, static_cast<GLint>(page.y) * pageSize.y };
+				sparse.decommit(static_cast<GLint>(page.level), offset, pageSize);
+			}
+
+			freeSlots.push_back(found->second.slot);
+			lru.pop_back();
+			resident.erase(found);
+			++evictions;
+
+			// Everything that fell back on this page falls back on whatever its parent does.
+			VirtualPage parent{ page.x >> 1, page.y >> 1, page.level + 1 };
+			Entry replacement = entries[parent.level][entryIndex(parent)];
+			remap(page, replacement, [&page](const Entry& current) { return current.level == page.level; });
+			return true;
+		}
+
+		// Set the entries of a page and every finer page under it, where the predicate accepts the current entry.
+		template<typename Pred>
+		void remap(const VirtualPage& page, const Entry& entry, Pred&& pred) {
+			for (GLint level = static_cast<GLint>(page.level); level >= 0; --level) {
+				uint32_t shift = page.level - static_cast<uint32_t>(level);
+				glm::ivec2 count = levelPages(level);
+				glm::ivec2 lo{ static_cast<GLint>(page.x << shift), static_cast<GLint>(page.y << shift) };
+				glm::ivec2 hi{ std::min(static_cast<GLint>((page.x + 1) << shift), count.x) - 1, std::min(static_cast<GLint>((page.y + 1) << shift), count.y) - 1 };
+
+				std::vector<Entry>& level_entries = entries[level];
+				bool changed = false;
+				for (GLint y = lo.y; y <= hi.y; ++y) {
+					for (GLint x = lo.x; x <= hi.x; ++x) {
+						Entry& current = level_entries[static_cast<size_t>(y) * count.x + x];
+						if (pred(current)) {
+							current = entry;
+							changed = true;
+						}
+					}
+				}
+				if (changed) {
+					dirty[level].add(lo, hi);
+				}
+			}
+		}
+
+		void uploadIndirection() {
+			GLint alignment = 4;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+			for (GLint level = 0; level < levels; ++level) {
+				DirtyRect& rect = dirty[level];
+				if (rect.empty()) {
+					continue;
+				}
+				glm::ivec2 count = levelPages(level);
+				glm::ivec2 region = rect.max - rect.min + 1;
+
+				// Upload the dirty rows in full, so the rows stay contiguous in the entries.
+				const Entry* rows = entries[level].data() + static_cast<size_t>(rect.min.y) * count.x;
+				glTextureSubImage2D(indirection.getId(), level, 0, rect.min.y, count.x, region.y, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, rows);
+				checkError();
+
+				rect = DirtyRect{};
+			}
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+		}
+
+		void bindFeedback() {
+			feedback.bindSSBO(FeedbackBinding);
+			seen.bindSSBO(SeenBinding);
+		}
+
+		Loader loader;
+		TexFormat format;
+		glm::ivec2 virtualSize, pageSize, pages;
+		VirtualBackend backend;
+		GLint levels;
+
+		SparseTexture2d sparse;
+		ImmutableTexture2d cache;
+		glm::ivec2 cacheSize{ 0 };
+		GLint slotsX = 1;
+		ImmutableTexture2d indirection;
+
+		// The CPU copy of each level of the indirection texture, and the part of it that changed since the last upload.
+		std::vector<std::vector<Entry>> entries;
+		std::vector<DirtyRect> dirty;
+		// The index of the first page of each level in the seen bitmap.
+		std::vector<uint32_t> levelOffsets;
+
+		std::unordered_map<uint32_t, Resident> resident;
+		// Most recently used at the front, pinned pages are not in it.
+		std::list<uint32_t> lru;
+		std::vector<uint32_t> freeSlots;
+		std::vector<uint32_t> wanted;
+		size_t capacity;
+
+		ImmutableBuffer feedback, seen;
+		uint32_t feedbackCount;
+		ReadbackQueue readback;
+		std::deque<ReadbackHandle> requests;
+
+		uint64_t frame;
+		uint32_t commitsPerUpdate, commitsLastUpdate;
+		uint64_t evictions;
+	};
+}
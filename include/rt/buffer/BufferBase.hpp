@@ -1,10 +1,12 @@
 #pragma once
 #include <rt/Core.hpp>
+#include <rt/StateCache.hpp>
 #include <ez/BitFlags.hpp>
 #include <vector>
 #include <cassert>
 #include <cinttypes>
 #include <type_traits>
+#include <stdexcept>
 
 namespace rt {
 	enum class MutableType : GLenum {
@@ -150,6 +152,7 @@ namespace rt {
 		}
 		~Buffer() {
 			if (isValid()) {
+				StateCache::get().forgetBuffer(id);
 				glDeleteBuffers(1, &id);
 				id = 0;
 				checkError();
@@ -164,6 +167,7 @@ namespace rt {
 
 		Buffer& operator=(Buffer&& other) noexcept {
 			if (isValid()) {
+				StateCache::get().forgetBuffer(id);
 				glDeleteBuffers(1, &id);
 				checkError();
 			}
@@ -184,6 +188,7 @@ namespace rt {
 		// or a vertex array, you'll have to redo those again to avoid any errors.
 		void reset() {
 			if (isValid()) {
+				StateCache::get().forgetBuffer(id);
 				glDeleteBuffers(1, &id);
 				checkError();
 				glCreateBuffers(1, &id);
@@ -283,35 +288,36 @@ namespace rt {
 		void clearTo(GLfloat value) {
 			assert(isValid());
 			glClearNamedBufferData(getId(), GL_R32F, GL_RED, GL_FLOAT, &value);
+			checkError();
 		}
 		void clearTo(GLint value) {
 			assert(isValid());
-			glClearNamedBufferData(getId(), GL_R32I, GL_RED, GL_INT, &value);
+			glClearNamedBufferData(getId(), GL_R32I, GL_RED_INTEGER, GL_INT, &value);
 			checkError();
 		}
 		void clearTo(GLuint value) {
 			assert(isValid());
-			glClearNamedBufferData(getId(), GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+			glClearNamedBufferData(getId(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &value);
 			checkError();
 		}
 		void clearTo(GLshort value) {
 			assert(isValid());
-			glClearNamedBufferData(getId(), GL_R16I, GL_RED, GL_SHORT, &value);
+			glClearNamedBufferData(getId(), GL_R16I, GL_RED_INTEGER, GL_SHORT, &value);
 			checkError();
 		}
 		void clearTo(GLushort value) {
 			assert(isValid());
-			glClearNamedBufferData(getId(), GL_R16UI, GL_RED, GL_UNSIGNED_SHORT, &value);
+			glClearNamedBufferData(getId(), GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, &value);
 			checkError();
 		}
 		void clearTo(GLbyte value) {
 			assert(isValid());
-			glClearNamedBufferData(getId(), GL_R8I, GL_RED, GL_BYTE, &value);
+			glClearNamedBufferData(getId(), GL_R8I, GL_RED_INTEGER, GL_BYTE, &value);
 			checkError();
 		}
 		void clearTo(GLubyte value) {
 			assert(isValid());
-			glClearNamedBufferData(getId(), GL_R8UI, GL_RED, GL_UNSIGNED_BYTE, &value);
+			glClearNamedBufferData(getId(), GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &value);
 			checkError();
 		}
 
@@ -334,23 +340,31 @@ namespace rt {
 		// Binding ---
 		void bindUBO(GLuint index) {
 			assert(isValid());
-			glBindBufferBase(GL_UNIFORM_BUFFER, index, getId());
-			checkError();
+			if (StateCache::get().bindBuffer(GL_UNIFORM_BUFFER, index, getId())) {
+				glBindBufferBase(GL_UNIFORM_BUFFER, index, getId());
+				checkError();
+			}
 		}
 		void bindUBO(GLuint index, intptr_t startIndex, size_t length) {
 			assert(isValid());
-			glBindBufferRange(GL_UNIFORM_BUFFER, index, getId(), startIndex, length);
-			checkError();
+			if (StateCache::get().bindBuffer(GL_UNIFORM_BUFFER, index, getId(), startIndex, length)) {
+				glBindBufferRange(GL_UNIFORM_BUFFER, index, getId(), startIndex, length);
+				checkError();
+			}
 		}
 		void bindSSBO(GLuint index) {
 			assert(isValid());
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, getId());
-			checkError();
+			if (StateCache::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, index, getId())) {
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, getId());
+				checkError();
+			}
 		}
 		void bindSSBO(GLuint index, intptr_t startIndex, size_t length) {
 			assert(isValid());
-			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, getId(), startIndex, length);
-			checkError();
+			if (StateCache::get().bindBuffer(GL_SHADER_STORAGE_BUFFER, index, getId(), startIndex, length)) {
+				glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, getId(), startIndex, length);
+				checkError();
+			}
 		}
 
 		// Mapping ---
@@ -430,7 +444,7 @@ namespace rt {
 			assert(isValid());
 #ifdef RENDER_TOOLS_ERROR_CHECKS
 			if (isImmutable()) {
-				throw std::exception("Called a Mutable buffer method on an immutable buffer type!");
+				throw std::runtime_error("Called a Mutable buffer method on an immutable buffer type!");
 			}
 #endif
 			byteSize = ns;
@@ -443,7 +457,7 @@ namespace rt {
 			assert(isValid());
 #ifdef RENDER_TOOLS_ERROR_CHECKS
 			if (isImmutable()) {
-				throw std::exception("Called a Mutable buffer method on an immutable buffer type!");
+				throw std::runtime_error("Called a Mutable buffer method on an immutable buffer type!");
 			}
 #endif
 			byteSize = sizeof(T) * length;
@@ -456,7 +470,7 @@ namespace rt {
 		void changeMutableType(MutableType nType) {
 #ifdef RENDER_TOOLS_ERROR_CHECKS
 			if (isImmutable()) {
-				throw std::exception("Called a Mutable buffer method on an immutable buffer type!");
+				throw std::runtime_error("Called a Mutable buffer method on an immutable buffer type!");
 			}
 #endif
 			if (isValid()) {
@@ -471,6 +485,7 @@ namespace rt {
 				glCopyNamedBufferSubData(getId(), tmpId, 0, 0, sizeBytes());
 				checkError();
 
+				StateCache::get().forgetBuffer(id);
 				glDeleteBuffers(1, &id);
 				checkError();
 
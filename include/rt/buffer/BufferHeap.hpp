@@ -0,0 +1,322 @@
+#pragma once
+#include "ImmutableBuffer.hpp"
+#include "BufferSlice.hpp"
+#include <vector>
+#include <set>
+#include <memory>
+#include <algorithm>
+
+namespace rt {
+	/*
+	Sub-allocating heap over large immutable buffer pages.
+	Allocations are served by a buddy allocator per page, so every block is naturally aligned to its own size.
+	The smallest block is at least as large as the uniform and shader storage buffer offset alignments,
+	which means that any slice can be bound directly as a UBO or SSBO range.
+	*/
+	class BufferHeap {
+	public:
+		static GLint getUBOAlignment() {
+			GLint value = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+			checkError();
+			return value;
+		}
+		static GLint getSSBOAlignment() {
+			GLint value = 0;
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &value);
+			checkError();
+			return value;
+		}
+
+		// Creates a heap that reserves pages of pageSize bytes, rounded up to a power of two.
+		// Init::Dynamic is always added to the flags, so that slices can be written to with subArray.
+		BufferHeap(size_t pageSize = 1 << 24, BufferInits flags = BufferInits::None)
+			: pages()
+			, inits(flags | BufferInit::Dynamic)
+			, blockBytes(0)
+			, pageBytes(0)
+			, allocatedBytes(0)
+		{
+			size_t alignment = static_cast<size_t>(std::max(getUBOAlignment(), getSSBOAlignment()));
+			blockBytes = roundPow2(std::max(alignment, MinBlockSize));
+			pageBytes = roundPow2(std::max(pageSize, blockBytes));
+
+			assert(Buffer::isValidInitializer(inits));
+		}
+		~BufferHeap() = default;
+
+		BufferHeap(BufferHeap&&) noexcept = default;
+		BufferHeap& operator=(BufferHeap&&) noexcept = default;
+
+		BufferHeap(const BufferHeap&) = delete;
+		BufferHeap& operator=(const BufferHeap&) = delete;
+
+		// Allocate a slice of at least length bytes, aligned to the input alignment.
+		// Allocations larger than the page size get a dedicated page.
+		BufferSlice allocate(size_t length, size_t alignment = 1) {
+			assert(length > 0);
+			assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two!");
+
+			uint32_t order = orderFor(std::max(length, alignment));
+
+			for (size_t i = 0; i < pages.size(); ++i) {
+				if (pages[i] && order <= pages[i]->maxOrder) {
+					int64_t block = pages[i]->take(order);
+					if (block >= 0) {
+						return makeSlice(static_cast<uint32_t>(i), static_cast<uint64_t>(block), order, length);
+					}
+				}
+			}
+
+			uint32_t index = addPage(std::max(pageBytes, blockBytes << order));
+			int64_t block = pages[index]->take(order);
+			assert(block >= 0);
+
+			return makeSlice(index, static_cast<uint64_t>(block), order, length);
+		}
+
+		template<typename T>
+		BufferSlice allocate(size_t count) {
+			static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::BufferHeap::allocate is not trivially copyable!");
+			return allocate(count * sizeof(T), alignof(T));
+		}
+
+		template<typename T>
+		BufferSlice allocate(const T* data, size_t count) {
+			BufferSlice slice = allocate<T>(count);
+			slice.subArray(data, count);
+			return slice;
+		}
+
+		// Return a slice to the heap, and reset it to the invalid state.
+		void free(BufferSlice& slice) {
+			if (!slice.isValid()) {
+				return;
+			}
+			assert(slice.page < pages.size() && pages[slice.page] && "Slice does not belong to this heap!");
+
+			Page& page = *pages[slice.page];
+			page.give(static_cast<uint64_t>(slice.offset) / blockBytes, slice.order);
+			page.used -= blockBytes << slice.order;
+			allocatedBytes -= blockBytes << slice.order;
+
+			slice = BufferSlice{};
+		}
+
+		/*
+		Move the input slices towards the start of the heap, using server side copies.
+		Slices are updated in place, bindings that used the old ranges have to be redone.
+		Pages that end up empty are released. Returns the number of slices that were moved.
+		*/
+		size_t compact(const std::vector<BufferSlice*>& slices) {
+			std::vector<BufferSlice*> sorted;
+			sorted.reserve(slices.size());
+			for (BufferSlice* slice : slices) {
+				if (slice != nullptr && slice->isValid()) {
+					sorted.push_back(slice);
+				}
+			}
+			// Largest first, and among equal sizes the ones furthest from the start, so they take the lowest holes.
+			std::sort(sorted.begin(), sorted.end(), [](const BufferSlice* lh, const BufferSlice* rh) {
+				if (lh->order != rh->order) {
+					return lh->order > rh->order;
+				}
+				if (lh->page != rh->page) {
+					return lh->page > rh->page;
+				}
+				return lh->offset > rh->offset;
+			});
+
+			size_t moved = 0;
+			for (BufferSlice* slice : sorted) {
+				// Allocate the new location before freeing the old one, so the copy never overlaps.
+				int64_t block = -1;
+				uint32_t index = 0;
+				for (; index < pages.size(); ++index) {
+					if (pages[index] && slice->order <= pages[index]->maxOrder) {
+						block = pages[index]->takeLowest(slice->order);
+						if (block >= 0) {
+							break;
+						}
+					}
+				}
+				if (block < 0) {
+					continue;
+				}
+
+				intptr_t offset = static_cast<intptr_t>(block) * static_cast<intptr_t>(blockBytes);
+				bool better = index < slice->page || (index == slice->page && offset < slice->offset);
+				if (better) {
+					BufferSlice target = makeSlice(index, static_cast<uint64_t>(block), slice->order, slice->length);
+					slice->copyTo(target);
+					free(*slice);
+					*slice = target;
+					++moved;
+				}
+				else {
+					pages[index]->give(static_cast<uint64_t>(block), slice->order);
+				}
+			}
+
+			trim();
+			return moved;
+		}
+
+		// Release any pages that have no live allocations.
+		void trim() {
+			for (std::unique_ptr<Page>& page : pages) {
+				if (page && page->used == 0) {
+					page.reset();
+				}
+			}
+			while (!pages.empty() && !pages.back()) {
+				pages.pop_back();
+			}
+		}
+
+		// The smallest unit of allocation, every slice size is a power of two multiple of this.
+		size_t blockSize() const noexcept {
+			return blockBytes;
+		}
+		size_t pageSize() const noexcept {
+			return pageBytes;
+		}
+		size_t numPages() const noexcept {
+			size_t count = 0;
+			for (const std::unique_ptr<Page>& page : pages) {
+				if (page) {
+					++count;
+				}
+			}
+			return count;
+		}
+		// The total number of bytes reserved in opengl by the heap.
+		size_t reservedBytes() const noexcept {
+			size_t total = 0;
+			for (const std::unique_ptr<Page>& page : pages) {
+				if (page) {
+					total += page->buffer.sizeBytes();
+				}
+			}
+			return total;
+		}
+		// The number of bytes handed out to slices, including the padding from rounding up to block sizes.
+		size_t usedBytes() const noexcept {
+			return allocatedBytes;
+		}
+	private:
+		static constexpr size_t MinBlockSize = 256;
+
+		struct Page {
+			Page(size_t length, BufferInits flags, uint32_t topOrder)
+				: buffer(length, flags)
+				, freeBlocks(static_cast<size_t>(topOrder) + 1)
+				, used(0)
+				, maxOrder(topOrder)
+			{
+				freeBlocks[maxOrder].insert(0);
+			}
+
+			// Take a free block of the given order, returns the index of the block in units of the smallest block, or -1.
+			int64_t take(uint32_t order) {
+				uint32_t found = order;
+				while (found <= maxOrder && freeBlocks[found].empty()) {
+					++found;
+				}
+				if (found > maxOrder) {
+					return -1;
+				}
+
+				return split(*freeBlocks[found].begin(), found, order);
+			}
+
+			// Like take, but picks the free block closest to the start of the page instead of the best fitting one.
+			int64_t takeLowest(uint32_t order) {
+				uint32_t found = maxOrder + 1;
+				uint64_t block = 0;
+				for (uint32_t current = order; current <= maxOrder; ++current) {
+					if (!freeBlocks[current].empty() && (found > maxOrder || *freeBlocks[current].begin() < block)) {
+						found = current;
+						block = *freeBlocks[current].begin();
+					}
+				}
+				if (found > maxOrder) {
+					return -1;
+				}
+				return split(block, found, order);
+			}
+
+			// Return a block, merging it with its buddy for as long as possible.
+			void give(uint64_t block, uint32_t order) {
+				while (order < maxOrder) {
+					uint64_t buddy = block ^ (uint64_t(1) << order);
+					auto it = freeBlocks[order].find(buddy);
+					if (it == freeBlocks[order].end()) {
+						break;
+					}
+					freeBlocks[order].erase(it);
+					block = std::min(block, buddy);
+					++order;
+				}
+				freeBlocks[order].insert(block);
+			}
+
+			// Remove a free block, and split it down to the requested size, keeping the lower half each time.
+			int64_t split(uint64_t block, uint32_t found, uint32_t order) {
+				freeBlocks[found].erase(block);
+				while (found > order) {
+					--found;
+					freeBlocks[found].insert(block + (uint64_t(1) << found));
+				}
+				return static_cast<int64_t>(block);
+			}
+
+			ImmutableBuffer buffer;
+			std::vector<std::set<uint64_t>> freeBlocks;
+			size_t used;
+			uint32_t maxOrder;
+		};
+
+		static size_t roundPow2(size_t value) noexcept {
+			size_t result = 1;
+			while (result < value) {
+				result <<= 1;
+			}
+			return result;
+		}
+
+		uint32_t orderFor(size_t length) const noexcept {
+			uint32_t order = 0;
+			while ((blockBytes << order) < length) {
+				++order;
+			}
+			return order;
+		}
+
+		uint32_t addPage(size_t length) {
+			std::unique_ptr<Page> page = std::make_unique<Page>(length, inits, orderFor(length));
+
+			for (size_t i = 0; i < pages.size(); ++i) {
+				if (!pages[i]) {
+					pages[i] = std::move(page);
+					return static_cast<uint32_t>(i);
+				}
+			}
+			pages.push_back(std::move(page));
+			return static_cast<uint32_t>(pages.size() - 1);
+		}
+
+		BufferSlice makeSlice(uint32_t index, uint64_t block, uint32_t order, size_t length) {
+			Page& page = *pages[index];
+			page.used += blockBytes << order;
+			allocatedBytes += blockBytes << order;
+
+			return BufferSlice{ &page.buffer, static_cast<intptr_t>(block * blockBytes), length, index, order };
+		}
+
+		std::vector<std::unique_ptr<Page>> pages;
+		BufferInits inits;
+		size_t blockBytes, pageBytes;
+		size_t allocatedBytes;
+	};
+}
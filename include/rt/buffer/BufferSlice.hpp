@@ -0,0 +1,91 @@
+#pragma once
+#include "BufferBase.hpp"
+
+namespace rt {
+	/*
+	A lightweight reference to a range of bytes inside of a larger buffer, as handed out by a BufferHeap.
+	The slice does not own anything, the heap it came from must outlive it.
+	*/
+	class BufferSlice {
+	public:
+		BufferSlice()
+			: buffer(nullptr)
+			, offset(0)
+			, length(0)
+			, page(0)
+			, order(0)
+		{}
+
+		template<typename T>
+		void subArray(const T* data, size_t count, intptr_t writeOffset = 0) {
+			assert(isValid());
+			assert(boundsCheckBytes(writeOffset, count * sizeof(T)) && "Attempted to write a value out of bounds!");
+			buffer->subArray(data, count, offset + writeOffset);
+		}
+
+		template<typename T>
+		void subValue(const T& obj, intptr_t writeOffset = 0) {
+			assert(isValid());
+			assert(boundsCheckBytes(writeOffset, sizeof(T)) && "Attempted to write a value out of bounds!");
+			buffer->subValue(obj, offset + writeOffset);
+		}
+
+		void copyTo(const BufferSlice& other) const {
+			assert(isValid());
+			assert(other.isValid());
+			assert(other.sizeBytes() >= sizeBytes());
+			buffer->copyTo(*other.buffer, length, offset, other.offset);
+		}
+
+		// Binding ---
+		void bindUBO(GLuint index) {
+			assert(isValid());
+			buffer->bindUBO(index, offset, length);
+		}
+		void bindSSBO(GLuint index) {
+			assert(isValid());
+			buffer->bindSSBO(index, offset, length);
+		}
+
+		// Getters ---
+		Buffer& getBuffer() const noexcept {
+			assert(isValid());
+			return *buffer;
+		}
+		GLuint getId() const noexcept {
+			return buffer != nullptr ? buffer->getId() : 0;
+		}
+		// The offset in bytes of the slice, relative to the start of the buffer it lives in.
+		intptr_t getOffset() const noexcept {
+			return offset;
+		}
+		size_t sizeBytes() const noexcept {
+			return length;
+		}
+
+		bool isValid() const noexcept {
+			return buffer != nullptr;
+		}
+
+		bool boundsCheckBytes(intptr_t relativeOffset, size_t byteCount) const noexcept {
+			return (relativeOffset + byteCount) <= sizeBytes();
+		}
+	private:
+		friend class BufferHeap;
+
+		BufferSlice(Buffer* buff, intptr_t start, size_t size, uint32_t pageIndex, uint32_t blockOrder)
+			: buffer(buff)
+			, offset(start)
+			, length(size)
+			, page(pageIndex)
+			, order(blockOrder)
+		{}
+
+		Buffer* buffer;
+		intptr_t offset;
+		size_t length;
+
+		// Bookkeeping for the heap.
+		uint32_t page, order;
+	};
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <map>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+namespace rt {
+	/*
+	A set of half open [begin, end) ranges that have been written to.
+	Ranges that overlap or touch are merged as they are added, so the set is always the smallest one covering every write.
+	Units are up to the user, elements or bytes.
+	The range that was added to last is remembered, so runs of writes that extend it skip the search of the map.
+	*/
+	class DirtyRanges {
+	public:
+		struct Range {
+			size_t begin;
+			size_t end;
+
+			size_t size() const noexcept {
+				return end - begin;
+			}
+		};
+
+		DirtyRanges()
+			: ranges()
+			, last(ranges.end())
+		{}
+
+		// The remembered range is an iterator into the map, copies and moves start without one.
+		DirtyRanges(const DirtyRanges& other)
+			: ranges(other.ranges)
+			, last(ranges.end())
+		{}
+		DirtyRanges(DirtyRanges&& other) noexcept
+			: ranges(std::move(other.ranges))
+			, last(ranges.end())
+		{
+			other.last = other.ranges.end();
+		}
+		DirtyRanges& operator=(const DirtyRanges& other) {
+			ranges = other.ranges;
+			last = ranges.end();
+			return *this;
+		}
+		DirtyRanges& operator=(DirtyRanges&& other) noexcept {
+			ranges = std::move(other.ranges);
+			last = ranges.end();
+			other.last = other.ranges.end();
+			return *this;
+		}
+
+		void add(size_t begin, size_t end) {
+			if (begin >= end) {
+				return;
+			}
+
+			// Starts inside or right at the end of the last range, and stops short of the next one.
+			if (last != ranges.end() && begin >= last->first && begin <= last->second) {
+				if (end <= last->second) {
+					return;
+				}
+				auto next = std::next(last);
+				if (next == ranges.end() || next->first > end) {
+					last->second = end;
+					return;
+				}
+			}
+
+			auto it = ranges.upper_bound(begin);
+			if (it != ranges.begin()) {
+				auto prev = std::prev(it);
+				if (prev->second >= begin) {
+					begin = prev->first;
+					end = std::max(end, prev->second);
+					ranges.erase(prev);
+				}
+			}
+			while (it != ranges.end() && it->first <= end) {
+				end = std::max(end, it->second);
+				it = ranges.erase(it);
+			}
+			last = ranges.emplace_hint(it, begin, end);
+		}
+		void add(const Range& range) {
+			add(range.begin, range.end);
+		}
+
+		void clear() noexcept {
+			ranges.clear();
+			last = ranges.end();
+		}
+
+		// Calls fn(const Range&) for every range, in ascending order.
+		template<typename Fn>
+		void forEach(Fn&& fn) const {
+			for (const auto& [begin, end] : ranges) {
+				fn(Range{ begin, end });
+			}
+		}
+
+		// Getters ---
+
+		bool empty() const noexcept {
+			return ranges.empty();
+		}
+		// The number of separate ranges.
+		size_t count() const noexcept {
+			return ranges.size();
+		}
+		// The total length covered by the ranges.
+		size_t length() const noexcept {
+			size_t total = 0;
+			for (const auto& [begin, end] : ranges) {
+				total += end - begin;
+			}
+			return total;
+		}
+		// The single range covering all of the ranges, or an empty one.
+		Range extent() const noexcept {
+			if (ranges.empty()) {
+				return Range{ 0, 0 };
+			}
+			return Range{ ranges.begin()->first, ranges.rbegin()->second };
+		}
+		bool contains(size_t index) const {
+			auto it = ranges.upper_bound(index);
+			return it != ranges.begin() && std::prev(it)->second > index;
+		}
+	private:
+		// Keyed by begin, mapping to end.
+		std::map<size_t, size_t> ranges;
+		std::map<size_t, size_t>::iterator last;
+	};
+}
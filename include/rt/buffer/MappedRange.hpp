@@ -0,0 +1,200 @@
+#pragma once
+#include "BufferBase.hpp"
+#include "DirtyRanges.hpp"
+#include <cstring>
+
+namespace rt {
+	/*
+	A typed view over a mapped range of a buffer, which remembers which elements were written.
+	With FlushExplicit, commit flushes only the written elements, merging neighbouring writes into single flushes,
+	instead of flushing the whole mapping. Without it the writes are still tracked, but commit has nothing to send.
+	Non const access to elements counts as a write, use the const overloads for reading.
+	*/
+	template<typename T>
+	class MappedRange {
+	public:
+		static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::MappedRange is not trivially copyable!");
+
+		using Flag = BufferFlag;
+		using Flags = BufferFlags;
+
+		// Maps count elements starting at offset, and unmaps them once this is destroyed.
+		MappedRange(Buffer& buff, intptr_t offset, size_t count, Flags flags)
+			: buffer(&buff)
+			, mapping(nullptr)
+			, length(count)
+			, mapOffset(0)
+			, explicitFlush(flags.contains(Flag::FlushExplicit))
+			, owning(true)
+			, dirty()
+			, flushes(0)
+			, flushedBytes(0)
+		{
+			assert(count > 0);
+			assert(!explicitFlush || flags.contains(Flag::Write));
+			mapping = buffer->mapRange<T>(offset, GLsizeiptr(count), flags);
+			assert(mapping != nullptr && "Failed to map the buffer range!");
+		}
+
+		// A view of count elements starting at offset inside an existing mapping, such as a persistent one.
+		// base is the pointer the buffer was mapped to, the mapping is left alone once this is destroyed.
+		MappedRange(Buffer& buff, T* base, intptr_t offset, size_t count, bool flushExplicit)
+			: buffer(&buff)
+			, mapping(base + offset)
+			, length(count)
+			, mapOffset(offset * sizeof(T))
+			, explicitFlush(flushExplicit)
+			, owning(false)
+			, dirty()
+			, flushes(0)
+			, flushedBytes(0)
+		{
+			assert(base != nullptr);
+		}
+
+		~MappedRange() {
+			unmap();
+		}
+
+		MappedRange(MappedRange&& other) noexcept
+			: buffer(other.buffer)
+			, mapping(other.mapping)
+			, length(other.length)
+			, mapOffset(other.mapOffset)
+			, explicitFlush(other.explicitFlush)
+			, owning(other.owning)
+			, dirty(std::move(other.dirty))
+			, flushes(other.flushes)
+			, flushedBytes(other.flushedBytes)
+		{
+			other.mapping = nullptr;
+			other.dirty.clear();
+		}
+		MappedRange& operator=(MappedRange&& other) noexcept {
+			unmap();
+
+			buffer = other.buffer;
+			mapping = other.mapping;
+			length = other.length;
+			mapOffset = other.mapOffset;
+			explicitFlush = other.explicitFlush;
+			owning = other.owning;
+			dirty = std::move(other.dirty);
+			flushes = other.flushes;
+			flushedBytes = other.flushedBytes;
+
+			other.mapping = nullptr;
+			other.dirty.clear();
+
+			return *this;
+		}
+
+		MappedRange(const MappedRange&) = delete;
+		MappedRange& operator=(const MappedRange&) = delete;
+
+		// Writing ---
+
+		T& operator[](size_t index) {
+			assert(index < length);
+			markDirty(index, 1);
+			return mapping[index];
+		}
+		const T& operator[](size_t index) const {
+			assert(index < length);
+			return mapping[index];
+		}
+
+		void write(size_t index, const T& value) {
+			assert(index < length);
+			mapping[index] = value;
+			markDirty(index, 1);
+		}
+		void write(size_t index, const T* values, size_t count) {
+			assert(index + count <= length);
+			std::memcpy(mapping + index, values, count * sizeof(T));
+			markDirty(index, count);
+		}
+
+		// Pointer for writing count elements starting at index, which are marked as written.
+		T* writable(size_t index, size_t count) {
+			assert(index + count <= length);
+			markDirty(index, count);
+			return mapping + index;
+		}
+
+		// For writes made through data().
+		void markDirty(size_t index, size_t count) {
+			assert(index + count <= length);
+			dirty.add(index, index + count);
+		}
+
+		// Flushes every range written since the last commit. Returns the number of flushes issued.
+		size_t commit() {
+			size_t issued = 0;
+			if (explicitFlush && isMapped()) {
+				dirty.forEach([this, &issued](const DirtyRanges::Range& range) {
+					GLsizeiptr bytes = GLsizeiptr(range.size() * sizeof(T));
+					glFlushMappedNamedBufferRange(buffer->getId(), mapOffset + intptr_t(range.begin * sizeof(T)), bytes);
+					checkError();
+					flushedBytes += size_t(bytes);
+					++issued;
+				});
+				flushes += issued;
+			}
+			dirty.clear();
+			return issued;
+		}
+
+		// Commits, then unmaps if this view made the mapping. Returns false if the data store was corrupted while mapped.
+		bool unmap() {
+			if (!isMapped()) {
+				return true;
+			}
+			commit();
+			bool res = true;
+			if (owning) {
+				res = buffer->unmap();
+			}
+			mapping = nullptr;
+			return res;
+		}
+
+		// Getters ---
+
+		T* data() noexcept {
+			return mapping;
+		}
+		const T* data() const noexcept {
+			return mapping;
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		bool isMapped() const noexcept {
+			return mapping != nullptr;
+		}
+		bool isExplicitFlush() const noexcept {
+			return explicitFlush;
+		}
+
+		const DirtyRanges& getDirty() const noexcept {
+			return dirty;
+		}
+		// Totals over every commit so far.
+		size_t numFlushes() const noexcept {
+			return flushes;
+		}
+		size_t numFlushedBytes() const noexcept {
+			return flushedBytes;
+		}
+	private:
+		Buffer* buffer;
+		T* mapping;
+		size_t length;
+		// Offset in bytes from the start of the mapping, flush offsets are relative to it.
+		intptr_t mapOffset;
+		bool explicitFlush, owning;
+		DirtyRanges dirty;
+		size_t flushes, flushedBytes;
+	};
+}
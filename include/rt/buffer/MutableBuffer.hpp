@@ -1,15 +1,61 @@
 #pragma once
 #include "BufferBase.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace rt {
 
+	/*
+	Buffer with mutable storage, which keeps its capacity separate from its size like std::vector.
+	Resizing within the capacity leaves the storage alone, growing past it reallocates to the capacity times the growth factor.
+	Reallocating keeps the id, and copies the contents through a temporary buffer on the GPU when they need to be kept,
+	so bindings to the buffer stay valid.
+	*/
 	class MutableBuffer : public Buffer {
 	public:
-		MutableBuffer(MutableType nType)
+		MutableBuffer(MutableType nType, float growthFactor = 2.f)
 			: type(nType)
-		{}
+			, capacity(0)
+			, growth(growthFactor)
+			, reallocations(0)
+			, streamHead(0)
+			, streamAverage(0.0)
+			, orphanPending(false)
+			, orphans(0)
+		{
+			assert(growthFactor >= 1.f);
+		}
 		~MutableBuffer() = default;
 
+		MutableBuffer(MutableBuffer&& other) noexcept
+			: Buffer(std::move(other))
+			, type(other.type)
+			, capacity(other.capacity)
+			, growth(other.growth)
+			, reallocations(other.reallocations)
+			, streamHead(other.streamHead)
+			, streamAverage(other.streamAverage)
+			, orphanPending(other.orphanPending)
+			, orphans(other.orphans)
+		{
+			other.byteSize = 0;
+			other.capacity = 0;
+		}
+		MutableBuffer& operator=(MutableBuffer&& other) noexcept {
+			Buffer::operator=(std::move(other));
+			type = other.type;
+			capacity = other.capacity;
+			growth = other.growth;
+			reallocations = other.reallocations;
+			streamHead = other.streamHead;
+			streamAverage = other.streamAverage;
+			orphanPending = other.orphanPending;
+			orphans = other.orphans;
+
+			other.capacity = 0;
+			return *this;
+		}
+
 		MutableBuffer(const MutableBuffer&) = delete;
 		MutableBuffer& operator=(const MutableBuffer&) = delete;
 
@@ -27,12 +73,18 @@ namespace rt {
 		template<typename T>
 		void initArray(const std::vector<T>& data, intptr_t startIndex, size_t length, Flags flags) = delete;
 
+		// Note that this method will invalidate any bindings, like Buffer::reset.
+		void reset() {
+			Buffer::reset();
+			capacity = 0;
+			streamHead = 0;
+			streamAverage = 0.0;
+			orphanPending = false;
+		}
+
 		template<typename T>
 		void resizeValue(const T& obj) {
-			assert(isValid());
-			this->byteSize = sizeof(T);
-			glNamedBufferSubData(this->id, sizeBytes(), reinterpret_cast<const void*>(&obj), static_cast<GLenum>(type));
-			checkError();
+			resizeArray(&obj, 1);
 		}
 		template<typename T>
 		void resizeValue(MutableType t, const T& obj) {
@@ -40,13 +92,14 @@ namespace rt {
 			resizeValue(obj);
 		}
 
+		// Resizes to ns bytes, the contents up to the smaller of the old and new size are kept.
 		void resizeArray(size_t ns) {
 			assert(isValid());
+			if (ns > capacity) {
+				reallocate(grownCapacity(ns), sizeBytes());
+			}
 			this->byteSize = ns;
-			glNamedBufferData(this->id, sizeBytes(), 0, static_cast<GLuint>(type));
-			checkError();
 		}
-		template<typename T>
 		void resizeArray(MutableType t, size_t ns) {
 			type = t;
 			resizeArray(ns);
@@ -54,10 +107,7 @@ namespace rt {
 
 		template<typename T>
 		void resizeArray(const std::vector<T>& data) {
-			assert(isValid());
-			this->byteSize = sizeof(T) * data.size();
-			glNamedBufferData(this->id, sizeBytes(), reinterpret_cast<const void*>(&data.data()), static_cast<GLenum>(type));
-			checkError();
+			resizeArray(data.data(), data.size());
 		}
 		template<typename T>
 		void resizeArray(MutableType t, const std::vector<T>& data) {
@@ -67,12 +117,8 @@ namespace rt {
 
 		template<typename T>
 		void resizeArray(const std::vector<T>& data, size_t length, intptr_t readIndex = 0) {
-			assert(isValid());
 			assert(readIndex + length <= data.size());
-
-			this->byteSize = sizeof(T) * length;
-			glNamedBufferData(this->id, sizeBytes(), reinterpret_cast<const void*>(&data[readIndex]), static_cast<GLenum>(type));
-			checkError();
+			resizeArray(data.data(), length, readIndex);
 		}
 		template<typename T>
 		void resizeArray(MutableType t, const std::vector<T>& data, size_t length, intptr_t readIndex) {
@@ -80,12 +126,21 @@ namespace rt {
 			resizeArray(data, length, readIndex);
 		}
 
+		// Resizes to length elements and replaces the contents with data.
 		template<typename T>
 		void resizeArray(const T* data, size_t length, intptr_t readIndex = 0) {
+			static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::MutableBuffer::resizeArray is not trivially copyable!");
 			assert(isValid());
-			this->byteSize = sizeof(T) * length;
-			glNamedBufferData(this->id, sizeBytes(), reinterpret_cast<const void*>(&data[readIndex]), static_cast<GLenum>(type));
-			checkError();
+			size_t bytes = sizeof(T) * length;
+			if (bytes > capacity) {
+				// Everything is about to be overwritten, so nothing is kept.
+				reallocate(grownCapacity(bytes), 0);
+			}
+			this->byteSize = bytes;
+			if (bytes > 0) {
+				glNamedBufferSubData(this->id, 0, bytes, reinterpret_cast<const void*>(&data[readIndex]));
+				checkError();
+			}
 		}
 		template<typename T>
 		void resizeArray(MutableType t, const T* data, size_t length, intptr_t readIndex) {
@@ -93,22 +148,140 @@ namespace rt {
 			resizeArray(data, length, readIndex);
 		}
 
+		// Makes room for at least bytes bytes without changing the size.
+		void reserve(size_t bytes) {
+			assert(isValid());
+			if (bytes > capacity) {
+				reallocate(bytes, sizeBytes());
+			}
+		}
+
+		// Releases the capacity past the current size.
+		void shrinkToFit() {
+			assert(isValid());
+			if (capacity > sizeBytes()) {
+				reallocate(sizeBytes(), sizeBytes());
+			}
+		}
+
+		// Sets the size to zero, keeping the capacity.
+		void clear() noexcept {
+			this->byteSize = 0;
+		}
+
+		// Re-specifies the storage with the new usage, keeping the contents and the id.
 		void changeMutableType(MutableType nType) {
-			if (isValid()) {
-				type = nType;
-				GLuint tmpId;
-				glCreateBuffers(1, &tmpId); checkError();
+			type = nType;
+			if (isValid() && capacity > 0) {
+				reallocate(capacity, sizeBytes());
+			}
+		}
 
-				glNamedBufferData(tmpId, sizeBytes(), 0, static_cast<GLuint>(type)); checkError();
+		// Streaming ---
+		/*
+		Streaming appends each write after the last one, and maps only the range being written with Unsyncronized | InvalidateRange,
+		so the driver never waits on draws still reading earlier writes. When a write does not fit in the rest of the buffer,
+		the buffer is orphaned with an InvalidateBuffer map and writing starts over from the front, opengl keeps the old storage
+		alive for the draws that use it. When the storage can not hold StreamWrites writes of the average size so far, wrapping
+		grows it by the growth factor instead of orphaning it, so a stream settles on a capacity that holds many writes. The storage never shrinks,
+		so one large frame does not cause reallocations in the frames after it. Calling reserve with a frame of writes up front,
+		and orphan once a frame, keeps it to one orphan a frame from the start.
+		The size covers the writes made to the current storage, the capacity is left to capacityBytes.
+		This is the fallback for rt::StreamRingBuffer on drivers that handle persistent mapping poorly.
+		*/
 
-				glCopyNamedBufferSubData(this->id, tmpId, 0, 0, sizeBytes()); checkError();
-				glDeleteBuffers(1, &this->id); checkError();
+		// Writes length elements to the stream, and returns the offset in bytes they were written at.
+		template<typename T>
+		intptr_t streamArray(const T* data, size_t length, size_t alignment = alignof(T)) {
+			static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::MutableBuffer::streamArray is not trivially copyable!");
+			intptr_t offset;
+			T* ptr = mapStream<T>(length, offset, alignment);
+			assert(ptr != nullptr);
+			std::memcpy(ptr, data, length * sizeof(T));
+			this->unmap();
+			return offset;
+		}
+		template<typename T>
+		intptr_t streamArray(const std::vector<T>& data, size_t alignment = alignof(T)) {
+			return streamArray(data.data(), data.size(), alignment);
+		}
+		template<typename T>
+		intptr_t streamValue(const T& obj, size_t alignment = alignof(T)) {
+			return streamArray(&obj, 1, alignment);
+		}
+
+		// Maps the next length elements of the stream for writing, offset receives where they start in bytes.
+		// The buffer must be unmapped before it is used.
+		template<typename T = uint8_t>
+		T* mapStream(size_t length, intptr_t& offset, size_t alignment = alignof(T)) {
+			static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::MutableBuffer::mapStream is not trivially copyable!");
+			assert(isValid());
+			assert(length > 0);
+			assert(alignment > 0);
 
-				this->id = tmpId;
+			size_t bytes = length * sizeof(T);
+			size_t start = (streamHead + alignment - 1) / alignment * alignment;
+			if (start + bytes > capacity) {
+				if (bytes > capacity || (grownCapacity(bytes) > capacity && double(capacity) < streamAverage * StreamWrites)) {
+					// New storage, which has nothing in flight that needs orphaning.
+					reallocate(grownCapacity(bytes), 0);
+					orphanPending = false;
+				}
+				else {
+					orphanPending = true;
+				}
+				start = 0;
+			}
+			streamAverage = streamAverage > 0.0 ? streamAverage + (double(bytes) - streamAverage) / StreamWrites : double(bytes);
+			// Everything before the end of this write was written since the storage was last orphaned.
+			this->byteSize = start + bytes;
+
+			Flags flags = Flag::Write;
+			if (orphanPending) {
+				flags |= Flag::InvalidateBuffer;
+				++orphans;
 			}
 			else {
-				type = nType;
+				flags |= Flag::InvalidateRange | Flag::Unsyncronized;
 			}
+			T* ptr = reinterpret_cast<T*>(mapRange<uint8_t>(intptr_t(start), GLsizeiptr(bytes), flags));
+
+			orphanPending = false;
+			streamHead = start + bytes;
+			offset = intptr_t(start);
+			return ptr;
+		}
+
+		// The next write starts over from the front of fresh storage.
+		void orphan() {
+			streamHead = 0;
+			orphanPending = true;
+		}
+
+		// Where the next write starts, before alignment.
+		size_t getStreamOffset() const noexcept {
+			return streamHead;
+		}
+		// How many times the stream has wrapped around and orphaned its storage.
+		size_t numOrphans() const noexcept {
+			return orphans;
+		}
+
+		// Getters ---
+
+		size_t capacityBytes() const noexcept {
+			return capacity;
+		}
+		float getGrowthFactor() const noexcept {
+			return growth;
+		}
+		void setGrowthFactor(float factor) {
+			assert(factor >= 1.f);
+			growth = factor;
+		}
+		// How many times the storage has been re-specified.
+		size_t numReallocations() const noexcept {
+			return reallocations;
 		}
 
 		// Overload
@@ -120,6 +293,46 @@ namespace rt {
 			return false;
 		}
 	private:
+		// Streams grow until they hold about this many writes of the average size, which is a moving average over as many writes.
+		static constexpr size_t StreamWrites = 64;
+
+		size_t grownCapacity(size_t needed) const {
+			return std::max(needed, size_t(double(capacity) * growth));
+		}
+
+		// Re-specifies the storage with newCapacity bytes under the same id, the first keep bytes are copied over.
+		void reallocate(size_t newCapacity, size_t keep) {
+			keep = std::min(keep, newCapacity);
+			GLuint tmpId = 0;
+			if (keep > 0) {
+				glCreateBuffers(1, &tmpId);
+				checkError();
+				glNamedBufferData(tmpId, keep, nullptr, GL_STREAM_COPY);
+				checkError();
+				glCopyNamedBufferSubData(this->id, tmpId, 0, 0, keep);
+				checkError();
+			}
+
+			glNamedBufferData(this->id, newCapacity, nullptr, static_cast<GLenum>(type));
+			checkError();
+
+			if (keep > 0) {
+				glCopyNamedBufferSubData(tmpId, this->id, 0, 0, keep);
+				checkError();
+				glDeleteBuffers(1, &tmpId);
+				checkError();
+			}
+			capacity = newCapacity;
+			++reallocations;
+		}
+
 		MutableType type;
+		size_t capacity;
+		float growth;
+		size_t reallocations;
+		size_t streamHead;
+		double streamAverage;
+		bool orphanPending;
+		size_t orphans;
 	};
 };
\ No newline at end of file
@@ -0,0 +1,264 @@
+#pragma once
+#include "ImmutableBuffer.hpp"
+#include "../Fence.hpp"
+#include <vector>
+#include <chrono>
+#include <cstring>
+
+namespace rt {
+	// A single sub-allocation handed out by a StreamRingBuffer.
+	// The pointer is only valid until the region it lives in is recycled, which is at least regionCount - 1
+	// calls to nextRegion later.
+	struct StreamAllocation {
+		uint8_t* data;
+		intptr_t offset;
+		size_t length;
+
+		bool isValid() const noexcept {
+			return data != nullptr;
+		}
+
+		template<typename T>
+		T* as() const noexcept {
+			return reinterpret_cast<T*>(data);
+		}
+	};
+
+	/*
+	Persistently mapped streaming buffer, split into a number of equally sized regions.
+	Each region is guarded by a fence, so the CPU only ever waits when it wraps around onto a region
+	that the GPU has not finished reading yet.
+	Typical usage is to call nextRegion once per frame, after all the draws that read from the current region have been issued.
+	*/
+	class StreamRingBuffer {
+	public:
+		// Creates a ring of regionCount regions, each regionSize bytes long.
+		// When coherent is false the buffer is mapped with FlushExplicit, and each allocation must be flushed before use.
+		StreamRingBuffer(size_t regionSize, uint32_t regionCount = 3, bool coherent = true)
+			: buffer()
+			, fences(regionCount)
+			, mapping(nullptr)
+			, regionBytes(regionSize)
+			, region(0)
+			, head(0)
+			, isCoherent(coherent)
+			, stalls(0)
+			, stallTime(0)
+		{
+			assert(regionSize > 0);
+			assert(regionCount > 0);
+
+			Inits inits = Init::Write | Init::Persistent;
+			Flags flags = Flag::Write | Flag::Persistent;
+			if (isCoherent) {
+				inits |= Init::Coherent;
+				flags |= Flag::Coherent;
+			}
+			else {
+				flags |= Flag::FlushExplicit;
+			}
+
+			buffer.initArray(regionBytes * regionCount, inits);
+			mapping = buffer.map<uint8_t>(flags);
+			assert(mapping != nullptr && "Failed to persistently map the stream buffer!");
+		}
+		~StreamRingBuffer() {
+			if (mapping != nullptr) {
+				buffer.unmap();
+				mapping = nullptr;
+			}
+		}
+
+		StreamRingBuffer(StreamRingBuffer&& other) noexcept
+			: buffer(std::move(other.buffer))
+			, fences(std::move(other.fences))
+			, mapping(other.mapping)
+			, regionBytes(other.regionBytes)
+			, region(other.region)
+			, head(other.head)
+			, isCoherent(other.isCoherent)
+			, stalls(other.stalls)
+			, stallTime(other.stallTime)
+		{
+			other.mapping = nullptr;
+		}
+		StreamRingBuffer& operator=(StreamRingBuffer&& other) noexcept {
+			if (mapping != nullptr) {
+				buffer.unmap();
+			}
+
+			buffer = std::move(other.buffer);
+			fences = std::move(other.fences);
+			mapping = other.mapping;
+			regionBytes = other.regionBytes;
+			region = other.region;
+			head = other.head;
+			isCoherent = other.isCoherent;
+			stalls = other.stalls;
+			stallTime = other.stallTime;
+
+			other.mapping = nullptr;
+			return *this;
+		}
+
+		StreamRingBuffer(const StreamRingBuffer&) = delete;
+		StreamRingBuffer& operator=(const StreamRingBuffer&) = delete;
+
+		// Sub-allocate length bytes from the current region, with the offset into the buffer aligned to alignment.
+		// If the current region does not have enough space left, the ring moves on to the next region first.
+		StreamAllocation allocate(size_t length, size_t alignment = 1) {
+			assert(isValid());
+			assert(alignment > 0);
+			assert(length <= regionBytes && "Allocation is larger than a single region of the stream buffer!");
+
+			size_t start = alignUp(regionStart() + head, alignment) - regionStart();
+			if (start + length > regionBytes) {
+				nextRegion();
+				start = alignUp(regionStart(), alignment) - regionStart();
+
+				if (start + length > regionBytes) {
+					return StreamAllocation{ nullptr, 0, 0 };
+				}
+			}
+
+			head = start + length;
+
+			intptr_t offset = static_cast<intptr_t>(regionStart() + start);
+			return StreamAllocation{ mapping + offset, offset, length };
+		}
+
+		// Sub-allocate space for count objects of type T, aligned to alignof(T) or alignment, whichever is larger.
+		template<typename T>
+		StreamAllocation allocate(size_t count, size_t alignment = alignof(T)) {
+			static_assert(std::is_trivially_copyable_v<T>, "Type passed into rt::StreamRingBuffer::allocate is not trivially copyable!");
+			return allocate(count * sizeof(T), alignment < alignof(T) ? alignof(T) : alignment);
+		}
+
+		// Copy the input data into the ring, returns the allocation it was written to.
+		template<typename T>
+		StreamAllocation write(const T* data, size_t count, size_t alignment = alignof(T)) {
+			StreamAllocation alloc = allocate<T>(count, alignment);
+			if (alloc.isValid()) {
+				std::memcpy(alloc.data, data, count * sizeof(T));
+				if (!isCoherent) {
+					flush(alloc);
+				}
+			}
+			return alloc;
+		}
+
+		// Make the writes to an allocation visible to opengl. Only required when the ring is not coherent.
+		void flush(const StreamAllocation& alloc) {
+			assert(alloc.isValid());
+			if (!isCoherent) {
+				buffer.flushRange(alloc.offset, alloc.length);
+			}
+		}
+
+		// Fence the current region, and move on to the next one.
+		// Blocks only if the GPU is still reading from the next region.
+		void nextRegion() {
+			assert(isValid());
+
+			Fence& current = fences[region];
+			current.reset();
+			current.init();
+
+			region = (region + 1) % numRegions();
+			head = 0;
+
+			Fence& next = fences[region];
+			if (next.isValid()) {
+				if (!next.isSignaled()) {
+					auto start = std::chrono::steady_clock::now();
+
+					FenceResult res = next.waitClient(WaitTimeout);
+					while (res == FenceResult::Timeout) {
+						res = next.waitClient(WaitTimeout);
+					}
+					assert(res != FenceResult::Failed);
+
+					stalls += 1;
+					stallTime += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+				}
+				next.reset();
+			}
+		}
+
+		// Returns the buffer object backing the ring, for binding the allocations to vertex arrays and shaders.
+		Buffer& getBuffer() noexcept {
+			return buffer;
+		}
+		const Buffer& getBuffer() const noexcept {
+			return buffer;
+		}
+		GLuint getId() const noexcept {
+			return buffer.getId();
+		}
+
+		size_t regionSize() const noexcept {
+			return regionBytes;
+		}
+		uint32_t numRegions() const noexcept {
+			return static_cast<uint32_t>(fences.size());
+		}
+		uint32_t currentRegion() const noexcept {
+			return region;
+		}
+		// The number of bytes left in the current region.
+		size_t remaining() const noexcept {
+			return regionBytes - head;
+		}
+		size_t sizeBytes() const noexcept {
+			return buffer.sizeBytes();
+		}
+
+		bool coherent() const noexcept {
+			return isCoherent;
+		}
+
+		// The number of times nextRegion had to wait on the GPU.
+		uint64_t getStallCount() const noexcept {
+			return stalls;
+		}
+		// The total time spent waiting on the GPU, in nanoseconds.
+		uint64_t getStallNanoseconds() const noexcept {
+			return stallTime;
+		}
+		void resetStats() noexcept {
+			stalls = 0;
+			stallTime = 0;
+		}
+
+		bool isValid() const noexcept {
+			return mapping != nullptr;
+		}
+	private:
+		using Init = BufferInit;
+		using Inits = BufferInits;
+		using Flag = BufferFlag;
+		using Flags = BufferFlags;
+
+		// One millisecond, in nanoseconds.
+		static constexpr uint64_t WaitTimeout = 1000000;
+
+		static size_t alignUp(size_t value, size_t alignment) noexcept {
+			return ((value + alignment - 1) / alignment) * alignment;
+		}
+
+		size_t regionStart() const noexcept {
+			return static_cast<size_t>(region) * regionBytes;
+		}
+
+		ImmutableBuffer buffer;
+		std::vector<Fence> fences;
+		uint8_t* mapping;
+		size_t regionBytes;
+		uint32_t region;
+		size_t head;
+		bool isCoherent;
+
+		uint64_t stalls;
+		uint64_t stallTime;
+	};
+}
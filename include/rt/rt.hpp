@@ -4,10 +4,24 @@
 #include "Texture.hpp"
 #include "BindlessTexture.hpp"
 #include "VertexArray.hpp"
+#include "IndirectDrawList.hpp"
+#include "DepthPyramid.hpp"
+#include "CullingPass.hpp"
 #include "Program.hpp"
+#include "ComputeProgram.hpp"
+#include "ProgramCache.hpp"
+#include "CompileQueue.hpp"
 #include "RenderBuffer.hpp"
 #include "Buffer.hpp"
+#include "GpuVector.hpp"
 #include "FrameBuffer.hpp"
 #include "Fence.hpp"
+#include "Barrier.hpp"
 #include "Sampler.hpp"
-#include "GLError.hpp"
\ No newline at end of file
+#include "GLError.hpp"
+#include "ReadbackQueue.hpp"
+#include "TextureUploader.hpp"
+#include "VirtualTexture.hpp"
+#include "StateCache.hpp"
+#include "Debug.hpp"
+#include "GpuProfiler.hpp"
\ No newline at end of file
@@ -0,0 +1,435 @@
+#pragma once
+#include "Texture2d.hpp"
+#include "Texture3d.hpp"
+#include "WorkerPool.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace rt {
+    /// <summary>
+    /// Returns true if textures of a compressed format can be created. Uncompressed formats are always supported.
+    /// S3TC and ASTC are extensions, RGTC, BPTC, ETC2 and EAC are core in 4.3. The extensions are looked up once.
+    /// </summary>
+    static bool compressionSupported(TexFormat format) {
+        if (!isCompressed(format)) {
+            return true;
+        }
+        switch (extractSize(format)) {
+        case TexType::BC1:
+        case TexType::BC2:
+        case TexType::BC3: {
+            static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+            return s3tc;
+        }
+        case TexType::BC1_SRGB:
+        case TexType::BC2_SRGB:
+        case TexType::BC3_SRGB: {
+            static const bool s3tcSrgb = hasExtension("GL_EXT_texture_compression_s3tc") &&
+                (hasExtension("GL_EXT_texture_sRGB") || hasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+            return s3tcSrgb;
+        }
+        case TexType::BC4:
+        case TexType::BC4_SN:
+        case TexType::BC5:
+        case TexType::BC5_SN:
+        case TexType::BC6H_UF:
+        case TexType::BC6H_SF:
+        case TexType::BC7:
+        case TexType::BC7_SRGB:
+        case TexType::ETC2:
+        case TexType::ETC2_SRGB:
+        case TexType::ETC2_A1:
+        case TexType::ETC2_A1_SRGB:
+        case TexType::ETC2_EAC:
+        case TexType::ETC2_EAC_SRGB:
+        case TexType::EAC:
+        case TexType::EAC_SN:
+            return true;
+        default: {
+            static const bool astc = hasExtension("GL_KHR_texture_compression_astc_ldr");
+            return astc;
+        }
+        }
+    }
+
+    namespace intern {
+        struct BlockColor {
+            float r, g, b;
+        };
+
+        static uint16_t packColor565(const BlockColor& color) noexcept {
+            uint16_t r = static_cast<uint16_t>(std::clamp(std::lround(color.r * (31.f / 255.f)), 0l, 31l));
+            uint16_t g = static_cast<uint16_t>(std::clamp(std::lround(color.g * (63.f / 255.f)), 0l, 63l));
+            uint16_t b = static_cast<uint16_t>(std::clamp(std::lround(color.b * (31.f / 255.f)), 0l, 31l));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+        // Expands the way decoders do, replicating the high bits into the low ones.
+        static BlockColor unpackColor565(uint16_t packed) noexcept {
+            uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+            return BlockColor{ float((r << 3) | (r >> 2)), float((g << 2) | (g >> 4)), float((b << 3) | (b >> 2)) };
+        }
+
+        static float colorDistance(const BlockColor& a, const BlockColor& b) noexcept {
+            float dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+            return dr * dr + dg * dg + db * db;
+        }
+
+        /*
+        Picks the closest palette entry for every texel, and returns the squared error.
+        With three colors the fourth entry is transparent black, used only by texels flagged in transparent.
+        */
+        static float fitColorIndices(const BlockColor* texels, uint16_t transparent, uint16_t c0, uint16_t c1, bool threeColor, uint32_t& indices) noexcept {
+            BlockColor a = unpackColor565(c0), b = unpackColor565(c1);
+            BlockColor palette[4];
+            palette[0] = a;
+            palette[1] = b;
+            if (threeColor) {
+                palette[2] = BlockColor{ (a.r + b.r) * 0.5f, (a.g + b.g) * 0.5f, (a.b + b.b) * 0.5f };
+                palette[3] = BlockColor{ 0.f, 0.f, 0.f };
+            }
+            else {
+                palette[2] = BlockColor{ (2.f * a.r + b.r) / 3.f, (2.f * a.g + b.g) / 3.f, (2.f * a.b + b.b) / 3.f };
+                palette[3] = BlockColor{ (a.r + 2.f * b.r) / 3.f, (a.g + 2.f * b.g) / 3.f, (a.b + 2.f * b.b) / 3.f };
+            }
+
+            indices = 0;
+            float error = 0.f;
+            uint32_t colors = threeColor ? 3 : 4;
+            for (uint32_t i = 0; i < 16; ++i) {
+                if (transparent & (1u << i)) {
+                    indices |= 3u << (2 * i);
+                    continue;
+                }
+                uint32_t best = 0;
+                float bestError = colorDistance(texels[i], palette[0]);
+                for (uint32_t c = 1; c < colors; ++c) {
+                    float candidate = colorDistance(texels[i], palette[c]);
+                    if (candidate < bestError) {
+                        bestError = candidate;
+                        best = c;
+                    }
+                }
+                indices |= best << (2 * i);
+                error += bestError;
+            }
+            return error;
+        }
+
+        /*
+        Least squares endpoints for the current indices, the refinement step of most BC1 encoders.
+        Returns false when the indices do not constrain both endpoints.
+        */
+        static bool refineColorEndpoints(const BlockColor* texels, uint16_t transparent, uint32_t indices, bool threeColor, BlockColor& a, BlockColor& b) noexcept {
+            static const float fourWeights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+            static const float threeWeights[4] = { 0.f, 1.f, 0.5f, 0.f };
+            const float* weights = threeColor ? threeWeights : fourWeights;
+
+            float aa = 0.f, bb = 0.f, ab = 0.f;
+            BlockColor ax{ 0.f, 0.f, 0.f }, bx{ 0.f, 0.f, 0.f };
+            for (uint32_t i = 0; i < 16; ++i) {
+                if (transparent & (1u << i)) {
+                    continue;
+                }
+                float t = weights[(indices >> (2 * i)) & 3];
+                float s = 1.f - t;
+                aa += s * s;
+                bb += t * t;
+                ab += s * t;
+                ax.r += s * texels[i].r; ax.g += s * texels[i].g; ax.b += s * texels[i].b;
+                bx.r += t * texels[i].r; bx.g += t * texels[i].g; bx.b += t * texels[i].b;
+            }
+
+            float det = aa * bb - ab * ab;
+            if (std::abs(det) < 1e-6f) {
+                return false;
+            }
+            float inv = 1.f / det;
+            a = BlockColor{ (ax.r * bb - bx.r * ab) * inv, (ax.g * bb - bx.g * ab) * inv, (ax.b * bb - bx.b * ab) * inv };
+            b = BlockColor{ (bx.r * aa - ax.r * ab) * inv, (bx.g * aa - ax.g * ab) * inv, (bx.b * aa - ax.b * ab) * inv };
+            return true;
+        }
+
+        /*
+        Encodes the 8 byte color part of BC1, BC2 and BC3 blocks from 16 texels in RGBA order.
+        Endpoints start at the extremes along the principal axis of the texel colors, and are then refined with least squares.
+        Texels with alpha below 128 are made transparent when allowPunchThrough is set, which needs the three color mode.
+        */
+        static void encodeColorBlock(const uint8_t* rgba, bool allowPunchThrough, uint8_t* out) noexcept {
+            BlockColor texels[16];
+            uint16_t transparent = 0;
+            for (uint32_t i = 0; i < 16; ++i) {
+                texels[i] = BlockColor{ float(rgba[i * 4 + 0]), float(rgba[i * 4 + 1]), float(rgba[i * 4 + 2]) };
+                if (allowPunchThrough && rgba[i * 4 + 3] < 128) {
+                    transparent |= static_cast<uint16_t>(1u << i);
+                }
+            }
+            bool threeColor = transparent != 0;
+
+            uint16_t c0 = 0, c1 = 0;
+            uint32_t indices = 0;
+            if (transparent == 0xFFFF) {
+                // Fully transparent, every index points at transparent black.
+                indices = 0xFFFFFFFF;
+            }
+            else {
+                BlockColor mean{ 0.f, 0.f, 0.f };
+                float count = 0.f;
+                for (uint32_t i = 0; i < 16; ++i) {
+                    if (!(transparent & (1u << i))) {
+                        mean.r += texels[i].r; mean.g += texels[i].g; mean.b += texels[i].b;
+                        count += 1.f;
+                    }
+                }
+                mean = BlockColor{ mean.r / count, mean.g / count, mean.b / count };
+
+                float cov[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+                for (uint32_t i = 0; i < 16; ++i) {
+                    if (transparent & (1u << i)) {
+                        continue;
+                    }
+                    float r = texels[i].r - mean.r, g = texels[i].g - mean.g, b = texels[i].b - mean.b;
+                    cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+                    cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+                }
+
+                // Power iteration for the principal axis.
+                BlockColor axis{ 1.f, 1.f, 1.f };
+                for (int iteration = 0; iteration < 8; ++iteration) {
+                    BlockColor next{
+                        cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                        cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                        cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b
+                    };
+                    float length = std::max(std::abs(next.r), std::max(std::abs(next.g), std::abs(next.b)));
+                    if (length < 1e-6f) {
+                        break;
+                    }
+                    axis = BlockColor{ next.r / length, next.g / length, next.b / length };
+                }
+
+                float minProj = 1e30f, maxProj = -1e30f;
+                BlockColor lo = mean, hi = mean;
+                for (uint32_t i = 0; i < 16; ++i) {
+                    if (transparent & (1u << i)) {
+                        continue;
+                    }
+                    float proj = (texels[i].r - mean.r) * axis.r + (texels[i].g - mean.g) * axis.g + (texels[i].b - mean.b) * axis.b;
+                    if (proj < minProj) {
+                        minProj = proj;
+                        lo = texels[i];
+                    }
+                    if (proj > maxProj) {
+                        maxProj = proj;
+                        hi = texels[i];
+                    }
+                }
+
+                c0 = packColor565(hi);
+                c1 = packColor565(lo);
+                float error = fitColorIndices(texels, transparent, c0, c1, threeColor, indices);
+
+                for (int iteration = 0; iteration < 2 && error > 0.f; ++iteration) {
+                    BlockColor a, b;
+                    if (!refineColorEndpoints(texels, transparent, indices, threeColor, a, b)) {
+                        break;
+                    }
+                    uint16_t r0 = packColor565(a), r1 = packColor565(b);
+                    uint32_t refinedIndices = 0;
+                    float refined = fitColorIndices(texels, transparent, r0, r1, threeColor, refinedIndices);
+                    if (refined >= error) {
+                        break;
+                    }
+                    c0 = r0;
+                    c1 = r1;
+                    indices = refinedIndices;
+                    error = refined;
+                }
+
+                // The order of the endpoints selects the mode, so swap them and the indices to match.
+                bool swap = threeColor ? c0 > c1 : c0 < c1;
+                if (swap) {
+                    std::swap(c0, c1);
+                    uint32_t remapped = 0;
+                    for (uint32_t i = 0; i < 16; ++i) {
+                        uint32_t index = (indices >> (2 * i)) & 3;
+                        if (threeColor) {
+                            index = index < 2 ? index ^ 1 : index;
+                        }
+                        else {
+                            index ^= 1;
+                        }
+                        remapped |= index << (2 * i);
+                    }
+                    indices = remapped;
+                }
+                else if (c0 == c1 && !threeColor) {
+                    // Equal endpoints decode in three color mode, where index 3 is black instead of the endpoint color.
+                    uint32_t remapped = 0;
+                    for (uint32_t i = 0; i < 16; ++i) {
+                        uint32_t index = (indices >> (2 * i)) & 3;
+                        remapped |= (index == 3 ? 0u : index) << (2 * i);
+                    }
+                    indices = remapped;
+                }
+            }
+
+            out[0] = static_cast<uint8_t>(c0 & 0xFF);
+            out[1] = static_cast<uint8_t>(c0 >> 8);
+            out[2] = static_cast<uint8_t>(c1 & 0xFF);
+            out[3] = static_cast<uint8_t>(c1 >> 8);
+            for (uint32_t i = 0; i < 4; ++i) {
+                out[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+            }
+        }
+
+        /*
+        Encodes an 8 byte BC4 block from 16 single channel texels, read with the given stride.
+        The endpoints are the channel's extremes, in the eight value mode.
+        */
+        static void encodeChannelBlock(const uint8_t* texels, size_t stride, uint8_t* out) noexcept {
+            uint8_t lo = 255, hi = 0;
+            for (uint32_t i = 0; i < 16; ++i) {
+                lo = std::min(lo, texels[i * stride]);
+                hi = std::max(hi, texels[i * stride]);
+            }
+
+            uint64_t indices = 0;
+            if (hi != lo) {
+                // Position 0 is the first endpoint and 7 the second, the palette stores them as 0 and 1 followed by the steps between.
+                static const uint64_t order[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+                float scale = 7.f / float(hi - lo);
+                for (uint32_t i = 0; i < 16; ++i) {
+                    int position = static_cast<int>(float(hi - texels[i * stride]) * scale + 0.5f);
+                    indices |= order[position] << (3 * i);
+                }
+            }
+
+            out[0] = hi;
+            out[1] = lo;
+            for (uint32_t i = 0; i < 6; ++i) {
+                out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+            }
+        }
+    }
+
+    /*
+    Compresses 8 bit images into BC1, BC3, BC4 and BC5 on the CPU, for content generated at runtime.
+    Blocks are independent, so rows of blocks are split across a pool of worker threads.
+    The encoder aims for speed over the last bit of quality, offline tools will do better for shipped assets.
+
+    Input pixels are tightly packed, with as many 8 bit channels as the format has components:
+    3 or 4 for BC1 depending on the format, 4 for BC3, 1 for BC4 and 2 for BC5.
+    The sRGB variants take the same sRGB encoded input, the blocks are the same.
+    Partial blocks at the right and bottom edges repeat the last row and column.
+    */
+    class BlockCompressor {
+    public:
+        static bool isSupported(TexFormat format) noexcept {
+            switch (format) {
+            case TexFormat::RGB_BC1:
+            case TexFormat::RGBA_BC1:
+            case TexFormat::RGB_BC1_SRGB:
+            case TexFormat::RGBA_BC1_SRGB:
+            case TexFormat::RGBA_BC3:
+            case TexFormat::RGBA_BC3_SRGB:
+            case TexFormat::R_BC4:
+            case TexFormat::RG_BC5:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        BlockCompressor(unsigned threadCount = std::thread::hardware_concurrency())
+            : pool(threadCount)
+        {}
+
+        BlockCompressor(const BlockCompressor&) = delete;
+        BlockCompressor& operator=(const BlockCompressor&) = delete;
+
+        // Compress an image into the blocks of format, compressedSize(format, size) bytes.
+        std::vector<uint8_t> compress(const void* pixels, const glm::ivec2& size, TexFormat format) {
+            std::vector<uint8_t> result(compressedSize(format, glm::ivec3{ size, 1 }));
+            compress(pixels, size, format, result.data());
+            return result;
+        }
+
+        void compress(const void* pixels, const glm::ivec2& size, TexFormat format, uint8_t* out) {
+            assert(isSupported(format) && "rt::BlockCompressor only supports BC1, BC3, BC4 and BC5!");
+            assert(size.x > 0 && size.y > 0);
+
+            const uint8_t* src = static_cast<const uint8_t*>(pixels);
+            size_t channels = static_cast<size_t>(extractComponent(format)) >> 8;
+            size_t bytes = blockBytes(format);
+            size_t blocksX = static_cast<size_t>((size.x + 3) / 4);
+            size_t blocksY = static_cast<size_t>((size.y + 3) / 4);
+            TexType type = extractSize(format);
+
+            pool.parallelFor(blocksY, [&](size_t begin, size_t end) {
+                uint8_t block[16 * 4];
+                for (size_t by = begin; by < end; ++by) {
+                    for (size_t bx = 0; bx < blocksX; ++bx) {
+                        gatherBlock(src, size, channels, bx * 4, by * 4, block);
+                        uint8_t* dst = out + (by * blocksX + bx) * bytes;
+
+                        switch (type) {
+                        case TexType::BC1:
+                        case TexType::BC1_SRGB:
+                            intern::encodeColorBlock(block, channels == 4, dst);
+                            break;
+                        case TexType::BC3:
+                        case TexType::BC3_SRGB:
+                            intern::encodeChannelBlock(block + 3, 4, dst);
+                            intern::encodeColorBlock(block, false, dst + 8);
+                            break;
+                        case TexType::BC4:
+                            intern::encodeChannelBlock(block, 4, dst);
+                            break;
+                        default:
+                            intern::encodeChannelBlock(block, 4, dst);
+                            intern::encodeChannelBlock(block + 1, 4, dst + 8);
+                            break;
+                        }
+                    }
+                }
+            });
+        }
+
+        // Compress an image and upload it as a whole level of the texture, in the texture's format.
+        void upload(Texture2dBase& tex, GLint level, const void* pixels) {
+            glm::ivec2 size{ std::max(tex.getWidth() >> level, 1), std::max(tex.getHeight() >> level, 1) };
+            std::vector<uint8_t> blocks = compress(pixels, size, tex.getFormat());
+            tex.compressedSubImage(blocks.data(), blocks.size(), level, glm::ivec2{ 0 }, size);
+        }
+        // Compress an image and upload it as one layer of a level of an array texture.
+        void upload(Texture3dBase& tex, GLint level, GLint layer, const void* pixels) {
+            glm::ivec2 size{ std::max(tex.getWidth() >> level, 1), std::max(tex.getHeight() >> level, 1) };
+            std::vector<uint8_t> blocks = compress(pixels, size, tex.getFormat());
+            tex.compressedSubImage(blocks.data(), blocks.size(), level, glm::ivec3{ 0, 0, layer }, glm::ivec3{ size, 1 });
+        }
+
+        // The number of threads the work is split across, including the calling thread.
+        size_t numThreads() const noexcept {
+            return pool.numThreads();
+        }
+    private:
+        // Copies a 4x4 block into RGBA order, with missing channels set to 0 and alpha to 255, clamping at the edges.
+        static void gatherBlock(const uint8_t* src, const glm::ivec2& size, size_t channels, size_t x0, size_t y0, uint8_t* block) noexcept {
+            for (size_t y = 0; y < 4; ++y) {
+                size_t sy = std::min(y0 + y, static_cast<size_t>(size.y) - 1);
+                for (size_t x = 0; x < 4; ++x) {
+                    size_t sx = std::min(x0 + x, static_cast<size_t>(size.x) - 1);
+                    const uint8_t* texel = src + (sy * static_cast<size_t>(size.x) + sx) * channels;
+                    uint8_t* dst = block + (y * 4 + x) * 4;
+                    dst[0] = texel[0];
+                    dst[1] = channels > 1 ? texel[1] : 0;
+                    dst[2] = channels > 2 ? texel[2] : 0;
+                    dst[3] = channels > 3 ? texel[3] : 255;
+                }
+            }
+        }
+
+        intern::WorkerPool pool;
+    };
+}
@@ -0,0 +1,586 @@
+#pragma once
+#include "Texture2d.hpp"
+#include "Texture3d.hpp"
+#include "WorkerPool.hpp"
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RT_MIP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace rt {
+    enum class MipFilter {
+        // Averages the texels each output texel covers. Fast, but a little blurry and prone to aliasing.
+        Box,
+        // Kaiser windowed sinc, reaching three output texels either side, so six wide. Sharper, but at 2:1 that is
+        // about 12 source taps per axis instead of the box filter's 2.
+        Kaiser,
+    };
+
+    struct MipOptions {
+        MipFilter filter = MipFilter::Box;
+        // The color channels of normalized formats hold sRGB encoded values, so they are decoded before filtering and encoded again after.
+        // Alpha is always linear.
+        bool srgb = false;
+    };
+
+    // A level built on the CPU, tightly packed in the pixel layout of the format it was built for.
+    struct MipLevel {
+        glm::ivec3 size;
+        std::vector<uint8_t> data;
+    };
+
+    namespace intern {
+        static float halfToFloat(uint16_t value) noexcept {
+            uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+            uint32_t exponent = (value >> 10) & 0x1F;
+            uint32_t mantissa = value & 0x3FF;
+
+            uint32_t bits;
+            if (exponent == 0) {
+                if (mantissa == 0) {
+                    bits = sign;
+                }
+                else {
+                    // Subnormal, normalize it.
+                    exponent = 127 - 15 + 1;
+                    while ((mantissa & 0x400) == 0) {
+                        mantissa <<= 1;
+                        --exponent;
+                    }
+                    bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+                }
+            }
+            else if (exponent == 0x1F) {
+                bits = sign | 0x7F800000 | (mantissa << 13);
+            }
+            else {
+                bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+            }
+
+            float result;
+            std::memcpy(&result, &bits, sizeof(float));
+            return result;
+        }
+
+        // Rounds to nearest even, values out of range become infinity.
+        static uint16_t floatToHalf(float value) noexcept {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(float));
+
+            uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+            uint32_t absBits = bits & 0x7FFFFFFF;
+
+            if (absBits >= 0x7F800000) {
+                return sign | (absBits > 0x7F800000 ? 0x7E00 : 0x7C00);
+            }
+            if (absBits >= 0x477FF000) {
+                return sign | 0x7C00;
+            }
+            if (absBits < 0x38800000) {
+                // Subnormal or zero.
+                if (absBits < 0x33000000) {
+                    return sign;
+                }
+                uint32_t exponent = absBits >> 23;
+                uint32_t mantissa = (absBits & 0x7FFFFF) | 0x800000;
+                uint32_t shift = 126 - exponent;
+                uint32_t half = mantissa >> shift;
+                uint32_t rest = mantissa & ((1u << shift) - 1);
+                uint32_t middle = 1u << (shift - 1);
+                if (rest > middle || (rest == middle && (half & 1))) {
+                    ++half;
+                }
+                return sign | static_cast<uint16_t>(half);
+            }
+
+            uint32_t half = ((absBits - 0x38000000) >> 13);
+            uint32_t rest = absBits & 0x1FFF;
+            if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+                ++half;
+            }
+            return sign | static_cast<uint16_t>(half);
+        }
+
+        static float srgbToLinear(float value) noexcept {
+            return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+        static float linearToSrgb(float value) noexcept {
+            return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+        }
+
+        // dst[i] += weight * src[i]
+        static void mipAccumulate(float* dst, const float* src, float weight, size_t count) noexcept {
+            size_t i = 0;
+#ifdef RT_MIP_SSE2
+            __m128 w = _mm_set1_ps(weight);
+            for (; i + 8 <= count; i += 8) {
+                __m128 a = _mm_loadu_ps(dst + i);
+                __m128 b = _mm_loadu_ps(dst + i + 4);
+                a = _mm_add_ps(a, _mm_mul_ps(w, _mm_loadu_ps(src + i)));
+                b = _mm_add_ps(b, _mm_mul_ps(w, _mm_loadu_ps(src + i + 4)));
+                _mm_storeu_ps(dst + i, a);
+                _mm_storeu_ps(dst + i + 4, b);
+            }
+            for (; i + 4 <= count; i += 4) {
+                _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+            }
+#endif
+            for (; i < count; ++i) {
+                dst[i] += weight * src[i];
+            }
+        }
+
+        static double besselI0(double x) noexcept {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; ++k) {
+                term *= (x * x) / (4.0 * k * k);
+                sum += term;
+            }
+            return sum;
+        }
+    }
+
+    /*
+    Builds mip chains on the CPU, then uploads every level with subImage.
+    glGenerateTextureMipmap is a plain box filter that ignores gamma, and on software drivers it runs on the driver thread.
+    This filters in linear space with a box or Kaiser filter, and splits each level across a pool of worker threads.
+    Each level is filtered from the full precision result of the previous one, not from the quantized texels.
+
+    Supports the N8, N16, F16 and F32 formats. 3d textures are reduced along all three axes,
+    the layers of array textures are filtered separately.
+    */
+    class MipBuilder {
+    public:
+        // Separable filter weights for reducing one axis from srcLength to dstLength.
+        struct Taps {
+            std::vector<uint32_t> offsets;
+            std::vector<int> indices;
+            std::vector<float> weights;
+        };
+
+        static Taps computeTaps(int srcLength, int dstLength, MipFilter filter) {
+            Taps taps;
+            taps.offsets.reserve(static_cast<size_t>(dstLength) + 1);
+            taps.offsets.push_back(0);
+
+            const double ratio = static_cast<double>(srcLength) / dstLength;
+            // Kaiser support is three output texels either side.
+            const double radius = filter == MipFilter::Box ? ratio * 0.5 : ratio * 3.0;
+            const double alpha = 4.0;
+            const double norm = intern::besselI0(alpha);
+
+            for (int i = 0; i < dstLength; ++i) {
+                double center = (i + 0.5) * ratio;
+                int first = static_cast<int>(std::floor(center - radius));
+                int last = static_cast<int>(std::ceil(center + radius));
+
+                size_t start = taps.weights.size();
+                double total = 0.0;
+                for (int x = first; x < last; ++x) {
+                    double weight;
+                    if (filter == MipFilter::Box) {
+                        // The part of source texel x that lies inside of the output texel.
+                        weight = std::min<double>(x + 1, center + radius) - std::max<double>(x, center - radius);
+                    }
+                    else {
+                        double t = (x + 0.5 - center) / ratio;
+                        double window = t * t < 9.0 ? intern::besselI0(alpha * std::sqrt(1.0 - t * t / 9.0)) / norm : 0.0;
+                        double sinc = t == 0.0 ? 1.0 : std::sin(3.14159265358979323846 * t) / (3.14159265358979323846 * t);
+                        weight = sinc * window;
+                    }
+                    if (weight == 0.0 || (filter == MipFilter::Box && weight < 0.0)) {
+                        continue;
+                    }
+
+                    int index = std::clamp(x, 0, srcLength - 1);
+                    // Merge taps that got clamped onto the same edge texel.
+                    auto found = std::find(taps.indices.begin() + start, taps.indices.end(), index);
+                    if (found != taps.indices.end()) {
+                        taps.weights[found - taps.indices.begin()] += static_cast<float>(weight);
+                    }
+                    else {
+                        taps.indices.push_back(index);
+                        taps.weights.push_back(static_cast<float>(weight));
+                    }
+                    total += weight;
+                }
+                for (size_t k = start; k < taps.weights.size(); ++k) {
+                    taps.weights[k] = static_cast<float>(taps.weights[k] / total);
+                }
+                taps.offsets.push_back(static_cast<uint32_t>(taps.weights.size()));
+            }
+            return taps;
+        }
+
+        static bool isSupported(TexFormat format) noexcept {
+            switch (extractSize(format)) {
+            case TexType::N8:
+            case TexType::N16:
+            case TexType::F16:
+            case TexType::F32:
+                break;
+            default:
+                return false;
+            }
+            TexComponent comp = extractComponent(format);
+            return comp == TexComponent::R || comp == TexComponent::RG || comp == TexComponent::RGB || comp == TexComponent::RGBA;
+        }
+
+        // The number of levels in a full chain for the given size.
+        static GLint fullChainLevels(const glm::ivec3& size) noexcept {
+            GLint largest = std::max(size.x, std::max(size.y, size.z));
+            GLint levels = 1;
+            while ((largest >> levels) > 0) {
+                ++levels;
+            }
+            return levels;
+        }
+
+        MipBuilder(unsigned threadCount = std::thread::hardware_concurrency())
+            : pool(threadCount)
+        {}
+
+        MipBuilder(const MipBuilder&) = delete;
+        MipBuilder& operator=(const MipBuilder&) = delete;
+
+        /*
+        Build levels 1 through levels - 1 from tightly packed base level pixels, in the pixel layout of format.
+        Depth is only reduced when reduceDepth is set, otherwise each layer is filtered on its own.
+        */
+        std::vector<MipLevel> generate(const void* base, const glm::ivec3& size, TexFormat format, GLint levels, bool reduceDepth, const MipOptions& options = {}) {
+            assert(isSupported(format) && "rt::MipBuilder only supports R, RG, RGB and RGBA formats of N8, N16, F16 and F32!");
+            assert(size.x > 0 && size.y > 0 && size.z > 0);
+
+            std::vector<MipLevel> result;
+            generate(base, size, format, levels, reduceDepth, options, [&result](MipLevel&& level) {
+                result.push_back(std::move(level));
+            });
+            return result;
+        }
+
+        // Build and upload every level of the texture, including the base level, from tightly packed pixels in the texture's format.
+        void build(Texture2dBase& tex, const void* base, const MipOptions& options = {}) {
+            GLenum target = tex.getGLTarget();
+            assert(target != GL_TEXTURE_2D_MULTISAMPLE && "Multisample textures have no mipmaps!");
+            assert(tex.isValidSize());
+
+            // The rows of 1d arrays are layers.
+            bool array = target == GL_TEXTURE_1D_ARRAY;
+            glm::ivec3 size{ tex.getWidth(), array ? 1 : tex.getHeight(), array ? tex.getHeight() : 1 };
+            GLint levels = levelCount(tex, size);
+
+            upload(tex, base, 0, size);
+            generate(base, size, tex.getFormat(), levels, false, options, [this, &tex, array](MipLevel&& level) {
+                glm::ivec3 region = array ? glm::ivec3{ level.size.x, level.size.z, 1 } : level.size;
+                upload(tex, level.data.data(), currentLevel, region);
+            });
+        }
+
+        void build(Texture3dBase& tex, const void* base, const MipOptions& options = {}) {
+            assert(tex.isValidSize());
+
+            bool volume = tex.getGLTarget() == GL_TEXTURE_3D;
+            glm::ivec3 size = tex.getSize();
+            GLint levels = levelCount(tex, volume ? size : glm::ivec3{ size.x, size.y, 1 });
+
+            upload(tex, base, 0, size);
+            generate(base, size, tex.getFormat(), levels, volume, options, [this, &tex](MipLevel&& level) {
+                upload(tex, level.data.data(), currentLevel, level.size);
+            });
+        }
+
+        size_t numThreads() const noexcept {
+            return pool.numThreads();
+        }
+    private:
+        using Callback = std::function<void(MipLevel&&)>;
+
+        static GLint levelCount(const TextureBase& tex, const glm::ivec3& size) {
+            GLint immutable = tex.getImmutableLevels();
+            return immutable > 0 ? immutable : fullChainLevels(size);
+        }
+
+        static int channelCount(TexFormat format) noexcept {
+            return static_cast<int>(extractComponent(format)) >> 8;
+        }
+
+        static PixelComponent pixelComponent(TexFormat format) noexcept {
+            switch (extractComponent(format)) {
+            case TexComponent::R:
+                return PixelComponent::R;
+            case TexComponent::RG:
+                return PixelComponent::RG;
+            case TexComponent::RGB:
+                return PixelComponent::RGB;
+            default:
+                return PixelComponent::RGBA;
+            }
+        }
+        static PixelFormat pixelFormat(TexFormat format) noexcept {
+            switch (extractSize(format)) {
+            case TexType::N8:
+                return PixelFormat::U8;
+            case TexType::N16:
+                return PixelFormat::U16;
+            case TexType::F16:
+                return PixelFormat::F16;
+            default:
+                return PixelFormat::F32;
+            }
+        }
+
+        // Rows of odd width are not four byte aligned, so the default unpack alignment would skew them.
+        template<typename Texture>
+        static void upload(Texture& tex, const void* data, GLint level, const glm::ivec3& size) {
+            GLint alignment = 4;
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+            TexFormat format = tex.getFormat();
+            if constexpr (std::is_base_of_v<Texture3dBase, Texture>) {
+                tex.subImage(data, level, glm::ivec3{ 0 }, size, pixelComponent(format), pixelFormat(format));
+            }
+            else {
+                tex.subImage(data, level, glm::ivec2{ 0 }, glm::ivec2{ size.x, size.y }, pixelComponent(format), pixelFormat(format));
+            }
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        }
+
+        void generate(const void* base, const glm::ivec3& size, TexFormat format, GLint levels, bool reduceDepth, const MipOptions& options, const Callback& callback) {
+            const int channels = channelCount(format);
+            const TexType type = extractSize(format);
+            const bool srgb = options.srgb && (type == TexType::N8 || type == TexType::N16);
+
+            glm::ivec3 srcSize = size;
+            std::vector<float> src(static_cast<size_t>(size.x) * size.y * size.z * channels);
+            decode(base, src.data(), src.size(), type, channels, srgb);
+
+            std::vector<float> tmp, dst;
+            for (currentLevel = 1; currentLevel < levels; ++currentLevel) {
+                glm::ivec3 dstSize{
+                    std::max(srcSize.x >> 1, 1),
+                    std::max(srcSize.y >> 1, 1),
+                    reduceDepth ? std::max(srcSize.z >> 1, 1) : srcSize.z
+                };
+                if (dstSize == srcSize) {
+                    break;
+                }
+
+                reduce(src, srcSize, dst, tmp, dstSize, channels, options.filter);
+
+                MipLevel level;
+                level.size = dstSize;
+                level.data.resize(dst.size() * typeSize(type));
+                encode(dst.data(), level.data.data(), dst.size(), type, channels, srgb);
+                callback(std::move(level));
+
+                std::swap(src, dst);
+                srcSize = dstSize;
+            }
+        }
+
+        // Each axis is resampled on its own, x first, then y, then z.
+        void reduce(const std::vector<float>& src, const glm::ivec3& srcSize, std::vector<float>& dst, std::vector<float>& tmp, const glm::ivec3& dstSize, int channels, MipFilter filter) {
+            const std::vector<float>* in = &src;
+            glm::ivec3 inSize = srcSize;
+            std::vector<float>* buffers[2] = { &dst, &tmp };
+            int which = 0;
+
+            for (int axis = 0; axis < 3; ++axis) {
+                if (inSize[axis] == dstSize[axis]) {
+                    continue;
+                }
+                glm::ivec3 outSize = inSize;
+                outSize[axis] = dstSize[axis];
+
+                std::vector<float>& out = *buffers[which];
+                which ^= 1;
+                out.assign(static_cast<size_t>(outSize.x) * outSize.y * outSize.z * channels, 0.f);
+
+                Taps taps = computeTaps(inSize[axis], outSize[axis], filter);
+                if (axis == 0) {
+                    reduceX(in->data(), inSize, out.data(), outSize, channels, taps);
+                }
+                else {
+                    reduceRows(in->data(), inSize, out.data(), outSize, channels, taps, axis);
+                }
+
+                in = &out;
+                inSize = outSize;
+            }
+
+            if (in != &dst) {
+                dst = *in;
+            }
+        }
+
+        void reduceX(const float* in, const glm::ivec3& inSize, float* out, const glm::ivec3& outSize, int channels, const Taps& taps) {
+            size_t rows = static_cast<size_t>(outSize.y) * outSize.z;
+            pool.parallelFor(rows, [&](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; ++row) {
+                    const float* srcRow = in + row * inSize.x * channels;
+                    float* dstRow = out + row * outSize.x * channels;
+
+                    for (int x = 0; x < outSize.x; ++x) {
+                        float* texel = dstRow + x * channels;
+#ifdef RT_MIP_SSE2
+                        if (channels == 4) {
+                            __m128 sum = _mm_setzero_ps();
+                            for (uint32_t k = taps.offsets[x]; k < taps.offsets[x + 1]; ++k) {
+                                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(taps.weights[k]), _mm_loadu_ps(srcRow + taps.indices[k] * 4)));
+                            }
+                            _mm_storeu_ps(texel, sum);
+                            continue;
+                        }
+#endif
+                        for (uint32_t k = taps.offsets[x]; k < taps.offsets[x + 1]; ++k) {
+                            const float* sample = srcRow + taps.indices[k] * channels;
+                            for (int c = 0; c < channels; ++c) {
+                                texel[c] += taps.weights[k] * sample[c];
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        // Reduces y or z, where every output row is a weighted sum of whole input rows.
+        void reduceRows(const float* in, const glm::ivec3& inSize, float* out, const glm::ivec3& outSize, int channels, const Taps& taps, int axis) {
+            const size_t rowLength = static_cast<size_t>(outSize.x) * channels;
+            size_t rows = static_cast<size_t>(outSize.y) * outSize.z;
+
+            pool.parallelFor(rows, [&](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; ++row) {
+                    int y = static_cast<int>(row % outSize.y);
+                    int z = static_cast<int>(row / outSize.y);
+                    int o = axis == 1 ? y : z;
+
+                    float* dstRow = out + row * rowLength;
+                    for (uint32_t k = taps.offsets[o]; k < taps.offsets[o + 1]; ++k) {
+                        int sy = axis == 1 ? taps.indices[k] : y;
+                        int sz = axis == 1 ? z : taps.indices[k];
+                        const float* srcRow = in + (static_cast<size_t>(sz) * inSize.y + sy) * rowLength;
+                        intern::mipAccumulate(dstRow, srcRow, taps.weights[k], rowLength);
+                    }
+                }
+            });
+        }
+
+        static size_t typeSize(TexType type) noexcept {
+            switch (type) {
+            case TexType::N8:
+                return 1;
+            case TexType::N16:
+            case TexType::F16:
+                return 2;
+            default:
+                return 4;
+            }
+        }
+
+        static constexpr int SrgbBuckets = 4096;
+
+        // Whether channel c gets the sRGB transfer function, alpha never does.
+        static bool isColor(size_t c, int channels, bool srgb) noexcept {
+            return srgb && (channels < 4 || c != 3);
+        }
+
+        void decode(const void* data, float* out, size_t count, TexType type, int channels, bool srgb) {
+            // 8 bit values are decoded through a table, sRGB or not.
+            float linear[256], color[256];
+            if (type == TexType::N8) {
+                for (int i = 0; i < 256; ++i) {
+                    linear[i] = i / 255.f;
+                    color[i] = srgb ? intern::srgbToLinear(linear[i]) : linear[i];
+                }
+            }
+
+            pool.parallelFor(count / channels, [&](size_t begin, size_t end) {
+                for (size_t i = begin * channels; i < end * channels; ++i) {
+                    bool srgbChannel = isColor(i % channels, channels, srgb);
+                    switch (type) {
+                    case TexType::N8: {
+                        uint8_t value = static_cast<const uint8_t*>(data)[i];
+                        out[i] = srgbChannel ? color[value] : linear[value];
+                        break;
+                    }
+                    case TexType::N16: {
+                        float value = static_cast<const uint16_t*>(data)[i] / 65535.f;
+                        out[i] = srgbChannel ? intern::srgbToLinear(value) : value;
+                        break;
+                    }
+                    case TexType::F16:
+                        out[i] = intern::halfToFloat(static_cast<const uint16_t*>(data)[i]);
+                        break;
+                    default:
+                        out[i] = static_cast<const float*>(data)[i];
+                        break;
+                    }
+                }
+            });
+        }
+
+        void encode(const float* in, void* data, size_t count, TexType type, int channels, bool srgb) {
+            // The linear values halfway between neighbouring 8 bit sRGB codes, stepping over these rounds exactly like encoding would.
+            // The coarse table gives the lowest code in each bucket of linear values, so only a step or two is needed.
+            float thresholds[256];
+            uint8_t coarse[SrgbBuckets + 1];
+            if (type == TexType::N8 && srgb) {
+                for (int i = 0; i < 255; ++i) {
+                    thresholds[i] = intern::srgbToLinear((i + 0.5f) / 255.f);
+                }
+                thresholds[255] = 2.f;
+                for (int i = 0, code = 0; i <= SrgbBuckets; ++i) {
+                    while (static_cast<float>(i) / SrgbBuckets >= thresholds[code]) {
+                        ++code;
+                    }
+                    coarse[i] = static_cast<uint8_t>(code);
+                }
+            }
+
+            pool.parallelFor(count / channels, [&](size_t begin, size_t end) {
+                for (size_t i = begin * channels; i < end * channels; ++i) {
+                    bool srgbChannel = isColor(i % channels, channels, srgb);
+                    // Written so NaN ends up as 0.
+                    float value = in[i] > 0.f ? std::min(in[i], 1.f) : 0.f;
+                    switch (type) {
+                    case TexType::N8:
+                        if (srgbChannel) {
+                            uint32_t code = coarse[static_cast<int>(value * SrgbBuckets)];
+                            while (value >= thresholds[code]) {
+                                ++code;
+                            }
+                            static_cast<uint8_t*>(data)[i] = static_cast<uint8_t>(code);
+                        }
+                        else {
+                            static_cast<uint8_t*>(data)[i] = static_cast<uint8_t>(value * 255.f + 0.5f);
+                        }
+                        break;
+                    case TexType::N16:
+                        value = srgbChannel ? intern::linearToSrgb(value) : value;
+                        static_cast<uint16_t*>(data)[i] = static_cast<uint16_t>(value * 65535.f + 0.5f);
+                        break;
+                    case TexType::F16:
+                        static_cast<uint16_t*>(data)[i] = intern::floatToHalf(in[i]);
+                        break;
+                    default:
+                        static_cast<float*>(data)[i] = in[i];
+                        break;
+                    }
+                }
+            });
+        }
+
+        intern::WorkerPool pool;
+
+        // The level being built, for the upload callbacks.
+        GLint currentLevel = 0;
+    };
+}
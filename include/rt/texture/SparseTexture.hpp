@@ -0,0 +1,308 @@
+#pragma once
+#include "Texture2d.hpp"
+#include "Texture3d.hpp"
+#include <vector>
+
+// Older headers may not have ARB_sparse_texture.
+#if !defined(GL_TEXTURE_SPARSE_ARB)
+#define GL_TEXTURE_SPARSE_ARB 0x91A6
+#define GL_VIRTUAL_PAGE_SIZE_INDEX_ARB 0x91A7
+#define GL_NUM_SPARSE_LEVELS_ARB 0x91AA
+#define GL_NUM_VIRTUAL_PAGE_SIZES_ARB 0x91A8
+#define GL_VIRTUAL_PAGE_SIZE_X_ARB 0x9195
+#define GL_VIRTUAL_PAGE_SIZE_Y_ARB 0x9196
+#define GL_VIRTUAL_PAGE_SIZE_Z_ARB 0x9197
+#endif
+
+namespace rt {
+    /// <summary>
+    /// Returns true if textures can be made sparse, and have their pages committed one by one.
+    /// The answer is looked up once, the first time this is called with a current context.
+    /// </summary>
+    static bool sparseTexturesSupported() {
+#if defined(GL_ARB_sparse_texture)
+        static const bool supported = hasExtension("GL_ARB_sparse_texture");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    /// <summary>
+    /// The page sizes the implementation supports for a format, in texels. Empty if sparse textures are not supported.
+    /// The index of a page size is what the sparse textures take in init.
+    /// </summary>
+    /// <param name="target">The texture target, such as GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY</param>
+    /// <param name="format">The format of the texture</param>
+    static std::vector<glm::ivec3> sparsePageSizes(GLenum target, TexFormat format) {
+        std::vector<glm::ivec3> result;
+        if (!sparseTexturesSupported()) {
+            return result;
+        }
+
+        GLenum formEnum = convertGL(format);
+        GLint count = 0;
+        glGetInternalformativ(target, formEnum, GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &count);
+        checkError();
+        if (count <= 0) {
+            return result;
+        }
+
+        std::vector<GLint> x(count), y(count), z(count);
+        glGetInternalformativ(target, formEnum, GL_VIRTUAL_PAGE_SIZE_X_ARB, count, x.data());
+        glGetInternalformativ(target, formEnum, GL_VIRTUAL_PAGE_SIZE_Y_ARB, count, y.data());
+        glGetInternalformativ(target, formEnum, GL_VIRTUAL_PAGE_SIZE_Z_ARB, count, z.data());
+        checkError();
+
+        for (GLint i = 0; i < count; ++i) {
+            result.emplace_back(x[i], y[i], z[i]);
+        }
+        return result;
+    }
+
+    namespace intern {
+        static void texturePageCommitment(GLuint id, GLenum target, GLint level, const glm::ivec3& offset, const glm::ivec3& region, bool commit) {
+#if defined(GL_ARB_sparse_texture)
+            // The direct state access entry point is only there alongside EXT_direct_state_access.
+            static const bool dsa = hasExtension("GL_EXT_direct_state_access");
+            if (dsa) {
+                glTexturePageCommitmentEXT(id, level, offset.x, offset.y, offset.z, region.x, region.y, region.z, commit ? GL_TRUE : GL_FALSE);
+                checkError();
+                return;
+            }
+
+            GLenum bindingQuery = target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D;
+            GLint previous = 0;
+            glGetIntegerv(bindingQuery, &previous);
+            glBindTexture(target, id);
+            glTexPageCommitmentARB(target, level, offset.x, offset.y, offset.z, region.x, region.y, region.z, commit ? GL_TRUE : GL_FALSE);
+            glBindTexture(target, static_cast<GLuint>(previous));
+            checkError();
+#else
+            assert(false && "Sparse textures are not supported by the loaded OpenGL headers!");
+#endif
+        }
+
+        // Sparse storage has to be requested before the storage is allocated.
+        static bool initSparse(GLuint id, GLenum target, TexFormat format, GLint pageSizeIndex, glm::ivec3& pageSize, GLint& sparseLevels) {
+            std::vector<glm::ivec3> sizes = sparsePageSizes(target, format);
+            if (pageSizeIndex < 0 || pageSizeIndex >= static_cast<GLint>(sizes.size())) {
+                return false;
+            }
+
+            glTextureParameteri(id, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+            glTextureParameteri(id, GL_VIRTUAL_PAGE_SIZE_INDEX_ARB, pageSizeIndex);
+            checkError();
+
+            pageSize = sizes[pageSizeIndex];
+            sparseLevels = 0;
+            return true;
+        }
+
+        static GLint numSparseLevels(GLuint id) {
+            GLint levels = 0;
+            glGetTextureParameteriv(id, GL_NUM_SPARSE_LEVELS_ARB, &levels);
+            checkError();
+            return levels;
+        }
+    }
+
+    /*
+    A 2d texture whose storage is only backed by memory for the pages that are committed.
+    Reads from pages that are not committed return undefined values, and writes to them are discarded.
+    The levels from numSparseLevels onwards are the mip tail, which is committed or decommitted as a whole.
+    */
+    class SparseTexture2d : public Texture2dBase {
+    public:
+        SparseTexture2d()
+            : Texture2dBase(GL_TEXTURE_2D)
+            , pageSize(0)
+            , sparseLevels(0)
+        {}
+
+        SparseTexture2d(const SparseTexture2d&) = delete;
+        SparseTexture2d& operator=(const SparseTexture2d&) = delete;
+
+        /// <summary>
+        /// Allocate the virtual storage of the texture, nothing is committed yet.
+        /// Returns false if sparse textures are not supported, or pageSizeIndex is not a valid page size for the format.
+        /// </summary>
+        /// <param name="form">The format of the texture</param>
+        /// <param name="mipLevels">The number of mipmap levels</param>
+        /// <param name="size">The size of the texture, it should be a multiple of the page size</param>
+        /// <param name="pageSizeIndex">The index into sparsePageSizes of the page size to use</param>
+        bool init(TexFormat form, GLint mipLevels, const glm::ivec2& size, GLint pageSizeIndex = 0) {
+            assert(mipLevels > 0);
+            assert(size.x > 0);
+            assert(size.y > 0);
+
+            if (!intern::initSparse(id, GL_TEXTURE_2D, form, pageSizeIndex, pageSize, sparseLevels)) {
+                return false;
+            }
+
+            format = form;
+            glTextureStorage2D(id, mipLevels, convertGL(format), size.x, size.y);
+            checkError();
+            width = size.x;
+            height = size.y;
+
+            sparseLevels = intern::numSparseLevels(id);
+            return true;
+        }
+
+        /// <summary>
+        /// Commit memory to a region of a level. The region has to be aligned to the page size,
+        /// except where it reaches the edge of the level.
+        /// </summary>
+        void commit(GLint level, const glm::ivec2& offset, const glm::ivec2& region) {
+            setCommitment(level, offset, region, true);
+        }
+        // Release the memory backing a region of a level, the same alignment rules as commit apply.
+        void decommit(GLint level, const glm::ivec2& offset, const glm::ivec2& region) {
+            setCommitment(level, offset, region, false);
+        }
+
+        // Commit or decommit every level of the mip tail.
+        void commitMipTail(bool commit = true) {
+            GLint levels = 0;
+            glGetTextureParameteriv(id, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+            checkError();
+            if (sparseLevels < levels) {
+                glm::ivec2 tail{ std::max(width >> sparseLevels, 1), std::max(height >> sparseLevels, 1) };
+                intern::texturePageCommitment(id, GL_TEXTURE_2D, sparseLevels, glm::ivec3{ 0 }, glm::ivec3{ tail, 1 }, commit);
+            }
+        }
+
+        glm::ivec2 getPageSize() const noexcept {
+            return glm::ivec2{ pageSize.x, pageSize.y };
+        }
+        // The number of levels that are made of whole pages, the rest are the mip tail.
+        GLint numSparseLevels() const noexcept {
+            return sparseLevels;
+        }
+
+        void reset() {
+            if (isValid()) {
+                StateCache::get().forgetTexture(id);
+                glDeleteTextures(1, &id);
+                checkError();
+
+                glCreateTextures(GL_TEXTURE_2D, 1, &id);
+                checkError();
+
+                width = 0;
+                height = 0;
+                pageSize = glm::ivec3{ 0 };
+                sparseLevels = 0;
+            }
+        }
+    private:
+        void setCommitment(GLint level, const glm::ivec2& offset, const glm::ivec2& region, bool commit) {
+            assert(level >= 0);
+            assert(boundsCheck(offset, region, level));
+            assert(offset.x % pageSize.x == 0 && offset.y % pageSize.y == 0 && "Sparse commitments must be aligned to the page size!");
+            intern::texturePageCommitment(id, GL_TEXTURE_2D, level, glm::ivec3{ offset, 0 }, glm::ivec3{ region, 1 }, commit);
+        }
+
+        glm::ivec3 pageSize;
+        GLint sparseLevels;
+    };
+
+    // A sparse 2d array texture, pages are committed per layer.
+    class SparseTexture2DArray : public Texture3dBase {
+    public:
+        SparseTexture2DArray()
+            : Texture3dBase(GL_TEXTURE_2D_ARRAY)
+            , pageSize(0)
+            , sparseLevels(0)
+        {}
+
+        SparseTexture2DArray(const SparseTexture2DArray&) = delete;
+        SparseTexture2DArray& operator=(const SparseTexture2DArray&) = delete;
+
+        /// <summary>
+        /// Allocate the virtual storage of the texture, nothing is committed yet.
+        /// Returns false if sparse textures are not supported, or pageSizeIndex is not a valid page size for the format.
+        /// </summary>
+        /// <param name="form">The format of the texture</param>
+        /// <param name="mipLevels">The number of mipmap levels</param>
+        /// <param name="size">The size of each layer, it should be a multiple of the page size</param>
+        /// <param name="numLayers">The number of layers</param>
+        /// <param name="pageSizeIndex">The index into sparsePageSizes of the page size to use</param>
+        bool init(TexFormat form, GLint mipLevels, const glm::ivec2& size, GLint numLayers, GLint pageSizeIndex = 0) {
+            assert(mipLevels > 0);
+            assert(size.x > 0);
+            assert(size.y > 0);
+            assert(numLayers > 0);
+
+            if (!intern::initSparse(id, GL_TEXTURE_2D_ARRAY, form, pageSizeIndex, pageSize, sparseLevels)) {
+                return false;
+            }
+
+            format = form;
+            glTextureStorage3D(id, mipLevels, convertGL(format), size.x, size.y, numLayers);
+            checkError();
+            width = size.x;
+            height = size.y;
+            depth = numLayers;
+
+            sparseLevels = intern::numSparseLevels(id);
+            return true;
+        }
+
+        // Commit memory to a region of a level, offset.z and region.z are the first layer and the number of layers.
+        void commit(GLint level, const glm::ivec3& offset, const glm::ivec3& region) {
+            setCommitment(level, offset, region, true);
+        }
+        void decommit(GLint level, const glm::ivec3& offset, const glm::ivec3& region) {
+            setCommitment(level, offset, region, false);
+        }
+
+        // Commit or decommit every level of the mip tail, of every layer.
+        void commitMipTail(bool commit = true) {
+            GLint levels = 0;
+            glGetTextureParameteriv(id, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+            checkError();
+            if (sparseLevels < levels) {
+                glm::ivec3 tail{ std::max(width >> sparseLevels, 1), std::max(height >> sparseLevels, 1), depth };
+                intern::texturePageCommitment(id, GL_TEXTURE_2D_ARRAY, sparseLevels, glm::ivec3{ 0 }, tail, commit);
+            }
+        }
+
+        glm::ivec2 getPageSize() const noexcept {
+            return glm::ivec2{ pageSize.x, pageSize.y };
+        }
+        GLint numSparseLevels() const noexcept {
+            return sparseLevels;
+        }
+
+        void reset() {
+            if (isValid()) {
+                StateCache::get().forgetTexture(id);
+                glDeleteTextures(1, &id);
+                checkError();
+
+                glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &id);
+                checkError();
+
+                width = 0;
+                height = 0;
+                depth = 0;
+                pageSize = glm::ivec3{ 0 };
+                sparseLevels = 0;
+            }
+        }
+    private:
+        void setCommitment(GLint level, const glm::ivec3& offset, const glm::ivec3& region, bool commit) {
+            assert(level >= 0);
+            // Layers do not shrink with the level, so Texture3dBase::boundsCheck does not apply.
+            assert(offset.x + region.x <= std::max(width >> level, 1) && offset.y + region.y <= std::max(height >> level, 1));
+            assert(offset.z + region.z <= depth);
+            assert(offset.x % pageSize.x == 0 && offset.y % pageSize.y == 0 && "Sparse commitments must be aligned to the page size!");
+            intern::texturePageCommitment(id, GL_TEXTURE_2D_ARRAY, level, offset, region, commit);
+        }
+
+        glm::ivec3 pageSize;
+        GLint sparseLevels;
+    };
+}
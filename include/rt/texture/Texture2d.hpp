@@ -47,7 +47,7 @@ namespace rt {
             assert(writeLevel >= 0);
             assert(boundsCheck(read, region, readLevel));
             assert(other.boundsCheck(write, region, writeLevel));
-            glCopyImageSubData(id, GL_TEXTURE_2D, readLevel, read.x, read.y, 0, other.getId(), GL_TEXTURE_2D, writeLevel, write.x, write.y, 0, region.x, region.y, 1);
+            glCopyImageSubData(id, getGLTarget(), readLevel, read.x, read.y, 0, other.getId(), other.getGLTarget(), writeLevel, write.x, write.y, 0, region.x, region.y, 1);
             checkError();
         }
 
@@ -65,6 +65,20 @@ namespace rt {
             subImage2D(data, level, offset, region, comp, form);
         }
 
+        /// <summary>
+        /// Substitute block compressed data into a texture object.
+        /// </summary>
+        /// <param name="data">The compressed blocks to read from, in the texture's format</param>
+        /// <param name="length">The number of bytes to read, compressedSize of the region</param>
+        /// <param name="level">The mipmap level to write to</param>
+        /// <param name="offset">The offset into the texture to write to, a multiple of the block size</param>
+        /// <param name="region">The region to write to, a multiple of the block size unless it reaches the edge of the level</param>
+        void compressedSubImage(const void* data, size_t length, GLint level, const glm::ivec2& offset, const glm::ivec2& region) {
+            assert(boundsCheck(offset, region, level));
+            assert(blockAligned(offset, region, level) && "Compressed regions have to be aligned to blocks!");
+            compressedSubImage2D(data, length, level, offset, region);
+        }
+
         bool isValidSize() const {
             return width > 0 && height > 0;
         }
@@ -92,6 +106,17 @@ namespace rt {
                 ((region.y + offset.y) <= subHeight);
         }
 
+        // Compressed writes have to start on a block, and cover whole blocks unless they reach the edge of the level.
+        bool blockAligned(const glm::ivec2& offset, const glm::ivec2& region, GLint level) const {
+            glm::ivec2 block = blockSize(format);
+            GLint subWidth = std::max(width >> level, 1);
+            GLint subHeight = std::max(height >> level, 1);
+            return
+                (offset.x % block.x) == 0 && (offset.y % block.y) == 0 &&
+                ((region.x % block.x) == 0 || offset.x + region.x == subWidth) &&
+                ((region.y % block.y) == 0 || offset.y + region.y == subHeight);
+        }
+
         bool isInitialized() const noexcept {
             return width > 0 && height > 0;
         }
@@ -126,6 +151,7 @@ namespace rt {
 
         void reset() {
             if (isValid()) {
+                StateCache::get().forgetTexture(id);
                 glDeleteTextures(1, &id);
                 checkError();
 
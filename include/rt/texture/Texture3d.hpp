@@ -37,7 +37,7 @@ namespace rt {
         }
 
         /// <summary>
-        /// Copy data from this texture object into another. The other object must be a 3d texture.
+        /// Copy data from this texture object into another. For array textures the z axis selects the layers.
         /// </summary>
         /// <param name="other"></param>
         /// <param name="readLevel"></param>
@@ -48,7 +48,7 @@ namespace rt {
         void copyTo(Texture3dBase& other, GLint readLevel, GLint writeLevel, glm::ivec3 read, glm::ivec3 write, glm::ivec3 region) {
             assert(boundsCheck(read, region, readLevel));
             assert(other.boundsCheck(write, region, writeLevel));
-            glCopyImageSubData(id, GL_TEXTURE_3D, readLevel, read.x, read.y, read.z, other.getId(), GL_TEXTURE_3D, writeLevel, write.x, write.y, write.z, region.x, region.y, region.z);
+            glCopyImageSubData(id, getGLTarget(), readLevel, read.x, read.y, read.z, other.getId(), other.getGLTarget(), writeLevel, write.x, write.y, write.z, region.x, region.y, region.z);
             checkError();
         }
 
@@ -66,6 +66,20 @@ namespace rt {
             subImage3D(data, level, offset, region, comp, form);
         }
 
+        /// <summary>
+        /// Substitute block compressed data into a texture object.
+        /// </summary>
+        /// <param name="data">The compressed blocks to read from, in the texture's format</param>
+        /// <param name="length">The number of bytes to read, compressedSize of the region</param>
+        /// <param name="level">The mipmap level to write to</param>
+        /// <param name="offset">The offset into the texture to write to, x and y a multiple of the block size</param>
+        /// <param name="region">The region to write to, x and y a multiple of the block size unless they reach the edge of the level</param>
+        void compressedSubImage(const void* data, size_t length, GLint level, const glm::ivec3& offset, const glm::ivec3& region) {
+            assert(boundsCheck(offset, region, level));
+            assert(blockAligned(offset, region, level) && "Compressed regions have to be aligned to blocks!");
+            compressedSubImage3D(data, length, level, offset, region);
+        }
+
         bool isValidSize() const {
             return width > 0 && height > 0 && depth > 0;
         }
@@ -92,7 +106,8 @@ namespace rt {
         bool boundsCheck(const glm::ivec3& offset, const glm::ivec3& region, GLint level) const {
             GLint subWidth = width >> level;
             GLint subHeight = height >> level;
-            GLint subDepth = depth >> level;
+            // Layers of array textures do not shrink with the level.
+            GLint subDepth = getGLTarget() == GL_TEXTURE_2D_ARRAY ? depth : depth >> level;
 
             return
                 ((region.x + offset.x) <= subWidth) &&
@@ -100,6 +115,17 @@ namespace rt {
                 ((region.z + offset.z) <= subDepth);
         }
 
+        // Compressed writes have to start on a block, and cover whole blocks unless they reach the edge of the level.
+        bool blockAligned(const glm::ivec3& offset, const glm::ivec3& region, GLint level) const {
+            glm::ivec2 block = blockSize(format);
+            GLint subWidth = std::max(width >> level, 1);
+            GLint subHeight = std::max(height >> level, 1);
+            return
+                (offset.x % block.x) == 0 && (offset.y % block.y) == 0 &&
+                ((region.x % block.x) == 0 || offset.x + region.x == subWidth) &&
+                ((region.y % block.y) == 0 || offset.y + region.y == subHeight);
+        }
+
         bool isInitialized() const noexcept {
             return width > 0 && height > 0 && depth > 0;
         }
@@ -128,7 +154,7 @@ namespace rt {
         Texture2DArray& operator=(const Texture2DArray&) = delete;
 
         void init(TexFormat form, GLint mipLevels, const glm::ivec2& size, GLint numLayers) {
-            init(form, mipLevels, size, numLayers);
+            init(form, mipLevels, glm::ivec3{ size, numLayers });
         }
         void init(TexFormat form, GLint mipLevels, const glm::ivec3& size) {
             assert(mipLevels > 0);
@@ -147,6 +173,7 @@ namespace rt {
 
         void reset() {
             if (isValid()) {
+                StateCache::get().forgetTexture(id);
                 glDeleteTextures(1, &id);
                 checkError();
 
@@ -199,6 +226,7 @@ namespace rt {
 
         void reset() {
             if (isValid()) {
+                StateCache::get().forgetTexture(id);
                 glDeleteTextures(1, &id);
                 checkError();
 
@@ -0,0 +1,430 @@
+#pragma once
+#include "Texture3d.hpp"
+#include <vector>
+#include <set>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+namespace rt {
+    /*
+    A rectangle in a TextureAtlas. Regions are handed out by value, and the id stays the same for as long as the entry lives.
+    Compaction and growth move entries around, so regions have to be looked up again once the atlas version changes.
+    */
+    struct AtlasRegion {
+        static constexpr uint32_t InvalidId = UINT32_MAX;
+
+        uint32_t id = InvalidId;
+        GLint layer = 0;
+        glm::ivec2 offset{ 0 };
+        glm::ivec2 size{ 0 };
+        // Normalized texture coordinates, min in xy and max in zw.
+        glm::vec4 uv{ 0.f };
+
+        bool isValid() const noexcept {
+            return id != InvalidId;
+        }
+    };
+
+    namespace intern {
+        /*
+        Shelf packer over the layers of an array texture. Shelves are grouped into height classes,
+        and each class keeps its open shelves ordered by free width, so finding the tightest shelf is a single lookup.
+        Space is handed back when a shelf empties out completely, anything finer needs a compaction.
+        */
+        class ShelfPacker {
+        public:
+            struct Placement {
+                GLint layer;
+                glm::ivec2 offset;
+                uint32_t shelf;
+            };
+
+            ShelfPacker(const glm::ivec2& layerSize)
+                : size(layerSize)
+            {}
+
+            // Rounds heights up to 8, then to the nearest of 3/4 and 1 times a power of two, wasting at most a quarter.
+            static GLint heightClass(GLint height) noexcept {
+                if (height <= 8) {
+                    return 8;
+                }
+                GLint pow2 = 16;
+                while (pow2 < height) {
+                    pow2 <<= 1;
+                }
+                GLint threeQuarters = pow2 - pow2 / 4;
+                return height <= threeQuarters ? threeQuarters : pow2;
+            }
+
+            void addLayers(GLint count) {
+                for (GLint i = 0; i < count; ++i) {
+                    GLint layer = static_cast<GLint>(layerTops.size());
+                    layerTops.push_back(0);
+                    layerSpace.emplace(size.y, layer);
+                }
+            }
+
+            bool place(const glm::ivec2& region, Placement& result) {
+                if (region.x > size.x || region.y > size.y) {
+                    return false;
+                }
+                GLint height = std::min(heightClass(region.y), size.y);
+
+                std::set<std::pair<GLint, uint32_t>>& open = openShelves[height];
+                auto shelfIt = open.lower_bound({ region.x, 0 });
+                uint32_t index = 0;
+                if (shelfIt != open.end()) {
+                    index = shelfIt->second;
+                    open.erase(shelfIt);
+                }
+                else {
+                    // Start a new shelf in the layer with the least vertical space that still fits it.
+                    auto layerIt = layerSpace.lower_bound({ height, 0 });
+                    if (layerIt == layerSpace.end()) {
+                        return false;
+                    }
+                    GLint layer = layerIt->second;
+                    layerSpace.erase(layerIt);
+
+                    index = static_cast<uint32_t>(shelves.size());
+                    shelves.push_back(Shelf{ layer, layerTops[layer], height, 0, 0 });
+                    layerTops[layer] += height;
+                    layerSpace.emplace(size.y - layerTops[layer], layer);
+                }
+
+                Shelf& shelf = shelves[index];
+                result = Placement{ shelf.layer, glm::ivec2{ shelf.cursor, shelf.y }, index };
+                shelf.cursor += region.x;
+                ++shelf.live;
+                open.emplace(size.x - shelf.cursor, index);
+                return true;
+            }
+
+            void release(const Placement& placement, GLint width) {
+                Shelf& shelf = shelves[placement.shelf];
+                assert(shelf.live > 0);
+
+                std::set<std::pair<GLint, uint32_t>>& open = openShelves[shelf.height];
+                open.erase({ size.x - shelf.cursor, placement.shelf });
+                --shelf.live;
+                if (shelf.live == 0) {
+                    shelf.cursor = 0;
+                }
+                else if (placement.offset.x + width == shelf.cursor) {
+                    // The last entry on the shelf, its space can be reused straight away.
+                    shelf.cursor = placement.offset.x;
+                }
+                open.emplace(size.x - shelf.cursor, placement.shelf);
+            }
+
+            GLint numLayers() const noexcept {
+                return static_cast<GLint>(layerTops.size());
+            }
+            // The area taken up by shelves, including the unused ends and the holes left by removed entries.
+            uint64_t reservedArea() const noexcept {
+                uint64_t total = 0;
+                for (GLint top : layerTops) {
+                    total += static_cast<uint64_t>(top) * size.x;
+                }
+                return total;
+            }
+        private:
+            struct Shelf {
+                GLint layer, y, height, cursor;
+                uint32_t live;
+            };
+
+            glm::ivec2 size;
+            std::vector<Shelf> shelves;
+            // Height class to the open shelves of that class, ordered by free width.
+            std::map<GLint, std::set<std::pair<GLint, uint32_t>>> openShelves;
+            // Remaining height and layer, ordered so the tightest layer is found first.
+            std::set<std::pair<GLint, GLint>> layerSpace;
+            std::vector<GLint> layerTops;
+        };
+
+        static GLenum clearFormat(const TextureBase& tex) {
+            TexType type = extractSize(tex.getFormat());
+            bool integer = type == TexType::I8 || type == TexType::I16 || type == TexType::I32 || type == TexType::U8 || type == TexType::U16 || type == TexType::U32;
+            return integer ? GL_RED_INTEGER : GL_RED;
+        }
+        static void clearToZero(TextureBase& tex) {
+            glClearTexImage(tex.getId(), 0, clearFormat(tex), GL_UNSIGNED_BYTE, nullptr);
+            checkError();
+        }
+        static void clearToZero(TextureBase& tex, const glm::ivec3& offset, const glm::ivec3& region) {
+            glClearTexSubImage(tex.getId(), 0, offset.x, offset.y, offset.z, region.x, region.y, region.z, clearFormat(tex), GL_UNSIGNED_BYTE, nullptr);
+            checkError();
+        }
+    }
+
+    /*
+    Packs many small images, such as glyphs or sprites, into the layers of a single Texture2DArray.
+    Inserts upload straight into their rectangle with subImage. When the layers fill up the array is reallocated
+    with twice as many layers, and the old contents are copied over on the GPU.
+    Removing entries leaves holes, compact repacks every live entry into a fresh array with glCopyImageSubData.
+    Allocation is logarithmic in the number of shelves, so atlases with hundreds of thousands of entries stay fast.
+
+    Entries are padded on their right and bottom edges, and everything outside of live entries is kept at zero, so filtering does not pick up neighbours.
+    Removing an entry clears it along with its padding, so space that is reused never holds the pixels of old entries.
+    */
+    class TextureAtlas {
+    public:
+        /// <summary>
+        /// Create an atlas and allocate its first layers.
+        /// </summary>
+        /// <param name="form">The format of the atlas texture</param>
+        /// <param name="layerSize">The size of each layer</param>
+        /// <param name="initialLayers">The number of layers to start with, the atlas never compacts below this</param>
+        /// <param name="maxLayers">The most layers the atlas may grow to, zero for the implementation limit</param>
+        /// <param name="entryPadding">Empty texels kept between entries</param>
+        TextureAtlas(TexFormat form, const glm::ivec2& layerSize, GLint initialLayers = 1, GLint maxLayers = 0, GLint entryPadding = 1)
+            : format(form)
+            , size(layerSize)
+            , minLayers(initialLayers)
+            , layerLimit(maxLayers)
+            , padding(entryPadding)
+            , packer(layerSize)
+            , usedArea(0)
+            , liveCount(0)
+            , version(0)
+        {
+            assert(size.x > 0 && size.y > 0);
+            assert(minLayers > 0);
+            assert(padding >= 0);
+
+            if (layerLimit <= 0) {
+                glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layerLimit);
+                checkError();
+            }
+            assert(minLayers <= layerLimit);
+
+            texture = makeTexture(minLayers);
+            packer.addLayers(minLayers);
+        }
+
+        TextureAtlas(TextureAtlas&&) noexcept = default;
+        TextureAtlas& operator=(TextureAtlas&&) noexcept = default;
+
+        TextureAtlas(const TextureAtlas&) = delete;
+        TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+        /// <summary>
+        /// Reserve a rectangle without writing to it. Returns an invalid region if it does not fit, even after growing.
+        /// </summary>
+        AtlasRegion allocate(const glm::ivec2& region) {
+            assert(region.x > 0 && region.y > 0);
+
+            intern::ShelfPacker::Placement placement;
+            glm::ivec2 padded = region + padding;
+            while (!packer.place(padded, placement)) {
+                if (padded.x > size.x || padded.y > size.y || !grow()) {
+                    return AtlasRegion{};
+                }
+            }
+
+            uint32_t id = 0;
+            if (!freeIds.empty()) {
+                id = freeIds.back();
+                freeIds.pop_back();
+            }
+            else {
+                id = static_cast<uint32_t>(entries.size());
+                entries.emplace_back();
+            }
+            entries[id] = Entry{ placement, region, true };
+
+            usedArea += static_cast<uint64_t>(region.x) * region.y;
+            ++liveCount;
+            return makeRegion(id);
+        }
+
+        /// <summary>
+        /// Reserve a rectangle and upload an image into it.
+        /// </summary>
+        /// <param name="data">The pixels to upload, region.x by region.y of them</param>
+        /// <param name="region">The size of the image</param>
+        /// <param name="comp">The component type of the data being read, this must be compatible with the atlas format</param>
+        /// <param name="form">The format of the pixel data being read</param>
+        AtlasRegion insert(const void* data, const glm::ivec2& region, PixelComponent comp, PixelFormat form) {
+            AtlasRegion result = allocate(region);
+            if (result.isValid()) {
+                texture->subImage(data, 0, glm::ivec3{ result.offset, result.layer }, glm::ivec3{ region, 1 }, comp, form);
+            }
+            return result;
+        }
+
+        // Release an entry and clear its texels, its space is reused once its shelf empties or the atlas is compacted.
+        void remove(uint32_t id) {
+            assert(contains(id) && "Attempted to remove an entry that is not in the atlas!");
+            Entry& entry = entries[id];
+            packer.release(entry.placement, entry.size.x + padding);
+            intern::clearToZero(*texture, glm::ivec3{ entry.placement.offset, entry.placement.layer }, glm::ivec3{ entry.size + padding, 1 });
+
+            usedArea -= static_cast<uint64_t>(entry.size.x) * entry.size.y;
+            --liveCount;
+            entry.alive = false;
+            freeIds.push_back(id);
+        }
+
+        /// <summary>
+        /// Repack every live entry into a fresh texture, tallest first, and copy them over on the GPU.
+        /// The layer count shrinks to what the entries need, but not below the initial layers.
+        /// Returns false and leaves the atlas as it was if the entries would not fit into the maximum layers.
+        /// </summary>
+        bool compact() {
+            std::vector<uint32_t> order;
+            order.reserve(liveCount);
+            for (uint32_t id = 0; id < entries.size(); ++id) {
+                if (entries[id].alive) {
+                    order.push_back(id);
+                }
+            }
+            std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+                const glm::ivec2& sa = entries[a].size;
+                const glm::ivec2& sb = entries[b].size;
+                return sa.y != sb.y ? sa.y > sb.y : (sa.x != sb.x ? sa.x > sb.x : a < b);
+            });
+
+            intern::ShelfPacker next(size);
+            next.addLayers(minLayers);
+            std::vector<intern::ShelfPacker::Placement> placements(order.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                glm::ivec2 padded = entries[order[i]].size + padding;
+                while (!next.place(padded, placements[i])) {
+                    if (next.numLayers() >= layerLimit) {
+                        return false;
+                    }
+                    next.addLayers(1);
+                }
+            }
+
+            std::unique_ptr<Texture2DArray> nextTexture = makeTexture(next.numLayers());
+            for (size_t i = 0; i < order.size(); ++i) {
+                Entry& entry = entries[order[i]];
+                const intern::ShelfPacker::Placement& placement = placements[i];
+                texture->copyTo(*nextTexture, 0, 0,
+                    glm::ivec3{ entry.placement.offset, entry.placement.layer },
+                    glm::ivec3{ placement.offset, placement.layer },
+                    glm::ivec3{ entry.size, 1 });
+                entry.placement = placement;
+            }
+
+            texture = std::move(nextTexture);
+            packer = std::move(next);
+            ++version;
+            return true;
+        }
+
+        // Remove every entry, keeping the texture and its layers.
+        void clear() {
+            intern::clearToZero(*texture);
+            entries.clear();
+            freeIds.clear();
+            packer = intern::ShelfPacker(size);
+            packer.addLayers(texture->getDepth());
+            usedArea = 0;
+            liveCount = 0;
+            ++version;
+        }
+
+        // Getters ---
+        bool contains(uint32_t id) const noexcept {
+            return id < entries.size() && entries[id].alive;
+        }
+        AtlasRegion region(uint32_t id) const {
+            assert(contains(id));
+            return makeRegion(id);
+        }
+
+        // Changes whenever entries move or the texture is reallocated, regions and bindings made before then are stale.
+        uint64_t getVersion() const noexcept {
+            return version;
+        }
+
+        const Texture2DArray& getTexture() const noexcept {
+            return *texture;
+        }
+        Texture2DArray& getTexture() noexcept {
+            return *texture;
+        }
+        glm::ivec2 getLayerSize() const noexcept {
+            return size;
+        }
+        GLint numLayers() const noexcept {
+            return packer.numLayers();
+        }
+        size_t numEntries() const noexcept {
+            return liveCount;
+        }
+        // The fraction of all layers covered by live entries.
+        float occupancy() const noexcept {
+            return static_cast<float>(static_cast<double>(usedArea) / (static_cast<double>(size.x) * size.y * numLayers()));
+        }
+        // The fraction of the space taken up by shelves that is not covered by live entries, a high value means compact would help.
+        float fragmentation() const noexcept {
+            uint64_t reserved = packer.reservedArea();
+            return reserved == 0 ? 0.f : static_cast<float>(1.0 - static_cast<double>(usedArea) / static_cast<double>(reserved));
+        }
+    private:
+        struct Entry {
+            intern::ShelfPacker::Placement placement;
+            glm::ivec2 size;
+            bool alive;
+        };
+
+        std::unique_ptr<Texture2DArray> makeTexture(GLint layers) const {
+            std::unique_ptr<Texture2DArray> tex = std::make_unique<Texture2DArray>();
+            tex->init(format, 1, glm::ivec3{ size, layers });
+            intern::clearToZero(*tex);
+            return tex;
+        }
+
+        // Double the layers, copying the old ones over in one go. Entries keep their place.
+        bool grow() {
+            GLint layers = packer.numLayers();
+            if (layers >= layerLimit) {
+                return false;
+            }
+            GLint grown = std::min(layers * 2, layerLimit);
+
+            std::unique_ptr<Texture2DArray> nextTexture = makeTexture(grown);
+            texture->copyTo(*nextTexture, 0, 0, glm::ivec3{ 0 }, glm::ivec3{ 0 }, glm::ivec3{ size, layers });
+            texture = std::move(nextTexture);
+
+            packer.addLayers(grown - layers);
+            ++version;
+            return true;
+        }
+
+        AtlasRegion makeRegion(uint32_t id) const {
+            const Entry& entry = entries[id];
+            glm::vec2 scale{ 1.f / static_cast<float>(size.x), 1.f / static_cast<float>(size.y) };
+            glm::vec2 min = glm::vec2(entry.placement.offset) * scale;
+            glm::vec2 max = glm::vec2(entry.placement.offset + entry.size) * scale;
+
+            AtlasRegion result;
+            result.id = id;
+            result.layer = entry.placement.layer;
+            result.offset = entry.placement.offset;
+            result.size = entry.size;
+            result.uv = glm::vec4{ min.x, min.y, max.x, max.y };
+            return result;
+        }
+
+        TexFormat format;
+        glm::ivec2 size;
+        GLint minLayers, layerLimit, padding;
+
+        std::unique_ptr<Texture2DArray> texture;
+        intern::ShelfPacker packer;
+
+        std::vector<Entry> entries;
+        std::vector<uint32_t> freeIds;
+        uint64_t usedArea;
+        size_t liveCount;
+        uint64_t version;
+    };
+}
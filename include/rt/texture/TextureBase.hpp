@@ -1,7 +1,9 @@
 #pragma once
 #include "../TextureUtilities.hpp"
+#include "../StateCache.hpp"
 #include <cassert>
 #include <array>
+#include <algorithm>
 
 #ifdef RENDER_TOOLS_COMPREHENSIVE_ERROR_CHECKS
 #define RT_ERROR(x) x
@@ -10,6 +12,12 @@
 #endif
 
 namespace rt {
+    enum class ImageAccess : GLenum {
+        Read = GL_READ_ONLY,
+        Write = GL_WRITE_ONLY,
+        ReadWrite = GL_READ_WRITE,
+    };
+
     class TextureBase {
     public:
         TextureBase()
@@ -30,6 +38,7 @@ namespace rt {
         }
         ~TextureBase() {
             if (isValid()) {
+                StateCache::get().forgetTexture(id);
                 glDeleteTextures(1, &id);
                 id = 0;
             }
@@ -40,6 +49,7 @@ namespace rt {
 
         TextureBase& operator=(TextureBase&& other) noexcept {
             if (isValid()) {
+                StateCache::get().forgetTexture(id);
                 glDeleteTextures(1, &id);
                 checkError();
             }
@@ -128,10 +138,39 @@ namespace rt {
         }
 
         void bindUnit(GLuint texUnit) {
-            glBindTextureUnit(texUnit, id);
+            if (StateCache::get().bindTextureUnit(texUnit, id)) {
+                glBindTextureUnit(texUnit, id);
+                checkError();
+            }
+        }
+
+        // Bind a single level to an image unit, for image load and store in shaders. Layered textures bind every layer.
+        void bindImage(GLuint imageUnit, GLint level, ImageAccess access) {
+            assert(level >= 0);
+            glBindImageTexture(imageUnit, id, level, GL_TRUE, 0, static_cast<GLenum>(access), convertGL(format));
             checkError();
         }
 
+        // Limit the levels that can be sampled, texel fetches then count levels from base.
+        void setLevelRange(GLint base, GLint max) {
+            assert(base >= 0 && base <= max);
+            glTextureParameteri(id, GL_TEXTURE_BASE_LEVEL, base);
+            glTextureParameteri(id, GL_TEXTURE_MAX_LEVEL, max);
+            checkError();
+        }
+        // Back to every level of the texture. Mutable storage can gain levels later, so it gets the opengl default of 1000.
+        void resetLevelRange() {
+            GLint levels = getImmutableLevels();
+            setLevelRange(0, levels > 0 ? levels - 1 : 1000);
+        }
+        // The number of levels of immutable storage, or 0 for mutable storage.
+        GLint getImmutableLevels() const {
+            GLint levels = 0;
+            glGetTextureParameteriv(id, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+            checkError();
+            return levels;
+        }
+
         void generateMipmaps() {
             glGenerateTextureMipmap(id);
             checkError();
@@ -253,6 +292,10 @@ namespace rt {
             return id;
         }
 
+        TexFormat getFormat() const noexcept {
+            return format;
+        }
+
         GLenum getGLTarget() const {
             GLint value = 0;
             glGetTextureParameteriv(id, GL_TEXTURE_TARGET, &value);
@@ -302,6 +345,38 @@ namespace rt {
             assert(level >= 0);
             glTextureSubImage3D(getId(), level, offset.x, offset.y, offset.z, region.x, region.y, region.z, convertGL(comp), convertGL(comp, form), data);
         }
+
+        /// <summary>
+        /// Substitute block compressed data into a texture object, the data has to be in the texture's own format.
+        /// </summary>
+        /// <param name="data">The compressed blocks to read from</param>
+        /// <param name="length">The number of bytes to read, compressedSize of the region</param>
+        /// <param name="level">The mipmap level to write to</param>
+        /// <param name="offset">The offset into the texture to write to, a multiple of the block size</param>
+        /// <param name="region">The region to write to, a multiple of the block size unless it reaches the edge of the level</param>
+        void compressedSubImage2D(const void* data, size_t length, GLint level, const glm::ivec2& offset, const glm::ivec2& region) {
+            assert(level >= 0);
+            assert(isCompressed(format) && "Compressed data can only be written to compressed textures!");
+            assert(length == compressedSize(format, glm::ivec3{ region, 1 }) && "Compressed data does not match the region!");
+            glCompressedTextureSubImage2D(getId(), level, offset.x, offset.y, region.x, region.y, convertGL(format), static_cast<GLsizei>(length), data);
+            checkError();
+        }
+
+        /// <summary>
+        /// Substitute block compressed data into a texture object, the data has to be in the texture's own format.
+        /// </summary>
+        /// <param name="data">The compressed blocks to read from</param>
+        /// <param name="length">The number of bytes to read, compressedSize of the region</param>
+        /// <param name="level">The mipmap level to write to</param>
+        /// <param name="offset">The offset into the texture to write to, x and y a multiple of the block size</param>
+        /// <param name="region">The region to write to, x and y a multiple of the block size unless they reach the edge of the level</param>
+        void compressedSubImage3D(const void* data, size_t length, GLint level, const glm::ivec3& offset, const glm::ivec3& region) {
+            assert(level >= 0);
+            assert(isCompressed(format) && "Compressed data can only be written to compressed textures!");
+            assert(length == compressedSize(format, region) && "Compressed data does not match the region!");
+            glCompressedTextureSubImage3D(getId(), level, offset.x, offset.y, offset.z, region.x, region.y, region.z, convertGL(format), static_cast<GLsizei>(length), data);
+            checkError();
+        }
     protected:
         void enableMipmapFilters() {
             if (minFilter != GL_LINEAR_MIPMAP_LINEAR) {
@@ -0,0 +1,128 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+namespace rt {
+    namespace intern {
+        /*
+        A fixed set of worker threads for splitting CPU side texture work, such as mip building and block compression.
+        One parallelFor runs at a time, and the calling thread works on it too.
+        */
+        class WorkerPool {
+        public:
+            WorkerPool(unsigned threadCount = std::thread::hardware_concurrency())
+                : workers()
+                , mutex()
+                , wake()
+                , done()
+                , job(nullptr)
+                , jobCount(0)
+                , jobChunk(1)
+                , next(0)
+                , active(0)
+                , generation(0)
+                , stopping(false)
+            {
+                // The calling thread does its share of the work too.
+                for (unsigned i = 1; i < threadCount; ++i) {
+                    workers.emplace_back([this]() { workerLoop(); });
+                }
+            }
+            ~WorkerPool() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                wake.notify_all();
+                for (std::thread& worker : workers) {
+                    worker.join();
+                }
+            }
+
+            WorkerPool(const WorkerPool&) = delete;
+            WorkerPool& operator=(const WorkerPool&) = delete;
+
+            // Splits [0, count) into chunks and runs them across the workers and the calling thread, returns once all of them are done.
+            void parallelFor(size_t count, const std::function<void(size_t, size_t)>& fn) {
+                if (count == 0) {
+                    return;
+                }
+                size_t chunk = std::max<size_t>(1, count / (numThreads() * 4));
+                if (workers.empty() || count <= chunk) {
+                    fn(0, count);
+                    return;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    job = &fn;
+                    jobCount = count;
+                    jobChunk = chunk;
+                    next.store(0);
+                    active = workers.size();
+                    ++generation;
+                }
+                wake.notify_all();
+
+                runChunks(fn, count, chunk);
+
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [this]() { return active == 0; });
+                job = nullptr;
+            }
+
+            // The number of threads work is split across, including the calling thread.
+            size_t numThreads() const noexcept {
+                return workers.size() + 1;
+            }
+        private:
+            void runChunks(const std::function<void(size_t, size_t)>& fn, size_t count, size_t chunk) {
+                for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+                    fn(begin, std::min(begin + chunk, count));
+                }
+            }
+
+            void workerLoop() {
+                uint64_t seen = 0;
+                while (true) {
+                    const std::function<void(size_t, size_t)>* fn;
+                    size_t count, chunk;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        wake.wait(lock, [this, seen]() { return stopping || generation != seen; });
+                        if (stopping) {
+                            return;
+                        }
+                        seen = generation;
+                        fn = job;
+                        count = jobCount;
+                        chunk = jobChunk;
+                    }
+
+                    runChunks(*fn, count, chunk);
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--active == 0) {
+                        done.notify_one();
+                    }
+                }
+            }
+
+            std::vector<std::thread> workers;
+            std::mutex mutex;
+            std::condition_variable wake, done;
+            const std::function<void(size_t, size_t)>* job;
+            size_t jobCount, jobChunk;
+            std::atomic<size_t> next;
+            size_t active;
+            uint64_t generation;
+            bool stopping;
+        };
+    }
+}
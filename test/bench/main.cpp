@@ -0,0 +1,313 @@
+// Per call error checks would dominate the timings.
+#undef RENDER_TOOLS_ERROR_CHECKS
+
+#include <Utilities.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#include <rt/IndirectDrawList.hpp>
+#include <rt/TextureUploader.hpp>
+
+/*
+Microbenchmarks for the common upload and submission paths, written as JSON so results can be compared between runs.
+Each iteration is timed on the CPU up to a glFinish, so the time includes the work the driver and GPU did for it.
+
+Usage: rt-bench [--out file.json] [--filter text] [--time milliseconds], results go to rt-bench.json by default.
+*/
+
+struct BenchResult {
+	std::string group;
+	std::string name;
+	size_t iterations;
+	double meanMs, medianMs, minMs, maxMs;
+	double bytesPerIteration;
+};
+
+class Bench {
+public:
+	Bench(std::string_view filter, double minTimeMs)
+		: filter(filter)
+		, minTime(minTimeMs)
+		, results()
+	{}
+
+	// Runs fn until at least the minimum time has passed, after a couple of warm up iterations.
+	template<typename Fn>
+	void run(std::string_view group, std::string_view name, double bytesPerIteration, Fn&& fn) {
+		std::string fullName = fmt::format("{}/{}", group, name);
+		if (!filter.empty() && fullName.find(filter) == std::string::npos) {
+			return;
+		}
+
+		for (int i = 0; i < WarmupIterations; ++i) {
+			fn();
+		}
+		glFinish();
+
+		std::vector<double> times;
+		double total = 0.0;
+		while ((total < minTime || times.size() < MinIterations) && times.size() < MaxIterations) {
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			glFinish();
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			times.push_back(ms);
+			total += ms;
+		}
+
+		std::sort(times.begin(), times.end());
+		BenchResult result{ std::string(group), std::string(name), times.size(), total / times.size(), times[times.size() / 2], times.front(), times.back(), bytesPerIteration };
+		fmt::print(stderr, "{:<40} {:>8} it {:>10.3f} ms median\n", fullName, result.iterations, result.medianMs);
+		results.push_back(std::move(result));
+	}
+
+	void write(std::FILE* out) const {
+		fmt::print(out, "{{\n");
+		fmt::print(out, "  \"version\": \"{}\",\n", escape(reinterpret_cast<const char*>(glGetString(GL_VERSION))));
+		fmt::print(out, "  \"renderer\": \"{}\",\n", escape(reinterpret_cast<const char*>(glGetString(GL_RENDERER))));
+#if defined(RT_TEST_HEADLESS)
+		fmt::print(out, "  \"headless\": true,\n");
+#else
+		fmt::print(out, "  \"headless\": false,\n");
+#endif
+		fmt::print(out, "  \"results\": [\n");
+		for (size_t i = 0; i < results.size(); ++i) {
+			const BenchResult& r = results[i];
+			double bytesPerSecond = r.bytesPerIteration > 0.0 ? r.bytesPerIteration / (r.medianMs / 1000.0) : 0.0;
+			fmt::print(out, "    {{ \"group\": \"{}\", \"name\": \"{}\", \"iterations\": {}, \"mean_ms\": {:.6f}, \"median_ms\": {:.6f}, \"min_ms\": {:.6f}, \"max_ms\": {:.6f}, \"bytes_per_second\": {:.0f} }}{}\n",
+				escape(r.group), escape(r.name), r.iterations, r.meanMs, r.medianMs, r.minMs, r.maxMs, bytesPerSecond, i + 1 < results.size() ? "," : "");
+		}
+		fmt::print(out, "  ]\n}}\n");
+	}
+private:
+	static std::string escape(std::string_view text) {
+		std::string result;
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				result.push_back('\\');
+			}
+			result.push_back(c);
+		}
+		return result;
+	}
+
+	static constexpr int WarmupIterations = 2;
+	static constexpr size_t MinIterations = 5;
+	static constexpr size_t MaxIterations = 10000;
+
+	std::string filter;
+	double minTime;
+	std::vector<BenchResult> results;
+};
+
+static std::string sizeName(size_t bytes) {
+	return bytes >= 1024 * 1024 ? fmt::format("{}MiB", bytes / (1024 * 1024)) : fmt::format("{}KiB", bytes / 1024);
+}
+
+static void benchBufferUploads(Bench& bench) {
+	for (size_t bytes : { size_t(64 * 1024), size_t(1024 * 1024), size_t(16 * 1024 * 1024) }) {
+		std::vector<uint8_t> data(bytes, 0x5A);
+		std::string size = sizeName(bytes);
+
+		rt::ImmutableBuffer dynamic{ bytes, rt::BufferInit::Dynamic };
+		bench.run("buffer_upload", "subArray/" + size, double(bytes), [&]() {
+			dynamic.subArray(data.data(), data.size());
+		});
+
+		rt::ImmutableBuffer mappable{ bytes, rt::BufferInit::Write };
+		bench.run("buffer_upload", "mapped/" + size, double(bytes), [&]() {
+			uint8_t* ptr = mappable.mapRange<uint8_t>(0, GLsizeiptr(bytes), rt::BufferFlag::Write | rt::BufferFlag::InvalidateBuffer);
+			std::memcpy(ptr, data.data(), data.size());
+			mappable.unmap();
+		});
+
+		rt::StreamRingBuffer ring{ bytes };
+		bench.run("buffer_upload", "persistent/" + size, double(bytes), [&]() {
+			rt::StreamAllocation alloc = ring.allocate(bytes);
+			std::memcpy(alloc.data, data.data(), data.size());
+			ring.nextRegion();
+		});
+	}
+}
+
+static constexpr GLsizei DrawCount = 4096;
+
+// A per draw material, written one element at a time like a renderer setting its parameters, where only a few of them change.
+static constexpr std::string_view paletteVertexSource =
+	"#version 450\n"
+	"layout(location = 0) in vec2 pos;\n"
+	"uniform vec4 palette[16];\n"
+	"out vec3 fragColor;\n"
+	"void main() {\n"
+	"	vec4 sum = vec4(0.0);\n"
+	"	for (int i = 0; i < 16; ++i) { sum += palette[i]; }\n"
+	"	gl_Position = vec4(pos * 0.1 + sum.xy * 0.01, 0.0, 1.0);\n"
+	"	fragColor = sum.rgb;\n"
+	"}\n";
+
+static void benchUniformUpdates(Bench& bench, ColoredQuadProgram& quad) {
+	std::vector<glm::mat4> models(DrawCount);
+	for (GLsizei i = 0; i < DrawCount; ++i) {
+		models[i] = glm::mat4{ 1.f };
+		models[i][3] = glm::vec4{ float(i % 64) / 64.f, float(i / 64) / 64.f, 0.f, 1.f };
+	}
+
+	rt::Program palette;
+	palette.compile(paletteVertexSource, loadSource("basic.fs.glsl"));
+	GLint uPalette = palette.getUniformLocation("palette");
+	std::vector<glm::vec4> colors(16, glm::vec4{ 0.5f });
+
+	const std::pair<std::string_view, rt::UniformMode> modes[] = {
+		{ "immediate", rt::UniformMode::Immediate },
+		{ "cached", rt::UniformMode::Cached },
+		{ "deferred", rt::UniformMode::Deferred },
+	};
+	for (const auto& [name, mode] : modes) {
+		quad.program.setUniformMode(mode);
+		quad.bind();
+		bench.run("uniform_update", fmt::format("{}/changing", name), double(DrawCount * sizeof(glm::mat4)), [&]() {
+			for (GLsizei i = 0; i < DrawCount; ++i) {
+				quad.program.uniform(quad.uModel, models[i]);
+				quad.draw();
+			}
+		});
+		bench.run("uniform_update", fmt::format("{}/unchanged", name), double(DrawCount * sizeof(glm::mat4)), [&]() {
+			for (GLsizei i = 0; i < DrawCount; ++i) {
+				quad.program.uniform(quad.uModel, models[0]);
+				quad.draw();
+			}
+		});
+		quad.unbind();
+
+		palette.setUniformMode(mode);
+		palette.bind();
+		quad.vao.bind();
+		bench.run("uniform_update", fmt::format("{}/elements", name), double(DrawCount * sizeof(glm::vec4) * colors.size()), [&]() {
+			for (GLsizei i = 0; i < DrawCount; ++i) {
+				colors[0].x = float(i % 64) / 64.f;
+				colors[1].y = float(i / 64) / 64.f;
+				for (size_t j = 0; j < colors.size(); ++j) {
+					palette.uniform(uPalette + GLint(j), colors[j]);
+				}
+				quad.draw();
+			}
+		});
+		quad.unbind();
+	}
+	quad.program.setUniformMode(rt::UniformMode::Immediate);
+}
+
+static void benchTextureUploads(Bench& bench) {
+	for (GLint side : { 256, 1024, 2048 }) {
+		glm::ivec2 size{ side };
+		size_t bytes = size_t(side) * side * 4;
+		std::vector<uint8_t> pixels(bytes, 0x7F);
+		std::string name = fmt::format("{}x{}", side, side);
+
+		rt::ImmutableTexture2d texture;
+		texture.init(rt::TexFormat::RGBA_N8, 1, size);
+
+		bench.run("texture_upload", "subImage/" + name, double(bytes), [&]() {
+			texture.subImage(pixels.data(), 0, glm::ivec2{ 0 }, size, rt::PixelComponent::RGBA, rt::PixelFormat::U8);
+		});
+
+		rt::TextureUploader uploader{ bytes * 3 };
+		bench.run("texture_upload", "uploader/" + name, double(bytes), [&]() {
+			uploader.submit(texture, 0, glm::ivec2{ 0 }, size, rt::PixelComponent::RGBA, rt::PixelFormat::U8, pixels.data());
+			uploader.flush();
+		});
+	}
+}
+
+static void benchDrawSubmission(Bench& bench, ColoredQuadProgram& quad) {
+	quad.bind();
+	bench.run("draw_submission", fmt::format("drawArrays/{}", DrawCount), 0.0, [&]() {
+		for (GLsizei i = 0; i < DrawCount; ++i) {
+			quad.draw();
+		}
+	});
+
+	rt::IndirectArraysDrawList list{ uint32_t(DrawCount) };
+	bench.run("draw_submission", fmt::format("multiDrawIndirect/{}", DrawCount), 0.0, [&]() {
+		list.begin();
+		for (GLsizei i = 0; i < DrawCount; ++i) {
+			list.add(6);
+		}
+		list.submit(quad.vao, rt::Primitive::Triangles);
+		list.getStream().nextRegion();
+	});
+	quad.unbind();
+}
+
+static void printUsage() {
+	fmt::print(stderr, "Usage: rt-bench [--out file.json] [--filter text] [--time milliseconds]\n");
+}
+
+int main(int argc, char** argv) {
+	std::string outPath = "rt-bench.json";
+	std::string filter;
+	double minTime = 250.0;
+	for (int i = 1; i < argc; i += 2) {
+		std::string_view arg = argv[i];
+		if (arg != "--out" && arg != "--filter" && arg != "--time") {
+			fmt::print(stderr, "Unknown argument {}\n", arg);
+			printUsage();
+			return 1;
+		}
+		if (i + 1 >= argc) {
+			fmt::print(stderr, "Missing a value for {}\n", arg);
+			printUsage();
+			return 1;
+		}
+
+		const char* value = argv[i + 1];
+		if (arg == "--out") {
+			outPath = value;
+		}
+		else if (arg == "--filter") {
+			filter = value;
+		}
+		else {
+			char* end = nullptr;
+			minTime = std::strtod(value, &end);
+			if (end == value || *end != '\0' || minTime <= 0.0) {
+				fmt::print(stderr, "--time expects a positive number of milliseconds, got {}\n", value);
+				return 1;
+			}
+		}
+	}
+
+	// Opened up front, so a bad path fails before the benchmarks run rather than after.
+	std::FILE* file = std::fopen(outPath.c_str(), "w");
+	if (file == nullptr) {
+		fmt::print(stderr, "Failed to open {} for writing: {}\n", outPath, std::strerror(errno));
+		return 1;
+	}
+
+	sf::Window* window = initializeWindow();
+	{
+		// Keep fill rate out of the draw timings.
+		glViewport(0, 0, 16, 16);
+
+		Bench bench{ filter, minTime };
+		ColoredQuadProgram quad;
+
+		benchBufferUploads(bench);
+		benchUniformUpdates(bench, quad);
+		benchTextureUploads(bench);
+		benchDrawSubmission(bench, quad);
+
+		bench.write(file);
+		std::fclose(file);
+		fmt::print("Results written to {}\n", outPath);
+	}
+	cleanup(window);
+
+	return 0;
+}
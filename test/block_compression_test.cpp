@@ -0,0 +1,130 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+
+#include <rt/Texture.hpp>
+
+// Not a multiple of the block size on purpose, so the edge blocks are partial.
+static const glm::ivec2 ImageSize{ 259, 131 };
+static const glm::ivec2 BenchSize{ 2048, 2048 };
+
+// Smooth gradients with a little noise, roughly what generated content looks like.
+static std::vector<uint8_t> makeImage(const glm::ivec2& size, size_t channels) {
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> noise(-6, 6);
+	std::vector<uint8_t> pixels(size_t(size.x) * size.y * channels);
+	for (GLint y = 0; y < size.y; ++y) {
+		for (GLint x = 0; x < size.x; ++x) {
+			uint8_t* pixel = pixels.data() + (size_t(y) * size.x + x) * channels;
+			for (size_t c = 0; c < channels; ++c) {
+				float wave = 0.5f + 0.5f * std::sin(float(x) * 0.02f * float(c + 1) + float(y) * 0.03f);
+				pixel[c] = uint8_t(std::clamp(int(wave * 255.f) + noise(rng), 0, 255));
+			}
+		}
+	}
+	return pixels;
+}
+
+static GLenum readFormat(size_t channels) {
+	switch (channels) {
+	case 1:
+		return GL_RED;
+	case 2:
+		return GL_RG;
+	case 3:
+		return GL_RGB;
+	default:
+		return GL_RGBA;
+	}
+}
+
+// Uploads through the compressor, lets the driver decompress, and measures the PSNR against the source.
+static double roundTrip(rt::BlockCompressor& compressor, rt::TexFormat format, const std::vector<uint8_t>& pixels, size_t channels, std::vector<uint8_t>& decoded) {
+	rt::ImmutableTexture2d texture;
+	texture.init(format, 1, ImageSize);
+	compressor.upload(texture, 0, pixels.data());
+
+	decoded.resize(pixels.size());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTextureImage(texture.getId(), 0, readFormat(channels), GL_UNSIGNED_BYTE, GLsizei(decoded.size()), decoded.data());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	double error = 0.0;
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		double diff = double(pixels[i]) - double(decoded[i]);
+		error += diff * diff;
+	}
+	double mse = error / double(pixels.size());
+	return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::BlockCompressor compressor;
+		fmt::print("Compressor threads: {}\n", compressor.numThreads());
+
+		bool metadata =
+			rt::isCompressed(rt::TexFormat::RGBA_BC7) && !rt::isCompressed(rt::TexFormat::RGBA_N8) &&
+			rt::blockSize(rt::TexFormat::RGBA_ASTC_10x6) == glm::ivec2(10, 6) && rt::blockSize(rt::TexFormat::RGBA_N8) == glm::ivec2(1, 1) &&
+			rt::blockBytes(rt::TexFormat::RGB_BC1) == 8 && rt::blockBytes(rt::TexFormat::RG_BC5) == 16 &&
+			rt::compressedSize(rt::TexFormat::RGBA_BC3, glm::ivec3{ ImageSize, 1 }) == size_t(65 * 33 * 16) &&
+			rt::compressedSize(rt::TexFormat::RGBA_ASTC_12x12, glm::ivec3{ 25, 24, 2 }) == size_t(3 * 2 * 2 * 16);
+		fmt::print("Metadata: {}\n", metadata ? "passed" : "failed");
+
+		struct Case {
+			rt::TexFormat format;
+			size_t channels;
+			double minPsnr;
+		};
+		const Case cases[] = {
+			{ rt::TexFormat::RGB_BC1, 3, 32.0 },
+			{ rt::TexFormat::RGBA_BC3, 4, 32.0 },
+			{ rt::TexFormat::R_BC4, 1, 40.0 },
+			{ rt::TexFormat::RG_BC5, 2, 40.0 },
+		};
+
+		bool quality = true;
+		std::vector<uint8_t> decoded;
+		for (const Case& test : cases) {
+			if (!rt::compressionSupported(test.format)) {
+				fmt::print("{}: not supported, skipped\n", rt::to_string_view(test.format));
+				continue;
+			}
+			std::vector<uint8_t> pixels = makeImage(ImageSize, test.channels);
+			double psnr = roundTrip(compressor, test.format, pixels, test.channels, decoded);
+			fmt::print("{}: {:.2f} dB\n", rt::to_string_view(test.format), psnr);
+			quality = quality && psnr >= test.minPsnr;
+		}
+
+		// Texels with alpha below half become transparent black with BC1 punch through alpha.
+		bool punchThrough = true;
+		if (rt::compressionSupported(rt::TexFormat::RGBA_BC1)) {
+			std::vector<uint8_t> pixels = makeImage(ImageSize, 4);
+			for (size_t i = 0; i < pixels.size(); i += 4) {
+				pixels[i + 3] = (i / 4) % 7 == 0 ? 0 : 255;
+			}
+			roundTrip(compressor, rt::TexFormat::RGBA_BC1, pixels, 4, decoded);
+			for (size_t i = 0; i < pixels.size(); i += 4) {
+				punchThrough = punchThrough && decoded[i + 3] == pixels[i + 3];
+			}
+			fmt::print("Punch through: {}\n", punchThrough ? "passed" : "failed");
+		}
+
+		std::vector<uint8_t> bench = makeImage(BenchSize, 4);
+		std::vector<uint8_t> blocks(rt::compressedSize(rt::TexFormat::RGBA_BC3, glm::ivec3{ BenchSize, 1 }));
+		auto start = std::chrono::steady_clock::now();
+		compressor.compress(bench.data(), BenchSize, rt::TexFormat::RGBA_BC3, blocks.data());
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		fmt::print("BC3 {}x{}: {:.2f} ms, {:.1f} MPixels/s\n", BenchSize.x, BenchSize.y, ms, double(BenchSize.x) * BenchSize.y / (ms * 1000.0));
+
+		passed = metadata && quality && punchThrough;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
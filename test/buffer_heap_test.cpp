@@ -0,0 +1,143 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <rt/Buffer.hpp>
+#include <rt/VertexArray.hpp>
+
+static constexpr size_t PageSize = 64 * 1024;
+
+static void fill(rt::BufferSlice& slice, uint32_t tag) {
+	std::vector<uint32_t> values(slice.sizeBytes() / sizeof(uint32_t), tag);
+	slice.subArray(values.data(), values.size());
+}
+
+static bool verify(const rt::BufferSlice& slice, uint32_t tag) {
+	std::vector<uint32_t> values(slice.sizeBytes() / sizeof(uint32_t));
+	slice.getBuffer().getData(values.data(), values.size(), slice.getOffset());
+	return std::all_of(values.begin(), values.end(), [tag](uint32_t value) { return value == tag; });
+}
+
+// Slices in the same buffer must not overlap, once rounded up to whole blocks.
+static bool verifyDisjoint(const std::vector<rt::BufferSlice>& slices, size_t blockSize) {
+	for (size_t i = 0; i < slices.size(); ++i) {
+		for (size_t j = i + 1; j < slices.size(); ++j) {
+			const rt::BufferSlice& a = slices[i];
+			const rt::BufferSlice& b = slices[j];
+			if (a.getId() != b.getId()) {
+				continue;
+			}
+			intptr_t aEnd = a.getOffset() + intptr_t((a.sizeBytes() + blockSize - 1) / blockSize * blockSize);
+			intptr_t bEnd = b.getOffset() + intptr_t((b.sizeBytes() + blockSize - 1) / blockSize * blockSize);
+			if (a.getOffset() < bEnd && b.getOffset() < aEnd) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::BufferHeap heap{ PageSize };
+		size_t block = heap.blockSize();
+		fmt::print("Block size: {}, page size: {}\n", block, heap.pageSize());
+
+		// Splitting, every slice is aligned to its own rounded up size.
+		std::mt19937 rng(17);
+		std::uniform_int_distribution<size_t> sizes(1, 4 * block / sizeof(uint32_t));
+		std::vector<rt::BufferSlice> slices;
+		bool split = true;
+		for (uint32_t i = 0; i < 40; ++i) {
+			rt::BufferSlice slice = heap.allocate(sizes(rng) * sizeof(uint32_t));
+			size_t rounded = block;
+			while (rounded < slice.sizeBytes()) {
+				rounded <<= 1;
+			}
+			split = split && slice.isValid() && slice.getOffset() % intptr_t(rounded) == 0;
+			fill(slice, i);
+			slices.push_back(slice);
+		}
+		split = split && verifyDisjoint(slices, block);
+		for (uint32_t i = 0; i < slices.size(); ++i) {
+			split = split && verify(slices[i], i);
+		}
+		fmt::print("Split: {}, pages: {}, used: {} bytes\n", split ? "passed" : "failed", heap.numPages(), heap.usedBytes());
+
+		// Freeing everything merges the buddies back, so a whole page fits again without reserving another one.
+		size_t reserved = heap.reservedBytes();
+		for (rt::BufferSlice& slice : slices) {
+			heap.free(slice);
+		}
+		bool merged = heap.usedBytes() == 0 && !slices.front().isValid();
+		std::vector<rt::BufferSlice> whole;
+		for (size_t i = 0; i < reserved / PageSize; ++i) {
+			whole.push_back(heap.allocate(PageSize));
+			merged = merged && whole.back().getOffset() == 0;
+		}
+		merged = merged && heap.reservedBytes() == reserved;
+		for (rt::BufferSlice& slice : whole) {
+			heap.free(slice);
+		}
+		heap.trim();
+		merged = merged && heap.numPages() == 0 && heap.reservedBytes() == 0;
+
+		// Larger than a page gets a dedicated one.
+		rt::BufferSlice large = heap.allocate(PageSize * 3);
+		merged = merged && large.isValid() && large.getBuffer().sizeBytes() >= PageSize * 3 && heap.numPages() == 1;
+		heap.free(large);
+		heap.trim();
+		fmt::print("Merge: {}\n", merged ? "passed" : "failed");
+
+		// Two pages of single blocks, most of them freed, compaction has to pack the rest into the first page.
+		slices.clear();
+		for (uint32_t i = 0; i < 2 * PageSize / block; ++i) {
+			slices.push_back(heap.allocate(block));
+		}
+		bool compacted = heap.numPages() == 2;
+		std::vector<rt::BufferSlice> kept;
+		std::vector<uint32_t> tags;
+		for (uint32_t i = 0; i < slices.size(); ++i) {
+			if (i % 5 == 4) {
+				fill(slices[i], 1000 + i);
+				kept.push_back(slices[i]);
+				tags.push_back(1000 + i);
+			}
+			else {
+				heap.free(slices[i]);
+			}
+		}
+		std::vector<rt::BufferSlice*> pointers;
+		for (rt::BufferSlice& slice : kept) {
+			pointers.push_back(&slice);
+		}
+		size_t moved = heap.compact(pointers);
+
+		intptr_t end = 0;
+		for (size_t i = 0; i < kept.size(); ++i) {
+			compacted = compacted && verify(kept[i], tags[i]);
+			end = std::max(end, kept[i].getOffset() + intptr_t(block));
+		}
+		compacted = compacted && moved > 0 && heap.numPages() == 1 && size_t(end) == kept.size() * block && verifyDisjoint(kept, block);
+		fmt::print("Compact: {}, moved {} of {} slices\n", compacted ? "passed" : "failed", moved, kept.size());
+
+		// Binding a slice as a vertex buffer takes the offset before the stride, like binding a whole buffer.
+		rt::VertexArray vao;
+		vao.bindVertex(kept[1], 0, 16, 12);
+		GLint64 offset = 0;
+		GLint stride = 0;
+		glGetVertexArrayIndexed64iv(vao.getId(), 0, GL_VERTEX_BINDING_OFFSET, &offset);
+		glGetVertexArrayIndexediv(vao.getId(), 0, GL_VERTEX_BINDING_STRIDE, &stride);
+		bool binding = offset == kept[1].getOffset() + 16 && stride == 12;
+		fmt::print("Vertex binding: {}\n", binding ? "passed" : "failed");
+
+		passed = split && merged && compacted && binding;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -16,7 +16,6 @@
 int main() {
 	sf::Window* window = initializeWindow();
 	{
-		glEnable(GL_TEXTURE_2D);
 		glDisable(GL_DEPTH_TEST);
 		glClearColor(0.3f, 0.6f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -40,7 +39,7 @@ int main() {
 			vptr[5] = { glm::vec2{+1, +1}, glm::vec3{0, 0, 1} };
 		}
 		else {
-			throw std::exception("No pointer returned when mapping vertices buffer.");
+			throw std::runtime_error("No pointer returned when mapping vertices buffer.");
 		}
 
 		rt::VertexArray vao;
@@ -0,0 +1,102 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <memory>
+
+#include <rt/CompileQueue.hpp>
+
+static constexpr int ProgramCount = 16;
+
+static std::string vertexVariant(int variant) {
+	return fmt::format(
+		"#version 450\n"
+		"layout(location = 0) in vec2 pos;\n"
+		"void main() {{\n"
+		"	gl_Position = vec4(pos * {}.0, 0.0, 1.0);\n"
+		"}}\n", variant + 1);
+}
+
+static std::string fragmentVariant(int variant) {
+	return fmt::format(
+		"#version 450\n"
+		"out vec4 color;\n"
+		"void main() {{\n"
+		"	color = vec4({}.0 / 16.0);\n"
+		"}}\n", variant);
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::CompileQueue queue;
+		fmt::print("Parallel compile: {}\n", queue.isParallel() ? "supported" : "not supported");
+
+		std::vector<std::unique_ptr<rt::Shader>> shaders;
+		std::vector<std::unique_ptr<rt::Program>> programs;
+		std::vector<int> linked(ProgramCount, -1);
+
+		// Each fragment shader's callback chains the link of its program, while the other compiles are still queued.
+		for (int i = 0; i < ProgramCount; ++i) {
+			shaders.push_back(std::make_unique<rt::Shader>(rt::ShaderStage::Vertex, vertexVariant(i)));
+			rt::Shader& vertex = *shaders.back();
+			shaders.push_back(std::make_unique<rt::Shader>(rt::ShaderStage::Fragment, fragmentVariant(i)));
+			rt::Shader& fragment = *shaders.back();
+			programs.push_back(std::make_unique<rt::Program>());
+			rt::Program& program = *programs.back();
+
+			queue.submit(vertex);
+			queue.submit(fragment, [&queue, &vertex, &fragment, &program, &linked, i](bool compiled) {
+				if (!compiled) {
+					return;
+				}
+				program.attachShader(vertex);
+				program.attachShader(fragment);
+				queue.submit(program, [&linked, i](bool result) {
+					linked[i] = result ? 1 : 0;
+				});
+			});
+		}
+
+		rt::Shader broken{ rt::ShaderStage::Fragment, "#version 450\nvoid main() { undefined = 1; }\n" };
+		bool reported = false;
+		queue.submit(broken, [&reported](bool compiled) {
+			reported = !compiled;
+		});
+
+		int polls = 0;
+		while (!queue.empty() && polls < 100000) {
+			queue.poll(4);
+			++polls;
+		}
+
+		bool chained = queue.empty();
+		for (int i = 0; i < ProgramCount; ++i) {
+			chained = chained && linked[i] == 1 && programs[i]->isLinked();
+		}
+		bool counted = reported && queue.numSucceeded() == 3 * ProgramCount && queue.numFailed() == 1;
+		fmt::print("Chained links: {}, counts: {}, {} polls\n", chained ? "passed" : "failed", counted ? "passed" : "failed", polls);
+
+		// Submitting from callbacks while waiting has to drain the queue as well.
+		rt::Shader vertex{ rt::ShaderStage::Vertex, vertexVariant(0) };
+		rt::Shader fragment{ rt::ShaderStage::Fragment, fragmentVariant(0) };
+		rt::Program program;
+		bool waited = false;
+		queue.submit(vertex);
+		queue.submit(fragment, [&](bool) {
+			program.attachShader(vertex);
+			program.attachShader(fragment);
+			queue.submit(program, [&waited](bool result) {
+				waited = result;
+			});
+		});
+		queue.wait();
+		waited = waited && queue.empty() && program.isLinked();
+		fmt::print("Wait: {}\n", waited ? "passed" : "failed");
+
+		passed = chained && counted && waited;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
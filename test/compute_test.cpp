@@ -0,0 +1,82 @@
+#include <Utilities.hpp>
+
+#include <vector>
+
+#include <rt/ComputeProgram.hpp>
+#include <rt/Barrier.hpp>
+#include <rt/Buffer.hpp>
+
+// Not a multiple of the group size, so the last group has invocations past the end.
+static constexpr GLuint ValueCount = 1000;
+
+static constexpr std::string_view fillSource =
+	"#version 450\n"
+	"layout(local_size_x = 64) in;\n"
+	"layout(std430, binding = 0) buffer Values { uint values[]; };\n"
+	"layout(std430, binding = 1) buffer Command { uvec3 groups; };\n"
+	"uniform uint count;\n"
+	"uniform uint scale;\n"
+	"void main() {\n"
+	"	uint i = gl_GlobalInvocationID.x;\n"
+	"	if (i >= count) { return; }\n"
+	"	values[i] = i * scale;\n"
+	"	if (i == 0) { groups = uvec3((count + 63) / 64, 1, 1); }\n"
+	"}\n";
+
+static bool verify(const rt::Buffer& buffer, GLuint scale) {
+	std::vector<GLuint> values(ValueCount);
+	buffer.getData(values.data(), ValueCount, 0);
+	for (GLuint i = 0; i < ValueCount; ++i) {
+		if (values[i] != i * scale) {
+			fmt::print("Value {} is {}, expected {}\n", i, values[i], i * scale);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		glm::ivec3 maxCount = rt::ComputeProgram::getMaxWorkGroupCount();
+		glm::ivec3 maxSize = rt::ComputeProgram::getMaxWorkGroupSize();
+		fmt::print("Max group count: {} {} {}, max group size: {} {} {}, max invocations: {}\n",
+			maxCount.x, maxCount.y, maxCount.z, maxSize.x, maxSize.y, maxSize.z, rt::ComputeProgram::getMaxWorkGroupInvocations());
+
+		rt::ComputeProgram program;
+		if (!program.compile(fillSource)) {
+			fmt::print("Failed to link the compute program:\n{}\n", program.getInfoLog());
+			return 1;
+		}
+		glm::uvec3 groupSize = program.getWorkGroupSize();
+		fmt::print("Work group size: {} {} {}\n", groupSize.x, groupSize.y, groupSize.z);
+		require(groupSize == glm::uvec3(64, 1, 1), "Wrong work group size.");
+
+		rt::ImmutableBuffer values(size_t(ValueCount * sizeof(GLuint)), rt::BufferInit::Dynamic | rt::BufferInit::Read);
+		rt::ImmutableBuffer command(rt::DispatchIndirectCommand{ 0, 0, 0 }, rt::BufferInit::Dynamic);
+		values.bindSSBO(0);
+		command.bindSSBO(1);
+
+		program.uniform(program.getUniformLocation("count"), ValueCount);
+
+		// Work out the group count from the problem size.
+		program.uniform(program.getUniformLocation("scale"), 2u);
+		program.dispatchFor(ValueCount);
+		rt::memoryBarrier(rt::Barrier::BufferUpdate | rt::Barrier::Command);
+		bool direct = verify(values, 2);
+		fmt::print("dispatchFor: {}\n", direct ? "passed" : "failed");
+
+		// Reuse the group count the first dispatch wrote.
+		program.uniform(program.getUniformLocation("scale"), 3u);
+		program.dispatchIndirect(command);
+		rt::memoryBarrier(rt::Barrier::BufferUpdate);
+		bool indirect = verify(values, 3);
+		fmt::print("dispatchIndirect: {}\n", indirect ? "passed" : "failed");
+
+		passed = direct && indirect;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <algorithm>
+
+#include <rt/CullingPass.hpp>
+
+// With an identity view projection the frustum is the [-1, 1] cube, and depth is z * 0.5 + 0.5.
+static const std::vector<rt::CullBounds> instances = {
+	{ glm::vec3{ 0.f, 0.f, 0.f }, 0.2f, 0 },      // Inside.
+	{ glm::vec3{ 3.f, 0.f, 0.f }, 0.5f, 0 },      // Right of the frustum.
+	{ glm::vec3{ 0.f, 5.f, 0.f }, 0.5f, 1 },      // Above.
+	{ glm::vec3{ 0.f, 0.f, -4.f }, 0.5f, 1 },     // In front of the near plane.
+	{ glm::vec3{ 1.3f, 0.f, 0.7f }, 0.5f, 1 },    // Crosses the right plane, behind the depth buffer.
+	{ glm::vec3{ 0.5f, 0.5f, -0.8f }, 0.1f, 2 },  // Inside, in front of the depth buffer.
+	{ glm::vec3{ -0.5f, -0.5f, 0.8f }, 0.1f, 2 }, // Inside, behind the depth buffer.
+};
+
+// The instances each draw should keep, in ascending order.
+using Expected = std::vector<std::vector<GLuint>>;
+
+// Checks the per draw commands, the visible indices in each draw's slots, and the compacted draws and their count.
+static bool verify(rt::CullingPass& culling, const std::vector<rt::DrawElementsIndirectCommand>& draws, const Expected& expected) {
+	std::vector<rt::DrawElementsIndirectCommand> commands(draws.size());
+	culling.getCommands().getData(commands.data(), commands.size(), 0);
+	std::vector<GLuint> visible(culling.numInstanceSlots());
+	culling.getVisible().getData(visible.data(), visible.size(), 0);
+
+	bool result = true;
+	GLuint slot = 0;
+	size_t nonEmpty = 0;
+	for (size_t i = 0; i < draws.size(); ++i) {
+		const rt::DrawElementsIndirectCommand& cmd = commands[i];
+		const std::vector<GLuint>& want = expected[i];
+		result = result && cmd.count == draws[i].count && cmd.firstIndex == draws[i].firstIndex && cmd.baseInstance == slot &&
+			cmd.instanceCount == want.size();
+
+		std::vector<GLuint> found(visible.begin() + slot, visible.begin() + slot + std::min<size_t>(cmd.instanceCount, draws[i].instanceCount));
+		std::sort(found.begin(), found.end());
+		result = result && found == want;
+		if (!want.empty()) {
+			++nonEmpty;
+		}
+		slot += draws[i].instanceCount;
+	}
+
+	GLuint drawCount = 0;
+	culling.getParameters().getData(&drawCount, 1, 0);
+	result = result && drawCount == nonEmpty;
+
+	// Compacted draws come out in no particular order.
+	std::vector<rt::DrawElementsIndirectCommand> compacted(std::min<size_t>(drawCount, draws.size()));
+	if (!compacted.empty()) {
+		culling.getCompacted().getData(compacted.data(), compacted.size(), 0);
+	}
+	std::sort(compacted.begin(), compacted.end(), [](const auto& lh, const auto& rh) {
+		return lh.firstIndex < rh.firstIndex;
+	});
+	size_t next = 0;
+	for (size_t i = 0; i < draws.size() && result; ++i) {
+		if (expected[i].empty()) {
+			continue;
+		}
+		result = next < compacted.size() && compacted[next].firstIndex == commands[i].firstIndex &&
+			compacted[next].instanceCount == commands[i].instanceCount && compacted[next].baseInstance == commands[i].baseInstance;
+		++next;
+	}
+	return result;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		// Building the pass compiles and links both compute shaders.
+		rt::CullingPass culling;
+
+		std::vector<rt::DrawElementsIndirectCommand> draws = {
+			{ 6, 2, 0, 0, 0 },
+			{ 3, 3, 6, 0, 0 },
+			{ 12, 2, 9, 0, 0 },
+		};
+		culling.setDraws(draws);
+		require(culling.numDrawCommands() == 3 && culling.numInstanceSlots() == 7, "Wrong draw bookkeeping.");
+
+		rt::ImmutableBuffer bounds{ instances.data(), instances.size(), rt::BufferInits::None };
+		glm::mat4 viewProj{ 1.f };
+
+		culling.cull(bounds, GLuint(instances.size()), viewProj);
+		bool frustum = verify(culling, draws, Expected{ { 0 }, { 4 }, { 5, 6 } });
+		fmt::print("Frustum: {}\n", frustum ? "passed" : "failed");
+
+		// Every level of the depth buffer holds 0.5, which hides anything with its nearest point past z = 0.
+		glm::ivec2 size{ 64, 64 };
+		GLint levels = 7;
+		rt::ImmutableTexture2d hiZ;
+		hiZ.init(rt::TexFormat::R_F32, levels, size);
+		hiZ.filterNearest();
+		std::vector<float> depth(size_t(size.x * size.y), 0.5f);
+		for (GLint level = 0; level < levels; ++level) {
+			glm::ivec2 levelSize = glm::max(size >> level, glm::ivec2{ 1 });
+			hiZ.subImage(depth.data(), level, glm::ivec2{ 0 }, levelSize, rt::PixelComponent::R, rt::PixelFormat::F32);
+		}
+
+		culling.cull(bounds, GLuint(instances.size()), viewProj, hiZ);
+		bool occlusion = verify(culling, draws, Expected{ { 0 }, {}, { 5 } });
+		fmt::print("Occlusion: {}\n", occlusion ? "passed" : "failed");
+
+		// Culling again starts from empty commands, instead of adding to the last results.
+		culling.cull(bounds, GLuint(instances.size()), viewProj);
+		bool repeated = verify(culling, draws, Expected{ { 0 }, { 4 }, { 5, 6 } });
+
+		// Nothing visible at all leaves no draws.
+		glm::mat4 away{ 1.f };
+		away[3] = glm::vec4{ 100.f, 0.f, 0.f, 1.f };
+		culling.cull(bounds, GLuint(instances.size()), away);
+		repeated = repeated && verify(culling, draws, Expected{ {}, {}, {} });
+		fmt::print("Repeated: {}\n", repeated ? "passed" : "failed");
+
+		passed = frustum && occlusion && repeated;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include <rt/Debug.hpp>
+
+static void insert(GLenum type, GLenum severity, GLuint id, std::string_view text) {
+	glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, type, id, severity, static_cast<GLsizei>(text.size()), text.data());
+}
+
+// Output is asynchronous, so the driver may call back a little later and from another thread.
+template<typename F>
+static bool arrives(F&& condition) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (!condition()) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+struct Received {
+	rt::DebugType type;
+	rt::DebugSeverity severity;
+	GLuint id;
+	std::string text;
+};
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		bool queued = false, performance = false, filtered = false, threaded = false, dropped = false;
+		{
+			rt::DebugOutput output;
+			std::vector<Received> received;
+			output.setHandler([&](const rt::DebugMessage& msg) {
+				received.push_back(Received{ msg.type, msg.severity, msg.id, std::string(msg.getText()) });
+			});
+			// Low severity messages start out disabled.
+			output.setMinimumSeverity(rt::DebugSeverity::Notification);
+			std::vector<rt::PerformanceEvent> events;
+			output.setPerformanceHandler([&](const rt::PerformanceEvent& event) {
+				events.push_back(event);
+			});
+
+			// A forced message is counted as it arrives, and reaches the handler only once drained.
+			insert(GL_DEBUG_TYPE_OTHER, GL_DEBUG_SEVERITY_HIGH, 42, "forced message");
+			queued = arrives([&]() { return output.count(rt::DebugSource::Application) == 1; }) &&
+				output.count(rt::DebugType::Other) == 1 && output.count(rt::DebugSeverity::High) == 1 && received.empty();
+			queued = queued && output.drain() == 1 && received.size() == 1 && received[0].id == 42 &&
+				received[0].type == rt::DebugType::Other && received[0].severity == rt::DebugSeverity::High && received[0].text == "forced message";
+
+			// Text longer than a message holds is cut short instead of allocating.
+			std::string longText(rt::DebugMessage::MaxLength + 100, 'x');
+			insert(GL_DEBUG_TYPE_OTHER, GL_DEBUG_SEVERITY_MEDIUM, 43, longText);
+			queued = queued && arrives([&]() { return output.count(rt::DebugSource::Application) == 2; }) &&
+				output.drain() == 1 && received.back().text.size() == rt::DebugMessage::MaxLength;
+
+			// A real error, raised by opengl itself.
+			glEnable(GLenum(0xFFFF));
+			queued = queued && arrives([&]() { return output.errorCount() == 1; }) && glGetError() == GL_INVALID_ENUM;
+			output.drain();
+			fmt::print("Queued messages: {}\n", queued ? "passed" : "failed");
+
+			// Performance warnings also come out as classified events.
+			insert(GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_SEVERITY_MEDIUM, 1, "Buffer object 7 was moved from video memory to system memory");
+			insert(GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_SEVERITY_MEDIUM, 2, "Program was recompiled based on GL state");
+			insert(GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_SEVERITY_LOW, 3, "Pipeline stall on a busy buffer");
+			performance = arrives([&]() { return output.count(rt::DebugType::Performance) == 3; }) && output.drain() == 3 &&
+				events.size() == 3 && events[0].kind == rt::PerformanceKind::BufferMigration &&
+				events[1].kind == rt::PerformanceKind::ShaderRecompile && events[2].kind == rt::PerformanceKind::Stall && events[2].id == 3;
+			fmt::print("Performance events: {}\n", performance ? "passed" : "failed");
+
+			// Filtered messages are never generated, so they are not counted either.
+			output.resetStats();
+			output.setMinimumSeverity(rt::DebugSeverity::Medium);
+			insert(GL_DEBUG_TYPE_OTHER, GL_DEBUG_SEVERITY_LOW, 50, "filtered");
+			insert(GL_DEBUG_TYPE_OTHER, GL_DEBUG_SEVERITY_MEDIUM, 51, "kept");
+			filtered = arrives([&]() { return output.count(rt::DebugSource::Application) >= 1; }) && output.drain() == 1 &&
+				received.back().id == 51 && output.count(rt::DebugSeverity::Low) == 0;
+			output.setMinimumSeverity(rt::DebugSeverity::Notification);
+			fmt::print("Filtered: {}\n", filtered ? "passed" : "failed");
+
+			// The consumer thread delivers on its own, and drains what is left when stopped.
+			size_t before = received.size();
+			output.startThread();
+			for (GLuint i = 0; i < 10; ++i) {
+				insert(GL_DEBUG_TYPE_MARKER, GL_DEBUG_SEVERITY_NOTIFICATION, 100 + i, "marker");
+			}
+			arrives([&]() { return output.count(rt::DebugType::Marker) == 10; });
+			output.stopThread();
+			threaded = received.size() == before + 10 && received.back().id == 109 && output.drain() == 0;
+			fmt::print("Consumer thread: {}\n", threaded ? "passed" : "failed");
+		}
+		{
+			// A full queue drops messages and counts them, instead of waiting for a drain.
+			rt::DebugOutput output{ 4 };
+			output.setHandler([](const rt::DebugMessage&) {});
+			for (GLuint i = 0; i < 10; ++i) {
+				insert(GL_DEBUG_TYPE_OTHER, GL_DEBUG_SEVERITY_NOTIFICATION, i, "overflow");
+			}
+			dropped = arrives([&]() { return output.count(rt::DebugSource::Application) == 10; }) &&
+				output.droppedCount() == 6 && output.drain() == 4;
+			fmt::print("Dropped: {}\n", dropped ? "passed" : "failed");
+		}
+
+		// Labels are what debuggers and messages will show for the object.
+		rt::ImmutableBuffer buffer{ 64, rt::BufferInits::None };
+		rt::label(buffer, "instances");
+		rt::ImmutableTexture2d texture;
+		texture.init(rt::TexFormat::R_N8, 1, glm::ivec2{ 4 });
+		rt::label(texture, "shadow map");
+		char name[64] = {};
+		GLsizei length = 0;
+		glGetObjectLabel(GL_BUFFER, buffer.getId(), sizeof(name), &length, name);
+		bool labels = std::string_view(name, length) == "instances";
+		glGetObjectLabel(GL_TEXTURE, texture.getId(), sizeof(name), &length, name);
+		labels = labels && std::string_view(name, length) == "shadow map";
+		fmt::print("Labels: {}\n", labels ? "passed" : "failed");
+
+		passed = queued && performance && filtered && threaded && dropped && labels;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
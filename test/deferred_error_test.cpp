@@ -0,0 +1,65 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <string_view>
+
+#if !defined(RENDER_TOOLS_DEFERRED_ERROR_CHECKS)
+#error "deferred_error_test has to be built with RENDER_TOOLS_DEFERRED_ERROR_CHECKS"
+#endif
+
+// A frame of eight checked calls, where the fifth one always fails.
+static constexpr uint32_t FrameCalls = 8;
+static constexpr uint32_t FailingCall = 5;
+
+static void frame() {
+	for (uint32_t i = 1; i <= FrameCalls; ++i) {
+		glEnable(i == FailingCall ? GLenum(0xFFFF) : GL_DEPTH_TEST);
+		rt::checkError("frame", i);
+	}
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::DeferredErrors& errors = rt::DeferredErrors::get();
+		require(rt::checkErrors(), "Setting up the context raised an error.");
+
+		// Each error halves the window of the next check, so the error is blamed on 8, 4, 2 and then 1 call.
+		// After the first frame the checks happen while recording, the one at the end of the frame finds nothing left.
+		std::vector<size_t> windows;
+		frame();
+		bool narrowed = !rt::checkErrors() && errors.getLastError() == GL_INVALID_ENUM;
+		windows.push_back(errors.getSuspects().size());
+		for (int i = 0; i < 3; ++i) {
+			frame();
+			narrowed = narrowed && rt::checkErrors();
+			windows.push_back(errors.getSuspects().size());
+		}
+		narrowed = narrowed && windows == std::vector<size_t>{ 8, 4, 2, 1 };
+		const rt::DeferredErrors::Tag& tag = errors.getSuspects().front();
+		narrowed = narrowed && std::string_view(tag.file) == "frame" && tag.line == FailingCall;
+		fmt::print("Narrowing: {}, windows {} {} {} {}\n", narrowed ? "passed" : "failed", windows[0], windows[1], windows[2], windows[3]);
+
+		// Once the call is found, checks go back to the interval that was set, which is only when asked to.
+		frame();
+		bool reset = errors.getSuspects().size() == 1 && !rt::checkErrors() && errors.getSuspects().size() == FrameCalls;
+
+		// An error made without a checked call is reported without suspects, and is not thrown either.
+		glEnable(GLenum(0xFFFF));
+		bool unchecked = !rt::checkErrors() && errors.getSuspects().empty();
+
+		// The last frame started narrowing again, the scope runs the final check of the frame.
+		{
+			rt::ErrorScope scope;
+			frame();
+		}
+		unchecked = unchecked && errors.getSuspects().size() == FrameCalls / 2 && rt::checkErrors();
+		fmt::print("Reset and scopes: {}\n", reset && unchecked ? "passed" : "failed");
+
+		passed = narrowed && reset && unchecked;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
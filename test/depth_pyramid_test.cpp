@@ -0,0 +1,126 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <rt/DepthPyramid.hpp>
+
+// Not a power of two, so texels of level 0 cover more than one depth texel, and 7 levels take two compute dispatches.
+static const glm::ivec2 depthSize{ 100, 70 };
+
+// The pyramid worked out on the CPU, the way the shaders describe it.
+static std::vector<std::vector<float>> reference(const std::vector<float>& depth, const glm::ivec2& size, GLint levels, rt::DepthReduction mode) {
+	auto reduce = [mode](float a, float b) {
+		return mode == rt::DepthReduction::Max ? std::max(a, b) : std::min(a, b);
+	};
+	std::vector<std::vector<float>> result(static_cast<size_t>(levels));
+	for (GLint level = 0; level < levels; ++level) {
+		glm::ivec2 current = glm::max(size >> level, glm::ivec2{ 1 });
+		glm::ivec2 previous = glm::max(size >> std::max(level - 1, 0), glm::ivec2{ 1 });
+		std::vector<float>& texels = result[size_t(level)];
+		texels.resize(size_t(current.x * current.y));
+
+		for (int y = 0; y < current.y; ++y) {
+			for (int x = 0; x < current.x; ++x) {
+				glm::ivec2 p{ x, y };
+				float v;
+				if (level == 0) {
+					glm::ivec2 lo = p * depthSize / size;
+					glm::ivec2 hi = glm::min(((p + 1) * depthSize + size - 1) / size, depthSize) - 1;
+					v = depth[size_t(lo.y * depthSize.x + lo.x)];
+					for (int dy = lo.y; dy <= hi.y; ++dy) {
+						for (int dx = lo.x; dx <= hi.x; ++dx) {
+							v = reduce(v, depth[size_t(dy * depthSize.x + dx)]);
+						}
+					}
+				}
+				else {
+					const std::vector<float>& below = result[size_t(level - 1)];
+					auto at = [&](glm::ivec2 t) {
+						t = glm::min(t, previous - 1);
+						return below[size_t(t.y * previous.x + t.x)];
+					};
+					glm::ivec2 q = p * 2;
+					v = reduce(reduce(at(q), at(q + glm::ivec2{ 1, 0 })), reduce(at(q + glm::ivec2{ 0, 1 }), at(q + glm::ivec2{ 1, 1 })));
+				}
+				texels[size_t(y * current.x + x)] = v;
+			}
+		}
+	}
+	return result;
+}
+
+static bool verify(rt::DepthPyramid& pyramid, const std::vector<std::vector<float>>& expected) {
+	for (GLint level = 0; level < pyramid.numLevels(); ++level) {
+		glm::ivec2 size = pyramid.getLevelSize(level);
+		std::vector<float> texels(size_t(size.x * size.y));
+		glGetTextureImage(pyramid.getTexture().getId(), level, GL_RED, GL_FLOAT, GLsizei(texels.size() * sizeof(float)), texels.data());
+		for (size_t i = 0; i < texels.size(); ++i) {
+			if (std::abs(texels[i] - expected[size_t(level)][i]) != 0.f) {
+				fmt::print("Level {} texel {} is {}, expected {}\n", level, i, texels[i], expected[size_t(level)][i]);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static glm::ivec2 levelRange(const rt::TextureBase& texture) {
+	glm::ivec2 range{ -1 };
+	glGetTextureParameteriv(texture.getId(), GL_TEXTURE_BASE_LEVEL, &range.x);
+	glGetTextureParameteriv(texture.getId(), GL_TEXTURE_MAX_LEVEL, &range.y);
+	return range;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		// Depth as it would come out of a copy of the depth buffer, in steps of 1/256 so that ties between texels happen.
+		std::mt19937 rng(5);
+		std::uniform_int_distribution<int> steps(0, 256);
+		std::vector<float> depth(size_t(depthSize.x * depthSize.y));
+		for (float& value : depth) {
+			value = float(steps(rng)) / 256.f;
+		}
+		rt::ImmutableTexture2d depthTexture;
+		depthTexture.init(rt::TexFormat::R_F32, 1, depthSize);
+		depthTexture.subImage(depth.data(), 0, glm::ivec2{ 0 }, depthSize, rt::PixelComponent::R, rt::PixelFormat::F32);
+
+		bool levels = true;
+		bool results = true;
+		for (rt::DepthReduction mode : { rt::DepthReduction::Max, rt::DepthReduction::Min }) {
+			rt::DepthPyramid pyramid{ mode };
+			for (rt::DepthPyramid::Path path : { rt::DepthPyramid::Path::Compute, rt::DepthPyramid::Path::Fragment }) {
+				pyramid.build(depthTexture, path);
+				levels = levels && pyramid.getSize() == glm::ivec2{ 64, 64 } && pyramid.numLevels() == 7 &&
+					pyramid.getTexture().getImmutableLevels() == pyramid.numLevels();
+
+				std::vector<std::vector<float>> expected = reference(depth, pyramid.getSize(), pyramid.numLevels(), mode);
+				bool result = verify(pyramid, expected);
+				fmt::print("{} {}: {}\n", mode == rt::DepthReduction::Max ? "Max" : "Min", path == rt::DepthPyramid::Path::Compute ? "compute" : "fragment",
+					result ? "passed" : "failed");
+				results = results && result;
+
+				// The fragment path limits the levels it samples while building, and has to leave all of them usable.
+				glm::ivec2 range = levelRange(pyramid.getTexture());
+				levels = levels && range.x == 0 && range.y >= pyramid.numLevels() - 1;
+			}
+		}
+
+		// Resetting the range goes back to the levels the texture really has, mutable storage keeps the opengl default.
+		rt::ImmutableTexture2d texture;
+		texture.init(rt::TexFormat::R_F32, 4, glm::ivec2{ 8, 8 });
+		texture.setLevelRange(1, 2);
+		levels = levels && levelRange(texture) == glm::ivec2{ 1, 2 };
+		texture.resetLevelRange();
+		levels = levels && levelRange(texture) == glm::ivec2{ 0, 3 };
+		fmt::print("Level ranges: {}\n", levels ? "passed" : "failed");
+
+		passed = levels && results;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include <rt/GpuVector.hpp>
+
+struct Instance {
+	glm::vec4 position;
+	glm::vec4 color;
+
+	bool operator==(const Instance& other) const {
+		return position == other.position && color == other.color;
+	}
+};
+
+template<typename T>
+static bool matchesGpu(rt::GpuVector<T>& vec) {
+	vec.sync();
+	if (vec.getBuffer().sizeBytes() != vec.sizeBytes()) {
+		return false;
+	}
+	std::vector<T> readback(vec.size());
+	if (!readback.empty()) {
+		vec.getBuffer().getData(readback.data(), readback.size(), 0);
+	}
+	return std::equal(readback.begin(), readback.end(), vec.begin(), vec.end());
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		// The usual container operations, with the buffer checked against the CPU copy after each group.
+		rt::GpuVector<uint32_t> values{ 1u, 2u, 3u };
+		bool operations = matchesGpu(values);
+		for (uint32_t i = 0; i < 100; ++i) {
+			values.push_back(i);
+		}
+		values.emplace_back(1000u);
+		operations = operations && matchesGpu(values) && values.size() == 104;
+
+		values.insert(10, { 7u, 8u, 9u });
+		values.erase(50, 20);
+		values[0] = 42u;
+		values.set(1, 43u);
+		values.pop_back();
+		operations = operations && matchesGpu(values) && values.size() == 86 && values[10] == 7u && values.front() == 42u;
+
+		std::vector<uint32_t> replacement(5000, 9u);
+		values.assign(replacement);
+		operations = operations && matchesGpu(values) && values.size() == 5000;
+		values.resize(20);
+		values.clear();
+		operations = operations && matchesGpu(values) && values.empty();
+		fmt::print("Operations: {}\n", operations ? "passed" : "failed");
+
+		// Sparse edits every frame to a large instance buffer, each sync coalesces them instead of one upload per element.
+		rt::GpuVector<Instance> instances;
+		instances.reserve(1 << 16);
+		size_t reallocations = instances.getBuffer().numReallocations();
+		instances.assign(size_t(1 << 16), Instance{ glm::vec4{ 0.f }, glm::vec4{ 1.f } });
+		instances.sync();
+
+		std::mt19937 rng(5);
+		bool coalesced = instances.getBuffer().numReallocations() == reallocations;
+		size_t edits = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < 100; ++frame) {
+			for (int i = 0; i < 200; ++i) {
+				instances[rng() % instances.size()].position = glm::vec4{ float(frame), float(i), 0.f, 1.f };
+				++edits;
+			}
+			// Close together edits, which end up in a single upload.
+			for (size_t i = 0; i < 32; ++i) {
+				instances[1000 + i * 2].color = glm::vec4{ float(frame) };
+			}
+			edits += 32;
+			coalesced = coalesced && instances.sync() <= 8;
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		coalesced = coalesced && matchesGpu(instances) && instances.numUploads() < edits / 10;
+		fmt::print("Coalesced: {}, {} edits in {} uploads, {:.2f} ms\n", coalesced ? "passed" : "failed", edits, instances.numUploads(), ms);
+
+		// Binding syncs first, and binds only the used part of the buffer.
+		instances.push_back(Instance{ glm::vec4{ 5.f }, glm::vec4{ 6.f } });
+		instances.bindSSBO(3);
+		GLint64 boundSize = 0;
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, 3, &boundSize);
+		bool binding = !instances.isDirty() && size_t(boundSize) == instances.sizeBytes();
+
+		rt::VertexArray vao;
+		instances.bindVertex(vao, 0);
+		GLint vertexBuffer = 0;
+		glGetVertexArrayIndexediv(vao.getId(), 0, GL_VERTEX_BINDING_BUFFER, &vertexBuffer);
+		binding = binding && GLuint(vertexBuffer) == instances.getBuffer().getId();
+		fmt::print("Binding: {}\n", binding ? "passed" : "failed");
+
+		passed = operations && coalesced && binding;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
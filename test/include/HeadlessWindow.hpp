@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdlib>
+#include <string>
+#include <stdexcept>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#if !defined(EGL_PLATFORM_SURFACELESS_MESA)
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+/*
+A stand in for the few parts of sf::Window the tests use, backed by an offscreen EGL context instead of a window.
+Prefers Mesa's surfaceless platform, so it runs without a display server, and renders into an 800x600 pbuffer so the default framebuffer still exists.
+Loops end on their own after a number of frames, RT_TEST_FRAMES in the environment, so interactive tests can run in CI.
+*/
+class HeadlessWindow {
+public:
+	struct Size {
+		unsigned int x, y;
+	};
+
+	HeadlessWindow(unsigned int width, unsigned int height)
+		: display_(EGL_NO_DISPLAY)
+		, surface(EGL_NO_SURFACE)
+		, context(EGL_NO_CONTEXT)
+		, size{ width, height }
+		, framesLeft(frameLimit())
+	{
+		display_ = openDisplay();
+		EGLint major, minor;
+		if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, &major, &minor)) {
+			throw std::runtime_error("Failed to initialize an EGL display!");
+		}
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			throw std::runtime_error("EGL display does not support desktop OpenGL!");
+		}
+
+		const EGLint configAttribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_NONE
+		};
+		EGLConfig config = nullptr;
+		EGLint numConfigs = 0;
+		eglChooseConfig(display_, configAttribs, &config, 1, &numConfigs);
+
+		// The core profile the library is written against, which also keeps deprecated calls out of the tests.
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, 5,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		// Without a pbuffer config the context is made current without a surface, and only framebuffer objects can be drawn to.
+		if (numConfigs > 0) {
+			const EGLint surfaceAttribs[] = { EGL_WIDTH, EGLint(width), EGL_HEIGHT, EGLint(height), EGL_NONE };
+			surface = eglCreatePbufferSurface(display_, config, surfaceAttribs);
+		}
+		context = eglCreateContext(display_, numConfigs > 0 ? config : EGLConfig(nullptr), EGL_NO_CONTEXT, contextAttribs);
+		if (context == EGL_NO_CONTEXT) {
+			throw std::runtime_error("Failed to create an OpenGL 4.5 core context through EGL!");
+		}
+	}
+	~HeadlessWindow() {
+		close();
+	}
+
+	HeadlessWindow(const HeadlessWindow&) = delete;
+	HeadlessWindow& operator=(const HeadlessWindow&) = delete;
+
+	bool setActive(bool active = true) {
+		if (active) {
+			return eglMakeCurrent(display_, surface, surface, context) == EGL_TRUE;
+		}
+		return eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE;
+	}
+
+	void display() {
+		if (surface != EGL_NO_SURFACE) {
+			eglSwapBuffers(display_, surface);
+		}
+		if (framesLeft > 0) {
+			--framesLeft;
+		}
+	}
+
+	void close() {
+		if (display_ == EGL_NO_DISPLAY) {
+			return;
+		}
+		eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (context != EGL_NO_CONTEXT) {
+			eglDestroyContext(display_, context);
+		}
+		if (surface != EGL_NO_SURFACE) {
+			eglDestroySurface(display_, surface);
+		}
+		eglTerminate(display_);
+		display_ = EGL_NO_DISPLAY;
+		surface = EGL_NO_SURFACE;
+		context = EGL_NO_CONTEXT;
+	}
+
+	// Getters ---
+
+	bool isOpen() const {
+		return display_ != EGL_NO_DISPLAY && framesLeft > 0;
+	}
+	Size getSize() const {
+		return size;
+	}
+	bool hasSurface() const {
+		return surface != EGL_NO_SURFACE;
+	}
+private:
+	static EGLDisplay openDisplay() {
+		std::string extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS) ? eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS) : "";
+		if (extensions.find("EGL_MESA_platform_surfaceless") != std::string::npos) {
+			auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+			if (getPlatformDisplay) {
+				EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+				if (display != EGL_NO_DISPLAY) {
+					return display;
+				}
+			}
+		}
+		return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	static unsigned int frameLimit() {
+		const char* frames = std::getenv("RT_TEST_FRAMES");
+		return frames ? unsigned(std::strtoul(frames, nullptr, 10)) : 30;
+	}
+
+	EGLDisplay display_;
+	EGLSurface surface;
+	EGLContext context;
+	Size size;
+	unsigned int framesLeft;
+};
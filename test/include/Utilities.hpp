@@ -7,6 +7,7 @@
 #include <string_view>
 
 #include <filesystem>
+#include <stdexcept>
 
 #include <fmt/format.h>
 
@@ -14,7 +15,16 @@
 #include <rt/Texture.hpp>
 #include <rt/VertexArray.hpp>
 
+#if defined(RT_TEST_HEADLESS)
+#include "HeadlessWindow.hpp"
+
+// The tests are written against sf::Window, headless builds swap in the EGL context without touching them.
+namespace sf {
+	using Window = HeadlessWindow;
+}
+#else
 #include <SFML/Window.hpp>
+#endif
 
 #include "config.hpp"
 
@@ -34,6 +44,42 @@ std::string loadSource(std::string_view filename) {
 	return text;
 }
 
+// Unlike assert this also fails release builds, tests report results through it and their exit code.
+void require(bool condition, std::string_view message) {
+	if (!condition) {
+		throw std::runtime_error(std::string(message));
+	}
+}
+
+#if defined(RT_TEST_HEADLESS)
+sf::Window * initializeWindow() {
+	sf::Window * window = new sf::Window(800, 600);
+
+	if (!window->setActive(true)) {
+		throw std::runtime_error("Failed to make the headless context current!");
+	}
+	fmt::print("Headless context made active{}.\n", window->hasSurface() ? "" : ", without a default framebuffer");
+
+	if (!rt::load()) {
+		throw std::runtime_error("Failed to initialize rt!");
+	}
+
+	fmt::print("Version: {}\n", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	fmt::print("Renderer: {}\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+	return window;
+}
+
+void cleanup(sf::Window* window) {
+	window->close();
+	delete window;
+}
+
+// There is nobody to close a headless window, so the loop runs for a fixed number of frames as fast as it can.
+bool loopWindow(sf::Window* window) {
+	return window->isOpen();
+}
+#else
 sf::Window * initializeWindow() {
 	sf::ContextSettings settings;
 	settings.depthBits = 24;
@@ -55,7 +101,7 @@ sf::Window * initializeWindow() {
 	fmt::print("Window made active.\n");
 
 	if (!rt::load()) {
-		throw std::exception("Failed to initialize rt!");
+		throw std::runtime_error("Failed to initialize rt!");
 	}
 
 	return window;
@@ -84,6 +130,7 @@ bool loopWindow(sf::Window* window) {
 	std::this_thread::sleep_for(std::chrono::milliseconds(30));
 	return true;
 }
+#endif
 
 class ColoredQuadProgram {
 public:
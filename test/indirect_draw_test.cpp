@@ -0,0 +1,138 @@
+#include <Utilities.hpp>
+
+#include <vector>
+
+#include <rt/IndirectDrawList.hpp>
+#include <rt/Barrier.hpp>
+
+static constexpr GLuint VertexCount = 64;
+
+// Every vertex the draws reach counts itself, once per instance.
+static constexpr std::string_view vertexSource =
+	"#version 450\n"
+	"layout(std430, binding = 0) buffer Hits { uint hits[]; };\n"
+	"void main() {\n"
+	"	atomicAdd(hits[gl_VertexID], 1u);\n"
+	"	gl_Position = vec4(0.0, 0.0, 0.0, 1.0);\n"
+	"	gl_PointSize = 1.0;\n"
+	"}\n";
+
+static constexpr std::string_view fragmentSource =
+	"#version 450\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = vec4(1.0);\n"
+	"}\n";
+
+// Expected hits of the vertices first to first + count, for each of the commands drawn.
+struct Range {
+	GLuint first, count, instances;
+};
+
+static bool verifyHits(rt::Buffer& hits, const std::vector<Range>& drawn) {
+	rt::memoryBarrier(rt::Barrier::BufferUpdate);
+	std::vector<GLuint> expected(VertexCount, 0);
+	for (const Range& range : drawn) {
+		for (GLuint i = range.first; i < range.first + range.count; ++i) {
+			expected[i] += range.instances;
+		}
+	}
+	std::vector<GLuint> found(VertexCount);
+	hits.getData(found.data(), found.size(), 0);
+	hits.clearTo(GLuint(0));
+	return found == expected;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::Program program;
+		require(program.compile(vertexSource, fragmentSource), "Failed to link the counting program.");
+		program.bind();
+
+		rt::ImmutableBuffer hits{ VertexCount * sizeof(GLuint), rt::BufferInits::None };
+		hits.clearTo(GLuint(0));
+		hits.bindSSBO(0);
+
+		std::vector<GLuint> indices(16);
+		for (GLuint i = 0; i < indices.size(); ++i) {
+			indices[i] = i;
+		}
+		rt::ImmutableBuffer indexBuffer{ indices.data(), indices.size(), rt::BufferInits::None };
+		rt::VertexArray vao;
+		vao.bindIndex(indexBuffer);
+		vao.bind();
+
+		// Nothing is rasterized, only the vertex shader matters.
+		glEnable(GL_RASTERIZER_DISCARD);
+
+		// Two lists per region, so consecutive lists in a frame land at different offsets.
+		rt::IndirectDrawList elements{ 4, 3, 2 };
+		elements.begin();
+		bool bookkeeping = elements.empty() && elements.size() == 0 && elements.maxSize() == 4;
+		elements.add(4, 2, 0, 0);
+		elements.add(3, 1, 4, 10);
+		elements.add(rt::DrawElementsIndirectCommand{ 2, 3, 8, 0, 0 });
+		bookkeeping = bookkeeping && !elements.empty() && elements.size() == 3 && elements.data()[1].baseVertex == 10 &&
+			elements.data()[2].instanceCount == 3 && elements.getOffset() % 16 == 0;
+
+		// Indices 4 to 6 are moved by the base vertex of the second command.
+		const std::vector<Range> allElements = { { 0, 4, 2 }, { 14, 3, 1 }, { 8, 2, 3 } };
+		elements.submit(vao, rt::Primitive::Points, rt::Index::U32);
+		bool multiDraw = verifyHits(hits, allElements);
+
+		rt::IndirectArraysDrawList arrays{ 2 };
+		arrays.begin();
+		arrays.add(3, 1, 20);
+		arrays.add(2, 2, 30, 5);
+		arrays.submit(vao, rt::Primitive::Points);
+		multiDraw = multiDraw && verifyHits(hits, { { 20, 3, 1 }, { 30, 2, 2 } });
+
+		// Beginning again drops the commands, and an empty list draws nothing.
+		intptr_t firstOffset = elements.getOffset();
+		elements.begin();
+		bookkeeping = bookkeeping && elements.empty() && elements.getOffset() != firstOffset;
+		elements.submit(vao, rt::Primitive::Points, rt::Index::U32);
+		bookkeeping = bookkeeping && verifyHits(hits, {});
+		fmt::print("Multi draw: {}, bookkeeping: {}\n", multiDraw ? "passed" : "failed", bookkeeping ? "passed" : "failed");
+
+		// The draw count comes from the parameters buffer, and is clamped to the size of the list.
+		bool countDraws = true;
+		if (rt::VertexArray::indirectCountSupported()) {
+			std::vector<GLuint> counts = { 2, 5, 1, 0 };
+			rt::ImmutableBuffer parameters{ counts.data(), counts.size(), rt::BufferInits::None };
+
+			elements.begin();
+			elements.add(4, 2, 0, 0);
+			elements.add(3, 1, 4, 10);
+			elements.add(2, 3, 8, 0);
+			elements.submitCount(vao, rt::Primitive::Points, rt::Index::U32, parameters);
+			countDraws = verifyHits(hits, { allElements[0], allElements[1] });
+			elements.submitCount(vao, rt::Primitive::Points, rt::Index::U32, parameters, sizeof(GLuint));
+			countDraws = countDraws && verifyHits(hits, allElements);
+			elements.submitCount(vao, rt::Primitive::Points, rt::Index::U32, parameters, 3 * sizeof(GLuint));
+			countDraws = countDraws && verifyHits(hits, {});
+
+			arrays.begin();
+			arrays.add(3, 1, 20);
+			arrays.add(2, 2, 30, 5);
+			arrays.submitCount(vao, rt::Primitive::Points, parameters, 2 * sizeof(GLuint));
+			countDraws = countDraws && verifyHits(hits, { { 20, 3, 1 } });
+			arrays.submitCount(vao, rt::Primitive::Points, parameters);
+			countDraws = countDraws && verifyHits(hits, { { 20, 3, 1 }, { 30, 2, 2 } });
+			fmt::print("Draw count: {}\n", countDraws ? "passed" : "failed");
+		}
+		else {
+			fmt::print("GL_ARB_indirect_parameters is not supported, skipping the draw count paths.\n");
+		}
+
+		glDisable(GL_RASTERIZER_DISCARD);
+		vao.unbind();
+
+		passed = multiDraw && bookkeeping && countDraws;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -15,7 +15,6 @@
 int main() {
 	sf::Window* window = initializeWindow();
 	{
-		glEnable(GL_TEXTURE_2D);
 		glDisable(GL_DEPTH_TEST);
 		glClearColor(0.3f, 0.6f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -0,0 +1,155 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include <rt/Buffer.hpp>
+
+static bool verifyRanges(const rt::DirtyRanges& ranges, const std::vector<rt::DirtyRanges::Range>& expected) {
+	if (ranges.count() != expected.size()) {
+		return false;
+	}
+	size_t i = 0;
+	bool equal = true;
+	ranges.forEach([&](const rt::DirtyRanges::Range& range) {
+		equal = equal && range.begin == expected[i].begin && range.end == expected[i].end;
+		++i;
+	});
+	return equal;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		// Overlapping and touching ranges merge, ranges with a gap between them do not.
+		rt::DirtyRanges ranges;
+		ranges.add(10, 20);
+		ranges.add(30, 40);
+		ranges.add(20, 25);
+		ranges.add(50, 60);
+		ranges.add(35, 52);
+		ranges.add(70, 70);
+		ranges.add(0, 5);
+		bool merging = verifyRanges(ranges, { { 0, 5 }, { 10, 25 }, { 30, 60 } }) &&
+			ranges.length() == 50 && ranges.extent().begin == 0 && ranges.extent().end == 60 &&
+			ranges.contains(30) && !ranges.contains(25) && !ranges.contains(60);
+		ranges.add(4, 31);
+		merging = merging && verifyRanges(ranges, { { 0, 60 } });
+
+		// Runs extending the last range, up to and into the range after it.
+		ranges.clear();
+		ranges.add(20, 30);
+		ranges.add(0, 4);
+		for (size_t i = 4; i < 12; ++i) {
+			ranges.add(i, i + 1);
+		}
+		merging = merging && verifyRanges(ranges, { { 0, 12 }, { 20, 30 } });
+		ranges.add(12, 20);
+		ranges.add(5, 8);
+		ranges.add(30, 31);
+		merging = merging && verifyRanges(ranges, { { 0, 31 } });
+		rt::DirtyRanges copy = ranges;
+		copy.add(31, 40);
+		merging = merging && verifyRanges(copy, { { 0, 40 } }) && verifyRanges(ranges, { { 0, 31 } });
+		fmt::print("Merging: {}\n", merging ? "passed" : "failed");
+
+		// Scattered writes through a persistent, explicitly flushed mapping.
+		constexpr size_t Count = 1 << 20;
+		rt::ImmutableBuffer buffer{ Count * sizeof(uint32_t), rt::BufferInit::Write | rt::BufferInit::Persistent };
+		uint32_t* base = buffer.map<uint32_t>(rt::BufferFlag::Write | rt::BufferFlag::Persistent | rt::BufferFlag::FlushExplicit);
+		require(base != nullptr, "Failed to map the buffer.");
+
+		rt::MappedRange<uint32_t> whole{ buffer, base, 0, Count, true };
+		std::vector<uint32_t> fill(Count, 0);
+		whole.write(0, fill.data(), Count);
+		bool flushed = whole.commit() == 1 && whole.numFlushedBytes() == Count * sizeof(uint32_t);
+
+		std::mt19937 rng(3);
+		std::vector<uint32_t> expected = fill;
+		for (int i = 0; i < 64; ++i) {
+			size_t index = rng() % (Count - 16);
+			for (size_t j = 0; j < 16; ++j) {
+				whole[index + j] = uint32_t(index + j);
+				expected[index + j] = uint32_t(index + j);
+			}
+		}
+		size_t dirtyCount = whole.getDirty().count();
+		size_t issued = whole.commit();
+		flushed = flushed && issued == dirtyCount && issued <= 64 && whole.getDirty().empty();
+
+		// A view into the middle of the same mapping, flush offsets have to account for where it starts.
+		rt::MappedRange<uint32_t> middle{ buffer, base, Count / 2, 1024, true };
+		for (size_t j = 0; j < 1024; j += 2) {
+			middle.write(j, 0xABCD0000u + uint32_t(j));
+			expected[Count / 2 + j] = 0xABCD0000u + uint32_t(j);
+		}
+		flushed = flushed && middle.commit() == 512;
+
+		glFinish();
+
+		std::vector<uint32_t> readback(Count);
+		buffer.getData(readback.data(), Count, 0);
+		bool contents = readback == expected;
+		fmt::print("Flushed ranges: {}, contents: {}\n", flushed ? "passed" : "failed", contents ? "passed" : "failed");
+
+		// Owning map of a sub range, unmapped and flushed on destruction.
+		rt::ImmutableBuffer small{ 256 * sizeof(float), rt::BufferInit::Write | rt::BufferInit::Dynamic };
+		std::vector<float> zeros(256, 0.f);
+		small.subArray(zeros.data(), zeros.size());
+		{
+			rt::MappedRange<float> range{ small, 64, 64, rt::BufferFlag::Write | rt::BufferFlag::FlushExplicit };
+			range[0] = 1.f;
+			range[63] = 2.f;
+		}
+		std::vector<float> smallback(256);
+		small.getData(smallback.data(), 256, 0);
+		bool owning = !small.isMapped() && smallback[64] == 1.f && smallback[127] == 2.f && smallback[65] == 0.f && smallback[128] == 0.f;
+		fmt::print("Owning range: {}\n", owning ? "passed" : "failed");
+
+		// Sparse updates to a large instance buffer, flushing only what changed against flushing everything.
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < 100; ++frame) {
+			for (int i = 0; i < 32; ++i) {
+				base[rng() % Count] = uint32_t(frame);
+			}
+			buffer.flush();
+			glFinish();
+		}
+		double wholeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < 100; ++frame) {
+			for (int i = 0; i < 32; ++i) {
+				whole[rng() % Count] = uint32_t(frame);
+			}
+			whole.commit();
+			glFinish();
+		}
+		double rangesMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		fmt::print("100 sparse updates, whole flush: {:.2f} ms, dirty ranges: {:.2f} ms\n", wholeMs, rangesMs);
+
+		// Element by element writes in runs, which extend the last range instead of searching for it.
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < 100; ++frame) {
+			for (int run = 0; run < 8; ++run) {
+				size_t first = rng() % (Count - 4096);
+				for (size_t i = 0; i < 4096; ++i) {
+					whole[first + i] = uint32_t(frame);
+				}
+			}
+			whole.commit();
+			glFinish();
+		}
+		double runsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		fmt::print("100 updates of 8 runs of 4096 elements, dirty ranges: {:.2f} ms\n", runsMs);
+
+		buffer.unmap();
+
+		passed = merging && flushed && contents && owning;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
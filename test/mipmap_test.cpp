@@ -0,0 +1,93 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include <rt/Texture.hpp>
+
+// Odd on purpose, so rows are not 4 byte aligned and every level rounds down.
+static const glm::ivec2 SmallSize{ 37, 23 };
+static const glm::ivec2 BenchSize{ 2048, 2048 };
+
+static GLint fullChain(const glm::ivec2& size) {
+	return rt::MipBuilder::fullChainLevels(glm::ivec3{ size, 1 });
+}
+
+static std::vector<uint8_t> randomPixels(size_t count) {
+	std::mt19937 rng(1234);
+	std::vector<uint8_t> pixels(count);
+	for (uint8_t& value : pixels) {
+		value = static_cast<uint8_t>(rng());
+	}
+	return pixels;
+}
+
+// The uploaded levels have to match what the builder generates on the CPU.
+static bool verifyUpload(rt::MipBuilder& builder) {
+	std::vector<uint8_t> pixels = randomPixels(size_t(SmallSize.x) * SmallSize.y * 3);
+
+	rt::ImmutableTexture2d texture;
+	texture.init(rt::TexFormat::RGB_N8, fullChain(SmallSize), SmallSize);
+	builder.build(texture, pixels.data(), { rt::MipFilter::Kaiser, true });
+
+	std::vector<rt::MipLevel> levels = builder.generate(pixels.data(), glm::ivec3{ SmallSize, 1 }, rt::TexFormat::RGB_N8, fullChain(SmallSize), false, { rt::MipFilter::Kaiser, true });
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	for (size_t i = 0; i < levels.size(); ++i) {
+		std::vector<uint8_t> readback(levels[i].data.size());
+		glGetTextureImage(texture.getId(), GLint(i + 1), GL_RGB, GL_UNSIGNED_BYTE, GLsizei(readback.size()), readback.data());
+		if (readback != levels[i].data) {
+			fmt::print("Level {} does not match\n", i + 1);
+			return false;
+		}
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	return true;
+}
+
+// Black and white average to 188 when filtered in linear space, and to 128 when not.
+static bool verifySrgb(rt::MipBuilder& builder) {
+	uint8_t pixels[8] = { 0, 0, 0, 255, 255, 255, 255, 255 };
+	std::vector<rt::MipLevel> linear = builder.generate(pixels, glm::ivec3{ 2, 1, 1 }, rt::TexFormat::RGBA_N8, 2, false);
+	std::vector<rt::MipLevel> srgb = builder.generate(pixels, glm::ivec3{ 2, 1, 1 }, rt::TexFormat::RGBA_N8, 2, false, { rt::MipFilter::Box, true });
+	return linear[0].data[0] == 128 && srgb[0].data[0] == 188 && srgb[0].data[3] == 255;
+}
+
+template<typename Func>
+static double timeMs(Func&& func) {
+	glFinish();
+	auto start = std::chrono::steady_clock::now();
+	func();
+	glFinish();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::MipBuilder builder;
+		fmt::print("Mip builder threads: {}\n", builder.numThreads());
+
+		bool upload = verifyUpload(builder);
+		fmt::print("Upload: {}\n", upload ? "passed" : "failed");
+		bool srgb = verifySrgb(builder);
+		fmt::print("sRGB: {}\n", srgb ? "passed" : "failed");
+
+		std::vector<uint8_t> pixels = randomPixels(size_t(BenchSize.x) * BenchSize.y * 4);
+		rt::ImmutableTexture2d texture;
+		texture.init(rt::TexFormat::RGBA_N8, fullChain(BenchSize), BenchSize);
+		texture.subImage(pixels.data(), 0, glm::ivec2{ 0 }, BenchSize, rt::PixelComponent::RGBA, rt::PixelFormat::U8);
+
+		fmt::print("glGenerateTextureMipmap: {:.2f} ms\n", timeMs([&]() { texture.generateMipmaps(); }));
+		fmt::print("MipBuilder box: {:.2f} ms\n", timeMs([&]() { builder.build(texture, pixels.data()); }));
+		fmt::print("MipBuilder box sRGB: {:.2f} ms\n", timeMs([&]() { builder.build(texture, pixels.data(), { rt::MipFilter::Box, true }); }));
+		fmt::print("MipBuilder kaiser sRGB: {:.2f} ms\n", timeMs([&]() { builder.build(texture, pixels.data(), { rt::MipFilter::Kaiser, true }); }));
+
+		passed = upload && srgb;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
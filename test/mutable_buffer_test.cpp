@@ -0,0 +1,73 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <numeric>
+#include <chrono>
+
+#include <rt/Buffer.hpp>
+
+static bool verifyPrefix(const rt::MutableBuffer& buffer, const std::vector<uint32_t>& expected, size_t count) {
+	std::vector<uint32_t> readback(count);
+	buffer.getData(readback.data(), count, 0);
+	return std::equal(readback.begin(), readback.end(), expected.begin());
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		std::vector<uint32_t> values(1 << 16);
+		std::iota(values.begin(), values.end(), 0u);
+
+		// Growing keeps the contents and the id, shrinking the size keeps the capacity.
+		rt::MutableBuffer buffer{ rt::MutableType::DynamicDraw };
+		GLuint id = buffer.getId();
+		buffer.resizeArray(values.data(), 1000);
+		size_t capacity = buffer.capacityBytes();
+		buffer.resizeArray(3000 * sizeof(uint32_t));
+		bool growth = buffer.getId() == id && buffer.sizeBytes() == 3000 * sizeof(uint32_t) && buffer.capacityBytes() >= 2 * capacity && verifyPrefix(buffer, values, 1000);
+
+		size_t grown = buffer.capacityBytes();
+		size_t reallocations = buffer.numReallocations();
+		buffer.resizeArray(values.data(), 10);
+		buffer.resizeArray(values.data(), 2500);
+		growth = growth && buffer.capacityBytes() == grown && buffer.numReallocations() == reallocations && verifyPrefix(buffer, values, 2500);
+		fmt::print("Growth: {}, capacity: {} -> {} bytes\n", growth ? "passed" : "failed", capacity, grown);
+
+		buffer.reserve(grown * 4);
+		bool reserved = buffer.capacityBytes() == grown * 4 && buffer.sizeBytes() == 2500 * sizeof(uint32_t) && verifyPrefix(buffer, values, 2500);
+		buffer.shrinkToFit();
+		bool shrunk = reserved && buffer.capacityBytes() == buffer.sizeBytes() && buffer.getId() == id && verifyPrefix(buffer, values, 2500);
+		fmt::print("Reserve and shrink to fit: {}\n", shrunk ? "passed" : "failed");
+
+		buffer.changeMutableType(rt::MutableType::StreamDraw);
+		GLint usage = 0;
+		glGetNamedBufferParameteriv(buffer.getId(), GL_BUFFER_USAGE, &usage);
+		bool changed = usage == GL_STREAM_DRAW && buffer.getId() == id && verifyPrefix(buffer, values, 2500);
+		fmt::print("Change type: {}\n", changed ? "passed" : "failed");
+
+		// A buffer that grows a little at a time, like a particle or ui vertex buffer.
+		double ms[2];
+		size_t counts[2];
+		const float factors[2] = { 1.f, 2.f };
+		for (int i = 0; i < 2; ++i) {
+			rt::MutableBuffer particles{ rt::MutableType::DynamicDraw, factors[i] };
+			auto start = std::chrono::steady_clock::now();
+			for (size_t count = 64; count <= values.size(); count += 64) {
+				particles.resizeArray(count * sizeof(uint32_t));
+				particles.subArray(values.data() + count - 64, 64, intptr_t((count - 64) * sizeof(uint32_t)));
+			}
+			glFinish();
+			ms[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			counts[i] = particles.numReallocations();
+			growth = growth && verifyPrefix(particles, values, values.size());
+		}
+		fmt::print("1024 growing resizes, factor 1: {} reallocations in {:.2f} ms, factor 2: {} reallocations in {:.2f} ms\n", counts[0], ms[0], counts[1], ms[1]);
+		bool amortized = counts[0] == 1024 && counts[1] <= 11;
+
+		passed = growth && shrunk && changed && amortized;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
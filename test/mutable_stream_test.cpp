@@ -0,0 +1,92 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include <rt/Buffer.hpp>
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::MutableBuffer stream{ rt::MutableType::StreamDraw };
+		std::mt19937 rng(11);
+		std::uniform_int_distribution<size_t> lengths(1, 4000);
+
+		// Every write is copied out on the GPU right away, later writes must not change what those copies see.
+		constexpr size_t Writes = 400;
+		std::vector<size_t> sizes(Writes);
+		size_t total = 0;
+		for (size_t& size : sizes) {
+			size = lengths(rng);
+			total += size;
+		}
+		rt::ImmutableBuffer results{ total * sizeof(uint32_t) };
+
+		std::vector<uint32_t> expected;
+		std::vector<uint32_t> data;
+		size_t written = 0;
+		bool aligned = true;
+		for (size_t i = 0; i < Writes; ++i) {
+			data.resize(sizes[i]);
+			for (size_t j = 0; j < data.size(); ++j) {
+				data[j] = uint32_t(i * 10000 + j);
+			}
+			expected.insert(expected.end(), data.begin(), data.end());
+
+			intptr_t offset = stream.streamArray(data, 256);
+			aligned = aligned && offset % 256 == 0;
+			stream.copyTo(results, data.size() * sizeof(uint32_t), offset, intptr_t(written * sizeof(uint32_t)));
+			written += data.size();
+		}
+
+		std::vector<uint32_t> readback(total);
+		results.getData(readback.data(), total, 0);
+		bool contents = aligned && readback == expected;
+		// Wrapping after a handful of writes grows the storage, so only a few writes out of all of them orphan it.
+		bool orphans = stream.numOrphans() > 0 && stream.numOrphans() < Writes / 32;
+		fmt::print("Contents: {}, orphans: {}, {} of {} writes, {} reallocations, capacity: {} bytes\n", contents ? "passed" : "failed",
+			orphans ? "passed" : "failed", stream.numOrphans(), Writes, stream.numReallocations(), stream.capacityBytes());
+
+		// A large write grows the storage, smaller writes after it reuse it.
+		size_t capacity = stream.capacityBytes();
+		std::vector<uint32_t> large(capacity / sizeof(uint32_t) * 3, 7u);
+		stream.streamArray(large);
+		size_t grown = stream.capacityBytes();
+		size_t reallocations = stream.numReallocations();
+		size_t orphaned = stream.numOrphans();
+		bool sized = stream.sizeBytes() == large.size() * sizeof(uint32_t);
+		stream.orphan();
+		for (int i = 0; i < 100; ++i) {
+			stream.streamArray(data);
+		}
+		sized = sized && stream.sizeBytes() < grown && stream.sizeBytes() == stream.getStreamOffset();
+		bool growth = grown >= capacity * 2 && grown >= large.size() * sizeof(uint32_t) && stream.capacityBytes() == grown &&
+			stream.numReallocations() == reallocations && stream.numOrphans() == orphaned + 1;
+		fmt::print("Growth: {}, sizes: {}, capacity: {} -> {} bytes\n", growth ? "passed" : "failed", sized ? "passed" : "failed", capacity, grown);
+
+		// Streaming against re-specifying the storage on every write.
+		std::vector<uint32_t> frame(16 * 1024, 3u);
+		auto start = std::chrono::steady_clock::now();
+		rt::MutableBuffer respecified{ rt::MutableType::StreamDraw };
+		for (int i = 0; i < 1000; ++i) {
+			respecified.resizeArray(frame.data(), frame.size());
+		}
+		glFinish();
+		double resizeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < 1000; ++i) {
+			stream.streamArray(frame);
+		}
+		glFinish();
+		double streamMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		fmt::print("1000 writes of 64KiB, resizeArray: {:.2f} ms, streamArray: {:.2f} ms\n", resizeMs, streamMs);
+
+		passed = contents && orphans && growth && sized;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <chrono>
+
+#include <rt/Program.hpp>
+#include <rt/ProgramCache.hpp>
+
+// Many small variants of the same program, like a renderer with a few hundred permutations would have.
+static constexpr int ProgramCount = 300;
+
+static std::string vertexVariant(int variant) {
+	return fmt::format(
+		"#version 450\n"
+		"#define VARIANT {}\n"
+		"layout(location = 0) in vec2 pos;\n"
+		"uniform mat4 model;\n"
+		"void main() {{\n"
+		"	gl_Position = model * vec4(pos * float(VARIANT + 1), 0.0, 1.0);\n"
+		"}}\n", variant);
+}
+
+static std::string fragmentVariant(int variant) {
+	return fmt::format(
+		"#version 450\n"
+		"#define VARIANT {}\n"
+		"out vec4 color;\n"
+		"uniform vec3 tint;\n"
+		"void main() {{\n"
+		"	color = vec4(tint * float(VARIANT % 7) / 7.0, 1.0);\n"
+		"}}\n", variant);
+}
+
+// Links every variant through the cache, and returns the time it took in milliseconds.
+static double linkAll(rt::ProgramCache& cache) {
+	std::vector<std::string> vertSources, fragSources;
+	for (int i = 0; i < ProgramCount; ++i) {
+		vertSources.push_back(vertexVariant(i));
+		fragSources.push_back(fragmentVariant(i));
+	}
+
+	std::vector<rt::Program> programs(ProgramCount);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < ProgramCount; ++i) {
+		require(cache.load(programs[i], vertSources[i], fragSources[i]), "Failed to link a program variant.");
+	}
+	// Make sure the driver actually finished linking before stopping the clock.
+	glFinish();
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		if (!rt::ProgramCache::isSupported()) {
+			fmt::print("Program binaries are not supported by this driver.\n");
+		}
+
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "rt_program_cache_test.bin";
+		std::filesystem::remove(path);
+
+		double cold = 0.0, warm = 0.0;
+		{
+			rt::ProgramCache cache(path);
+			cold = linkAll(cache);
+			fmt::print("Cold: {:.1f} ms, hits {}, misses {}, rejects {}\n", cold, cache.hits(), cache.misses(), cache.rejects());
+			cache.save();
+		}
+		{
+			rt::ProgramCache cache(path);
+			warm = linkAll(cache);
+			fmt::print("Warm: {:.1f} ms, hits {}, misses {}, rejects {}\n", warm, cache.hits(), cache.misses(), cache.rejects());
+			passed = cache.hits() == ProgramCount || !rt::ProgramCache::isSupported();
+		}
+		// How much the cache saves depends on the driver's compiler, with shaders this small llvmpipe only links about twice as fast warm.
+		fmt::print("Speedup: {:.2f}x for {} programs, cold {:.2f} ms and warm {:.2f} ms per program\n", cold / warm, ProgramCount,
+			cold / ProgramCount, warm / ProgramCount);
+
+		// A damaged file is dropped as a whole instead of trusting the lengths in it, and written out again.
+		bool damaged = true;
+		if (rt::ProgramCache::isSupported()) {
+			// The length of the first entry, after the 24 byte file header and the entry's key and format.
+			{
+				std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+				uint32_t huge = 0xFFFFFFF0u;
+				file.seekp(36);
+				file.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+			}
+			{
+				rt::ProgramCache cache(path);
+				damaged = cache.size() == 0;
+			}
+			{
+				rt::ProgramCache cache(path);
+				damaged = damaged && cache.size() == 0;
+				linkAll(cache);
+			}
+			std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+			{
+				rt::ProgramCache cache(path);
+				damaged = damaged && cache.size() == 0;
+			}
+		}
+		fmt::print("Damaged file: {}\n", damaged ? "passed" : "failed");
+		passed = passed && damaged;
+
+		std::filesystem::remove(path);
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <string>
+
+#include <rt/Program.hpp>
+
+using namespace rt::literals;
+
+static constexpr std::string_view vertexSource =
+	"#version 450\n"
+	"layout(location = 0) in vec2 pos;\n"
+	"layout(location = 1) in vec4 extra[3];\n"
+	"struct Light { vec3 color; float radius[2]; };\n"
+	"uniform float weights[4];\n"
+	"uniform Light lights[2];\n"
+	"uniform vec2 grid[2][3];\n"
+	"uniform mat4 model;\n"
+	"layout(std140, binding = 2) uniform Camera { mat4 view; };\n"
+	"out vec4 tint;\n"
+	"void main() {\n"
+	"	float sum = weights[0] + weights[1] + weights[2] + weights[3];\n"
+	"	vec3 light = lights[0].color * lights[0].radius[1] + lights[1].color * lights[1].radius[0];\n"
+	"	vec2 cell = grid[0][2] + grid[1][1];\n"
+	"	tint = vec4(light * sum, 1.0) + extra[0] + extra[1] + extra[2] + vec4(cell, 0.0, 0.0);\n"
+	"	gl_Position = view * model * vec4(pos, 0.0, 1.0);\n"
+	"}\n";
+
+static constexpr std::string_view fragmentSource =
+	"#version 450\n"
+	"in vec4 tint;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = tint;\n"
+	"}\n";
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::Program program;
+		require(program.compile(vertexSource, fragmentSource), "Failed to link the program.");
+		require(program.getReflection().isBuilt(), "Reflection was not built after linking.");
+
+		// Every name opengl resolves has to resolve to the same location through reflection, array elements included.
+		const std::vector<std::string> uniformNames = {
+			"weights", "weights[0]", "weights[1]", "weights[2]", "weights[3]",
+			"lights[0].color", "lights[1].color", "lights[0].radius", "lights[0].radius[1]", "lights[1].radius[1]",
+			"grid[0]", "grid[0][2]", "grid[1][1]", "grid[1][2]", "model",
+		};
+		bool uniforms = true;
+		for (const std::string& name : uniformNames) {
+			GLint expected = glGetUniformLocation(program.getId(), name.c_str());
+			GLint found = program.getUniformLocation(name);
+			if (expected < 0 || found != expected) {
+				fmt::print("{}: reflection {}, opengl {}\n", name, found, expected);
+				uniforms = false;
+			}
+		}
+		fmt::print("Uniform elements: {}\n", uniforms ? "passed" : "failed");
+
+		// Out of range and malformed indices, and names that are not there at all.
+		const std::vector<std::string> missingNames = {
+			"weights[4]", "weights[-1]", "weights[]", "weights[1x]", "weights[ 1]", "model[0]", "view", "lights[2].color", "missing", "[1]",
+		};
+		bool missing = true;
+		for (const std::string& name : missingNames) {
+			GLint found = program.getUniformLocation(name);
+			if (found != -1) {
+				fmt::print("{}: reflection {}, expected -1\n", name, found);
+				missing = false;
+			}
+		}
+		fmt::print("Missing names: {}\n", missing ? "passed" : "failed");
+
+		// Input array elements go back to opengl, the precomputed hashes only find names as reflected.
+		bool other = program.getInputLocation("extra[2]") == glGetProgramResourceLocation(program.getId(), GL_PROGRAM_INPUT, "extra[2]") &&
+			program.getInputLocation("extra") == 1 && program.getInputLocation("pos") == 0 &&
+			program.getUniformLocation("weights"_name) == program.getUniformLocation("weights[0]") &&
+			program.getUniformLocation("model"_name) == glGetUniformLocation(program.getId(), "model") &&
+			program.getUBOIndex("Camera") == program.getUBOIndex("Camera"_name) && program.getUBOIndex("Camera") != GLint(GL_INVALID_INDEX) &&
+			program.getUBOIndex("Missing") == GLint(GL_INVALID_INDEX);
+		fmt::print("Inputs, blocks and hashes: {}\n", other ? "passed" : "failed");
+
+		// Resources are kept by name, a name hashing like another can not stand in for it.
+		rt::ResourceTable table;
+		std::vector<rt::ProgramResource> resources(2);
+		resources[0].hash = rt::fnv1a("alpha");
+		resources[0].name = "alpha";
+		resources[0].location = 3;
+		resources[1].hash = rt::fnv1a("alpha");
+		resources[1].name = "beta";
+		resources[1].location = 7;
+		table.build(resources);
+		bool names = table.size() == 2 && table.find("alpha") != nullptr && table.find("alpha")->location == 3 && table.find("gamma") == nullptr;
+		fmt::print("Collisions: {}\n", names ? "passed" : "failed");
+
+		passed = uniforms && missing && other && names;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
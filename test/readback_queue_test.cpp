@@ -0,0 +1,123 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <chrono>
+
+#include <rt/ReadbackQueue.hpp>
+
+static uint8_t texel(GLint x, GLint y) {
+	return uint8_t(x * 16 + y);
+}
+
+// Spins on isReady, which never blocks, until the request is done or a second has passed. Returns the number of polls.
+static int pollUntilReady(const rt::ReadbackHandle& handle) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	int polls = 1;
+	while (!handle.isReady()) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return -1;
+		}
+		glFlush();
+		++polls;
+	}
+	return polls;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::ReadbackQueue queue{ 4096, 3 };
+
+		// Rows of 5 single byte texels are 5 bytes, the result has to be tightly packed regardless of the pack alignment.
+		glm::ivec2 size{ 16, 8 };
+		std::vector<uint8_t> pixels;
+		for (GLint y = 0; y < size.y; ++y) {
+			for (GLint x = 0; x < size.x; ++x) {
+				pixels.push_back(texel(x, y));
+			}
+		}
+		rt::ImmutableTexture2d texture;
+		texture.init(rt::TexFormat::R_N8, 1, size);
+		texture.subImage(pixels.data(), 0, glm::ivec2{ 0 }, size, rt::PixelComponent::R, rt::PixelFormat::U8);
+
+		glm::ivec2 offset{ 3, 2 };
+		glm::ivec2 region{ 5, 4 };
+		rt::ReadbackHandle textureRead = queue.readTexture(texture, 0, offset, region, rt::PixelComponent::R, rt::PixelFormat::U8);
+
+		std::vector<uint32_t> values(2048);
+		for (uint32_t i = 0; i < values.size(); ++i) {
+			values[i] = i * 3;
+		}
+		rt::ImmutableBuffer buffer{ values.data(), values.size(), rt::BufferInits::None };
+		rt::ReadbackHandle bufferRead = queue.readBuffer(buffer, 64 * sizeof(uint32_t), 100 * sizeof(uint32_t));
+
+		GLint alignment = 0;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+		bool issued = textureRead.isValid() && bufferRead.isValid() && queue.numFreeSlots() == 1 && alignment == 4 &&
+			textureRead.sizeBytes() == size_t(region.x * region.y) && bufferRead.sizeBytes() == 64 * sizeof(uint32_t);
+
+		int texturePolls = pollUntilReady(textureRead);
+		bool textureData = texturePolls > 0 && textureRead.data() != nullptr;
+		if (textureData) {
+			const uint8_t* result = textureRead.data<uint8_t>();
+			for (GLint y = 0; y < region.y; ++y) {
+				for (GLint x = 0; x < region.x; ++x) {
+					textureData = textureData && result[y * region.x + x] == texel(offset.x + x, offset.y + y);
+				}
+			}
+		}
+		int bufferPolls = pollUntilReady(bufferRead);
+		bool bufferData = bufferPolls > 0 && bufferRead.data() != nullptr;
+		if (bufferData) {
+			const uint32_t* result = bufferRead.data<uint32_t>();
+			for (uint32_t i = 0; i < 64; ++i) {
+				bufferData = bufferData && result[i] == (100 + i) * 3;
+			}
+		}
+		fmt::print("Texture: {}, buffer: {}, ready after {} and {} polls\n", textureData ? "passed" : "failed", bufferData ? "passed" : "failed",
+			texturePolls, bufferPolls);
+
+		// Requests fail once the slots run out or when they are too large, and released handles let go of their slot.
+		rt::ReadbackHandle third = queue.readBuffer(buffer, 16);
+		bool slots = third.isValid() && queue.numFreeSlots() == 0 && !queue.readBuffer(buffer, 16).isValid();
+		third.release();
+		slots = slots && !third.isValid() && third.data() == nullptr && third.sizeBytes() == 0 && queue.numFreeSlots() == 1;
+		slots = slots && !queue.readBuffer(buffer, 4096 + 4).isValid() && queue.numFreeSlots() == 1;
+
+		// A copy of a released handle stays invalid after its slot is handed out again.
+		rt::ReadbackHandle stale = bufferRead;
+		bufferRead.release();
+		rt::ReadbackHandle reused = queue.readBuffer(buffer, 16);
+		slots = slots && reused.isValid() && !stale.isValid() && !stale.isReady() && stale.data() == nullptr;
+		slots = slots && reused.wait() && reused.data<uint32_t>()[0] == 0;
+		reused.release();
+		textureRead.release();
+		slots = slots && queue.numFreeSlots() == queue.numSlots();
+		fmt::print("Slots: {}\n", slots ? "passed" : "failed");
+
+		// A pack alignment the caller set is kept, and reads of rows that are not a multiple of 8 bytes still come back tight.
+		glPixelStorei(GL_PACK_ALIGNMENT, 2);
+		bool packing = true;
+		for (GLint width : { 5, 8 }) {
+			rt::ReadbackHandle read = queue.readTexture(texture, 0, offset, glm::ivec2{ width, 3 }, rt::PixelComponent::R, rt::PixelFormat::U8);
+			GLint packBuffer = -1;
+			glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+			glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+			packing = packing && read.wait() && alignment == 2 && packBuffer == 0;
+			const uint8_t* result = read.data<uint8_t>();
+			for (GLint y = 0; y < 3 && packing; ++y) {
+				for (GLint x = 0; x < width; ++x) {
+					packing = packing && result[y * width + x] == texel(offset.x + x, offset.y + y);
+				}
+			}
+		}
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		fmt::print("Pack state: {}\n", packing ? "passed" : "failed");
+
+		passed = issued && textureData && bufferData && slots && packing;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <optional>
+
+#include <rt/StateCache.hpp>
+#include <rt/Sampler.hpp>
+#include <rt/FrameBuffer.hpp>
+#include <rt/Buffer.hpp>
+
+static constexpr GLuint Unit = 2;
+
+static constexpr std::string_view vertexSource =
+	"#version 450\n"
+	"void main() {\n"
+	"	gl_Position = vec4(0.0, 0.0, 0.0, 1.0);\n"
+	"}\n";
+
+static constexpr std::string_view fragmentSource =
+	"#version 450\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = vec4(1.0);\n"
+	"}\n";
+
+// What opengl itself reports as bound, so the test does not only trust the cache.
+static GLuint bound(GLenum binding) {
+	GLint value = 0;
+	if (binding == GL_TEXTURE_BINDING_2D || binding == GL_SAMPLER_BINDING) {
+		glActiveTexture(GL_TEXTURE0 + Unit);
+	}
+	glGetIntegerv(binding, &value);
+	return GLuint(value);
+}
+
+static GLuint boundStorage(GLuint index) {
+	GLint value = 0;
+	glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, index, &value);
+	return GLuint(value);
+}
+
+// The objects live in optionals, so they can be deleted and created again in place.
+struct Objects {
+	std::optional<rt::Program> program;
+	std::optional<rt::VertexArray> vao;
+	std::optional<rt::ImmutableTexture2d> texture;
+	std::optional<rt::Sampler> sampler;
+	std::optional<rt::ImmutableBuffer> buffer;
+	std::optional<rt::FrameBuffer> framebuffer;
+
+	void create() {
+		program.emplace();
+		require(program->compile(vertexSource, fragmentSource), "Failed to link the program.");
+		vao.emplace();
+		texture.emplace();
+		texture->init(rt::TexFormat::R_N8, 1, glm::ivec2{ 4 });
+		sampler.emplace();
+		buffer.emplace(256, rt::BufferInits::None);
+		framebuffer.emplace();
+	}
+	void destroy() {
+		program.reset();
+		vao.reset();
+		texture.reset();
+		sampler.reset();
+		buffer.reset();
+		framebuffer.reset();
+	}
+	void bind() {
+		program->bind();
+		vao->bind();
+		texture->bindUnit(Unit);
+		sampler->bindUnit(Unit);
+		buffer->bindSSBO(1, 0, 64);
+		framebuffer->bind();
+	}
+	bool isBound() const {
+		return bound(GL_CURRENT_PROGRAM) == program->getId() && bound(GL_VERTEX_ARRAY_BINDING) == vao->getId() &&
+			bound(GL_TEXTURE_BINDING_2D) == texture->getId() && bound(GL_SAMPLER_BINDING) == sampler->getId() &&
+			boundStorage(1) == buffer->getId() && bound(GL_DRAW_FRAMEBUFFER_BINDING) == framebuffer->getId();
+	}
+	std::vector<GLuint> ids() const {
+		return { program->getId(), vao->getId(), texture->getId(), sampler->getId(), buffer->getId(), framebuffer->getId() };
+	}
+};
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::StateCache& cache = rt::StateCache::get();
+		cache.enable();
+		cache.resetStats();
+
+		// Binding the same thing twice only reaches opengl once.
+		Objects objects;
+		objects.create();
+		for (int i = 0; i < 2; ++i) {
+			objects.program->bind();
+			objects.vao->bind();
+			objects.texture->bindUnit(Unit);
+			objects.sampler->bindUnit(Unit);
+			objects.buffer->bindSSBO(1);
+			objects.framebuffer->bind();
+		}
+		// Binding both targets also covers the draw framebuffer, a range is a different binding than the whole buffer.
+		objects.framebuffer->bindDraw();
+		objects.buffer->bindSSBO(1, 0, 64);
+		bool elided = cache.issuedCount() == 7 && cache.elidedCount() == 7 && objects.isBound() &&
+			cache.currentProgram() == objects.program->getId() && cache.currentTexture(Unit) == objects.texture->getId();
+		fmt::print("Elided binds: {}, issued {}, elided {}\n", elided ? "passed" : "failed", cache.issuedCount(), cache.elidedCount());
+
+		// Deleting a bound object forgets it, so whatever is bound next in its place, possibly under the same name, reaches opengl.
+		std::vector<GLuint> old = objects.ids();
+		objects.destroy();
+		bool forgotten = cache.currentProgram() == rt::StateCache::Unknown && cache.currentVertexArray() == rt::StateCache::Unknown &&
+			cache.currentTexture(Unit) == rt::StateCache::Unknown && cache.currentSampler(Unit) == rt::StateCache::Unknown &&
+			cache.currentDrawFramebuffer() == rt::StateCache::Unknown && cache.currentReadFramebuffer() == rt::StateCache::Unknown;
+
+		objects.create();
+		cache.resetStats();
+		objects.bind();
+		forgotten = forgotten && cache.issuedCount() == 6 && cache.elidedCount() == 0 && objects.isBound();
+		std::vector<GLuint> fresh = objects.ids();
+		int reused = 0;
+		for (size_t i = 0; i < old.size(); ++i) {
+			reused += old[i] == fresh[i] ? 1 : 0;
+		}
+
+		// The same with a name that is known to come back, which the driver does not have to do.
+		cache.bindTextureUnit(Unit + 1, 1000);
+		cache.bindBuffer(GL_UNIFORM_BUFFER, 3, 1000, 0, 16);
+		cache.forgetTexture(1000);
+		cache.forgetBuffer(1000);
+		forgotten = forgotten && cache.bindTextureUnit(Unit + 1, 1000) && cache.bindBuffer(GL_UNIFORM_BUFFER, 3, 1000, 0, 16);
+		cache.invalidate();
+		fmt::print("Forgotten on deletion: {}, {} of 6 names reused\n", forgotten ? "passed" : "failed", reused);
+
+		// Disabled, every bind reaches opengl and nothing is known.
+		cache.disable();
+		cache.resetStats();
+		objects.program->bind();
+		objects.program->bind();
+		bool disabled = cache.issuedCount() == 2 && cache.elidedCount() == 0 && cache.currentProgram() == rt::StateCache::Unknown;
+		fmt::print("Disabled: {}\n", disabled ? "passed" : "failed");
+
+		objects.program->unbind();
+		objects.vao->unbind();
+		objects.framebuffer->unbind();
+
+		passed = elided && forgotten && disabled;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <Utilities.hpp>
+
+#include <cmath>
+#include <rt/rt.hpp>
+
+int main() {
+	sf::Window* window = initializeWindow();
+	{
+		glDisable(GL_DEPTH_TEST);
+		glClearColor(0.3f, 0.6f, 0.3f, 1.0f);
+
+		struct Vert {
+			glm::vec2 pos;
+			glm::vec3 color;
+		};
+
+		// Room for a few hundred quads per frame, triple buffered.
+		rt::StreamRingBuffer stream(sizeof(Vert) * 6 * 256, 3);
+		require(stream.isValid(), "Failed to create the stream buffer.");
+
+		rt::VertexArray vao;
+		vao.attribFormatF32(0, 2, offsetof(Vert, pos));
+		vao.attribFormatF32(1, 3, offsetof(Vert, color));
+		vao.attribEnable(0);
+		vao.attribEnable(1);
+		vao.attribBinding(0, 0);
+		vao.attribBinding(1, 0);
+
+		rt::Program program;
+		program.compile(loadSource("basic.vs.glsl"), loadSource("basic.fs.glsl"));
+		program.uniform(program.getUniformLocation("model"), glm::mat4{ 1 });
+
+		program.bind();
+		vao.bind();
+
+		int frame = 0;
+		while (loopWindow(window))
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			float t = 0.5f + 0.5f * std::sin(static_cast<float>(frame) * 0.05f);
+			const Vert quad[6] = {
+				Vert{ glm::vec2{-1, +1}, glm::vec3{t, 0, 0} },
+				Vert{ glm::vec2{-1, -1}, glm::vec3{0, t, 0} },
+				Vert{ glm::vec2{+1, +1}, glm::vec3{0, 0, t} },
+
+				Vert{ glm::vec2{-1, -1}, glm::vec3{0, t, 0} },
+				Vert{ glm::vec2{+1, -1}, glm::vec3{t, 0, t} },
+				Vert{ glm::vec2{+1, +1}, glm::vec3{0, 0, t} },
+			};
+
+			rt::StreamAllocation alloc = stream.write(quad, 6);
+			require(alloc.isValid(), "Stream buffer write failed.");
+
+			vao.bindVertex(stream.getBuffer(), 0, alloc.offset, sizeof(Vert));
+			vao.drawArrays(rt::Primitive::Triangles, 6);
+
+			stream.nextRegion();
+			window->display();
+			++frame;
+		}
+
+		fmt::print("Stream buffer stalled {} times, for {} ms total.\n", stream.getStallCount(), stream.getStallNanoseconds() / 1000000);
+
+		vao.unbind();
+		program.unbind();
+	}
+	cleanup(window);
+
+	return 0;
+}
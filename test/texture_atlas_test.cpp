@@ -0,0 +1,153 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include <rt/Texture.hpp>
+
+// Every entry is filled with a color derived from its id, so moved entries can be checked after compaction.
+static glm::u8vec4 entryColor(uint32_t id) {
+	uint32_t hash = id * 2654435761u;
+	return glm::u8vec4(hash & 0xFF, (hash >> 8) & 0xFF, (hash >> 16) & 0xFF, 255);
+}
+
+static rt::AtlasRegion insertEntry(rt::TextureAtlas& atlas, const glm::ivec2& size, std::vector<glm::u8vec4>& pixels, uint32_t tag) {
+	pixels.assign(size_t(size.x) * size.y, entryColor(tag));
+	return atlas.insert(pixels.data(), size, rt::PixelComponent::RGBA, rt::PixelFormat::U8);
+}
+
+static bool verifyEntry(const rt::TextureAtlas& atlas, const rt::AtlasRegion& region, uint32_t tag) {
+	std::vector<glm::u8vec4> readback(size_t(region.size.x) * region.size.y);
+	glGetTextureSubImage(atlas.getTexture().getId(), 0, region.offset.x, region.offset.y, region.layer, region.size.x, region.size.y, 1,
+		GL_RGBA, GL_UNSIGNED_BYTE, GLsizei(readback.size() * 4), readback.data());
+	for (const glm::u8vec4& pixel : readback) {
+		if (pixel != entryColor(tag)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// No two live entries may overlap, padding included.
+static bool verifyDisjoint(const std::vector<rt::AtlasRegion>& regions, GLint padding) {
+	for (size_t i = 0; i < regions.size(); ++i) {
+		for (size_t j = i + 1; j < regions.size(); ++j) {
+			const rt::AtlasRegion& a = regions[i];
+			const rt::AtlasRegion& b = regions[j];
+			if (a.layer != b.layer) {
+				continue;
+			}
+			bool apart =
+				a.offset.x + a.size.x + padding <= b.offset.x || b.offset.x + b.size.x + padding <= a.offset.x ||
+				a.offset.y + a.size.y + padding <= b.offset.y || b.offset.y + b.size.y + padding <= a.offset.y;
+			if (!apart) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		std::mt19937 rng(42);
+		std::uniform_int_distribution<GLint> glyphSize(4, 40);
+		std::vector<glm::u8vec4> pixels;
+
+		// Starts with one small layer, so inserting has to grow the array and keep what was already there.
+		rt::TextureAtlas atlas{ rt::TexFormat::RGBA_N8, glm::ivec2{ 256 }, 1, 16 };
+		std::vector<uint32_t> ids;
+		for (uint32_t i = 0; i < 600; ++i) {
+			rt::AtlasRegion region = insertEntry(atlas, glm::ivec2{ glyphSize(rng), glyphSize(rng) }, pixels, i);
+			require(region.isValid(), "Atlas insert failed.");
+			ids.push_back(region.id);
+		}
+		std::vector<rt::AtlasRegion> regions;
+		for (uint32_t id : ids) {
+			regions.push_back(atlas.region(id));
+		}
+		bool inserted = atlas.numLayers() > 1 && verifyDisjoint(regions, 1);
+		for (uint32_t i = 0; i < ids.size(); ++i) {
+			inserted = inserted && verifyEntry(atlas, atlas.region(ids[i]), i);
+		}
+		fmt::print("Insert: {}, layers: {}, occupancy: {:.2f}\n", inserted ? "passed" : "failed", atlas.numLayers(), atlas.occupancy());
+
+		// Remove two thirds of the entries, compaction has to move the rest without losing their contents.
+		std::vector<uint32_t> kept;
+		for (uint32_t i = 0; i < ids.size(); ++i) {
+			if (i % 3 != 0) {
+				atlas.remove(ids[i]);
+			}
+			else {
+				kept.push_back(i);
+			}
+		}
+		float fragmented = atlas.fragmentation();
+		uint64_t version = atlas.getVersion();
+		bool compacted = atlas.compact() && atlas.getVersion() != version && atlas.fragmentation() < fragmented && atlas.numEntries() == kept.size();
+		regions.clear();
+		for (uint32_t i : kept) {
+			rt::AtlasRegion region = atlas.region(ids[i]);
+			regions.push_back(region);
+			compacted = compacted && verifyEntry(atlas, region, i);
+		}
+		compacted = compacted && verifyDisjoint(regions, 1);
+		fmt::print("Compact: {}, layers: {}, fragmentation: {:.2f} -> {:.2f}\n", compacted ? "passed" : "failed", atlas.numLayers(), fragmented, atlas.fragmentation());
+
+		// Too large for a layer, and too many for the layer limit.
+		rt::TextureAtlas small{ rt::TexFormat::RGBA_N8, glm::ivec2{ 64 }, 1, 2, 0 };
+		bool limits = !small.allocate(glm::ivec2{ 65, 8 }).isValid();
+		for (int i = 0; i < 8; ++i) {
+			limits = limits && small.allocate(glm::ivec2{ 32 }).isValid();
+		}
+		limits = limits && !small.allocate(glm::ivec2{ 32 }).isValid() && small.numLayers() == 2 && small.occupancy() == 1.f;
+		fmt::print("Limits: {}\n", limits ? "passed" : "failed");
+
+		// Space freed by a removed entry is reused by a smaller one, whatever the old entry left outside of it has to be zero again.
+		rt::TextureAtlas reuse{ rt::TexFormat::RGBA_N8, glm::ivec2{ 64 }, 1, 1 };
+		rt::AtlasRegion old = insertEntry(reuse, glm::ivec2{ 30, 30 }, pixels, 1);
+		reuse.remove(old.id);
+		rt::AtlasRegion fresh = insertEntry(reuse, glm::ivec2{ 20, 25 }, pixels, 2);
+		bool cleared = fresh.isValid() && fresh.offset == old.offset && fresh.layer == old.layer && verifyEntry(reuse, fresh, 2);
+		glm::ivec2 area = old.size + 1;
+		std::vector<glm::u8vec4> texels(size_t(area.x) * area.y);
+		glGetTextureSubImage(reuse.getTexture().getId(), 0, old.offset.x, old.offset.y, old.layer, area.x, area.y, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, GLsizei(texels.size() * 4), texels.data());
+		for (GLint y = 0; y < area.y; ++y) {
+			for (GLint x = 0; x < area.x; ++x) {
+				bool inside = x < fresh.size.x && y < fresh.size.y;
+				cleared = cleared && (inside || texels[size_t(y * area.x + x)] == glm::u8vec4{ 0 });
+			}
+		}
+		reuse.clear();
+		rt::AtlasRegion allocated = reuse.allocate(glm::ivec2{ 20, 25 });
+		cleared = cleared && allocated.isValid() && !verifyEntry(reuse, allocated, 2);
+		fmt::print("Cleared padding: {}\n", cleared ? "passed" : "failed");
+
+		// Allocation only, with a churn of removals, to check that it stays fast with a lot of entries.
+		rt::TextureAtlas large{ rt::TexFormat::R_N8, glm::ivec2{ 4096 }, 4, 64 };
+		auto start = std::chrono::steady_clock::now();
+		std::vector<uint32_t> live;
+		for (uint32_t i = 0; i < 200000; ++i) {
+			rt::AtlasRegion region = large.allocate(glm::ivec2{ glyphSize(rng), glyphSize(rng) });
+			require(region.isValid(), "Atlas allocation failed.");
+			live.push_back(region.id);
+			if (i % 4 == 3) {
+				size_t victim = rng() % live.size();
+				large.remove(live[victim]);
+				live[victim] = live.back();
+				live.pop_back();
+			}
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		fmt::print("200000 allocations: {:.2f} ms, entries: {}, layers: {}\n", ms, large.numEntries(), large.numLayers());
+
+		passed = inserted && compacted && limits && cleared && large.numEntries() == live.size();
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include <rt/TextureUploader.hpp>
+
+static constexpr GLint TextureSize = 256;
+static constexpr GLint TileSize = 64;
+static constexpr GLint TilesPerSide = TextureSize / TileSize;
+static constexpr int TextureCount = 4;
+static constexpr int UrgentTexture = 2;
+
+static uint8_t pattern(int texture, int tile, size_t i) {
+	return static_cast<uint8_t>(texture * 31 + tile * 7 + i);
+}
+
+// Every tile has to end up in the right place with the pattern its fill function wrote.
+static bool verify(const rt::ImmutableTexture2d& texture, int index) {
+	std::vector<uint8_t> pixels(size_t(TextureSize) * TextureSize * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTextureImage(texture.getId(), 0, GL_RGBA, GL_UNSIGNED_BYTE, GLsizei(pixels.size()), pixels.data());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	for (GLint y = 0; y < TextureSize; ++y) {
+		for (GLint x = 0; x < TextureSize; ++x) {
+			int tile = (y / TileSize) * TilesPerSide + x / TileSize;
+			size_t inTile = (size_t(y % TileSize) * TileSize + x % TileSize) * 4;
+			for (size_t c = 0; c < 4; ++c) {
+				if (pixels[(size_t(y) * TextureSize + x) * 4 + c] != pattern(index, tile, inTile + c)) {
+					fmt::print("Texture {} is wrong at {} {}\n", index, x, y);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		// Small enough that the ring wraps around several times.
+		rt::TextureUploader uploader(100 * 1024, 2, 40 * 1024);
+
+		std::vector<rt::ImmutableTexture2d> textures(TextureCount);
+		std::vector<int> order;
+		for (int t = 0; t < TextureCount; ++t) {
+			textures[t].init(rt::TexFormat::RGBA_N8, 1, glm::ivec2{ TextureSize });
+			for (int tile = 0; tile < TilesPerSide * TilesPerSide; ++tile) {
+				glm::ivec2 offset{ (tile % TilesPerSide) * TileSize, (tile / TilesPerSide) * TileSize };
+				uint64_t ticket = uploader.submit(textures[t], 0, offset, glm::ivec2{ TileSize }, rt::PixelComponent::RGBA, rt::PixelFormat::U8,
+					[t, tile](uint8_t* staging, size_t length) {
+						for (size_t i = 0; i < length; ++i) {
+							staging[i] = pattern(t, tile, i);
+						}
+					},
+					t == UrgentTexture ? 10 : 0,
+					[&order, t]() { order.push_back(t); });
+				require(ticket != 0, "A tile that fits in the ring was rejected.");
+			}
+		}
+
+		// Larger than the staging ring.
+		uint64_t rejected = uploader.submit(textures[0], 0, glm::ivec2{ 0 }, glm::ivec2{ TextureSize }, rt::PixelComponent::RGBA, rt::PixelFormat::U8,
+			[](uint8_t*, size_t) {});
+
+		int frames = 0;
+		size_t largestFrame = 0;
+		while (!uploader.empty()) {
+			uploader.update();
+			largestFrame = std::max(largestFrame, uploader.bytesIssuedLastUpdate());
+			++frames;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		fmt::print("Uploaded {} bytes in {} frames, at most {} bytes per frame\n", uploader.bytesIssuedTotal(), frames, largestFrame);
+
+		bool budget = largestFrame <= uploader.getFrameBudget();
+		bool urgentFirst = order.size() >= TilesPerSide * TilesPerSide && order.front() == UrgentTexture;
+		bool contents = true;
+		for (int t = 0; t < TextureCount; ++t) {
+			contents = verify(textures[t], t) && contents;
+		}
+		fmt::print("Budget: {}, priority: {}, contents: {}, oversized: {}\n", budget ? "passed" : "failed", urgentFirst ? "passed" : "failed", contents ? "passed" : "failed",
+			rejected == 0 ? "passed" : "failed");
+
+		passed = budget && urgentFirst && contents && rejected == 0;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <Utilities.hpp>
+
+#include <vector>
+
+#include <rt/Program.hpp>
+
+static constexpr std::string_view vertexSource =
+	"#version 450\n"
+	"uniform float values[4];\n"
+	"uniform float single;\n"
+	"uniform vec4 colors[3];\n"
+	"void main() {\n"
+	"	float sum = values[0] + values[1] + values[2] + values[3] + single;\n"
+	"	gl_Position = vec4(sum, 0.0, 0.0, 1.0) + colors[0] + colors[1] + colors[2];\n"
+	"}\n";
+
+static constexpr std::string_view fragmentSource =
+	"#version 450\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = vec4(1.0);\n"
+	"}\n";
+
+// What opengl actually holds, read back one location at a time.
+static std::vector<float> readFloats(const rt::Program& program, GLint location, int count) {
+	std::vector<float> result(static_cast<size_t>(count));
+	for (int i = 0; i < count; ++i) {
+		glGetUniformfv(program.getId(), location + i, &result[size_t(i)]);
+	}
+	return result;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		rt::Program program;
+		require(program.compile(vertexSource, fragmentSource), "Failed to link the program.");
+		GLint values = program.getUniformLocation("values");
+		GLint single = program.getUniformLocation("single");
+		GLint colors = program.getUniformLocation("colors");
+
+		// An element written on its own changes what the cache holds for the array around it.
+		program.setUniformMode(rt::UniformMode::Cached);
+		const float first[4] = { 1.f, 2.f, 3.f, 4.f };
+		program.uniform(values, first, 4);
+		program.uniform(values + 1, 9.f);
+		program.uniform(values, first, 4);
+		bool overlap = readFloats(program, values, 4) == std::vector<float>{ 1.f, 2.f, 3.f, 4.f };
+
+		// And the other way around, an array over an element written before.
+		program.uniform(values + 2, 7.f);
+		const float second[4] = { 5.f, 6.f, 7.f, 8.f };
+		program.uniform(values, second, 4);
+		program.uniform(values + 2, 7.f);
+		program.uniform(values + 3, 3.f);
+		overlap = overlap && readFloats(program, values, 4) == std::vector<float>{ 5.f, 6.f, 7.f, 3.f };
+
+		uint64_t skipped = program.getUniformCache().skippedCount();
+		program.uniform(values, second[0]);
+		program.uniform(values + 3, 3.f);
+		overlap = overlap && program.getUniformCache().skippedCount() == skipped + 2;
+		fmt::print("Overlapping writes: {}\n", overlap ? "passed" : "failed");
+
+		// Values set in immediate mode are not shadowed, so coming back to the cache must not compare against the old ones.
+		program.uniform(single, 1.f);
+		program.setUniformMode(rt::UniformMode::Immediate);
+		program.uniform(single, 2.f);
+		program.setUniformMode(rt::UniformMode::Cached);
+		program.uniform(single, 1.f);
+		bool switched = readFloats(program, single, 1) == std::vector<float>{ 1.f };
+		fmt::print("Mode switch: {}\n", switched ? "passed" : "failed");
+
+		// Deferred values reach opengl with the next draw, without flushing by hand.
+		rt::VertexArray vao;
+		program.bind();
+		vao.bind();
+		program.setUniformMode(rt::UniformMode::Deferred);
+		program.getUniformCache().resetStats();
+		for (int i = 0; i < 3; ++i) {
+			program.uniform(colors + i, glm::vec4{ float(i) });
+		}
+		for (float value = 0.f; value < 10.f; value += 1.f) {
+			program.uniform(single, value);
+		}
+		glm::vec4 held{ -1.f };
+		glGetUniformfv(program.getId(), colors + 2, &held.x);
+		bool staged = held != glm::vec4{ 2.f } && program.getUniformCache().issuedCount() == 0;
+
+		vao.drawArrays(rt::Primitive::Points, 1);
+		glGetUniformfv(program.getId(), colors + 2, &held.x);
+		float singleHeld = -1.f;
+		glGetUniformfv(program.getId(), single, &singleHeld);
+		// The three elements go out as one array upload, and the ten writes to single as one call.
+		bool deferred = staged && held == glm::vec4{ 2.f } && singleHeld == 9.f && program.getUniformCache().issuedCount() == 2 &&
+			!program.getUniformCache().hasPending();
+
+		// Neighbouring uniforms are never merged into one upload, that would run past the end of an array.
+		program.uniform(values + 3, 11.f);
+		program.uniform(single, 12.f);
+		vao.drawArrays(rt::Primitive::Points, 1);
+		deferred = deferred && readFloats(program, values + 3, 2) == std::vector<float>{ 11.f, 12.f };
+		fmt::print("Deferred: {}\n", deferred ? "passed" : "failed");
+
+		// A moved program keeps its staged values, and the draw flushes them from the new one.
+		program.uniform(single, 20.f);
+		rt::Program moved = std::move(program);
+		vao.drawArrays(rt::Primitive::Points, 1);
+		float movedHeld = -1.f;
+		glGetUniformfv(moved.getId(), single, &movedHeld);
+		bool move = movedHeld == 20.f && !moved.getUniformCache().hasPending();
+		fmt::print("Move: {}\n", move ? "passed" : "failed");
+
+		vao.unbind();
+		moved.unbind();
+		passed = overlap && switched && deferred && move;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}
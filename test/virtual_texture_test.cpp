@@ -0,0 +1,156 @@
+#include <Utilities.hpp>
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include <rt/rt.hpp>
+
+static const glm::ivec2 VirtualSize{ 1024, 1024 };
+static const glm::ivec2 PageSize{ 128, 128 };
+
+static const char* vertexSource = R"(
+#version 450
+out vec2 uv;
+
+void main() {
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	uv = vec2(corner.x, 1.0 - corner.y);
+	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static const char* fragmentSource = R"(
+in vec2 uv;
+out vec4 color;
+
+void main() {
+	color = rtVtSample(uv);
+}
+)";
+
+// Every page is a flat color, red encodes the level, green and blue the page.
+static glm::u8vec4 pageColor(const rt::VirtualPage& page) {
+	return glm::u8vec4(page.level * 60, page.x * 16, page.y * 16, 255);
+}
+
+// Renders the whole texture into a target of the given size, and returns the pixels.
+static std::vector<glm::u8vec4> render(rt::VirtualTexture& vt, rt::Program& program, rt::VertexArray& vao, const glm::ivec2& size) {
+	rt::ImmutableTexture2d target;
+	target.init(rt::TexFormat::RGBA_N8, 1, size);
+	rt::FrameBuffer fbo;
+	fbo.attachColor(target, 0);
+	require(fbo.isComplete(), "Render target is incomplete.");
+
+	fbo.bind();
+	glViewport(0, 0, size.x, size.y);
+
+	vt.beginFrame();
+	vt.bind(program, 0, 1);
+	program.bind();
+	vao.bind();
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	vao.unbind();
+	program.unbind();
+	vt.endFrame();
+
+	fbo.unbind();
+
+	std::vector<glm::u8vec4> pixels(size_t(size.x) * size.y);
+	glGetTextureImage(target.getId(), 0, GL_RGBA, GL_UNSIGNED_BYTE, GLsizei(pixels.size() * 4), pixels.data());
+	return pixels;
+}
+
+// The pixel must come from the page covering it at the level the indirection texture points at.
+static bool verifyPixels(const rt::VirtualTexture& vt, const std::vector<glm::u8vec4>& pixels, const glm::ivec2& size, GLint level) {
+	for (GLint y = 0; y < size.y; ++y) {
+		for (GLint x = 0; x < size.x; ++x) {
+			glm::vec2 uv{ (x + 0.5f) / size.x, 1.f - (y + 0.5f) / size.y };
+			glm::ivec2 texel = glm::ivec2(uv * glm::vec2(VirtualSize));
+			glm::ivec2 page = texel / (PageSize << level);
+			rt::VirtualPage requested{ uint32_t(page.x), uint32_t(page.y), uint32_t(level) };
+
+			uint32_t resident = uint32_t(vt.residentLevel(requested));
+			rt::VirtualPage source{ requested.x >> (resident - level), requested.y >> (resident - level), resident };
+			if (pixels[size_t(y) * size.x + x] != pageColor(source)) {
+				fmt::print("Pixel {}, {} does not match its page\n", x, y);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	sf::Window* window = initializeWindow();
+	bool passed = false;
+	{
+		std::vector<glm::u8vec4> pagePixels(size_t(PageSize.x) * PageSize.y);
+		uint32_t loads = 0;
+		auto loader = [&](rt::VirtualTexture& vt, const rt::VirtualPage& page) {
+			std::fill(pagePixels.begin(), pagePixels.end(), pageColor(page));
+			vt.writePage(page, pagePixels.data(), rt::PixelComponent::RGBA, rt::PixelFormat::U8);
+			++loads;
+		};
+
+		// Room for 12 pages, less than the 64 pages of level 0.
+		size_t budget = 12 * size_t(PageSize.x) * PageSize.y * 4;
+		rt::VirtualTexture vt{ rt::TexFormat::RGBA_N8, VirtualSize, budget, loader, PageSize, 4096, false };
+		fmt::print("Backend: {}, levels: {}, capacity: {}\n", vt.getBackend() == rt::VirtualBackend::Sparse ? "sparse" : "software", vt.numLevels(), vt.pageCapacity());
+
+		std::string fragment = std::string("#version 450\n") + std::string(rt::intern::virtualTextureSource) + fragmentSource;
+		rt::Program program;
+		bool compiled = program.compile(vertexSource, fragment);
+		fmt::print("Compiled: {}\n", compiled);
+		rt::VertexArray vao;
+
+		// Only the coarsest level is resident to begin with, everything samples it.
+		bool pinned = vt.numResident() == 1 && vt.residentLevel({ 5, 6, 0 }) == 3;
+		std::vector<glm::u8vec4> pixels = render(vt, program, vao, glm::ivec2{ 32 });
+		bool fallback = verifyPixels(vt, pixels, glm::ivec2{ 32 }, 3);
+		fmt::print("Fallback: {}\n", pinned && fallback ? "passed" : "failed");
+
+		// Between a quarter and a sixth of the size samples level 2, whose four pages fit easily.
+		static const glm::ivec2 CoarseSize{ 180 };
+		for (int frame = 0; frame < 8; ++frame) {
+			pixels = render(vt, program, vao, CoarseSize);
+			glFinish();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			vt.update();
+		}
+		pixels = render(vt, program, vao, CoarseSize);
+		bool coarse = vt.residentLevel({ 1, 1, 2 }) == 2 && verifyPixels(vt, pixels, CoarseSize, 2);
+		fmt::print("Level 2: {}, resident: {}, loads: {}\n", coarse ? "passed" : "failed", vt.numResident(), loads);
+
+		// Full size wants all of level 0, pages get evicted and every pixel still has to fall back correctly.
+		bool bounded = true;
+		for (int frame = 0; frame < 16; ++frame) {
+			pixels = render(vt, program, vao, VirtualSize);
+			glFinish();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			vt.update();
+			bounded = bounded && vt.numResident() <= vt.pageCapacity() && vt.numCommitsLastUpdate() <= 16;
+		}
+		pixels = render(vt, program, vao, VirtualSize);
+		bool fine = verifyPixels(vt, pixels, VirtualSize, 0);
+		fmt::print("Level 0: {}, resident: {}, evictions: {}, loads: {}\n", fine && bounded ? "passed" : "failed", vt.numResident(), vt.numEvictions(), loads);
+
+		// Pages requested from the CPU, coarse ones are committed first.
+		rt::VirtualTexture cpu{ rt::TexFormat::RGBA_N8, VirtualSize, budget, loader, PageSize, 4096, false };
+		cpu.setCommitsPerUpdate(1);
+		cpu.request(rt::VirtualPage{ 7, 0, 0 });
+		cpu.request(rt::VirtualPage{ 3, 0, 1 });
+		cpu.update();
+		bool ordered = cpu.isResident({ 3, 0, 1 }) && !cpu.isResident({ 7, 0, 0 }) && cpu.numWanted() == 1;
+		ordered = ordered && cpu.residentLevel({ 7, 0, 0 }) == 1 && cpu.residentLevel({ 5, 0, 0 }) == 3;
+		cpu.update();
+		ordered = ordered && cpu.residentLevel({ 7, 0, 0 }) == 0 && cpu.residentLevel({ 6, 0, 0 }) == 1 && cpu.numWanted() == 0;
+		fmt::print("Requests: {}\n", ordered ? "passed" : "failed");
+
+		passed = compiled && pinned && fallback && coarse && fine && bounded && vt.numEvictions() > 0 && ordered;
+	}
+	cleanup(window);
+
+	return passed ? 0 : 1;
+}